@@ -0,0 +1,218 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+  * Micro-benchmark of the collision kernels: the scalar collision templates,
+  * applied cell by cell, are compared with the batched templates, which treat
+  * simd::Pack<T>::width cells at once. The populations are stored in a
+  * structure-of-arrays layout, and there is no streaming step.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+
+/// Populations of numCells cells, stored direction by direction.
+template<class D>
+struct Populations {
+    Populations(plint numCells_)
+        : numCells(numCells_),
+          data(D::q, std::vector<T>(numCells_))
+    {
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            pointers[iPop] = &data[iPop][0];
+        }
+    }
+    plint numCells;
+    std::vector<std::vector<T> > data;
+    T* pointers[D::q];
+};
+
+/// Fill the populations with equilibria of a random velocity field.
+template<class D>
+void initialize(Populations<D>& f) {
+    srand(0);
+    Array<T,D::d> j;
+    for (plint iCell=0; iCell<f.numCells; ++iCell) {
+        T rhoBar = (T)0.02*((T)rand()/(T)RAND_MAX-(T)0.5);
+        for (plint iD=0; iD<D::d; ++iD) {
+            j[iD] = (T)0.1*((T)rand()/(T)RAND_MAX-(T)0.5);
+        }
+        T jSqr = VectorTemplateImpl<T,D::d>::normSqr(j);
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            f.data[iPop][iCell] = dynamicsTemplatesImpl<T,D>::bgk_ma2_equilibrium (
+                    iPop, rhoBar, D::invRho(rhoBar), j, jSqr )
+                + (T)1.e-3*((T)rand()/(T)RAND_MAX-(T)0.5);
+        }
+    }
+}
+
+enum KernelT { bgk, trt, mrt };
+
+/// One pass of the scalar collision templates over all cells.
+template<template<typename U> class Descriptor, template<typename U> class MRTDescriptor>
+void scalarCollision(Populations<typename Descriptor<T>::BaseDescriptor>& f, KernelT kernel, T omega) {
+    typedef typename Descriptor<T>::BaseDescriptor D;
+    typedef typename MRTDescriptor<T>::SecondBaseDescriptor MRTD;
+    BlockStatistics statistics;
+    TRTdynamics<T,Descriptor> trtDynamics(omega);
+    Cell<T,Descriptor> cell(&trtDynamics);
+    cell.specifyStatisticsStatus(false);
+    Array<T,D::q> fCell;
+    Array<T,D::d> j;
+    for (plint iCell=0; iCell<f.numCells; ++iCell) {
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            fCell[iPop] = f.pointers[iPop][iCell];
+        }
+        if (kernel==bgk) {
+            T rhoBar;
+            momentTemplatesImpl<T,D>::get_rhoBar_j(fCell, rhoBar, j);
+            dynamicsTemplatesImpl<T,D>::bgk_ma2_collision(fCell, rhoBar, j, omega);
+        }
+        else if (kernel==trt) {
+            cell.getRawPopulations() = fCell;
+            trtDynamics.TRTdynamics<T,Descriptor>::collide(cell, statistics);
+            fCell = cell.getRawPopulations();
+        }
+        else {
+            mrtTemplatesImpl<T,MRTD>::mrtCollision(fCell, omega);
+        }
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            f.pointers[iPop][iCell] = fCell[iPop];
+        }
+    }
+}
+
+/// One pass of the batched collision templates over all cells. The number
+///   of cells must be a multiple of the pack width.
+template<class D>
+void batchedCollision(Populations<D>& f, KernelT kernel, T omega, T omegaMinus,
+                      std::vector<T> const& collisionMatrix)
+{
+    typedef batchedDynamicsTemplates<T,D> Batched;
+    typedef simd::Pack<T> Pack;
+    Array<Pack,D::q> fPack;
+    Array<Pack,D::d> j;
+    Pack rhoBar;
+    for (plint iCell=0; iCell<f.numCells; iCell+=Pack::width) {
+        Batched::load(f.pointers, iCell, fPack);
+        Batched::get_rhoBar_j(fPack, rhoBar, j);
+        if (kernel==bgk) {
+            Batched::bgk_ma2_collision(fPack, rhoBar, j, omega);
+        }
+        else if (kernel==trt) {
+            Batched::trt_ma2_collision(fPack, rhoBar, j, omega, omegaMinus);
+        }
+        else {
+            Batched::mrt_ma2_collision(fPack, rhoBar, j, &collisionMatrix[0]);
+        }
+        Batched::store(fPack, f.pointers, iCell);
+    }
+}
+
+template<template<typename U> class Descriptor, template<typename U> class MRTDescriptor>
+void benchmark(std::string name, plint numCells, plint numIter) {
+    typedef typename Descriptor<T>::BaseDescriptor D;
+    typedef typename MRTDescriptor<T>::SecondBaseDescriptor MRTD;
+    T omega = 1.6;
+    T omegaMinus = TRTdynamics<T,Descriptor>::getOmegaMinus();
+    std::vector<T> collisionMatrix;
+    batchedDynamicsTemplates<T,D>::template computeMrtCollisionMatrix<MRTD>(omega, collisionMatrix);
+
+    char const* kernelNames[] = { "BGK", "TRT", "MRT" };
+    KernelT kernels[] = { bgk, trt, mrt };
+    for (plint iKernel=0; iKernel<3; ++iKernel) {
+        Populations<D> fScalar(numCells), fBatched(numCells);
+        initialize(fScalar);
+        initialize(fBatched);
+
+        // Accuracy: maximum deviation after one collision.
+        scalarCollision<Descriptor,MRTDescriptor>(fScalar, kernels[iKernel], omega);
+        batchedCollision(fBatched, kernels[iKernel], omega, omegaMinus, collisionMatrix);
+        T maxDeviation = T();
+        for (plint iPop=0; iPop<D::q; ++iPop) {
+            for (plint iCell=0; iCell<numCells; ++iCell) {
+                maxDeviation = std::max( maxDeviation,
+                        std::fabs(fScalar.data[iPop][iCell]-fBatched.data[iPop][iCell]) );
+            }
+        }
+
+        global::timer("scalar").restart();
+        for (plint iter=0; iter<numIter; ++iter) {
+            scalarCollision<Descriptor,MRTDescriptor>(fScalar, kernels[iKernel], omega);
+        }
+        double scalarTime = global::timer("scalar").stop();
+
+        global::timer("batched").restart();
+        for (plint iter=0; iter<numIter; ++iter) {
+            batchedCollision(fBatched, kernels[iKernel], omega, omegaMinus, collisionMatrix);
+        }
+        double batchedTime = global::timer("batched").stop();
+
+        double numUpdates = (double)numCells*(double)numIter*1.e-6;
+        pcout << name << " " << kernelNames[iKernel]
+              << ": scalar " << numUpdates/scalarTime << " MLUPS"
+              << ", batched " << numUpdates/batchedTime << " MLUPS"
+              << ", speedup " << scalarTime/batchedTime
+              << ", max. deviation " << maxDeviation << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    plbInit(&argc, &argv);
+
+    plint N = 64;
+    plint numIter = 20;
+    try {
+        if (global::argc()>1) {
+            global::argv(1).read(N);
+        }
+        if (global::argc()>2) {
+            global::argv(2).read(numIter);
+        }
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " [N [numIter]]" << std::endl;
+        pcout << "where N^3 is the number of cells, and numIter the number of collisions per kernel." << std::endl;
+        exit(1);
+    }
+    plint width = simd::Pack<T>::width;
+    plint numCells = (N*N*N+width-1)/width*width;
+
+    pcout << "Collision kernels on " << numCells << " cells, " << numIter << " iterations, "
+          << "instruction set " << simd::instructionSet() << " (pack width " << width << ")." << std::endl;
+
+    benchmark<descriptors::D3Q19Descriptor,descriptors::MRTD3Q19Descriptor>("D3Q19", numCells, numIter);
+    benchmark<descriptors::D3Q27Descriptor,descriptors::MRTD3Q27Descriptor>("D3Q27", numCells, numIter);
+}
@@ -0,0 +1,216 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+  * Benchmark of fused data processors: a forcing term and three point-wise
+  * analysis functionals are executed once each, in four traversals of the
+  * lattice, and then fused into a single tiled traversal (see
+  * FusedProcessingFunctional3D). The number of bytes moved per step is
+  * estimated from the cell sizes of the blocks: every traversal reads each
+  * cell of its arguments, and writes back the cells of the modified ones.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+#define DESCRIPTOR descriptors::D3Q19Descriptor
+
+/// Point-wise forcing term: adds the momentum force to every cell.
+class AddMomentum3D : public BoxProcessingFunctional3D_L<T,DESCRIPTOR> {
+public:
+    AddMomentum3D(Array<T,3> const& force_)
+        : force(force_)
+    { }
+    virtual void process(Box3D domain, BlockLattice3D<T,DESCRIPTOR>& lattice) {
+        typedef DESCRIPTOR<T> D;
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    Cell<T,DESCRIPTOR>& cell = lattice.get(iX,iY,iZ);
+                    for (plint iPop=0; iPop<D::q; ++iPop) {
+                        cell[iPop] += D::invCs2*D::t[iPop]*
+                            (D::c[iPop][0]*force[0]+D::c[iPop][1]*force[1]+D::c[iPop][2]*force[2]);
+                    }
+                }
+            }
+        }
+    }
+    virtual AddMomentum3D* clone() const {
+        return new AddMomentum3D(*this);
+    }
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+        modified[0] = modif::staticVariables;
+    }
+private:
+    Array<T,3> force;
+};
+
+struct Fields {
+    Fields(plint N)
+        : lattice(N, N, N, new BGKdynamics<T,DESCRIPTOR>(1.6)),
+          density(N, N, N),
+          velocity(N, N, N),
+          energy(N, N, N)
+    {
+        initializeAtEquilibrium(lattice, lattice.getBoundingBox(), 1., Array<T,3>(0.01,0.02,0.));
+        lattice.initialize();
+    }
+    MultiBlockLattice3D<T,DESCRIPTOR> lattice;
+    MultiScalarField3D<T> density;
+    MultiTensorField3D<T,3> velocity;
+    MultiScalarField3D<T> energy;
+};
+
+/// The functionals of one step, and their arguments.
+void createFunctionals( Fields& fields, std::vector<BoxProcessingFunctional3D*>& functionals,
+                        std::vector<std::vector<MultiBlock3D*> >& arguments )
+{
+    functionals.clear();
+    arguments.clear();
+    std::vector<MultiBlock3D*> args;
+
+    functionals.push_back(new AddMomentum3D(Array<T,3>(1.e-6,0.,0.)));
+    args.assign(1, &fields.lattice);
+    arguments.push_back(args);
+
+    functionals.push_back(new BoxDensityFunctional3D<T,DESCRIPTOR>);
+    args.assign(1, &fields.lattice);
+    args.push_back(&fields.density);
+    arguments.push_back(args);
+
+    functionals.push_back(new BoxVelocityFunctional3D<T,DESCRIPTOR>);
+    args.assign(1, &fields.lattice);
+    args.push_back(&fields.velocity);
+    arguments.push_back(args);
+
+    functionals.push_back(new BoxKineticEnergyFunctional3D<T,DESCRIPTOR>);
+    args.assign(1, &fields.lattice);
+    args.push_back(&fields.energy);
+    arguments.push_back(args);
+}
+
+/// Estimated bytes moved per cell: every argument is read, and the modified ones are written.
+double bytesPerCell(BoxProcessingFunctional3D const& functional, std::vector<MultiBlock3D*> const& args) {
+    std::vector<modif::ModifT> modified(args.size(), modif::nothing);
+    functional.getTypeOfModification(modified);
+    double bytes = 0.;
+    for (pluint iArg=0; iArg<args.size(); ++iArg) {
+        plint factor = modified[iArg]==modif::nothing ? 1 : 2;
+        bytes += (double)(factor*args[iArg]->sizeOfCell());
+    }
+    return bytes;
+}
+
+int main(int argc, char* argv[]) {
+    plbInit(&argc, &argv);
+
+    plint N = 100;
+    plint numIter = 20;
+    plint tileSize = 16;
+    try {
+        if (global::argc()>1) {
+            global::argv(1).read(N);
+        }
+        if (global::argc()>2) {
+            global::argv(2).read(numIter);
+        }
+        if (global::argc()>3) {
+            global::argv(3).read(tileSize);
+        }
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " [N [numIter [tileSize]]]" << std::endl;
+        pcout << "where N^3 is the number of cells, numIter the number of steps, "
+              << "and tileSize the tile edge of the fused traversal." << std::endl;
+        exit(1);
+    }
+
+    Fields separate(N), fused(N);
+    Box3D domain = separate.lattice.getBoundingBox();
+    std::vector<BoxProcessingFunctional3D*> functionals;
+    std::vector<std::vector<MultiBlock3D*> > arguments;
+
+    // Bytes per cell, separate traversals versus a single traversal.
+    createFunctionals(separate, functionals, arguments);
+    double separateBytes = 0.;
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        separateBytes += bytesPerCell(*functionals[iFunctional], arguments[iFunctional]);
+    }
+    FusedProcessingFunctional3D fusedFunctional;
+    std::vector<MultiBlock3D*> fusedArguments;
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        std::vector<plint> blockIds;
+        for (pluint iArg=0; iArg<arguments[iFunctional].size(); ++iArg) {
+            std::vector<MultiBlock3D*>::iterator it = std::find (
+                    fusedArguments.begin(), fusedArguments.end(), arguments[iFunctional][iArg] );
+            blockIds.push_back(it-fusedArguments.begin());
+            if (it==fusedArguments.end()) {
+                fusedArguments.push_back(arguments[iFunctional][iArg]);
+            }
+        }
+        fusedFunctional.addFunctional(functionals[iFunctional], blockIds);
+    }
+    double fusedBytes = bytesPerCell(fusedFunctional, fusedArguments);
+    double numCells = (double)N*(double)N*(double)N;
+
+    global::timer("separate").restart();
+    for (plint iter=0; iter<numIter; ++iter) {
+        createFunctionals(separate, functionals, arguments);
+        for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+            applyProcessingFunctional(functionals[iFunctional], domain, arguments[iFunctional]);
+        }
+    }
+    double separateTime = global::timer("separate").stop()/(double)numIter;
+
+    global::timer("fused").restart();
+    for (plint iter=0; iter<numIter; ++iter) {
+        createFunctionals(fused, functionals, arguments);
+        applyFusedProcessingFunctionals(functionals, domain, arguments, tileSize);
+    }
+    double fusedTime = global::timer("fused").stop()/(double)numIter;
+
+    T maxDeviation = std::max (
+            computeMax(*computeAbsoluteValue(*subtract(separate.density, fused.density))),
+            computeMax(*computeAbsoluteValue(*subtract(separate.energy, fused.energy))) );
+
+    pcout << "Four point-wise functionals on " << N << "^3 cells, tile size " << tileSize << "." << std::endl;
+    pcout << "separate: " << separateBytes*numCells*1.e-6 << " MB moved per step, "
+          << separateTime*1.e3 << " ms per step, "
+          << separateBytes*numCells/separateTime*1.e-9 << " GB/s" << std::endl;
+    pcout << "fused:    " << fusedBytes*numCells*1.e-6 << " MB moved per step, "
+          << fusedTime*1.e3 << " ms per step, "
+          << fusedBytes*numCells/fusedTime*1.e-9 << " GB/s" << std::endl;
+    pcout << "speedup " << separateTime/fusedTime
+          << ", max. deviation " << maxDeviation << std::endl;
+}
@@ -0,0 +1,184 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+  * Benchmark of passive tracer particles: a periodic box is seeded with point
+  * particles, which are advected by a steady ABC flow. The same simulation is
+  * run with a LightParticleField3D and with a DenseParticleField3D, and the
+  * time per step (advection, fluid-to-particle coupling and transfer of the
+  * particles between blocks) is given, together with the time spent on the
+  * transfer alone.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+#define DESCRIPTOR descriptors::D3Q19Descriptor
+
+/// Steady Arnold-Beltrami-Childress flow, at equilibrium.
+class AbcFlow : public OneCellIndexedFunctional3D<T,DESCRIPTOR> {
+public:
+    AbcFlow(plint N_, T uMax_)
+        : N(N_), uMax(uMax_)
+    { }
+    virtual AbcFlow* clone() const {
+        return new AbcFlow(*this);
+    }
+    virtual void execute(plint iX, plint iY, plint iZ, Cell<T,DESCRIPTOR>& cell) const {
+        T k = (T)2*std::acos((T)-1)/(T)N;
+        Array<T,3> u( uMax*(std::sin(k*iZ)+std::cos(k*iY)),
+                      uMax*(std::sin(k*iX)+std::cos(k*iZ)),
+                      uMax*(std::sin(k*iY)+std::cos(k*iX)) );
+        iniCellAtEquilibrium(cell, (T)1, u);
+    }
+private:
+    plint N;
+    T uMax;
+};
+
+/// Sum of the particle positions, as a check that both particle fields agree.
+class SumPositions : public PlainReductiveBoxProcessingFunctional3D {
+public:
+    SumPositions()
+        : sumId(this->getStatistics().subscribeSum())
+    { }
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> blocks) {
+        ParticleField3D<T,DESCRIPTOR>& particleField =
+            *dynamic_cast<ParticleField3D<T,DESCRIPTOR>*>(blocks[0]);
+        std::vector<Particle3D<T,DESCRIPTOR> const*> found;
+        particleField.findParticles(domain, found);
+        for (pluint i=0; i<found.size(); ++i) {
+            Array<T,3> const& position = found[i]->getPosition();
+            this->getStatistics().gatherSum(sumId, position[0]+position[1]+position[2]);
+        }
+    }
+    virtual SumPositions* clone() const {
+        return new SumPositions(*this);
+    }
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+        modified[0] = modif::nothing;
+    }
+    T getSum() const {
+        return this->getStatistics().getSum(sumId);
+    }
+private:
+    plint sumId;
+};
+
+template<class ParticleFieldT>
+void runParticles( MultiBlockLattice3D<T,DESCRIPTOR>& lattice, T probabilityPerCell,
+                   plint numIter, std::string const& name )
+{
+    MultiParticleField3D<ParticleFieldT> particles (
+            lattice.getMultiBlockManagement(),
+            defaultMultiBlockPolicy3D().getCombinedStatistics() );
+    particles.periodicity().toggleAll(true);
+
+    std::vector<MultiBlock3D*> particleArg;
+    particleArg.push_back(&particles);
+    std::vector<MultiBlock3D*> particleFluidArg;
+    particleFluidArg.push_back(&particles);
+    particleFluidArg.push_back(&lattice);
+
+    // The same random sequence is used for both particle fields.
+    srand(1);
+    applyProcessingFunctional (
+            new InjectRandomParticlesFunctional3D<T,DESCRIPTOR> (
+                new PointParticle3D<T,DESCRIPTOR>(0, Array<T,3>(0.,0.,0.), Array<T,3>(0.,0.,0.)),
+                probabilityPerCell ),
+            lattice.getBoundingBox(), particleArg );
+    particles.duplicateOverlaps(modif::dynamicVariables);
+
+    integrateProcessingFunctional (
+            new AdvanceParticlesEveryWhereFunctional3D<T,DESCRIPTOR>,
+            lattice.getBoundingBox(), particleArg, 0 );
+    integrateProcessingFunctional (
+            new FluidToParticleCoupling3D<T,DESCRIPTOR>((T)1),
+            lattice.getBoundingBox(), particleFluidArg, 1 );
+
+    global::timer("particles").restart();
+    for (plint iter=0; iter<numIter; ++iter) {
+        particles.executeInternalProcessors();
+    }
+    double stepTime = global::timer("particles").stop()/(double)numIter;
+
+    global::timer("transfer").restart();
+    for (plint iter=0; iter<numIter; ++iter) {
+        particles.duplicateOverlaps(modif::dynamicVariables);
+    }
+    double transferTime = global::timer("transfer").stop()/(double)numIter;
+
+    plint numParticles = countParticles(particles, particles.getBoundingBox());
+    SumPositions sumPositions;
+    applyProcessingFunctional(sumPositions, particles.getBoundingBox(), particleArg);
+
+    pcout << name << ": " << numParticles << " particles, "
+          << stepTime*1.e3 << " ms per step, "
+          << transferTime*1.e3 << " ms per transfer, "
+          << "sum of positions " << std::setprecision(12) << sumPositions.getSum() << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    plbInit(&argc, &argv);
+
+    plint N = 64;
+    plint numIter = 20;
+    T probabilityPerCell = 1.;
+    try {
+        if (global::argc()>1) {
+            global::argv(1).read(N);
+        }
+        if (global::argc()>2) {
+            global::argv(2).read(numIter);
+        }
+        if (global::argc()>3) {
+            global::argv(3).read(probabilityPerCell);
+        }
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " [N [numIter [probabilityPerCell]]]" << std::endl;
+        pcout << "where N^3 is the number of cells, numIter the number of steps, and "
+              << "probabilityPerCell the probability with which a cell is seeded with a particle."
+              << std::endl;
+        exit(1);
+    }
+
+    MultiBlockLattice3D<T,DESCRIPTOR> lattice(N, N, N, new BGKdynamics<T,DESCRIPTOR>(1.));
+    lattice.periodicity().toggleAll(true);
+    applyIndexed(lattice, lattice.getBoundingBox(), new AbcFlow(N, 0.05));
+    lattice.initialize();
+
+    runParticles<LightParticleField3D<T,DESCRIPTOR> >(lattice, probabilityPerCell, numIter, "light");
+    runParticles<DenseParticleField3D<T,DESCRIPTOR> >(lattice, probabilityPerCell, numIter, "dense");
+}
@@ -0,0 +1,165 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+  * Flow in a lid-driven 3D cavity, computed with the default lattice
+  * (MultiBlockLattice3D) and with the structure-of-arrays lattice
+  * (MultiSoaBlockLattice3D), with populations stored in double and in
+  * float precision. The walls are bounce-back nodes and the lid is an
+  * equilibrium velocity boundary, so that no data processor is needed and
+  * the same case runs on all lattices. The SoA lattices are built from the
+  * initialized MultiBlockLattice3D, and copied back at the end to compare
+  * the results.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+#define DESCRIPTOR descriptors::D3Q19Descriptor
+
+void cavitySetup( MultiBlockLattice3D<T,DESCRIPTOR>& lattice,
+                  IncomprFlowParam<T> const& parameters )
+{
+    const plint nx = parameters.getNx();
+    const plint ny = parameters.getNy();
+    const plint nz = parameters.getNz();
+    Box3D topLid = Box3D(1, nx-2, ny-1, ny-1, 1, nz-2);
+
+    // Bounce-back on the outer layer, except on the lid.
+    defineDynamics(lattice, Box3D(0,0, 0,ny-1, 0,nz-1), new BounceBack<T,DESCRIPTOR>((T)1.));
+    defineDynamics(lattice, Box3D(nx-1,nx-1, 0,ny-1, 0,nz-1), new BounceBack<T,DESCRIPTOR>((T)1.));
+    defineDynamics(lattice, Box3D(0,nx-1, 0,ny-1, 0,0), new BounceBack<T,DESCRIPTOR>((T)1.));
+    defineDynamics(lattice, Box3D(0,nx-1, 0,ny-1, nz-1,nz-1), new BounceBack<T,DESCRIPTOR>((T)1.));
+    defineDynamics(lattice, Box3D(0,nx-1, 0,0, 0,nz-1), new BounceBack<T,DESCRIPTOR>((T)1.));
+    defineDynamics(lattice, topLid, new EquilibriumVelocityBoundaryDynamics<T,DESCRIPTOR,1,1> (
+                new BGKdynamics<T,DESCRIPTOR>(parameters.getOmega()) ) );
+
+    T u = std::sqrt((T)2)/(T)2 * parameters.getLatticeU();
+    initializeAtEquilibrium(lattice, lattice.getBoundingBox(), (T) 1., Array<T,3>((T)0.,(T)0.,(T)0.) );
+    initializeAtEquilibrium(lattice, topLid, (T) 1., Array<T,3>(u,(T)0.,u) );
+    setBoundaryVelocity(lattice, topLid, Array<T,3>(u,(T)0.,u) );
+
+    lattice.initialize();
+}
+
+/// Run numIter iterations, after the same number of warm-up iterations, and
+///   return the performance in mega site updates per second. The timed
+///   iterations are repeated numRepeat times, and the best result is kept.
+template<class Lattice>
+T runBenchmark(Lattice& lattice, plint numIter, plint numRepeat) {
+    for (plint iT=0; iT<numIter; ++iT) {
+        lattice.collideAndStream();
+    }
+    T bestPerformance = T();
+    for (plint iRepeat=0; iRepeat<numRepeat; ++iRepeat) {
+        global::timer("benchmark").restart();
+        for (plint iT=0; iT<numIter; ++iT) {
+            lattice.collideAndStream();
+        }
+        T time = global::timer("benchmark").stop();
+        bestPerformance = std::max(bestPerformance,
+                (T) (lattice.getBoundingBox().nCells()*numIter) / time / 1.e6);
+    }
+    return bestPerformance;
+}
+
+/// Maximum deviation of the velocity norm from the reference lattice, after the
+///   populations have been copied back into a MultiBlockLattice3D.
+template<class Lattice>
+T computeDeviation(MultiBlockLattice3D<T,DESCRIPTOR>& reference, Lattice& lattice) {
+    MultiBlockLattice3D<T,DESCRIPTOR> copyBack(reference);
+    copy(lattice, lattice.getBoundingBox(), copyBack, copyBack.getBoundingBox(), modif::staticVariables);
+    std::auto_ptr<MultiScalarField3D<T> > deviation (
+            subtract(*computeVelocityNorm(reference), *computeVelocityNorm(copyBack)) );
+    return std::max(computeMax(*deviation), -computeMin(*deviation));
+}
+
+int main(int argc, char* argv[]) {
+
+    plbInit(&argc, &argv);
+
+    plint N = 100;
+    plint numIter = 20;
+    plint numRepeat = 3;
+    try {
+        if (global::argc()>1) {
+            global::argv(1).read(N);
+        }
+        if (global::argc()>2) {
+            global::argv(2).read(numIter);
+        }
+        if (global::argc()>3) {
+            global::argv(3).read(numRepeat);
+        }
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " [N [numIter [numRepeat]]]" << std::endl;
+        pcout << "where N is the resolution, numIter the number of timed iterations, "
+              << "and numRepeat the number of repetitions of the timing." << std::endl;
+        exit(1);
+    }
+
+    IncomprFlowParam<T> parameters(
+            (T) 1e-2,  // uMax
+            (T) 1.,    // Re
+            N,         // N
+            1.,        // lx
+            1.,        // ly
+            1.         // lz
+    );
+
+    MultiBlockLattice3D<T, DESCRIPTOR> lattice (
+            parameters.getNx(), parameters.getNy(), parameters.getNz(),
+            new BGKdynamics<T,DESCRIPTOR>(parameters.getOmega()) );
+    cavitySetup(lattice, parameters);
+
+    MultiSoaBlockLattice3D<T,DESCRIPTOR> soaLattice(lattice);
+    MultiSoaBlockLattice3D<T,DESCRIPTOR,float> soaFloatLattice(lattice);
+
+    plint packWidth = simd::Pack<T>::width;
+    pcout << "Cavity with " << parameters.getNx() << "x" << parameters.getNy() << "x" << parameters.getNz()
+          << " grid points, " << global::mpi().getSize() << " MPI processes, "
+          << "instruction set " << simd::instructionSet()
+          << " (pack width " << packWidth << ")." << std::endl;
+
+    T aosPerformance = runBenchmark(lattice, numIter, numRepeat);
+    pcout << "MultiBlockLattice3D:              " << aosPerformance << " MLUPS" << std::endl;
+
+    T soaPerformance = runBenchmark(soaLattice, numIter, numRepeat);
+    pcout << "MultiSoaBlockLattice3D (double):  " << soaPerformance << " MLUPS"
+          << ", speedup " << soaPerformance/aosPerformance
+          << ", max. deviation " << computeDeviation(lattice, soaLattice) << std::endl;
+
+    T floatPerformance = runBenchmark(soaFloatLattice, numIter, numRepeat);
+    pcout << "MultiSoaBlockLattice3D (float):   " << floatPerformance << " MLUPS"
+          << ", speedup " << floatPerformance/aosPerformance
+          << ", max. deviation " << computeDeviation(lattice, soaFloatLattice) << std::endl;
+}
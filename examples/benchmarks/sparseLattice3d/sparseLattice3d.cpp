@@ -0,0 +1,203 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/** \file
+  * Benchmark of the sparse lattice on a porous geometry: a periodic network of
+  * cylindrical pores, in which the fluid occupies a small fraction of the volume,
+  * is simulated with a MultiBlockLattice3D and with a MultiSparseBlockLattice3D.
+  * The solid cells which are in contact with the fluid have BounceBack dynamics,
+  * and the remaining solid cells have NoDynamics and are not stored by the sparse
+  * lattice. The performance is given in million fluid-cell updates per second.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+#define DESCRIPTOR descriptors::D3Q19Descriptor
+
+/// Three families of cylindrical pores, aligned with the axes, with a given
+///   spacing and radius.
+class PoreNetwork {
+public:
+    PoreNetwork(plint spacing_, T radius_)
+        : spacing(spacing_), radius(radius_)
+    { }
+    bool isFluid(plint iX, plint iY, plint iZ) const {
+        T x = distance(iX), y = distance(iY), z = distance(iZ);
+        T r2 = radius*radius;
+        return x*x+y*y<r2 || y*y+z*z<r2 || x*x+z*z<r2;
+    }
+    /// A solid cell which has at least one fluid cell among its neighbors.
+    bool isWall(plint iX, plint iY, plint iZ) const {
+        if (isFluid(iX,iY,iZ)) {
+            return false;
+        }
+        for (plint dx=-1; dx<=1; ++dx) {
+            for (plint dy=-1; dy<=1; ++dy) {
+                for (plint dz=-1; dz<=1; ++dz) {
+                    if (isFluid(iX+dx,iY+dy,iZ+dz)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+private:
+    /// Distance to the closest pore axis, in one direction.
+    T distance(plint i) const {
+        plint r = i%spacing;
+        if (r<0) r += spacing;
+        return (T)r - (T)(spacing-1)/(T)2;
+    }
+private:
+    plint spacing;
+    T radius;
+};
+
+class WallDomain : public DomainFunctional3D {
+public:
+    WallDomain(PoreNetwork const& network_)
+        : network(network_)
+    { }
+    virtual bool operator() (plint iX, plint iY, plint iZ) const {
+        return network.isWall(iX,iY,iZ);
+    }
+    virtual WallDomain* clone() const {
+        return new WallDomain(*this);
+    }
+private:
+    PoreNetwork network;
+};
+
+class InteriorSolidDomain : public DomainFunctional3D {
+public:
+    InteriorSolidDomain(PoreNetwork const& network_)
+        : network(network_)
+    { }
+    virtual bool operator() (plint iX, plint iY, plint iZ) const {
+        return !network.isFluid(iX,iY,iZ) && !network.isWall(iX,iY,iZ);
+    }
+    virtual InteriorSolidDomain* clone() const {
+        return new InteriorSolidDomain(*this);
+    }
+private:
+    PoreNetwork network;
+};
+
+/// Time per iteration, in seconds.
+template<class Lattice>
+double timeIterations(Lattice& lattice, plint numIter) {
+    global::timer("iterations").restart();
+    for (plint iter=0; iter<numIter; ++iter) {
+        lattice.collideAndStream();
+    }
+    return global::timer("iterations").stop()/(double)numIter;
+}
+
+int main(int argc, char* argv[]) {
+    plbInit(&argc, &argv);
+
+    plint N = 128;
+    plint numIter = 50;
+    plint spacing = 16;
+    T radius = 3.;
+    try {
+        if (global::argc()>1) {
+            global::argv(1).read(N);
+        }
+        if (global::argc()>2) {
+            global::argv(2).read(numIter);
+        }
+        if (global::argc()>3) {
+            global::argv(3).read(spacing);
+        }
+        if (global::argc()>4) {
+            global::argv(4).read(radius);
+        }
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " [N [numIter [spacing [radius]]]]" << std::endl;
+        pcout << "where N^3 is the number of cells, numIter the number of steps, "
+              << "and spacing and radius define the network of pores." << std::endl;
+        exit(1);
+    }
+
+    PoreNetwork network(spacing, radius);
+    MultiBlockLattice3D<T,DESCRIPTOR> lattice(N, N, N, new BGKdynamics<T,DESCRIPTOR>(1.6));
+    lattice.periodicity().toggleAll(true);
+    defineDynamics(lattice, lattice.getBoundingBox(), new InteriorSolidDomain(network),
+                   new NoDynamics<T,DESCRIPTOR>);
+    defineDynamics(lattice, lattice.getBoundingBox(), new WallDomain(network),
+                   new BounceBack<T,DESCRIPTOR>(1.));
+    initializeAtEquilibrium(lattice, lattice.getBoundingBox(), 1., Array<T,3>(0.02,0.01,0.));
+    lattice.initialize();
+
+    MultiSparseBlockLattice3D<T,DESCRIPTOR> sparseLattice(lattice);
+
+    plint numFluid = 0;
+    for (plint iX=0; iX<spacing; ++iX) {
+        for (plint iY=0; iY<spacing; ++iY) {
+            for (plint iZ=0; iZ<spacing; ++iZ) {
+                if (network.isFluid(iX,iY,iZ)) {
+                    ++numFluid;
+                }
+            }
+        }
+    }
+    double fluidFraction = (double)numFluid/(double)(spacing*spacing*spacing);
+    double numCells = (double)N*(double)N*(double)N;
+    double numStored = (double)sparseLattice.getNumStoredCells();
+    double fluidCells = fluidFraction*numCells;
+    double cellBytes = (double)lattice.sizeOfCell();
+
+    double denseTime = timeIterations(lattice, numIter);
+    double sparseTime = timeIterations(sparseLattice, numIter);
+
+    std::auto_ptr<MultiScalarField3D<T> > denseVelocity = computeVelocityNorm(lattice);
+    std::auto_ptr<MultiScalarField3D<T> > sparseVelocity = computeVelocityNorm(sparseLattice);
+    T maxDeviation = computeMax(*computeAbsoluteValue(*subtract(*denseVelocity, *sparseVelocity)));
+
+    pcout << N << "^3 cells, fluid fraction " << fluidFraction
+          << " (periodic approximation), stored fraction " << numStored/numCells << "." << std::endl;
+    pcout << "dense:  " << numCells*cellBytes*1.e-6 << " MB of populations, "
+          << denseTime*1.e3 << " ms per step, "
+          << fluidCells/denseTime*1.e-6 << " fluid MLUPS" << std::endl;
+    pcout << "sparse: " << numStored*cellBytes*1.e-6 << " MB of populations, "
+          << sparseTime*1.e3 << " ms per step, "
+          << fluidCells/sparseTime*1.e-6 << " fluid MLUPS" << std::endl;
+    pcout << "speedup " << denseTime/sparseTime
+          << ", max. deviation of the velocity " << maxDeviation << std::endl;
+}
@@ -0,0 +1,306 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+  * Benchmark of the access to the triangles of a surface mesh, through the
+  * TriangleHash or through the TriangleBvh, on the aneurysm geometry. The
+  * program compares the time and memory needed to build both structures,
+  * the time needed to find the wall along all lattice links which cross the
+  * surface (this is what the off-lattice boundary conditions do during their
+  * set-up), and checks that both structures find the same triangles at the
+  * same distances, and that the batched segment queries of the hierarchy agree
+  * with the individual ones. Finally, the set-up of the Guo off-lattice boundary
+  * condition is timed with both structures.
+**/
+
+#include "palabos3D.h"
+#include "palabos3D.hh"   // include full template code
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+using namespace plb;
+using namespace std;
+
+typedef double T;
+#define DESCRIPTOR descriptors::D3Q19Descriptor
+
+/// Shoots along all links which go from a solid to a fluid cell, and finds the
+///   intersection with the wall. In compare mode, the results obtained with the
+///   hash and with the hierarchy are compared link by link.
+class ShootLinks : public PlainReductiveBoxProcessingFunctional3D {
+public:
+    enum Mode { useHash=0, useBvh=1, compare=2 };
+    ShootLinks(TriangleBoundary3D<T> const& boundary_, BoundaryProfiles3D<T,Array<T,3> > const& profiles_,
+               Mode mode_)
+        : boundary(boundary_), profiles(profiles_), mode(mode_),
+          numLinksId(this->getStatistics().subscribeIntSum()),
+          numMismatchesId(this->getStatistics().subscribeIntSum()),
+          sumDistancesId(this->getStatistics().subscribeSum())
+    { }
+    // Field 0: voxels; Field 1: hash; Field 2: BVH.
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> blocks) {
+        ScalarField3D<int>& voxels = *dynamic_cast<ScalarField3D<int>*>(blocks[0]);
+        TriangleFlowShape3D<T,Array<T,3> > prototype(boundary, profiles);
+        std::vector<AtomicBlock3D*> hashArgs, bvhArgs;
+        hashArgs.push_back(blocks[0]); hashArgs.push_back(blocks[1]); hashArgs.push_back(blocks[0]);
+        bvhArgs.push_back(blocks[0]);  bvhArgs.push_back(blocks[2]);  bvhArgs.push_back(blocks[0]);
+        TriangleFlowShape3D<T,Array<T,3> >* hashShape = prototype.clone(hashArgs);
+        TriangleFlowShape3D<T,Array<T,3> >* bvhShape = prototype.clone(bvhArgs);
+        Dot3D location = voxels.getLocation();
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    if (!voxelFlag::outsideFlag(voxels.get(iX,iY,iZ))) continue;
+                    Dot3D cell(iX+location.x, iY+location.y, iZ+location.z);
+                    if (mode==compare) {
+                        compareBatch(*dynamic_cast<AtomicContainerBlock3D*>(blocks[2]), voxels, iX, iY, iZ);
+                    }
+                    for (int iNeighbor=0; iNeighbor<NextNeighbor<T>::numNeighbors; ++iNeighbor) {
+                        int const* c = NextNeighbor<T>::c[iNeighbor];
+                        if (!voxelFlag::insideFlag(voxels.get(iX+c[0],iY+c[1],iZ+c[2]))) continue;
+                        Array<T,3> fromPoint(cell.x, cell.y, cell.z);
+                        Array<T,3> direction(c[0], c[1], c[2]);
+                        plint hashId = -1, bvhId = -1;
+                        T hashDistance = T(), bvhDistance = T();
+                        bool hashOk = false, bvhOk = false;
+                        if (mode != useBvh) {
+                            hashOk = shoot(*hashShape, fromPoint, direction, hashId, hashDistance);
+                        }
+                        if (mode != useHash) {
+                            bvhOk = shoot(*bvhShape, fromPoint, direction, bvhId, bvhDistance);
+                        }
+                        this->getStatistics().gatherIntSum(numLinksId, 1);
+                        this->getStatistics().gatherSum(sumDistancesId,
+                                mode==useBvh ? bvhDistance : hashDistance);
+                        if (mode==compare && (hashOk!=bvhOk || hashId!=bvhId || hashDistance!=bvhDistance)) {
+                            this->getStatistics().gatherIntSum(numMismatchesId, 1);
+                        }
+                    }
+                }
+            }
+        }
+        delete hashShape;
+        delete bvhShape;
+    }
+    virtual ShootLinks* clone() const {
+        return new ShootLinks(*this);
+    }
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+        modified[0] = modif::nothing;
+        modified[1] = modif::nothing;
+        modified[2] = modif::nothing;
+    }
+    plint getNumLinks() const { return this->getStatistics().getIntSum(numLinksId); }
+    plint getNumMismatches() const { return this->getStatistics().getIntSum(numMismatchesId); }
+    T getSumDistances() const { return this->getStatistics().getSum(sumDistancesId); }
+private:
+    /// The batched segment query must find the same candidates as the individual ones.
+    void compareBatch( AtomicContainerBlock3D& bvhContainer, ScalarField3D<int>& voxels,
+                       plint iX, plint iY, plint iZ )
+    {
+        TriangleBvh<T> bvh(bvhContainer);
+        Dot3D location = voxels.getLocation();
+        Array<T,3> fromPoint(iX+location.x, iY+location.y, iZ+location.z);
+        std::vector<Array<T,3> > directions;
+        for (int iNeighbor=0; iNeighbor<NextNeighbor<T>::numNeighbors; ++iNeighbor) {
+            int const* c = NextNeighbor<T>::c[iNeighbor];
+            directions.push_back(Array<T,3>(c[0], c[1], c[2]));
+        }
+        std::vector<std::vector<plint> > batch;
+        bvh.getTrianglesOnSegments(fromPoint, directions, batch);
+        std::vector<plint> single;
+        for (pluint iDirection=0; iDirection<directions.size(); ++iDirection) {
+            bvh.getTrianglesOnSegment(fromPoint, fromPoint+directions[iDirection], single);
+            if (single != batch[iDirection]) {
+                this->getStatistics().gatherIntSum(numMismatchesId, 1);
+            }
+        }
+    }
+    static bool shoot( TriangleFlowShape3D<T,Array<T,3> >& shape, Array<T,3> const& fromPoint,
+                       Array<T,3> const& direction, plint& id, T& distance )
+    {
+        Array<T,3> locatedPoint, wallNormal, surfaceData;
+        OffBoundary::Type bdType;
+        return shape.pointOnSurface( fromPoint, direction, locatedPoint, distance,
+                                     wallNormal, surfaceData, bdType, id );
+    }
+private:
+    TriangleBoundary3D<T> const& boundary;
+    BoundaryProfiles3D<T,Array<T,3> > const& profiles;
+    Mode mode;
+    plint numLinksId, numMismatchesId, sumDistancesId;
+};
+
+/// Memory used by the hash or the hierarchy, in bytes.
+class ContainerMemory : public PlainReductiveBoxProcessingFunctional3D {
+public:
+    ContainerMemory()
+        : bytesId(this->getStatistics().subscribeSum())
+    { }
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> blocks) {
+        AtomicContainerBlock3D& container = *dynamic_cast<AtomicContainerBlock3D*>(blocks[0]);
+        double bytes = 0.;
+        if (TriangleHashData* hash = dynamic_cast<TriangleHashData*>(container.getData())) {
+            ScalarField3D<std::vector<plint> >& triangles = hash->triangles;
+            for (plint iX=0; iX<triangles.getNx(); ++iX) {
+                for (plint iY=0; iY<triangles.getNy(); ++iY) {
+                    for (plint iZ=0; iZ<triangles.getNz(); ++iZ) {
+                        bytes += sizeof(std::vector<plint>) +
+                                 triangles.get(iX,iY,iZ).capacity()*sizeof(plint);
+                    }
+                }
+            }
+        }
+        else if (TriangleBvhData<T>* bvh = dynamic_cast<TriangleBvhData<T>*>(container.getData())) {
+            bytes += bvh->nodes.capacity()*sizeof(TriangleBvhNode<T>) +
+                     bvh->triangles.capacity()*sizeof(plint) +
+                     2.*bvh->lowerBounds.capacity()*sizeof(Array<T,3>);
+        }
+        this->getStatistics().gatherSum(bytesId, bytes);
+    }
+    virtual ContainerMemory* clone() const {
+        return new ContainerMemory(*this);
+    }
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+        modified[0] = modif::nothing;
+    }
+    double getMegaBytes() const { return this->getStatistics().getSum(bytesId)/1.e6; }
+private:
+    plint bytesId;
+};
+
+MultiContainerBlock3D* createContainer( VoxelizedDomain3D<T>& voxelizedDomain, bool bvh,
+                                        double& buildTime, double& megaBytes )
+{
+    TriangleBoundary3D<T> const& boundary = voxelizedDomain.getBoundary();
+    global::timer("build").restart();
+    MultiContainerBlock3D* container = new MultiContainerBlock3D(voxelizedDomain.getVoxelMatrix());
+    std::vector<MultiBlock3D*> arg;
+    arg.push_back(container);
+    if (bvh) {
+        applyProcessingFunctional(new CreateTriangleBvh<T>(boundary.getMesh()), container->getBoundingBox(), arg);
+    }
+    else {
+        applyProcessingFunctional(new CreateTriangleHash<T>(boundary.getMesh()), container->getBoundingBox(), arg);
+    }
+    buildTime = global::timer("build").stop();
+    ContainerMemory memory;
+    applyProcessingFunctional(memory, container->getBoundingBox(), arg);
+    megaBytes = memory.getMegaBytes();
+    return container;
+}
+
+double setUpGuo( VoxelizedDomain3D<T>& voxelizedDomain, BoundaryProfiles3D<T,Array<T,3> > const& profiles )
+{
+    std::auto_ptr<MultiBlockLattice3D<T,DESCRIPTOR> > lattice
+        = generateMultiBlockLattice<T,DESCRIPTOR> (
+                voxelizedDomain.getVoxelMatrix(), 1, new BGKdynamics<T,DESCRIPTOR>(1.) );
+    global::timer("guo").restart();
+    OffLatticeBoundaryCondition3D<T,DESCRIPTOR,Array<T,3> > boundaryCondition (
+            new GuoOffLatticeModel3D<T,DESCRIPTOR> (
+                new TriangleFlowShape3D<T,Array<T,3> >(voxelizedDomain.getBoundary(), profiles),
+                voxelFlag::inside ),
+            voxelizedDomain, *lattice );
+    return global::timer("guo").stop();
+}
+
+int main(int argc, char* argv[]) {
+    plbInit(&argc, &argv);
+
+    std::string fileName = "../../codesByTopic/marchingCube/aneurysm.stl";
+    plint resolution = 200;
+    plint blockSize = 20;
+    try {
+        if (global::argc()>1) {
+            global::argv(1).read(resolution);
+        }
+        if (global::argc()>2) {
+            global::argv(2).read(blockSize);
+        }
+        if (global::argc()>3) {
+            global::argv(3).read(fileName);
+        }
+    }
+    catch(...)
+    {
+        pcout << "Wrong parameters. The syntax is " << std::endl;
+        pcout << argv[0] << " [resolution [blockSize [fileName]]]" << std::endl;
+        pcout << "where resolution is the number of cells along the x-direction of the STL, "
+              << "and blockSize the size of the blocks of the sparse domain." << std::endl;
+        exit(1);
+    }
+
+    TriangleSet<T> triangleSet(fileName, DBL);
+    plint margin = 3;
+    plint borderWidth = 1;
+    plint extendedEnvelopeWidth = 2;
+    DEFscaledMesh<T>* defMesh = new DEFscaledMesh<T>(triangleSet, resolution, 0, margin, 0);
+    TriangleBoundary3D<T> boundary(*defMesh);
+    delete defMesh;
+    boundary.getMesh().inflate();
+    BoundaryProfiles3D<T,Array<T,3> > profiles;
+
+    VoxelizedDomain3D<T> voxelizedDomain (
+            boundary, voxelFlag::inside, 0, borderWidth, extendedEnvelopeWidth, blockSize );
+    pcout << "Mesh: " << boundary.getMesh().getNumTriangles() << " triangles; "
+          << getMultiBlockInfo(voxelizedDomain.getVoxelMatrix()) << std::endl;
+
+    double hashTime, bvhTime, hashMemory, bvhMemory;
+    std::auto_ptr<MultiContainerBlock3D> hash(createContainer(voxelizedDomain, false, hashTime, hashMemory));
+    std::auto_ptr<MultiContainerBlock3D> bvh(createContainer(voxelizedDomain, true, bvhTime, bvhMemory));
+    pcout << "Build: hash " << hashTime << " s, " << hashMemory << " MB; "
+          << "BVH " << bvhTime << " s, " << bvhMemory << " MB" << std::endl;
+
+    std::vector<MultiBlock3D*> shootArg;
+    shootArg.push_back(&voxelizedDomain.getVoxelMatrix());
+    shootArg.push_back(hash.get());
+    shootArg.push_back(bvh.get());
+    // The boundary layer, with a one-cell margin for the neighbors.
+    Box3D domain(voxelizedDomain.getVoxelMatrix().getBoundingBox().enlarge(-1));
+
+    ShootLinks compare(boundary, profiles, ShootLinks::compare);
+    applyProcessingFunctional(compare, domain, shootArg);
+    pcout << "Links: " << compare.getNumLinks() << ", mismatches between hash and BVH: "
+          << compare.getNumMismatches() << std::endl;
+
+    global::timer("shoot").restart();
+    ShootLinks shootHash(boundary, profiles, ShootLinks::useHash);
+    applyProcessingFunctional(shootHash, domain, shootArg);
+    double shootHashTime = global::timer("shoot").stop();
+    global::timer("shoot").restart();
+    ShootLinks shootBvh(boundary, profiles, ShootLinks::useBvh);
+    applyProcessingFunctional(shootBvh, domain, shootArg);
+    double shootBvhTime = global::timer("shoot").stop();
+    pcout << "Links: hash " << shootHashTime << " s, BVH " << shootBvhTime << " s; "
+          << "sum of distances " << std::setprecision(12) << shootHash.getSumDistances()
+          << " / " << shootBvh.getSumDistances() << std::endl;
+
+    double guoHashTime = setUpGuo(voxelizedDomain, profiles);
+    voxelizedDomain.useTriangleBvh();
+    double guoBvhTime = setUpGuo(voxelizedDomain, profiles);
+    pcout << "Guo set-up: hash " << guoHashTime << " s, BVH " << guoBvhTime << " s" << std::endl;
+}
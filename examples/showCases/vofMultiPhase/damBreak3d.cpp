@@ -126,12 +126,11 @@ void writeResults(MultiBlockLattice3D<T,DESCRIPTOR>& lattice, MultiScalarField3D
     imageWriter.writeScaledPpm(createFileName("volumeFraction", iT, 6), *extractSubDomain(volumeFraction, slice));
 
     // Use a marching-cube algorithm to reconstruct the free surface and write an STL file.
+    //   Every process writes its own part of the surface.
     std::vector<T> isoLevels;
     isoLevels.push_back((T) 0.5);
-    typedef TriangleSet<T>::Triangle Triangle;
-    std::vector<Triangle> triangles;
-    isoSurfaceMarchingCube(triangles, volumeFraction, isoLevels, volumeFraction.getBoundingBox());
-    TriangleSet<T>(triangles).writeBinarySTL(createFileName(outDir+"/interface", iT, 6)+".stl");
+    writeIsoSurfaceBinarySTL(createFileName(outDir+"/interface", iT, 6)+".stl",
+                             volumeFraction, isoLevels, volumeFraction.getBoundingBox());
 
     VtkImageOutput3D<T> vtkOut(createFileName("volumeFraction", iT, 6), 1.);
     vtkOut.writeData<float>(volumeFraction, "vf", 1.);
@@ -82,6 +82,48 @@ struct BlockDataTransfer3D {
     /// Receive data from a byte-stream into the block, and re-map IDs for dynamics if exist.
     virtual void receive( Box3D domain, std::vector<char> const& buffer,
                           modif::ModifT kind, std::map<int,std::string> const& foreignIds ) =0;
+    /// Send static data from the block into preallocated memory of
+    ///   domain.nCells()*staticCellSize() bytes, without intermediate buffer.
+    /** By default, the data is serialized with send() and copied. **/
+    virtual void sendStatic(Box3D domain, char* buffer) const {
+        std::vector<char> message;
+        send(domain, message, modif::staticVariables);
+        std::copy(message.begin(), message.end(), buffer);
+    }
+    /// Receive static data into the block from memory of
+    ///   domain.nCells()*staticCellSize() bytes, without intermediate buffer.
+    /** By default, the data is copied and deserialized with receive(). **/
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset) {
+        std::vector<char> message(buffer, buffer+domain.nCells()*staticCellSize());
+        receive(domain, message, modif::staticVariables, absoluteOffset);
+    }
+    /// Populations which enter the cells of "domain" from outside "bound" during a
+    ///   streaming step restricted to "bound", and the size of their data in bytes.
+    /** After a collision and streaming step on "bound", these are the only populations
+     *  of an envelope which differ from the ones of the corresponding bulk. For each
+     *  cell of "domain", the list holds the number of populations followed by their
+     *  indices. Returns false if the block has no populations, in which case
+     *  the full static content must be transmitted.
+     **/
+    virtual bool getStreamedPopulations( Box3D domain, Box3D bound,
+                                         std::vector<plint>& populations, plint& numBytes ) const
+    {
+        return false;
+    }
+    /// Send the populations listed by getStreamedPopulations() into preallocated memory.
+    virtual void sendPopulations(Box3D domain, std::vector<plint> const& populations, char* buffer) const {
+        PLB_ASSERT( false );
+    }
+    /// Receive the populations listed by getStreamedPopulations() from memory.
+    virtual void receivePopulations(Box3D domain, std::vector<plint> const& populations, char const* buffer) {
+        PLB_ASSERT( false );
+    }
+    /// Attribute the populations listed by getStreamedPopulations() between two blocks.
+    virtual void attributePopulations( Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                                       AtomicBlock3D const& from, std::vector<plint> const& populations )
+    {
+        PLB_ASSERT( false );
+    }
     /// Attribute data between two blocks.
     virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
                            AtomicBlock3D const& from, modif::ModifT kind) =0;
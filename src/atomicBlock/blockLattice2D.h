@@ -168,12 +168,19 @@ public:
     void boundaryStream(Box2D bound, Box2D domain);
     /// Apply collision and streaming step to bulk (non-boundary) cells
     void bulkCollideAndStream(Box2D domain);
+    /// Cache-efficient bulkCollideAndStream(domain), in which the collision step of
+    ///   the cells whose dynamics is exactly of type DynamicsType is inlined.
+    template<class DynamicsType>
+    void specializedBulkCollideAndStream(Box2D domain);
 private:
     /// Generic implementation of bulkCollideAndStream(domain).
     void linearBulkCollideAndStream(Box2D domain);
-    /// Cache-efficient implementation of bulkCollideAndStream(domain)for
-    ///   nearest-neighbor lattices.
+    /// Cache-efficient implementation of bulkCollideAndStream(domain).
     void blockwiseBulkCollideAndStream(Box2D domain);
+    /// Cache-efficient loop over the cells, with the collision step executed
+    ///   by Collision::collide(cell, statistics).
+    template<class Collision>
+    void blockwiseBulkCollideAndStreamImplementation(Box2D domain);
 private:
     /// Helper method for memory allocation
     void allocateAndInitialize();
@@ -188,6 +195,8 @@ private:
     Cell<T,Descriptor>    **grid;
     BlockLatticeDataTransfer2D<T,Descriptor> dataTransfer;
 public:
+    /// Tile size of the cache-blocked collideAndStream, which can be tuned separately
+    ///   for each combination of T and Descriptor.
     static CachePolicy2D& cachePolicy();
     template<typename T_, template<typename U_> class Descriptor_>
     friend class ExternalRhoJcollideAndStream2D;
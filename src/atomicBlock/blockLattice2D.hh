@@ -37,6 +37,7 @@
 #include "core/latticeStatistics.h"
 #include "core/dynamicsIdentifiers.h"
 #include "core/plbProfiler.h"
+#include "atomicBlock/specializedCollideAndStream2D.hh"
 #include <algorithm>
 #include <typeinfo>
 #include <cmath>
@@ -414,19 +415,27 @@ void BlockLattice2D<T,Descriptor>::bulkCollideAndStream(Box2D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
-    if (Descriptor<T>::vicinity==1) {
-        // On nearest-neighbor lattice, use the cache-efficient
-        //   version of collidAndStream.
-        blockwiseBulkCollideAndStream(domain);
+    // Use the cache-efficient version of collideAndStream, which works
+    //   for nearest-neighbor and extended lattices alike. If the domain
+    //   is dominated by a registered dynamics class, its collision step
+    //   is inlined.
+    typename SpecializedCollideAndStreamRegistry2D<T,Descriptor>::Kernel kernel =
+        specializedCollideAndStreamRegistry2D<T,Descriptor>().choose(*this, domain);
+    if (kernel) {
+        (this->*kernel)(domain);
     }
     else {
-        // Otherwise, use the straightforward implementation.
-        //   Note that at some point, we should implement the cache-efficient
-        //   version for extended lattices as well.
-        linearBulkCollideAndStream(domain);
+        blockwiseBulkCollideAndStream(domain);
     }
 }
 
+template<typename T, template<typename U> class Descriptor>
+template<class DynamicsType>
+void BlockLattice2D<T,Descriptor>::specializedBulkCollideAndStream(Box2D domain) {
+    blockwiseBulkCollideAndStreamImplementation <
+        SpecializedCollision2D<T,Descriptor,DynamicsType> > (domain);
+}
+
 
 /** Straightforward implementation which works for all kinds of lattices,
  *  not only nearest-neighbor.
@@ -446,20 +455,30 @@ void BlockLattice2D<T,Descriptor>::linearBulkCollideAndStream(Box2D domain) {
 
 
 /** Sophisticated implementation which improves cache usage through block-wise
- *  loops. For now, this works only with nearest-neighbor lattices. On extended
- *  lattices, the naive version "linearBulkCollideAndStream" is used.
+ *  loops. The tiles are skewed according to the lattice velocities, in such a way
+ *  that a cell is only swapped with neighbors which are already collided. The tile
+ *  size is taken from cachePolicy().
  */
 template<typename T, template<typename U> class Descriptor>
 void BlockLattice2D<T,Descriptor>::blockwiseBulkCollideAndStream(Box2D domain) {
+    blockwiseBulkCollideAndStreamImplementation<GenericCollision2D<T,Descriptor> >(domain);
+}
+
+template<typename T, template<typename U> class Descriptor>
+template<class Collision>
+void BlockLattice2D<T,Descriptor>::blockwiseBulkCollideAndStreamImplementation(Box2D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
+    plint skewY;
+    indexTemplates::streamingSkew2D<Descriptor<T> >(skewY);
+
     // For cache efficiency, memory is traversed block-wise. The two outer loops enumerate
     //   the blocks, whereas the two inner loops enumerate the cells inside each block.
     const plint blockSize = cachePolicy().getBlockSize();
     // Outer loops.
     for (plint outerX=domain.x0; outerX<=domain.x1; outerX+=blockSize) {
-        for (plint outerY=domain.y0; outerY<=domain.y1+blockSize-1; outerY+=blockSize) {
+        for (plint outerY=domain.y0; outerY<=domain.y1+skewY*(blockSize-1); outerY+=blockSize) {
             // Inner loops.
             plint dx = 0;
             for (plint innerX=outerX;
@@ -469,15 +488,15 @@ void BlockLattice2D<T,Descriptor>::blockwiseBulkCollideAndStream(Box2D domain) {
                 // Y-index is shifted in negative direction at each x-increment. to ensure
                 //   that only post-collision cells are accessed during the swap-operation
                 //   of the streaming.
-                plint minY = outerY-dx;
+                plint minY = outerY-skewY*dx;
                 plint maxY = minY+blockSize-1;
                 for (plint innerY=std::max(minY,domain.y0);
                      innerY <= std::min(maxY, domain.y1);
                      ++innerY)
                 {
                     // Collide the cell.
-                    grid[innerX][innerY].collide (
-                            this->getInternalStatistics() );
+                    Collision::collide( grid[innerX][innerY],
+                                        this->getInternalStatistics() );
                     // Swap the populations on the cell, and then with post-collision
                     //   neighboring cell, to perform the streaming step.
                     latticeTemplates<T,Descriptor>::swapAndStream2D (
@@ -844,7 +863,10 @@ void BlockLatticeDataTransfer2D<T,Descriptor>::attribute_regenerate (
 
 template<typename T, template<typename U> class Descriptor>
 CachePolicy2D& BlockLattice2D<T,Descriptor>::cachePolicy() {
-    static CachePolicy2D cachePolicySingleton(200);
+    // The default tile size is 200 for D2Q9, and is adapted to other lattices
+    //   in such a way that the tiles occupy the same amount of memory.
+    static CachePolicy2D cachePolicySingleton (
+            (plint) (200.*std::sqrt(9./(double)Descriptor<T>::q) + 0.5) );
     return cachePolicySingleton;
 }
 
@@ -63,6 +63,17 @@ public:
     /// Receive data from a byte-stream into the block, and re-map IDs for dynamics if exist.
     virtual void receive( Box3D domain, std::vector<char> const& buffer,
                           modif::ModifT kind, std::map<int,std::string> const& foreignIds );
+    /// Serialize the populations and external scalars directly into "buffer".
+    virtual void sendStatic(Box3D domain, char* buffer) const;
+    /// Unserialize the populations and external scalars directly from "buffer".
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
+    /// Populations i of the cells x of "domain" for which x-c_i is outside "bound".
+    virtual bool getStreamedPopulations( Box3D domain, Box3D bound,
+                                         std::vector<plint>& populations, plint& numBytes ) const;
+    virtual void sendPopulations(Box3D domain, std::vector<plint> const& populations, char* buffer) const;
+    virtual void receivePopulations(Box3D domain, std::vector<plint> const& populations, char const* buffer);
+    virtual void attributePopulations( Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                                       AtomicBlock3D const& from, std::vector<plint> const& populations );
     /// Attribute data between two lattices.
     virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
                            AtomicBlock3D const& from, modif::ModifT kind);
@@ -155,6 +166,35 @@ public:
     virtual void collideAndStream(Box3D domain);
     /// Apply first collision, then streaming step to the whole domain
     virtual void collideAndStream();
+    /// First part of collideAndStream(domain), split to overlap computations
+    ///   and communication: collision and streaming of the cells outside "interior".
+    /** On output, the cells at a distance larger than Descriptor<T>::vicinity
+     *  from "interior" have their final post-streaming value.
+     */
+    void collideAndStreamShell(Box3D domain, Box3D interior);
+    /// Second part of collideAndStream(domain): collision of the cells in
+    ///   "interior", and streaming of all pairs of neighbors which involve them.
+    void collideAndStreamInterior(Box3D domain, Box3D interior);
+    /// One time step of the in-place "AA" propagation pattern on a 3D sub-box:
+    ///   local collision on even steps, and collision with a pull from and a push
+    ///   to the neighbors on odd steps.
+    /** The parity alternates with each call. After an even step, the lattice is
+     *  not in its natural layout: the post-collision population f_i(x) is stored
+     *  in the opposite slot of cell x, and the population which enters x in
+     *  direction i is found at (x-c_i, opposite(i)), see getPopulationAA(). After
+     *  an odd step, the natural layout is restored. Populations which would leave
+     *  "domain" are bounced back, as in collideAndStream(domain).
+     */
+    void collideAndStreamAA(Box3D domain);
+    /// After an even AA step, complete the streaming on "domain" to restore the
+    ///   natural layout, and reset the parity. Does nothing after an odd step.
+    void restoreNaturalLayoutAA(Box3D domain);
+    /// True if the next call to collideAndStreamAA() executes an odd step, i.e.
+    ///   if the lattice is not in its natural layout.
+    bool isAAOddStep() const { return aaOddStep; }
+    /// Population iPop of cell (iX,iY,iZ) as it would be found in the natural
+    ///   layout, independently of the parity of the AA step.
+    T& getPopulationAA(plint iX, plint iY, plint iZ, plint iPop);
     /// Increment time counter
     /** Warning: don't call this method manually. Instead, call incrementTime()
      *  on the multi-block lattice. Otherwise, the internal time of the multi-block
@@ -176,12 +216,29 @@ public:
     void boundaryStream(Box3D bound, Box3D domain);
     /// Apply collision and streaming step to bulk (non-boundary) cells
     void bulkCollideAndStream(Box3D domain);
+    /// Cache-efficient bulkCollideAndStream(domain), in which the collision step of
+    ///   the cells whose dynamics is exactly of type DynamicsType is inlined.
+    template<class DynamicsType>
+    void specializedBulkCollideAndStream(Box3D domain);
 private:
     /// Generic implementation of bulkCollideAndStream(domain).
     void linearBulkCollideAndStream(Box3D domain);
-    /// Cache-efficient implementation of bulkCollideAndStream(domain)for
-    ///   nearest-neighbor lattices.
+    /// Cache-efficient implementation of bulkCollideAndStream(domain).
     void blockwiseBulkCollideAndStream(Box3D domain);
+    /// Cache-efficient loop over the cells, with the collision step executed
+    ///   by Collision::collide(cell, statistics).
+    template<class Collision>
+    void blockwiseBulkCollideAndStreamImplementation(Box3D domain);
+    /// Apply streaming step to the cells of "domain", for pairs of neighbors which
+    ///   are both inside "bound", and of which at least one (interiorPairs=true)
+    ///   or none (interiorPairs=false) is inside "interior".
+    void partialStream(Box3D bound, Box3D interior, Box3D domain, bool interiorPairs);
+    /// Odd AA step on the cells of "domain", with bounce-back of the
+    ///   populations which would leave "bound".
+    void boundaryOddStepAA(Box3D bound, Box3D domain);
+    /// Odd AA step on the cells of "domain", which must be at a distance of at
+    ///   least Descriptor<T>::vicinity from the boundaries of the lattice.
+    void bulkOddStepAA(Box3D domain);
 private:
     /// Helper method for memory allocation
     void allocateAndInitialize();
@@ -195,7 +252,10 @@ private:
     Dynamics<T,Descriptor>* backgroundDynamics;
     Cell<T,Descriptor>     *rawData;
     Cell<T,Descriptor>   ***grid;
+    bool aaOddStep;
 public:
+    /// Tile size of the cache-blocked collideAndStream, which can be tuned separately
+    ///   for each combination of T and Descriptor.
     static CachePolicy3D& cachePolicy();
     template<typename T_, template<typename U_> class Descriptor_>
     friend class ExternalRhoJcollideAndStream3D;
@@ -38,6 +38,8 @@
 #include "core/latticeStatistics.h"
 #include "core/dynamicsIdentifiers.h"
 #include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
+#include "atomicBlock/specializedCollideAndStream3D.hh"
 #include <algorithm>
 #include <typeinfo>
 #include <cmath>
@@ -55,7 +57,8 @@ BlockLattice3D<T,Descriptor>::BlockLattice3D (
         plint nx_, plint ny_, plint nz_,
         Dynamics<T,Descriptor>* backgroundDynamics_ )
    :  AtomicBlock3D(nx_, ny_, nz_, new BlockLatticeDataTransfer3D<T,Descriptor>()),
-      backgroundDynamics(backgroundDynamics_)
+      backgroundDynamics(backgroundDynamics_),
+      aaOddStep(false)
 {
     plint nx = this->getNx();
     plint ny = this->getNy();
@@ -104,7 +107,8 @@ template<typename T, template<typename U> class Descriptor>
 BlockLattice3D<T,Descriptor>::BlockLattice3D(BlockLattice3D<T,Descriptor> const& rhs)
     : BlockLatticeBase3D<T,Descriptor>(rhs),
       AtomicBlock3D(rhs),
-      backgroundDynamics(rhs.backgroundDynamics->clone())
+      backgroundDynamics(rhs.backgroundDynamics->clone()),
+      aaOddStep(rhs.aaOddStep)
 {
     plint nx = this->getNx();
     plint ny = this->getNy();
@@ -156,6 +160,7 @@ void BlockLattice3D<T,Descriptor>::swap(BlockLattice3D& rhs) {
     std::swap(backgroundDynamics, rhs.backgroundDynamics);
     std::swap(rawData, rhs.rawData);
     std::swap(grid, rhs.grid);
+    std::swap(aaOddStep, rhs.aaOddStep);
     global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
 }
 
@@ -315,6 +320,200 @@ void BlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
     global::profiler().stop("collStream");
 }
 
+/** The union of collideAndStreamShell(domain,interior) and
+ * collideAndStreamInterior(domain,interior) is equivalent to
+ * collideAndStream(domain): every cell is collided before any of its
+ * populations is swapped with a neighbor, and every pair of neighbors is
+ * swapped exactly once.
+ */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::collideAndStreamShell(Box3D domain, Box3D interior) {
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    global::profiler().start("collStream");
+    std::vector<Box3D> shell;
+    except(domain, interior, shell);
+    for (pluint iBox=0; iBox<shell.size(); ++iBox) {
+        global::profiler().increment("collStreamCells", shell[iBox].nCells());
+        collide(shell[iBox]);
+    }
+    for (pluint iBox=0; iBox<shell.size(); ++iBox) {
+        partialStream(domain, interior, shell[iBox], false);
+    }
+    global::profiler().stop("collStream");
+}
+
+/** \sa collideAndStreamShell(Box3D,Box3D) */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::collideAndStreamInterior(Box3D domain, Box3D interior) {
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    Box3D inters;
+    if (!intersect(domain, interior, inters)) {
+        return;
+    }
+    interior = inters;
+    global::profiler().start("collStream");
+    global::profiler().increment("collStreamCells", interior.nCells());
+
+    static const plint vicinity = Descriptor<T>::vicinity;
+    Box3D bulk(interior.enlarge(-vicinity));
+
+    // The rim of the interior is collided first, because its neighbors
+    //   are accessed by the swaps of the bulk algorithm.
+    std::vector<Box3D> rim;
+    except(interior, bulk, rim);
+    for (pluint iBox=0; iBox<rim.size(); ++iBox) {
+        collide(rim[iBox]);
+    }
+    if (bulk.x1>=bulk.x0 && bulk.y1>=bulk.y0 && bulk.z1>=bulk.z0) {
+        bulkCollideAndStream(bulk);
+    }
+
+    // The remaining pairs are those which start on the rim, or on the
+    //   shell cells adjacent to the interior.
+    Box3D layer;
+    intersect(domain, interior.enlarge(vicinity), layer);
+    std::vector<Box3D> layerBoxes;
+    except(layer, bulk, layerBoxes);
+    for (pluint iBox=0; iBox<layerBoxes.size(); ++iBox) {
+        partialStream(domain, interior, layerBoxes[iBox], true);
+    }
+    global::profiler().stop("collStream");
+}
+
+/** The even step is an in-place collision, followed by a revert of the
+ * populations (like collide(domain)). The odd step reads, for each cell, the
+ * incoming populations from the opposite slots of its neighbors, collides, and
+ * writes the outgoing populations into the slots of its neighbors from which
+ * they are read at the next even step. Every slot is read and written by a
+ * single cell, which makes the odd step safe in place.
+ */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::collideAndStreamAA(Box3D domain) {
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    global::profiler().start("collStream");
+    global::profiler().increment("collStreamCells", domain.nCells());
+    if (!aaOddStep) {
+        collide(domain);
+    }
+    else {
+        static const plint vicinity = Descriptor<T>::vicinity;
+        Box3D bulk(domain.enlarge(-vicinity));
+        std::vector<Box3D> rim;
+        except(domain, bulk, rim);
+        for (pluint iBox=0; iBox<rim.size(); ++iBox) {
+            boundaryOddStepAA(domain, rim[iBox]);
+        }
+        if (bulk.x1>=bulk.x0 && bulk.y1>=bulk.y0 && bulk.z1>=bulk.z0) {
+            bulkOddStepAA(bulk);
+        }
+    }
+    aaOddStep = !aaOddStep;
+    global::profiler().stop("collStream");
+}
+
+/** After an even step, the streaming which is pending is exactly the one
+ * of the swap algorithm, boundaryStream(domain,domain).
+ */
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::restoreNaturalLayoutAA(Box3D domain) {
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+    if (aaOddStep) {
+        boundaryStream(domain, domain);
+        aaOddStep = false;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+T& BlockLattice3D<T,Descriptor>::getPopulationAA(plint iX, plint iY, plint iZ, plint iPop) {
+    PLB_PRECONDITION( contained(iX,iY,iZ, this->getBoundingBox()) );
+    if (aaOddStep) {
+        plint prevX = iX - Descriptor<T>::c[iPop][0];
+        plint prevY = iY - Descriptor<T>::c[iPop][1];
+        plint prevZ = iZ - Descriptor<T>::c[iPop][2];
+        if (contained(prevX,prevY,prevZ, this->getBoundingBox())) {
+            return grid[prevX][prevY][prevZ][indexTemplates::opposite<Descriptor<T> >(iPop)];
+        }
+    }
+    return grid[iX][iY][iZ][iPop];
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::boundaryOddStepAA(Box3D bound, Box3D domain) {
+    PLB_PRECONDITION( contained(bound, this->getBoundingBox()) );
+    PLB_PRECONDITION( contained(domain, bound) );
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Cell<T,Descriptor>& original = grid[iX][iY][iZ];
+                Cell<T,Descriptor> cell(original);
+                // Pull: a population which would enter from outside "bound" is
+                //   the one which was bounced back by the previous even step.
+                for (plint iPop=0; iPop<Descriptor<T>::q; ++iPop) {
+                    plint prevX = iX - Descriptor<T>::c[iPop][0];
+                    plint prevY = iY - Descriptor<T>::c[iPop][1];
+                    plint prevZ = iZ - Descriptor<T>::c[iPop][2];
+                    if (contained(prevX,prevY,prevZ, bound)) {
+                        cell[iPop] = grid[prevX][prevY][prevZ][indexTemplates::opposite<Descriptor<T> >(iPop)];
+                    }
+                }
+                cell.collide(this->getInternalStatistics());
+                // Push: a population which would leave "bound" is bounced back.
+                for (plint iPop=0; iPop<Descriptor<T>::q; ++iPop) {
+                    plint nextX = iX + Descriptor<T>::c[iPop][0];
+                    plint nextY = iY + Descriptor<T>::c[iPop][1];
+                    plint nextZ = iZ + Descriptor<T>::c[iPop][2];
+                    if (contained(nextX,nextY,nextZ, bound)) {
+                        grid[nextX][nextY][nextZ][iPop] = cell[iPop];
+                    }
+                    else {
+                        original[indexTemplates::opposite<Descriptor<T> >(iPop)] = cell[iPop];
+                    }
+                }
+                for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+                    *original.getExternal(iExt) = *cell.getExternal(iExt);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::bulkOddStepAA(Box3D domain) {
+    PLB_PRECONDITION( contained(domain.enlarge(Descriptor<T>::vicinity), this->getBoundingBox()) );
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Cell<T,Descriptor>& original = grid[iX][iY][iZ];
+                Cell<T,Descriptor> cell(original);
+                for (plint iPop=1; iPop<=Descriptor<T>::q/2; ++iPop) {
+                    plint dX = Descriptor<T>::c[iPop][0];
+                    plint dY = Descriptor<T>::c[iPop][1];
+                    plint dZ = Descriptor<T>::c[iPop][2];
+                    cell[iPop] = grid[iX-dX][iY-dY][iZ-dZ][iPop+Descriptor<T>::q/2];
+                    cell[iPop+Descriptor<T>::q/2] = grid[iX+dX][iY+dY][iZ+dZ][iPop];
+                }
+                cell.collide(this->getInternalStatistics());
+                original[0] = cell[0];
+                for (plint iPop=1; iPop<=Descriptor<T>::q/2; ++iPop) {
+                    plint dX = Descriptor<T>::c[iPop][0];
+                    plint dY = Descriptor<T>::c[iPop][1];
+                    plint dZ = Descriptor<T>::c[iPop][2];
+                    grid[iX+dX][iY+dY][iZ+dZ][iPop] = cell[iPop];
+                    grid[iX-dX][iY-dY][iZ-dZ][iPop+Descriptor<T>::q/2] = cell[iPop+Descriptor<T>::q/2];
+                }
+                for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+                    *original.getExternal(iExt) = *cell.getExternal(iExt);
+                }
+            }
+        }
+    }
+}
+
 /** At the end of this method, finalizeIteration() and
  * executeInternalProcessors() are automatically invoked.
  * \sa collideAndStream(int,int,int,int,int,int) */
@@ -444,6 +643,33 @@ void BlockLattice3D<T,Descriptor>::boundaryStream(Box3D bound, Box3D domain) {
     }
 }
 
+template<typename T, template<typename U> class Descriptor>
+void BlockLattice3D<T,Descriptor>::partialStream (
+        Box3D bound, Box3D interior, Box3D domain, bool interiorPairs )
+{
+    PLB_PRECONDITION( contained(bound, this->getBoundingBox()) );
+    PLB_PRECONDITION( contained(domain, bound) );
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                bool cellInInterior = contained(iX,iY,iZ, interior);
+                for (plint iPop=1; iPop<=Descriptor<T>::q/2; ++iPop) {
+                    plint nextX = iX + Descriptor<T>::c[iPop][0];
+                    plint nextY = iY + Descriptor<T>::c[iPop][1];
+                    plint nextZ = iZ + Descriptor<T>::c[iPop][2];
+                    if ( contained(nextX,nextY,nextZ, bound) &&
+                         (cellInInterior || contained(nextX,nextY,nextZ, interior)) == interiorPairs )
+                    {
+                        std::swap(grid[iX][iY][iZ][iPop+Descriptor<T>::q/2],
+                                  grid[nextX][nextY][nextZ][iPop]);
+                    }
+                }
+            }
+        }
+    }
+}
+
 /** This method is faster than boundaryStream(int,int,int,int,int,int), but it
  * is erroneous when applied to boundary cells.
  * \sa stream(int,int,int,int,int,int)
@@ -479,20 +705,27 @@ void BlockLattice3D<T,Descriptor>::bulkCollideAndStream(Box3D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
-    // if (Descriptor<T>::q==15 || Descriptor<T>::q==19) {
-    if (Descriptor<T>::q==19) {
-        // On nearest-neighbor lattice, use the cache-efficient
-        //   version of collidAndStream.
-        blockwiseBulkCollideAndStream(domain);
+    // Use the cache-efficient version of collideAndStream, which works
+    //   for nearest-neighbor and extended lattices alike. If the domain
+    //   is dominated by a registered dynamics class, its collision step
+    //   is inlined.
+    typename SpecializedCollideAndStreamRegistry3D<T,Descriptor>::Kernel kernel =
+        specializedCollideAndStreamRegistry3D<T,Descriptor>().choose(*this, domain);
+    if (kernel) {
+        (this->*kernel)(domain);
     }
     else {
-        // Otherwise, use the straightforward implementation.
-        //   Note that at some point, we should implement the cache-efficient
-        //   version for extended lattices as well.
-        linearBulkCollideAndStream(domain);
+        blockwiseBulkCollideAndStream(domain);
     }
 }
 
+template<typename T, template<typename U> class Descriptor>
+template<class DynamicsType>
+void BlockLattice3D<T,Descriptor>::specializedBulkCollideAndStream(Box3D domain) {
+    blockwiseBulkCollideAndStreamImplementation <
+        SpecializedCollision3D<T,Descriptor,DynamicsType> > (domain);
+}
+
 
 /** Straightforward implementation which works for all kinds of lattices,
  *  not only nearest-neighbor.
@@ -514,21 +747,33 @@ void BlockLattice3D<T,Descriptor>::linearBulkCollideAndStream(Box3D domain) {
 
 
 /** Sophisticated implementation which improves cache usage through block-wise
- *  loops. For now, this works only with nearest-neighbor lattices. On extended
- *  lattices, the naive version "linearBulkCollideAndStream" is used.
+ *  loops. The tiles are skewed according to the lattice velocities, in such a way
+ *  that a cell is only swapped with neighbors which are already collided. The tile
+ *  size is taken from cachePolicy().
  */
 template<typename T, template<typename U> class Descriptor>
 void BlockLattice3D<T,Descriptor>::blockwiseBulkCollideAndStream(Box3D domain) {
+    blockwiseBulkCollideAndStreamImplementation<GenericCollision3D<T,Descriptor> >(domain);
+}
+
+template<typename T, template<typename U> class Descriptor>
+template<class Collision>
+void BlockLattice3D<T,Descriptor>::blockwiseBulkCollideAndStreamImplementation(Box3D domain) {
     // Make sure domain is contained within current lattice
     PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
 
+    plint skewY, skewZx, skewZy;
+    indexTemplates::streamingSkew3D<Descriptor<T> >(skewY, skewZx, skewZy);
+
     // For cache efficiency, memory is traversed block-wise. The three outer loops enumerate
     //   the blocks, whereas the three inner loops enumerate the cells inside each block.
     const plint blockSize = cachePolicy().getBlockSize();
     // Outer loops.
     for (plint outerX=domain.x0; outerX<=domain.x1; outerX+=blockSize) {
-        for (plint outerY=domain.y0; outerY<=domain.y1+blockSize-1; outerY+=blockSize) {
-            for (plint outerZ=domain.z0; outerZ<=domain.z1+2*(blockSize-1); outerZ+=blockSize) {
+        for (plint outerY=domain.y0; outerY<=domain.y1+skewY*(blockSize-1); outerY+=blockSize) {
+            for (plint outerZ=domain.z0;
+                 outerZ<=domain.z1+(skewZx+skewZy)*(blockSize-1); outerZ+=blockSize)
+            {
                 // Inner loops.
                 plint dx = 0;
                 for (plint innerX=outerX;
@@ -538,25 +783,25 @@ void BlockLattice3D<T,Descriptor>::blockwiseBulkCollideAndStream(Box3D domain) {
                     // Y-index is shifted in negative direction at each x-increment. to ensure
                     //   that only post-collision cells are accessed during the swap-operation
                     //   of the streaming.
-                    plint minY = outerY-dx;
+                    plint minY = outerY-skewY*dx;
                     plint maxY = minY+blockSize-1;
-                    plint dy = 0;
                     for (plint innerY=std::max(minY,domain.y0);
                          innerY <= std::min(maxY, domain.y1);
-                         ++innerY, ++dy)
+                         ++innerY)
                     {
                         // Z-index is shifted in negative direction at each x-increment. and at each
                         //    y-increment, to ensure that only post-collision cells are accessed during
                         //    the swap-operation of the streaming.
-                        plint minZ = outerZ-dx-dy;
+                        plint dy = innerY-minY;
+                        plint minZ = outerZ-skewZx*dx-skewZy*dy;
                         plint maxZ = minZ+blockSize-1;
                         for (plint innerZ=std::max(minZ,domain.z0);
                              innerZ <= std::min(maxZ, domain.z1);
                              ++innerZ)
                         {
                             // Collide the cell.
-                            grid[innerX][innerY][innerZ].collide (
-                                    this->getInternalStatistics() );
+                            Collision::collide( grid[innerX][innerY][innerZ],
+                                                this->getInternalStatistics() );
                             // Swap the populations on the cell, and then with post-collision
                             //   neighboring cell, to perform the streaming step.
                             latticeTemplates<T,Descriptor>::swapAndStream3D (
@@ -707,23 +952,136 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::send_static (
         Box3D domain, std::vector<char>& buffer ) const
 {
     PLB_PRECONDITION( constLattice );
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
     // Avoid dereferencing uninitialized pointer.
     if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::sendStatic (
+        Box3D domain, char* buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    PLB_PRECONDITION(contained(domain, constLattice->getBoundingBox()));
+    plint cellSize = staticCellSize();
 
     plint iData=0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                constLattice->get(iX,iY,iZ).serialize(&buffer[iData]);
+                constLattice->get(iX,iY,iZ).serialize(buffer+iData);
                 iData += cellSize;
             }
         }
     }
 }
 
+/** The list depends only on the geometry and on the lattice descriptor, so that
+ *  the sender and the recipient of a message compute the same list.
+ */
+template<typename T, template<typename U> class Descriptor>
+bool BlockLatticeDataTransfer3D<T,Descriptor>::getStreamedPopulations (
+        Box3D domain, Box3D bound, std::vector<plint>& populations, plint& numBytes ) const
+{
+    populations.clear();
+    plint numPopulations = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                pluint countPos = populations.size();
+                populations.push_back(0);
+                for (plint iPop=0; iPop<Descriptor<T>::q; ++iPop) {
+                    plint prevX = iX - Descriptor<T>::c[iPop][0];
+                    plint prevY = iY - Descriptor<T>::c[iPop][1];
+                    plint prevZ = iZ - Descriptor<T>::c[iPop][2];
+                    if (!contained(prevX,prevY,prevZ, bound)) {
+                        populations.push_back(iPop);
+                        ++populations[countPos];
+                        ++numPopulations;
+                    }
+                }
+            }
+        }
+    }
+    numBytes = numPopulations*(plint)sizeof(T);
+    return true;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::sendPopulations (
+        Box3D domain, std::vector<plint> const& populations, char* buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    PLB_PRECONDITION(contained(domain, constLattice->getBoundingBox()));
+    T* data = reinterpret_cast<T*>(buffer);
+    pluint iList = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Cell<T,Descriptor> const& cell = constLattice->get(iX,iY,iZ);
+                plint numPopulations = populations[iList++];
+                for (plint i=0; i<numPopulations; ++i) {
+                    *data++ = cell[populations[iList++]];
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::receivePopulations (
+        Box3D domain, std::vector<plint> const& populations, char const* buffer )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(domain, lattice->getBoundingBox()));
+    T const* data = reinterpret_cast<T const*>(buffer);
+    pluint iList = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Cell<T,Descriptor>& cell = lattice->get(iX,iY,iZ);
+                plint numPopulations = populations[iList++];
+                for (plint i=0; i<numPopulations; ++i) {
+                    cell[populations[iList++]] = *data++;
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::attributePopulations (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        AtomicBlock3D const& from, std::vector<plint> const& populations )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(toDomain, lattice->getBoundingBox()));
+    BlockLattice3D<T,Descriptor> const* fromPtr =
+        dynamic_cast<BlockLattice3D<T,Descriptor> const*>(&from);
+    if (!fromPtr) {
+        // Different memory layout: the full static content is a valid superset.
+        attribute(toDomain, deltaX, deltaY, deltaZ, from, modif::staticVariables);
+        return;
+    }
+    BlockLattice3D<T,Descriptor> const& fromLattice = *fromPtr;
+    pluint iList = 0;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                Cell<T,Descriptor>& cell = lattice->get(iX,iY,iZ);
+                Cell<T,Descriptor> const& fromCell = fromLattice.get(iX+deltaX,iY+deltaY,iZ+deltaZ);
+                plint numPopulations = populations[iList++];
+                for (plint i=0; i<numPopulations; ++i) {
+                    plint iPop = populations[iList++];
+                    cell[iPop] = fromCell[iPop];
+                }
+            }
+        }
+    }
+}
+
 template<typename T, template<typename U> class Descriptor>
 void BlockLatticeDataTransfer3D<T,Descriptor>::send_dynamic (
         Box3D domain, std::vector<char>& buffer ) const
@@ -803,13 +1161,22 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::receive_static (
     PLB_PRECONDITION( (plint) buffer.size() == domain.nCells()*staticCellSize() );
     // Avoid dereferencing uninitialized pointer.
     if (buffer.empty()) return;
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
+
+template<typename T, template<typename U> class Descriptor>
+void BlockLatticeDataTransfer3D<T,Descriptor>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(domain, lattice->getBoundingBox()));
     plint cellSize = staticCellSize();
 
     plint iData=0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                lattice->get(iX,iY,iZ).unSerialize(&buffer[iData]);
+                lattice->get(iX,iY,iZ).unSerialize(buffer+iData);
                 iData += cellSize;
             }
         }
@@ -895,9 +1262,23 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::attribute (
         AtomicBlock3D const& from, modif::ModifT kind )
 {
     PLB_PRECONDITION( lattice );
-    PLB_PRECONDITION (typeid(from) == typeid(BlockLattice3D<T,Descriptor> const&));
     PLB_PRECONDITION(contained(toDomain, lattice->getBoundingBox()));
-    BlockLattice3D<T,Descriptor> const& fromLattice = (BlockLattice3D<T,Descriptor> const&) from;
+    BlockLattice3D<T,Descriptor> const* fromPtr =
+        dynamic_cast<BlockLattice3D<T,Descriptor> const*>(&from);
+    if (!fromPtr) {
+        // The source has a different memory layout (e.g. SoaBlockLattice3D), and
+        //   must have the same byte-stream format. This is not the case if it
+        //   stores the populations with a different type.
+        if (from.getDataTransfer().staticCellSize() != staticCellSize()) {
+            plbLogicError( "BlockLatticeDataTransfer3D::attribute: the source block stores its cells with a "
+                           "different size; use convert() to copy between storage types." );
+        }
+        std::vector<char> buffer;
+        from.getDataTransfer().send(toDomain.shift(deltaX,deltaY,deltaZ), buffer, kind);
+        receive(toDomain, buffer, kind);
+        return;
+    }
+    BlockLattice3D<T,Descriptor> const& fromLattice = *fromPtr;
     switch(kind) {
         case modif::staticVariables:
             attribute_static(toDomain, deltaX, deltaY, deltaZ, fromLattice); break;
@@ -1007,7 +1388,10 @@ void BlockLatticeDataTransfer3D<T,Descriptor>::attribute_regenerate (
 
 template<typename T, template<typename U> class Descriptor>
 CachePolicy3D& BlockLattice3D<T,Descriptor>::cachePolicy() {
-    static CachePolicy3D cachePolicySingleton(30);
+    // The default tile size is 30 for D3Q19, and is adapted to other lattices
+    //   in such a way that the tiles occupy the same amount of memory.
+    static CachePolicy3D cachePolicySingleton (
+            (plint) (30.*std::pow(19./(double)Descriptor<T>::q, 1./3.) + 0.5) );
     return cachePolicySingleton;
 }
 
@@ -61,6 +61,10 @@ public:
     {
         receive(domain, buffer, kind);
     }
+    /// Copy the data directly into "buffer".
+    virtual void sendStatic(Box3D domain, char* buffer) const;
+    /// Copy the data directly from "buffer".
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
     /// Attribute data between two blocks.
     virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
                            AtomicBlock3D const& from, modif::ModifT kind);
@@ -140,6 +144,10 @@ public:
     {
         receive(domain, buffer, kind);
     }
+    /// Copy the data directly into "buffer".
+    virtual void sendStatic(Box3D domain, char* buffer) const;
+    /// Copy the data directly from "buffer".
+    virtual void receiveStatic(Box3D domain, char const* buffer, Dot3D absoluteOffset);
     /// Attribute data between two blocks.
     virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
                            AtomicBlock3D const& from, modif::ModifT kind);
@@ -176,17 +176,23 @@ void ScalarFieldDataTransfer3D<T>::send(Box3D domain, std::vector<char>& buffer,
 {
     PLB_PRECONDITION( constField );
     PLB_PRECONDITION( contained(domain, constField->getBoundingBox()) );
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
     // Avoid dereferencing uninitialized pointer.
     if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
 
+template<typename T>
+void ScalarFieldDataTransfer3D<T>::sendStatic(Box3D domain, char* buffer) const
+{
+    PLB_PRECONDITION( constField );
+    PLB_PRECONDITION( contained(domain, constField->getBoundingBox()) );
     plint iData=0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&buffer[iData]), (const void*)(&constField->get(iX,iY,iZ)), sizeof(T));
+                memcpy((void*)(buffer+iData), (const void*)(&constField->get(iX,iY,iZ)), sizeof(T));
                 iData += sizeof(T);
             }
         }
@@ -198,16 +204,24 @@ void ScalarFieldDataTransfer3D<T>::receive (
         Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
 {
     PLB_PRECONDITION( field );
-    PLB_PRECONDITION( contained(domain, field->getBoundingBox()) );
     PLB_PRECONDITION( domain.nCells()*staticCellSize() == (plint)buffer.size() );
 
     // Avoid dereferencing uninitialized pointer.
     if (buffer.empty()) return;
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
+
+template<typename T>
+void ScalarFieldDataTransfer3D<T>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION( field );
+    PLB_PRECONDITION( contained(domain, field->getBoundingBox()) );
     plint iData=0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&field->get(iX,iY,iZ)), (const void*)(&buffer[iData]), sizeof(T));
+                memcpy((void*)(&field->get(iX,iY,iZ)), (const void*)(buffer+iData), sizeof(T));
                 iData += sizeof(T);
             }
         }
@@ -392,17 +406,23 @@ void TensorFieldDataTransfer3D<T,nDim>::send(Box3D domain, std::vector<char>& bu
 {
     PLB_PRECONDITION( constField );
     PLB_PRECONDITION( contained(domain, constField->getBoundingBox()) );
-    plint cellSize = staticCellSize();
-    pluint numBytes = domain.nCells()*cellSize;
+    pluint numBytes = domain.nCells()*staticCellSize();
     // Avoid dereferencing uninitialized pointer.
     if (numBytes==0) return;
     buffer.resize(numBytes);
+    sendStatic(domain, &buffer[0]);
+}
 
+template<typename T, int nDim>
+void TensorFieldDataTransfer3D<T,nDim>::sendStatic(Box3D domain, char* buffer) const
+{
+    PLB_PRECONDITION( constField );
+    PLB_PRECONDITION( contained(domain, constField->getBoundingBox()) );
     plint iData=0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&buffer[iData]), (const void*)(&constField->get(iX,iY,iZ)[0]), nDim*sizeof(T));
+                memcpy((void*)(buffer+iData), (const void*)(&constField->get(iX,iY,iZ)[0]), nDim*sizeof(T));
                 iData += nDim*sizeof(T);
             }
         }
@@ -414,16 +434,24 @@ void TensorFieldDataTransfer3D<T,nDim>::receive (
         Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
 {
     PLB_PRECONDITION( field );
-    PLB_PRECONDITION( contained(domain, field->getBoundingBox()) );
     PLB_PRECONDITION( domain.nCells()*staticCellSize() == (plint)buffer.size() );
 
     // Avoid dereferencing uninitialized pointer.
     if (buffer.empty()) return;
+    receiveStatic(domain, &buffer[0], Dot3D());
+}
+
+template<typename T, int nDim>
+void TensorFieldDataTransfer3D<T,nDim>::receiveStatic (
+        Box3D domain, char const* buffer, Dot3D absoluteOffset )
+{
+    PLB_PRECONDITION( field );
+    PLB_PRECONDITION( contained(domain, field->getBoundingBox()) );
     plint iData=0;
     for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
         for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
             for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
-                memcpy((void*)(&field->get(iX,iY,iZ)[0]), (const void*)(&buffer[iData]), nDim*sizeof(T));
+                memcpy((void*)(&field->get(iX,iY,iZ)[0]), (const void*)(buffer+iData), nDim*sizeof(T));
                 iData += nDim*sizeof(T);
             }
         }
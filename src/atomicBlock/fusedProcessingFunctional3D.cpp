@@ -0,0 +1,160 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Fusion of point-wise data processing functionals into a single traversal -- implementation.
+ */
+#include "atomicBlock/fusedProcessingFunctional3D.h"
+#include "atomicBlock/atomicBlock3D.h"
+#include "core/plbDebug.h"
+#include <algorithm>
+
+namespace plb {
+
+FusedProcessingFunctional3D::FusedProcessingFunctional3D(plint tileSize_)
+    : tileSize(tileSize_)
+{
+    PLB_PRECONDITION( tileSize>0 );
+}
+
+FusedProcessingFunctional3D::FusedProcessingFunctional3D(FusedProcessingFunctional3D const& rhs)
+    : BoxProcessingFunctional3D(rhs),
+      tileSize(rhs.tileSize),
+      functionals(rhs.functionals.size()),
+      functionalBlockIds(rhs.functionalBlockIds)
+{
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        functionals[iFunctional] = rhs.functionals[iFunctional]->clone();
+    }
+}
+
+FusedProcessingFunctional3D& FusedProcessingFunctional3D::operator= (
+        FusedProcessingFunctional3D const& rhs )
+{
+    BoxProcessingFunctional3D::operator=(rhs);
+    FusedProcessingFunctional3D(rhs).swap(*this);
+    return *this;
+}
+
+/** Swaps the functionals only; the scale factors of the base class are not exchanged. **/
+void FusedProcessingFunctional3D::swap(FusedProcessingFunctional3D& rhs) {
+    std::swap(tileSize, rhs.tileSize);
+    functionals.swap(rhs.functionals);
+    functionalBlockIds.swap(rhs.functionalBlockIds);
+}
+
+FusedProcessingFunctional3D::~FusedProcessingFunctional3D() {
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        delete functionals[iFunctional];
+    }
+}
+
+void FusedProcessingFunctional3D::addFunctional (
+        BoxProcessingFunctional3D* functional, std::vector<plint> const& blockIds )
+{
+    PLB_PRECONDITION( !blockIds.empty() );
+    PLB_PRECONDITION( functionals.empty() || functional->appliesTo()==functionals[0]->appliesTo() );
+    functionals.push_back(functional);
+    functionalBlockIds.push_back(blockIds);
+}
+
+plint FusedProcessingFunctional3D::getNumFunctionals() const {
+    return (plint)functionals.size();
+}
+
+void FusedProcessingFunctional3D::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks )
+{
+    // Arguments and domain shift of each functional: the domain of a functional
+    //   is expressed in the coordinates of its first atomic-block.
+    std::vector<std::vector<AtomicBlock3D*> > arguments(functionals.size());
+    std::vector<Dot3D> shifts(functionals.size());
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        std::vector<plint> const& blockIds = functionalBlockIds[iFunctional];
+        arguments[iFunctional].resize(blockIds.size());
+        for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+            PLB_ASSERT( blockIds[iBlock]>=0 && blockIds[iBlock]<(plint)atomicBlocks.size() );
+            arguments[iFunctional][iBlock] = atomicBlocks[blockIds[iBlock]];
+        }
+        shifts[iFunctional] = computeRelativeDisplacement(*atomicBlocks[0], *arguments[iFunctional][0]);
+    }
+
+    for (plint x0=domain.x0; x0<=domain.x1; x0+=tileSize) {
+        plint x1 = std::min(x0+tileSize-1, domain.x1);
+        for (plint y0=domain.y0; y0<=domain.y1; y0+=tileSize) {
+            plint y1 = std::min(y0+tileSize-1, domain.y1);
+            for (plint z0=domain.z0; z0<=domain.z1; z0+=tileSize) {
+                plint z1 = std::min(z0+tileSize-1, domain.z1);
+                Box3D tile(x0,x1, y0,y1, z0,z1);
+                for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+                    functionals[iFunctional]->processGenericBlocks (
+                            tile.shift(shifts[iFunctional].x, shifts[iFunctional].y, shifts[iFunctional].z),
+                            arguments[iFunctional] );
+                }
+            }
+        }
+    }
+}
+
+BlockDomain::DomainT FusedProcessingFunctional3D::appliesTo() const {
+    if (functionals.empty()) {
+        return BlockDomain::bulk;
+    }
+    return functionals[0]->appliesTo();
+}
+
+void FusedProcessingFunctional3D::rescale(double dxScale, double dtScale) {
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        functionals[iFunctional]->rescale(dxScale, dtScale);
+    }
+}
+
+void FusedProcessingFunctional3D::setscale(int dxScale_, int dtScale_) {
+    BoxProcessingFunctional3D::setscale(dxScale_, dtScale_);
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        functionals[iFunctional]->setscale(dxScale_, dtScale_);
+    }
+}
+
+void FusedProcessingFunctional3D::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    for (pluint iBlock=0; iBlock<modified.size(); ++iBlock) {
+        modified[iBlock] = modif::nothing;
+    }
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        std::vector<plint> const& blockIds = functionalBlockIds[iFunctional];
+        std::vector<modif::ModifT> functionalModified(blockIds.size(), modif::nothing);
+        functionals[iFunctional]->getTypeOfModification(functionalModified);
+        for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+            PLB_ASSERT( blockIds[iBlock]<(plint)modified.size() );
+            modified[blockIds[iBlock]] = combine(modified[blockIds[iBlock]], functionalModified[iBlock]);
+        }
+    }
+}
+
+FusedProcessingFunctional3D* FusedProcessingFunctional3D::clone() const {
+    return new FusedProcessingFunctional3D(*this);
+}
+
+}  // namespace plb
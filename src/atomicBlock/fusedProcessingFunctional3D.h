@@ -0,0 +1,77 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Fusion of point-wise data processing functionals into a single traversal -- header file.
+ */
+#ifndef FUSED_PROCESSING_FUNCTIONAL_3D_H
+#define FUSED_PROCESSING_FUNCTIONAL_3D_H
+
+#include "core/globalDefs.h"
+#include "core/geometry3D.h"
+#include "atomicBlock/dataProcessingFunctional3D.h"
+#include <vector>
+
+namespace plb {
+
+/// Executes a sequence of boxed functionals in a single traversal of their common domain.
+/** The domain is cut into tiles of tileSize^3 cells, and all functionals are executed
+ *  on one tile before the next tile is treated. This way, the data of a tile is read
+ *  from memory once instead of once per functional. The result is the same as with
+ *  separate functionals only if each functional is point-wise with respect to the data
+ *  written by the previous ones: a functional may read neighboring cells only in
+ *  atomic-blocks which are not modified within the group.
+ *
+ *  Each functional acts on a subset of the atomic-blocks of the fused functional,
+ *  specified by their position in the argument list. All functionals must apply
+ *  to the same type of domain (see appliesTo()).
+ */
+class FusedProcessingFunctional3D : public BoxProcessingFunctional3D {
+public:
+    FusedProcessingFunctional3D(plint tileSize_=16);
+    FusedProcessingFunctional3D(FusedProcessingFunctional3D const& rhs);
+    FusedProcessingFunctional3D& operator=(FusedProcessingFunctional3D const& rhs);
+    void swap(FusedProcessingFunctional3D& rhs);
+    virtual ~FusedProcessingFunctional3D();
+    /// Append a functional, which takes ownership of it. The argument blockIds
+    ///   lists the positions of its atomic-blocks in the argument list of the
+    ///   fused functional.
+    void addFunctional(BoxProcessingFunctional3D* functional, std::vector<plint> const& blockIds);
+    plint getNumFunctionals() const;
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks);
+    virtual BlockDomain::DomainT appliesTo() const;
+    virtual void rescale(double dxScale, double dtScale);
+    virtual void setscale(int dxScale_, int dtScale_);
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual FusedProcessingFunctional3D* clone() const;
+private:
+    plint tileSize;
+    std::vector<BoxProcessingFunctional3D*> functionals;
+    std::vector<std::vector<plint> > functionalBlockIds;
+};
+
+}  // namespace plb
+
+#endif  // FUSED_PROCESSING_FUNCTIONAL_3D_H
@@ -30,6 +30,7 @@
 #include "atomicBlock/atomicContainerBlock2D.h"
 #include "atomicBlock/atomicBlockOperations2D.h"
 #include "atomicBlock/blockLattice2D.h"
+#include "atomicBlock/specializedCollideAndStream2D.h"
 #include "atomicBlock/dataField2D.h"
 #include "atomicBlock/dataProcessor2D.h"
 #include "atomicBlock/dataProcessingFunctional2D.h"
@@ -27,6 +27,7 @@
  */
 
 #include "atomicBlock/blockLattice2D.hh"
+#include "atomicBlock/specializedCollideAndStream2D.hh"
 #include "atomicBlock/dataField2D.hh"
 #include "atomicBlock/dataProcessingFunctional2D.hh"
 #include "atomicBlock/dataProcessorWrapper2D.hh"
@@ -30,9 +30,13 @@
 #include "atomicBlock/atomicContainerBlock3D.h"
 #include "atomicBlock/atomicBlockOperations3D.h"
 #include "atomicBlock/blockLattice3D.h"
+#include "atomicBlock/soaBlockLattice3D.h"
+#include "atomicBlock/sparseBlockLattice3D.h"
+#include "atomicBlock/specializedCollideAndStream3D.h"
 #include "atomicBlock/dataField3D.h"
 #include "atomicBlock/dataProcessor3D.h"
 #include "atomicBlock/dataProcessingFunctional3D.h"
+#include "atomicBlock/fusedProcessingFunctional3D.h"
 #include "atomicBlock/dataProcessorWrapper3D.h"
 #include "atomicBlock/reductiveDataProcessingFunctional3D.h"
 #include "atomicBlock/reductiveDataProcessorWrapper3D.h"
@@ -27,6 +27,9 @@
  */
 
 #include "atomicBlock/blockLattice3D.hh"
+#include "atomicBlock/soaBlockLattice3D.hh"
+#include "atomicBlock/sparseBlockLattice3D.hh"
+#include "atomicBlock/specializedCollideAndStream3D.hh"
 #include "atomicBlock/dataField3D.hh"
 #include "atomicBlock/dataProcessingFunctional3D.hh"
 #include "atomicBlock/dataProcessorWrapper3D.hh"
@@ -0,0 +1,321 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D block lattice with structure-of-arrays population storage -- header file.
+ */
+#ifndef SOA_BLOCK_LATTICE_3D_H
+#define SOA_BLOCK_LATTICE_3D_H
+
+#include "core/globalDefs.h"
+#include "core/plbDebug.h"
+#include "core/cell.h"
+#include "atomicBlock/atomicBlock3D.h"
+#include "core/blockIdentifiers.h"
+#include "core/blockStatistics.h"
+#include "latticeBoltzmann/mrtLattices.h"
+#include <vector>
+#include <map>
+
+namespace plb {
+
+template<typename T, template<typename U> class Descriptor> struct Dynamics;
+template<typename T, template<typename U> class Descriptor> class BlockLattice3D;
+template<typename T, template<typename U> class Descriptor, typename S=T> class SoaBlockLattice3D;
+
+
+/// Data transfer for the SoaBlockLattice3D.
+/** The byte-stream format is the one of BlockLatticeDataTransfer3D, except that
+ *  the populations are written in the storage type S. If S is equal to T, data
+ *  can therefore be exchanged between a SoaBlockLattice3D and a BlockLattice3D
+ *  through the usual communicators. Otherwise, the messages are smaller, and the
+ *  conversion from and to a BlockLattice3D is done by attribute() and convert().
+ */
+template<typename T, template<typename U> class Descriptor, typename S=T>
+class SoaBlockLatticeDataTransfer3D : public BlockDataTransfer3D {
+public:
+    SoaBlockLatticeDataTransfer3D();
+    virtual void setBlock(AtomicBlock3D& block);
+    virtual void setConstBlock(AtomicBlock3D const& block);
+    virtual SoaBlockLatticeDataTransfer3D<T,Descriptor,S>* clone() const;
+    virtual plint staticCellSize() const;
+    /// Send data from the lattice into a byte-stream.
+    virtual void send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const;
+    /// Receive data from a byte-stream into the lattice.
+    virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind);
+    virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind, Dot3D absoluteOffset) {
+        receive(domain, buffer, kind);
+    }
+    /// Receive data from a byte-stream into the block, and re-map IDs for dynamics if exist.
+    virtual void receive( Box3D domain, std::vector<char> const& buffer,
+                          modif::ModifT kind, std::map<int,std::string> const& foreignIds );
+    /// Attribute data between two lattices. The source can be a SoaBlockLattice3D,
+    ///   a BlockLattice3D, or any other block with a compatible byte-stream format.
+    virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                           AtomicBlock3D const& from, modif::ModifT kind);
+    virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                           AtomicBlock3D const& from, modif::ModifT kind, Dot3D absoluteOffset)
+    {
+        attribute(toDomain, deltaX, deltaY, deltaZ, from, kind);
+    }
+private:
+    void send_static(Box3D domain, std::vector<char>& buffer) const;
+    void send_dynamic(Box3D domain, std::vector<char>& buffer) const;
+    void send_all(Box3D domain, std::vector<char>& buffer) const;
+
+    void receive_static(Box3D domain, std::vector<char> const& buffer);
+    void receive_dynamic(Box3D domain, std::vector<char> const& buffer);
+    void receive_all(Box3D domain, std::vector<char> const& buffer);
+    void receive_regenerate( Box3D domain, std::vector<char> const& buffer,
+                             std::map<int,int> const& idIndirect = (std::map<int,int>()) );
+
+    void attribute_static (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        SoaBlockLattice3D<T,Descriptor,S> const& from );
+    void attribute_dynamics (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        SoaBlockLattice3D<T,Descriptor,S> const& from );
+    void attribute_block_lattice (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        BlockLattice3D<T,Descriptor> const& from, modif::ModifT kind );
+private:
+    SoaBlockLattice3D<T,Descriptor,S>* lattice;
+    SoaBlockLattice3D<T,Descriptor,S> const* constLattice;
+};
+
+/// A regular lattice which stores each population direction in its own array.
+/** Contrary to the BlockLattice3D, which stores an array of Cell objects,
+ *  the populations of the SoaBlockLattice3D are stored in q separate, aligned
+ *  arrays (structure-of-arrays layout), and the external scalars in separate
+ *  arrays as well. Instead of a Dynamics pointer, each cell holds a 32-bit
+ *  index into a table of dynamics objects, which is shared among all cells
+ *  with identical dynamics (same ID and same serialized content).
+ *
+ *  Collision and streaming are executed in a single, push-type sweep between
+ *  two population buffers, one z-pencil at a time. Runs of cells with BGK, TRT
+ *  or MRT dynamics are treated by the batched collision templates, which load
+ *  simd::Pack<T>::width neighboring cells at once from the population arrays;
+ *  all other cells are gathered into a temporary Cell and collided through the
+ *  virtual interface of their dynamics.
+ *
+ *  The two population buffers cause more memory traffic per time step than the
+ *  in-place streaming of the BlockLattice3D. With S=T=double, the lattice is
+ *  therefore only about as fast as a MultiBlockLattice3D on memory-bound runs;
+ *  the performance gain comes from a narrower storage type (see below). The
+ *  benchmark examples/benchmarks/soaLattice3d compares the two lattices.
+ *
+ *  As the dynamics objects are shared, dynamics which modify their internal
+ *  state during collision should not be used with this lattice. Data processors
+ *  which are written for the BlockLattice3D cannot be applied to this lattice;
+ *  use the conversion functions of MultiSoaBlockLattice3D instead.
+ *
+ *  The populations are stored in type S, which defaults to T. With a narrower
+ *  type, e.g. S=float and T=double, the memory footprint and the memory traffic
+ *  of the populations are halved, while the collision is still computed in type T.
+ *  As in the rest of Palabos, the stored populations are shifted by the lattice
+ *  weights (f_i - t_i), which keeps their magnitude small and preserves the
+ *  precision of the narrow type. The external scalars are stored in type T.
+ *
+ *  This class is not intended to be derived from.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+class SoaBlockLattice3D : public AtomicBlock3D
+{
+public:
+    /// Construction of an nx_ by ny_ by nz_ lattice
+    SoaBlockLattice3D(plint nx_, plint ny_, plint nz_, Dynamics<T,Descriptor>* backgroundDynamics_);
+    /// Destruction of the lattice
+    ~SoaBlockLattice3D();
+    /// Copy construction
+    SoaBlockLattice3D(SoaBlockLattice3D<T,Descriptor,S> const& rhs);
+    /// Copy assignment
+    SoaBlockLattice3D& operator=(SoaBlockLattice3D<T,Descriptor,S> const& rhs);
+    /// Swap the content of two SoaBlockLattices
+    void swap(SoaBlockLattice3D& rhs);
+public:
+    /// Read/write access to a population, in the storage type.
+    S& pop(plint iPop, plint iX, plint iY, plint iZ) {
+        PLB_PRECONDITION( iPop < Descriptor<T>::numPop );
+        return populations[iPop][index(iX,iY,iZ)];
+    }
+    /// Read-only access to a population, in the storage type.
+    S const& pop(plint iPop, plint iX, plint iY, plint iZ) const {
+        PLB_PRECONDITION( iPop < Descriptor<T>::numPop );
+        return populations[iPop][index(iX,iY,iZ)];
+    }
+    /// Read/write access to an external scalar.
+    T& external(plint iExt, plint iX, plint iY, plint iZ) {
+        PLB_PRECONDITION( iExt < Descriptor<T>::ExternalField::numScalars );
+        return externalScalars[iExt][index(iX,iY,iZ)];
+    }
+    /// Read-only access to an external scalar.
+    T const& external(plint iExt, plint iX, plint iY, plint iZ) const {
+        PLB_PRECONDITION( iExt < Descriptor<T>::ExternalField::numScalars );
+        return externalScalars[iExt][index(iX,iY,iZ)];
+    }
+    /// Copy populations, external scalars, statistics status and dynamics of a cell.
+    /** The dynamics object referred to by the cell remains owned by the lattice. */
+    void gatherCell(plint iX, plint iY, plint iZ, Cell<T,Descriptor>& cell) const;
+    /// Copy populations and external scalars from a cell (the dynamics is not copied).
+    void scatterCell(plint iX, plint iY, plint iZ, Cell<T,Descriptor> const& cell);
+    /// Get the (shared) dynamics object of a cell.
+    Dynamics<T,Descriptor> const& getDynamics(plint iX, plint iY, plint iZ) const;
+    /// Get the index of a cell in the table of dynamics objects.
+    plint getDynamicsIndex(plint iX, plint iY, plint iZ) const {
+        return dynamicsIndex[index(iX,iY,iZ)];
+    }
+    /// Number of distinct dynamics objects currently in use in the lattice.
+    plint getNumDynamics() const { return (plint)dynamicsTable.size(); }
+    /// Specify wheter statistics measurements are done on a rect. domain
+    void specifyStatisticsStatus(Box3D domain, bool status);
+    /// Tell whether statistics are taken on a cell.
+    bool takesStatistics(plint iX, plint iY, plint iZ) const {
+        return statisticsFlags[index(iX,iY,iZ)];
+    }
+    /// Apply collision step to a 3D sub-box
+    void collide(Box3D domain);
+    /// Apply collision step to the whole domain
+    void collide();
+    /// Apply first collision, then streaming step to a 3D sub-box
+    /** Populations which would leave the sub-box are bounced back, and the cells
+     *  outside the sub-box are left untouched, as in BlockLattice3D. */
+    void collideAndStream(Box3D domain);
+    /// Apply first collision, then streaming step to the whole domain, with
+    ///   periodic boundaries.
+    void collideAndStream();
+    /// Increment time counter
+    /** Warning: don't call this method manually. Instead, call incrementTime()
+     *  on the multi-block lattice. Otherwise, the internal time of the multi-block
+     *  and the atomic-blocks get out of sync.
+     **/
+    void incrementTime();
+    TimeCounter& getTimeCounter() { return timeCounter; }
+    TimeCounter const& getTimeCounter() const { return timeCounter; }
+public:
+    /// Attribute dynamics to a cell. The lattice takes ownership of the object.
+    /** If an identical dynamics object is already present in the lattice, the
+     *  new object is deleted and replaced by a reference to the existing one.
+     */
+    void attributeDynamics(plint iX, plint iY, plint iZ, Dynamics<T,Descriptor>* dynamics);
+    /// Attribute dynamics to a rectangular domain. The lattice takes ownership of the object.
+    void attributeDynamics(Box3D domain, Dynamics<T,Descriptor>* dynamics);
+    /// Get a const reference to the background dynamics
+    Dynamics<T,Descriptor> const& getBackgroundDynamics() const;
+    /// Assign the same dynamics to every cell.
+    void resetDynamics(Dynamics<T,Descriptor> const& dynamics);
+    /// Remove unused dynamics objects from the table.
+    void compactDynamicsTable();
+    /// Alignment, in bytes, of each population array.
+    static plint alignment() { return 64; }
+private:
+    /// Kinds of collision kernels which are executed without virtual function call.
+    enum KernelT { genericKernel, bgkKernel, trtKernel, mrtKernel };
+    plint index(plint iX, plint iY, plint iZ) const {
+        PLB_PRECONDITION(iX>=0 && iX<this->getNx());
+        PLB_PRECONDITION(iY>=0 && iY<this->getNy());
+        PLB_PRECONDITION(iZ>=0 && iZ<this->getNz());
+        return iZ+this->getNz()*(iY+this->getNy()*iX);
+    }
+    /// Helper method for memory allocation
+    void allocateAndInitialize();
+    /// Helper method for memory de-allocation
+    void releaseMemory();
+    plint allocatedMemory() const;
+    /// Register a dynamics object in the table, and return its index.
+    plint registerDynamics(Dynamics<T,Descriptor>* dynamics);
+    void classifyKernel(plint iDynamics);
+    void copyOutside(Box3D domain);
+    void pencilCollideAndStream(Box3D domain);
+    void genericCollide(plint iCell, Cell<T,Descriptor>& cell, Array<T,Descriptor<T>::numPop>& f);
+    void implementPeriodicity();
+private:
+    Dynamics<T,Descriptor>* backgroundDynamics;
+    std::vector<Dynamics<T,Descriptor>*> dynamicsTable;
+    std::vector<int> kernels;
+    /// Relaxation parameters of the non-virtual kernels, per dynamics object:
+    ///   omega for BGK, omega+ and omega- for TRT, and the collision matrix for MRT.
+    std::vector<std::vector<T> > kernelParameters;
+    std::map<std::vector<char>,plint> dynamicsLookup;
+    plint stride;
+    char* rawData;
+    S* populations[Descriptor<T>::numPop];
+    S* tmpPopulations[Descriptor<T>::numPop];
+    T* externalScalars[Descriptor<T>::ExternalField::numScalars+1];
+    unsigned int* dynamicsIndex;
+    bool* statisticsFlags;
+    TimeCounter timeCounter;
+    template<typename T_, template<typename U_> class Descriptor_, typename S_>
+    friend class SoaBlockLatticeDataTransfer3D;
+};
+
+/// Recognition of MRT dynamics by the SoaBlockLattice3D.
+/** MRT dynamics exist for the MRT descriptors only; for all other descriptors,
+ *  no dynamics is recognized.
+ */
+template<typename T, template<typename U> class Descriptor>
+struct SoaMrtKernel3D {
+    /// If the dynamics is MRT, compute its collision matrix and return true.
+    static bool classify(Dynamics<T,Descriptor> const& dynamics, std::vector<T>& collisionMatrix) {
+        return false;
+    }
+};
+
+template<typename T>
+struct SoaMrtKernel3D<T,descriptors::MRTD3Q19Descriptor> {
+    static bool classify(Dynamics<T,descriptors::MRTD3Q19Descriptor> const& dynamics,
+                         std::vector<T>& collisionMatrix);
+};
+
+template<typename T>
+struct SoaMrtKernel3D<T,descriptors::MRTD3Q27Descriptor> {
+    static bool classify(Dynamics<T,descriptors::MRTD3Q27Descriptor> const& dynamics,
+                         std::vector<T>& collisionMatrix);
+};
+
+/// Copy data from a BlockLattice3D into a SoaBlockLattice3D, converting the
+///   populations to the storage type.
+template<typename T, template<typename U> class Descriptor, typename S>
+void convert (
+        BlockLattice3D<T,Descriptor> const& from, Box3D fromDomain,
+        SoaBlockLattice3D<T,Descriptor,S>& to, Box3D toDomain, modif::ModifT kind );
+
+/// Copy data from a SoaBlockLattice3D into a BlockLattice3D, converting the
+///   populations from the storage type.
+template<typename T, template<typename U> class Descriptor, typename S>
+void convert (
+        SoaBlockLattice3D<T,Descriptor,S> const& from, Box3D fromDomain,
+        BlockLattice3D<T,Descriptor>& to, Box3D toDomain, modif::ModifT kind );
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageDensity(SoaBlockLattice3D<T,Descriptor,S> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageEnergy(SoaBlockLattice3D<T,Descriptor,S> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredMaxVelocity(SoaBlockLattice3D<T,Descriptor,S> const& blockLattice);
+
+}  // namespace plb
+
+#endif  // SOA_BLOCK_LATTICE_3D_H
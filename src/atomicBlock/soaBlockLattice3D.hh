@@ -0,0 +1,1170 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D block lattice with structure-of-arrays population storage -- generic implementation.
+ */
+#ifndef SOA_BLOCK_LATTICE_3D_HH
+#define SOA_BLOCK_LATTICE_3D_HH
+
+#include "atomicBlock/soaBlockLattice3D.h"
+#include "atomicBlock/blockLattice3D.h"
+#include "core/dynamics.h"
+#include "core/cell.h"
+#include "latticeBoltzmann/momentTemplates.h"
+#include "latticeBoltzmann/dynamicsTemplates.h"
+#include "latticeBoltzmann/batchedDynamicsTemplates.h"
+#include "latticeBoltzmann/indexTemplates.h"
+#include "basicDynamics/isoThermalDynamics.h"
+#include "complexDynamics/trtDynamics.h"
+#include "complexDynamics/mrtDynamics.h"
+#include "core/latticeStatistics.h"
+#include "core/dynamicsIdentifiers.h"
+#include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace plb {
+
+////////////////////// Class SoaBlockLattice3D /////////////////////////
+
+/** \param nx_ lattice width (first index)
+ *  \param ny_ lattice height (second index)
+ *  \param nz_ lattice depth (third index)
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLattice3D<T,Descriptor,S>::SoaBlockLattice3D (
+        plint nx_, plint ny_, plint nz_,
+        Dynamics<T,Descriptor>* backgroundDynamics_ )
+   :  AtomicBlock3D(nx_, ny_, nz_, new SoaBlockLatticeDataTransfer3D<T,Descriptor,S>()),
+      backgroundDynamics(backgroundDynamics_),
+      stride(0), rawData(0), dynamicsIndex(0), statisticsFlags(0)
+{
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average rho-bar
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average uSqr
+    this->getInternalStatistics().subscribeMax();     // Subscribe max uSqr
+
+    allocateAndInitialize();
+    registerDynamics(backgroundDynamics);
+    plint numCells = this->getNx()*this->getNy()*this->getNz();
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        std::fill(populations[iPop], populations[iPop]+numCells, S());
+        std::fill(tmpPopulations[iPop], tmpPopulations[iPop]+numCells, S());
+    }
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        std::fill(externalScalars[iExt], externalScalars[iExt]+numCells, T());
+    }
+    std::fill(dynamicsIndex, dynamicsIndex+numCells, 0u);
+    std::fill(statisticsFlags, statisticsFlags+numCells, true);
+
+    // Attribute default value to the standard statistics, as in BlockLattice3D.
+    std::vector<double> average, sum, max;
+    std::vector<plint> intSum;
+    average.push_back(Descriptor<double>::rhoBar(1.));
+    average.push_back(0.);
+    max.push_back(0.);
+    plint numStatCells = 1;
+    this->getInternalStatistics().evaluate (average, sum, max, intSum, numStatCells);
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLattice3D<T,Descriptor,S>::~SoaBlockLattice3D()
+{
+    global::plbCounter("MEMORY_LATTICE").increment(-allocatedMemory());
+    releaseMemory();
+}
+
+/** The whole data of the lattice is duplicated, including the dynamics
+ *  objects. The internal processors are not copied.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLattice3D<T,Descriptor,S>::SoaBlockLattice3D(SoaBlockLattice3D<T,Descriptor,S> const& rhs)
+    : AtomicBlock3D(rhs),
+      backgroundDynamics(rhs.backgroundDynamics->clone()),
+      kernels(rhs.kernels),
+      kernelParameters(rhs.kernelParameters),
+      dynamicsLookup(rhs.dynamicsLookup),
+      stride(0), rawData(0), dynamicsIndex(0), statisticsFlags(0),
+      timeCounter(rhs.timeCounter)
+{
+    allocateAndInitialize();
+    dynamicsTable.push_back(backgroundDynamics);
+    for (pluint iDyn=1; iDyn<rhs.dynamicsTable.size(); ++iDyn) {
+        dynamicsTable.push_back(rhs.dynamicsTable[iDyn]->clone());
+    }
+    plint numCells = this->getNx()*this->getNy()*this->getNz();
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        std::copy(rhs.populations[iPop], rhs.populations[iPop]+numCells, populations[iPop]);
+        std::fill(tmpPopulations[iPop], tmpPopulations[iPop]+numCells, S());
+    }
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        std::copy(rhs.externalScalars[iExt], rhs.externalScalars[iExt]+numCells, externalScalars[iExt]);
+    }
+    std::copy(rhs.dynamicsIndex, rhs.dynamicsIndex+numCells, dynamicsIndex);
+    std::copy(rhs.statisticsFlags, rhs.statisticsFlags+numCells, statisticsFlags);
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLattice3D<T,Descriptor,S>& SoaBlockLattice3D<T,Descriptor,S>::operator= (
+        SoaBlockLattice3D<T,Descriptor,S> const& rhs )
+{
+    SoaBlockLattice3D<T,Descriptor,S> tmp(rhs);
+    swap(tmp);
+    return *this;
+}
+
+/** The swap is efficient, in the sense that only pointers to the
+ * lattice are copied, and not the lattice itself.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::swap(SoaBlockLattice3D& rhs) {
+    global::plbCounter("MEMORY_LATTICE").increment(-allocatedMemory());
+    AtomicBlock3D::swap(rhs);
+    std::swap(backgroundDynamics, rhs.backgroundDynamics);
+    dynamicsTable.swap(rhs.dynamicsTable);
+    kernels.swap(rhs.kernels);
+    kernelParameters.swap(rhs.kernelParameters);
+    dynamicsLookup.swap(rhs.dynamicsLookup);
+    std::swap(stride, rhs.stride);
+    std::swap(rawData, rhs.rawData);
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        std::swap(populations[iPop], rhs.populations[iPop]);
+        std::swap(tmpPopulations[iPop], rhs.tmpPopulations[iPop]);
+    }
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        std::swap(externalScalars[iExt], rhs.externalScalars[iExt]);
+    }
+    std::swap(dynamicsIndex, rhs.dynamicsIndex);
+    std::swap(statisticsFlags, rhs.statisticsFlags);
+    std::swap(timeCounter, rhs.timeCounter);
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+/** All population arrays, the temporary population arrays used during
+ *  streaming, and the external scalars are allocated in a single chunk of
+ *  memory. Each array starts on an address which is a multiple of alignment().
+ *  The populations are stored in type S, and the external scalars in type T.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::allocateAndInitialize() {
+    static const plint numPop = Descriptor<T>::numPop;
+    static const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    plint numCells = this->getNx()*this->getNy()*this->getNz();
+    // The stride is aligned for the narrower of the two types, and therefore
+    //   for the wider one as well.
+    plint alignedSize = std::max((plint)1, alignment() / (plint)std::min(sizeof(S),sizeof(T)));
+    stride = ((numCells+alignedSize-1)/alignedSize)*alignedSize;
+
+    rawData = new char[2*numPop*stride*sizeof(S) + numExt*stride*sizeof(T) + alignment()];
+    plint misalignment = (plint)((std::size_t)rawData % (std::size_t)alignment());
+    char* data = rawData + (alignment()-misalignment)%alignment();
+    S* popData = (S*) data;
+    for (plint iPop=0; iPop<numPop; ++iPop) {
+        populations[iPop] = popData + iPop*stride;
+        tmpPopulations[iPop] = popData + (numPop+iPop)*stride;
+    }
+    T* extData = (T*) (data + 2*numPop*stride*sizeof(S));
+    for (plint iExt=0; iExt<numExt; ++iExt) {
+        externalScalars[iExt] = extData + iExt*stride;
+    }
+    externalScalars[numExt] = 0;
+    dynamicsIndex = new unsigned int[numCells];
+    statisticsFlags = new bool[numCells];
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::releaseMemory() {
+    for (pluint iDyn=0; iDyn<dynamicsTable.size(); ++iDyn) {
+        delete dynamicsTable[iDyn];
+    }
+    dynamicsTable.clear();
+    delete [] rawData;
+    delete [] dynamicsIndex;
+    delete [] statisticsFlags;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+plint SoaBlockLattice3D<T,Descriptor,S>::allocatedMemory() const {
+    plint numCells = this->getNx()*this->getNy()*this->getNz();
+    return stride*(2*Descriptor<T>::numPop*sizeof(S) + Descriptor<T>::ExternalField::numScalars*sizeof(T))
+           + numCells*(sizeof(unsigned int)+sizeof(bool));
+}
+
+/** Dynamics objects are identified by their ID and their serialized
+ *  content. If an identical object is already in the table, the new one
+ *  is deleted.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+plint SoaBlockLattice3D<T,Descriptor,S>::registerDynamics(Dynamics<T,Descriptor>* dynamics) {
+    PLB_ASSERT( dynamics );
+    std::vector<char> key;
+    serialize(*dynamics, key);
+    int id = dynamics->getId();
+    key.insert(key.end(), (char*)&id, (char*)&id+sizeof(id));
+    typename std::map<std::vector<char>,plint>::const_iterator it = dynamicsLookup.find(key);
+    if (it != dynamicsLookup.end()) {
+        if (dynamicsTable[it->second] != dynamics) {
+            delete dynamics;
+        }
+        return it->second;
+    }
+    plint iDynamics = (plint)dynamicsTable.size();
+    dynamicsTable.push_back(dynamics);
+    dynamicsLookup[key] = iDynamics;
+    kernels.push_back(genericKernel);
+    kernelParameters.push_back(std::vector<T>());
+    classifyKernel(iDynamics);
+    return iDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::classifyKernel(plint iDynamics) {
+    static const int bgkId = BGKdynamics<T,Descriptor>((T)1).getId();
+    static const int trtId = TRTdynamics<T,Descriptor>((T)1).getId();
+    Dynamics<T,Descriptor> const& dynamics = *dynamicsTable[iDynamics];
+    std::vector<T>& parameters = kernelParameters[iDynamics];
+    parameters.clear();
+    if (dynamics.getId()==bgkId) {
+        kernels[iDynamics] = bgkKernel;
+        parameters.push_back(dynamics.getOmega());
+    }
+    else if (dynamics.getId()==trtId) {
+        kernels[iDynamics] = trtKernel;
+        parameters.push_back(dynamics.getOmega());
+        parameters.push_back(TRTdynamics<T,Descriptor>::getOmegaMinus());
+    }
+    else if (SoaMrtKernel3D<T,Descriptor>::classify(dynamics, parameters)) {
+        kernels[iDynamics] = mrtKernel;
+    }
+    else {
+        kernels[iDynamics] = genericKernel;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::attributeDynamics (
+        plint iX, plint iY, plint iZ, Dynamics<T,Descriptor>* dynamics )
+{
+    dynamicsIndex[index(iX,iY,iZ)] = (unsigned int) registerDynamics(dynamics);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::attributeDynamics (
+        Box3D domain, Dynamics<T,Descriptor>* dynamics )
+{
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+    unsigned int iDynamics = (unsigned int) registerDynamics(dynamics);
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                dynamicsIndex[index(iX,iY,iZ)] = iDynamics;
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+Dynamics<T,Descriptor> const& SoaBlockLattice3D<T,Descriptor,S>::getBackgroundDynamics() const {
+    return *backgroundDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+Dynamics<T,Descriptor> const& SoaBlockLattice3D<T,Descriptor,S>::getDynamics (
+        plint iX, plint iY, plint iZ ) const
+{
+    return *dynamicsTable[dynamicsIndex[index(iX,iY,iZ)]];
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::resetDynamics(Dynamics<T,Descriptor> const& dynamics) {
+    attributeDynamics(this->getBoundingBox(), dynamics.clone());
+    compactDynamicsTable();
+}
+
+/** The background dynamics always keeps the index 0. */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::compactDynamicsTable() {
+    plint numCells = this->getNx()*this->getNy()*this->getNz();
+    std::vector<bool> used(dynamicsTable.size(), false);
+    used[0] = true;
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        used[dynamicsIndex[iCell]] = true;
+    }
+    std::vector<unsigned int> newIndex(dynamicsTable.size());
+    std::vector<Dynamics<T,Descriptor>*> newTable;
+    std::vector<int> newKernels;
+    std::vector<std::vector<T> > newKernelParameters;
+    for (pluint iDyn=0; iDyn<dynamicsTable.size(); ++iDyn) {
+        if (used[iDyn]) {
+            newIndex[iDyn] = (unsigned int) newTable.size();
+            newTable.push_back(dynamicsTable[iDyn]);
+            newKernels.push_back(kernels[iDyn]);
+            newKernelParameters.push_back(std::vector<T>());
+            newKernelParameters.back().swap(kernelParameters[iDyn]);
+        }
+        else {
+            delete dynamicsTable[iDyn];
+        }
+    }
+    for (plint iCell=0; iCell<numCells; ++iCell) {
+        dynamicsIndex[iCell] = newIndex[dynamicsIndex[iCell]];
+    }
+    typename std::map<std::vector<char>,plint>::iterator it = dynamicsLookup.begin();
+    while (it != dynamicsLookup.end()) {
+        if (used[it->second]) {
+            it->second = newIndex[it->second];
+            ++it;
+        }
+        else {
+            dynamicsLookup.erase(it++);
+        }
+    }
+    dynamicsTable.swap(newTable);
+    kernels.swap(newKernels);
+    kernelParameters.swap(newKernelParameters);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::gatherCell (
+        plint iX, plint iY, plint iZ, Cell<T,Descriptor>& cell ) const
+{
+    plint iCell = index(iX,iY,iZ);
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        cell[iPop] = populations[iPop][iCell];
+    }
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        *cell.getExternal(iExt) = externalScalars[iExt][iCell];
+    }
+    cell.specifyStatisticsStatus(statisticsFlags[iCell]);
+    cell.attributeDynamics(dynamicsTable[dynamicsIndex[iCell]]);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::scatterCell (
+        plint iX, plint iY, plint iZ, Cell<T,Descriptor> const& cell )
+{
+    plint iCell = index(iX,iY,iZ);
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        populations[iPop][iCell] = (S) cell[iPop];
+    }
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        externalScalars[iExt][iCell] = *cell.getExternal(iExt);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::specifyStatisticsStatus(Box3D domain, bool status) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                statisticsFlags[index(iX,iY,iZ)] = status;
+            }
+        }
+    }
+}
+
+/** Contrary to BlockLattice3D::collide(Box3D), the populations are left in
+ *  their natural order after the collision (they are not reverted).
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::collide(Box3D domain) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    Cell<T,Descriptor> cell;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                gatherCell(iX,iY,iZ, cell);
+                cell.collide(this->getInternalStatistics());
+                scatterCell(iX,iY,iZ, cell);
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::collide() {
+    collide(this->getBoundingBox());
+}
+
+/** The populations of the cells in the sub-box are collided and pushed into
+ *  the temporary population arrays, which are then swapped with the current
+ *  ones. Cells outside the sub-box are copied unchanged.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::collideAndStream(Box3D domain) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    global::profiler().start("collStream");
+    global::profiler().increment("collStreamCells", domain.nCells());
+
+    copyOutside(domain);
+    pencilCollideAndStream(domain);
+
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        std::swap(populations[iPop], tmpPopulations[iPop]);
+    }
+    global::profiler().stop("collStream");
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::collideAndStream() {
+    collideAndStream(this->getBoundingBox());
+
+    implementPeriodicity();
+
+    this->executeInternalProcessors();
+    this->evaluateStatistics();
+    this->incrementTime();
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::incrementTime() {
+    timeCounter.incrementTime();
+}
+
+/** The populations of the cells outside the domain are copied from populations
+ *  to tmpPopulations, so that they are preserved by the swap of the two arrays.
+ *  Only the pencils outside the domain in x or y are treated here: the ends of
+ *  the other pencils are copied by pencilCollideAndStream(), while the pencil
+ *  is in cache.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::copyOutside(Box3D domain) {
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            if (iX>=domain.x0 && iX<=domain.x1 && iY>=domain.y0 && iY<=domain.y1) {
+                continue;
+            }
+            plint iCell = index(iX,iY,0);
+            for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+                std::copy(populations[iPop]+iCell, populations[iPop]+iCell+nz, tmpPopulations[iPop]+iCell);
+            }
+        }
+    }
+}
+
+/** Collision of a single cell through the virtual interface of its dynamics.
+ *  On output, f contains the post-collision populations.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::genericCollide (
+        plint iCell, Cell<T,Descriptor>& cell, Array<T,Descriptor<T>::numPop>& f )
+{
+    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+        cell[iPop] = populations[iPop][iCell];
+    }
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        *cell.getExternal(iExt) = externalScalars[iExt][iCell];
+    }
+    cell.specifyStatisticsStatus(statisticsFlags[iCell]);
+    cell.attributeDynamics(dynamicsTable[dynamicsIndex[iCell]]);
+    cell.collide(this->getInternalStatistics());
+    f = cell.getRawPopulations();
+    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+        externalScalars[iExt][iCell] = *cell.getExternal(iExt);
+    }
+}
+
+/** The cells of a z-pencil are processed in runs of equal dynamics. For runs
+ *  with BGK, TRT or MRT dynamics, the collision is executed by the batched
+ *  collision templates, on simd::Pack<T>::width cells at once. The last,
+ *  incomplete batch of a run is padded with copies of its last cell.
+ *
+ *  The post-collision populations of the pencil are first written, direction
+ *  by direction, into a small buffer which stays in cache. They are then
+ *  streamed with one contiguous copy per direction, so that the main memory
+ *  is accessed by long sequential runs instead of q scattered writes per cell.
+ *  Populations which would leave the domain are bounced back into the opposite
+ *  direction of the same cell. This reproduces the behavior of
+ *  BlockLattice3D::boundaryStream(). The cells of the lattice beyond the ends
+ *  of the pencil are copied to tmpPopulations on the way.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::pencilCollideAndStream(Box3D domain) {
+    typedef typename Descriptor<T>::BaseDescriptor BaseDescriptor;
+    typedef batchedDynamicsTemplates<T,BaseDescriptor> Batched;
+    typedef simd::Pack<T> Pack;
+    static const plint numPop = Descriptor<T>::numPop;
+    plint const width = Pack::width;
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    plint length = domain.getNz();
+    // Each direction of the pencil buffer is padded by one batch, because the
+    //   last batch of a run is always stored completely.
+    plint bufferStride = length+width;
+    std::vector<S> pencilBuffer(numPop*bufferStride);
+    S* post[numPop];
+    S const* source[numPop];
+    S* target[numPop];
+    for (plint iPop=0; iPop<numPop; ++iPop) {
+        plint offset = Descriptor<T>::c[iPop][0]*ny*nz +
+                       Descriptor<T>::c[iPop][1]*nz +
+                       Descriptor<T>::c[iPop][2];
+        post[iPop] = &pencilBuffer[iPop*bufferStride];
+        source[iPop] = populations[iPop];
+        target[iPop] = tmpPopulations[iPop]+offset;
+    }
+    BlockStatistics& statistics = this->getInternalStatistics();
+    Cell<T,Descriptor> cell;
+    Array<T,numPop> f;
+    Array<Pack,numPop> fPack;
+    Array<Pack,Descriptor<T>::d> jPack;
+    Pack rhoBar, uSqr;
+    T buffer[Pack::width], rhoBarValues[Pack::width], uSqrValues[Pack::width];
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint pencil = index(iX,iY,domain.z0);
+            plint iZ = 0;
+            while (iZ<length) {
+                unsigned int iDynamics = dynamicsIndex[pencil+iZ];
+                plint endZ = iZ+1;
+                while (endZ<length && dynamicsIndex[pencil+endZ]==iDynamics) {
+                    ++endZ;
+                }
+                int kernel = kernels[iDynamics];
+                if (kernel!=genericKernel) {
+                    T const* parameters = &kernelParameters[iDynamics][0];
+                    for (plint batch=iZ; batch<endZ; batch+=width) {
+                        plint numCells = std::min(width, endZ-batch);
+                        if (numCells==width) {
+                            Batched::load(source, pencil+batch, fPack);
+                        }
+                        else {
+                            for (plint iPop=0; iPop<numPop; ++iPop) {
+                                for (plint iCell=0; iCell<width; ++iCell) {
+                                    buffer[iCell] = source[iPop][pencil+batch+std::min(iCell,numCells-1)];
+                                }
+                                fPack[iPop] = Pack::load(buffer);
+                            }
+                        }
+                        Batched::get_rhoBar_j(fPack, rhoBar, jPack);
+                        if (kernel==bgkKernel) {
+                            uSqr = Batched::bgk_ma2_collision(fPack, rhoBar, jPack, parameters[0]);
+                        }
+                        else if (kernel==trtKernel) {
+                            uSqr = Batched::trt_ma2_collision(fPack, rhoBar, jPack, parameters[0], parameters[1]);
+                        }
+                        else {
+                            uSqr = Batched::mrt_ma2_collision(fPack, rhoBar, jPack, parameters);
+                        }
+                        Batched::store(fPack, post, batch);
+                        bool storeValues = true;
+                        for (plint iCell=0; iCell<numCells; ++iCell) {
+                            if (statisticsFlags[pencil+batch+iCell]) {
+                                if (storeValues) {
+                                    rhoBar.store(rhoBarValues);
+                                    uSqr.store(uSqrValues);
+                                    storeValues = false;
+                                }
+                                gatherStatistics(statistics, rhoBarValues[iCell], uSqrValues[iCell]);
+                            }
+                        }
+                    }
+                }
+                else {
+                    for (plint iCell=iZ; iCell<endZ; ++iCell) {
+                        genericCollide(pencil+iCell, cell, f);
+                        for (plint iPop=0; iPop<numPop; ++iPop) {
+                            post[iPop][iCell] = (S) f[iPop];
+                        }
+                    }
+                }
+                iZ = endZ;
+            }
+            for (plint iPop=0; iPop<numPop; ++iPop) {
+                // Range of cells whose neighbor in direction iPop is inside the domain.
+                plint nextX = iX + Descriptor<T>::c[iPop][0];
+                plint nextY = iY + Descriptor<T>::c[iPop][1];
+                plint cz = Descriptor<T>::c[iPop][2];
+                plint begin = std::min(length, std::max((plint)0, -cz));
+                plint end = std::max(begin, std::min(length, length-cz));
+                if (nextX<domain.x0 || nextX>domain.x1 || nextY<domain.y0 || nextY>domain.y1) {
+                    begin = end = length;
+                }
+                std::copy(post[iPop]+begin, post[iPop]+end, target[iPop]+pencil+begin);
+                // Cells of the lattice beyond the ends of the pencil are preserved.
+                std::copy(source[iPop]+pencil-domain.z0, source[iPop]+pencil,
+                          tmpPopulations[iPop]+pencil-domain.z0);
+                std::copy(source[iPop]+pencil+length, source[iPop]+pencil-domain.z0+nz,
+                          tmpPopulations[iPop]+pencil+length);
+                S* opposite = tmpPopulations[indexTemplates::opposite<Descriptor<T> >(iPop)]+pencil;
+                for (plint iCell=0; iCell<begin; ++iCell) {
+                    opposite[iCell] = post[iPop][iCell];
+                }
+                for (plint iCell=end; iCell<length; ++iCell) {
+                    opposite[iCell] = post[iPop][iCell];
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLattice3D<T,Descriptor,S>::implementPeriodicity() {
+    static const plint vicinity = Descriptor<T>::vicinity;
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            bool xyShell = iX<vicinity || iX>=nx-vicinity || iY<vicinity || iY>=ny-vicinity;
+            for (plint iZ=0; iZ<nz; ++iZ) {
+                if (!xyShell && iZ==vicinity && nz-vicinity>iZ) {
+                    iZ = nz-vicinity;
+                }
+                for (plint iPop=1; iPop<=Descriptor<T>::q/2; ++iPop) {
+                    plint nextX = iX + Descriptor<T>::c[iPop][0];
+                    plint nextY = iY + Descriptor<T>::c[iPop][1];
+                    plint nextZ = iZ + Descriptor<T>::c[iPop][2];
+                    if ( nextX<0 || nextX>=nx || nextY<0 || nextY>=ny || nextZ<0 || nextZ>=nz ) {
+                        nextX = (nextX+nx)%nx;
+                        nextY = (nextY+ny)%ny;
+                        nextZ = (nextZ+nz)%nz;
+                        std::swap (
+                            populations[indexTemplates::opposite<Descriptor<T> >(iPop)][index(iX,iY,iZ)],
+                            populations[iPop][index(nextX,nextY,nextZ)] );
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+////////////////////// Class SoaBlockLatticeDataTransfer3D /////////////////////////
+
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::SoaBlockLatticeDataTransfer3D()
+    : lattice(0),
+      constLattice(0)
+{ }
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::setBlock(AtomicBlock3D& block) {
+    lattice = dynamic_cast<SoaBlockLattice3D<T,Descriptor,S>*>(&block);
+    PLB_ASSERT(lattice);
+    constLattice = lattice;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::setConstBlock(AtomicBlock3D const& block) {
+    constLattice = dynamic_cast<SoaBlockLattice3D<T,Descriptor,S> const*>(&block);
+    PLB_ASSERT(constLattice);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLatticeDataTransfer3D<T,Descriptor,S>* SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::clone() const
+{
+    return new SoaBlockLatticeDataTransfer3D<T,Descriptor,S>(*this);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+plint SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::staticCellSize() const {
+    return sizeof(S)*Descriptor<T>::numPop + sizeof(T)*Descriptor<T>::ExternalField::numScalars;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::send (
+        Box3D domain, std::vector<char>& buffer, modif::ModifT kind ) const
+{
+    PLB_PRECONDITION( constLattice );
+    PLB_PRECONDITION(contained(domain, constLattice->getBoundingBox()));
+    buffer.clear();
+    switch(kind) {
+        case modif::staticVariables:
+            send_static(domain, buffer); break;
+        case modif::dynamicVariables:
+            send_dynamic(domain, buffer); break;
+        case modif::allVariables:
+        case modif::dataStructure:
+            send_all(domain,buffer); break;
+        default: PLB_ASSERT(false);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::send_static (
+        Box3D domain, std::vector<char>& buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    static const plint numPop = Descriptor<T>::numPop;
+    static const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    plint cellSize = staticCellSize();
+    pluint numBytes = domain.nCells()*cellSize;
+    // Avoid dereferencing uninitialized pointer.
+    if (numBytes==0) return;
+    buffer.resize(numBytes);
+
+    char* data = &buffer[0];
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                for (plint iPop=0; iPop<numPop; ++iPop) {
+                    memcpy((void*)data, (const void*)&constLattice->pop(iPop,iX,iY,iZ), sizeof(S));
+                    data += sizeof(S);
+                }
+                for (plint iExt=0; iExt<numExt; ++iExt) {
+                    memcpy((void*)data, (const void*)&constLattice->external(iExt,iX,iY,iZ), sizeof(T));
+                    data += sizeof(T);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::send_dynamic (
+        Box3D domain, std::vector<char>& buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                // The serialize function automatically reallocates memory for buffer.
+                serialize(constLattice->getDynamics(iX,iY,iZ), buffer);
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::send_all (
+        Box3D domain, std::vector<char>& buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    static const plint numPop = Descriptor<T>::numPop;
+    static const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                // 1. Send dynamic info (automaic allocation of buffer memory).
+                serialize(constLattice->getDynamics(iX,iY,iZ), buffer);
+                pluint pos = buffer.size();
+                // 2. Send static info (needs manual allocation of buffer memory).
+                if (staticCellSize()>0) {
+                    buffer.resize(pos+staticCellSize());
+                    for (plint iPop=0; iPop<numPop; ++iPop) {
+                        memcpy((void*)&buffer[pos], (const void*)&constLattice->pop(iPop,iX,iY,iZ), sizeof(S));
+                        pos += sizeof(S);
+                    }
+                    for (plint iExt=0; iExt<numExt; ++iExt) {
+                        memcpy((void*)&buffer[pos], (const void*)&constLattice->external(iExt,iX,iY,iZ), sizeof(T));
+                        pos += sizeof(T);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::receive (
+        Box3D domain, std::vector<char> const& buffer,
+        modif::ModifT kind, std::map<int,std::string> const& foreignIds )
+{
+    if (kind==modif::dataStructure && !foreignIds.empty()) {
+        std::map<int,int> idIndirect;
+        meta::createIdIndirection<T,Descriptor>(foreignIds, idIndirect);
+        receive_regenerate(domain, buffer, idIndirect);
+    }
+    else {
+        receive(domain, buffer, kind);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::receive (
+        Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(domain, lattice->getBoundingBox()));
+    switch(kind) {
+        case modif::staticVariables:
+            receive_static(domain, buffer); break;
+        case modif::dynamicVariables:
+            receive_dynamic(domain, buffer); break;
+        case modif::allVariables:
+            receive_all(domain, buffer); break;
+        case modif::dataStructure:
+            receive_regenerate(domain, buffer); break;
+        default:
+            PLB_ASSERT( false );
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::receive_static (
+        Box3D domain, std::vector<char> const& buffer )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION( (plint) buffer.size() == domain.nCells()*staticCellSize() );
+    static const plint numPop = Descriptor<T>::numPop;
+    static const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    // Avoid dereferencing uninitialized pointer.
+    if (buffer.empty()) return;
+
+    char const* data = &buffer[0];
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                for (plint iPop=0; iPop<numPop; ++iPop) {
+                    memcpy((void*)&lattice->pop(iPop,iX,iY,iZ), (const void*)data, sizeof(S));
+                    data += sizeof(S);
+                }
+                for (plint iExt=0; iExt<numExt; ++iExt) {
+                    memcpy((void*)&lattice->external(iExt,iX,iY,iZ), (const void*)data, sizeof(T));
+                    data += sizeof(T);
+                }
+            }
+        }
+    }
+}
+
+/** As dynamics objects are shared between cells, the dynamic variables are
+ *  unserialized into a copy of the current dynamics of the cell, which is
+ *  then attributed to the cell.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::receive_dynamic (
+        Box3D domain, std::vector<char> const& buffer )
+{
+    PLB_PRECONDITION( lattice );
+    pluint serializerPos = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Dynamics<T,Descriptor>* newDynamics = lattice->getDynamics(iX,iY,iZ).clone();
+                serializerPos = unserialize(*newDynamics, buffer, serializerPos);
+                lattice->attributeDynamics(iX,iY,iZ, newDynamics);
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::receive_all (
+        Box3D domain, std::vector<char> const& buffer )
+{
+    PLB_PRECONDITION( lattice );
+    static const plint numPop = Descriptor<T>::numPop;
+    static const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    pluint posInBuffer = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                // 1. Unserialize dynamic data.
+                Dynamics<T,Descriptor>* newDynamics = lattice->getDynamics(iX,iY,iZ).clone();
+                posInBuffer = unserialize(*newDynamics, buffer, posInBuffer);
+                lattice->attributeDynamics(iX,iY,iZ, newDynamics);
+                // 2. Unserialize static data.
+                if (staticCellSize()>0) {
+                    for (plint iPop=0; iPop<numPop; ++iPop) {
+                        memcpy((void*)&lattice->pop(iPop,iX,iY,iZ), (const void*)&buffer[posInBuffer], sizeof(S));
+                        posInBuffer += sizeof(S);
+                    }
+                    for (plint iExt=0; iExt<numExt; ++iExt) {
+                        memcpy((void*)&lattice->external(iExt,iX,iY,iZ), (const void*)&buffer[posInBuffer], sizeof(T));
+                        posInBuffer += sizeof(T);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::receive_regenerate (
+        Box3D domain, std::vector<char> const& buffer, std::map<int,int> const& idIndirect )
+{
+    PLB_PRECONDITION( lattice );
+    static const plint numPop = Descriptor<T>::numPop;
+    static const plint numExt = Descriptor<T>::ExternalField::numScalars;
+    pluint posInBuffer = 0;
+    plint cellSize = staticCellSize();
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                // 1. Generate dynamics object, and unserialize dynamic data.
+                std::map<int,int> const* indirectPtr = idIndirect.empty() ? 0 : &idIndirect;
+                HierarchicUnserializer unserializer(buffer, posInBuffer, indirectPtr);
+                Dynamics<T,Descriptor>* newDynamics =
+                    meta::dynamicsRegistration<T,Descriptor>().generate(unserializer);
+                posInBuffer = unserializer.getCurrentPos();
+                lattice->attributeDynamics(iX,iY,iZ, newDynamics);
+
+                // 2. Unserialize static data.
+                if (cellSize>0) {
+                    PLB_ASSERT( !buffer.empty() );
+                    PLB_ASSERT( posInBuffer+cellSize<=buffer.size() );
+                    for (plint iPop=0; iPop<numPop; ++iPop) {
+                        memcpy((void*)&lattice->pop(iPop,iX,iY,iZ), (const void*)&buffer[posInBuffer], sizeof(S));
+                        posInBuffer += sizeof(S);
+                    }
+                    for (plint iExt=0; iExt<numExt; ++iExt) {
+                        memcpy((void*)&lattice->external(iExt,iX,iY,iZ), (const void*)&buffer[posInBuffer], sizeof(T));
+                        posInBuffer += sizeof(T);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** If the source is a BlockLattice3D, the populations are converted to the
+ *  storage type. Other sources are transferred through the byte-stream
+ *  format, which must then be the same as the one of this lattice.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::attribute (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        AtomicBlock3D const& from, modif::ModifT kind )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(toDomain, lattice->getBoundingBox()));
+    SoaBlockLattice3D<T,Descriptor,S> const* fromLattice =
+        dynamic_cast<SoaBlockLattice3D<T,Descriptor,S> const*>(&from);
+    if (!fromLattice) {
+        BlockLattice3D<T,Descriptor> const* fromBlockLattice =
+            dynamic_cast<BlockLattice3D<T,Descriptor> const*>(&from);
+        if (fromBlockLattice) {
+            attribute_block_lattice(toDomain, deltaX, deltaY, deltaZ, *fromBlockLattice, kind);
+            return;
+        }
+        // Lattices with a different storage type have a different byte-stream format.
+        if (from.getDataTransfer().staticCellSize() != staticCellSize()) {
+            plbLogicError( "SoaBlockLatticeDataTransfer3D::attribute: the source block stores its cells with a "
+                           "different size; use convert() to copy between storage types." );
+        }
+        std::vector<char> buffer;
+        from.getDataTransfer().send(toDomain.shift(deltaX,deltaY,deltaZ), buffer, kind);
+        receive(toDomain, buffer, kind);
+        return;
+    }
+    switch(kind) {
+        case modif::staticVariables:
+            attribute_static(toDomain, deltaX, deltaY, deltaZ, *fromLattice); break;
+        case modif::dynamicVariables:
+            attribute_dynamics(toDomain, deltaX, deltaY, deltaZ, *fromLattice); break;
+        case modif::allVariables:
+        case modif::dataStructure:
+            attribute_dynamics(toDomain, deltaX, deltaY, deltaZ, *fromLattice);
+            attribute_static(toDomain, deltaX, deltaY, deltaZ, *fromLattice);
+            break;
+        default:
+            PLB_ASSERT( false );
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::attribute_static (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        SoaBlockLattice3D<T,Descriptor,S> const& from )
+{
+    PLB_PRECONDITION( lattice );
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+                S const* fromPop = &from.pop(iPop,iX+deltaX,iY+deltaY,toDomain.z0+deltaZ);
+                std::copy(fromPop, fromPop+toDomain.getNz(), &lattice->pop(iPop,iX,iY,toDomain.z0));
+            }
+            for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+                T const* fromExt = &from.external(iExt,iX+deltaX,iY+deltaY,toDomain.z0+deltaZ);
+                std::copy(fromExt, fromExt+toDomain.getNz(), &lattice->external(iExt,iX,iY,toDomain.z0));
+            }
+        }
+    }
+}
+
+/** The dynamics objects are cloned from the source lattice. Consecutive cells
+ *  with the same dynamics in the source share a single clone.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::attribute_dynamics (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        SoaBlockLattice3D<T,Descriptor,S> const& from )
+{
+    PLB_PRECONDITION( lattice );
+    plint previousIndex = -1;
+    unsigned int toIndex = 0;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                plint fromIndex = from.getDynamicsIndex(iX+deltaX,iY+deltaY,iZ+deltaZ);
+                if (fromIndex!=previousIndex) {
+                    toIndex = (unsigned int) lattice->registerDynamics (
+                            from.getDynamics(iX+deltaX,iY+deltaY,iZ+deltaZ).clone() );
+                    previousIndex = fromIndex;
+                }
+                lattice->dynamicsIndex[lattice->index(iX,iY,iZ)] = toIndex;
+            }
+        }
+    }
+}
+
+/** Cells of the source which share the same dynamics object are attributed
+ *  a single entry of the dynamics table.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void SoaBlockLatticeDataTransfer3D<T,Descriptor,S>::attribute_block_lattice (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        BlockLattice3D<T,Descriptor> const& from, modif::ModifT kind )
+{
+    PLB_PRECONDITION( lattice );
+    bool copyDynamics = kind!=modif::staticVariables;
+    bool copyStatic = kind!=modif::dynamicVariables;
+    Dynamics<T,Descriptor> const* previousDynamics = 0;
+    unsigned int toIndex = 0;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                Cell<T,Descriptor> const& cell = from.get(iX+deltaX,iY+deltaY,iZ+deltaZ);
+                if (copyDynamics) {
+                    if (&cell.getDynamics()!=previousDynamics) {
+                        toIndex = (unsigned int) lattice->registerDynamics(cell.getDynamics().clone());
+                        previousDynamics = &cell.getDynamics();
+                    }
+                    lattice->dynamicsIndex[lattice->index(iX,iY,iZ)] = toIndex;
+                }
+                if (copyStatic) {
+                    lattice->scatterCell(iX,iY,iZ, cell);
+                }
+            }
+        }
+    }
+}
+
+
+/////////// Free Functions //////////////////////////////
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void convert (
+        BlockLattice3D<T,Descriptor> const& from, Box3D fromDomain,
+        SoaBlockLattice3D<T,Descriptor,S>& to, Box3D toDomain, modif::ModifT kind )
+{
+    PLB_PRECONDITION( fromDomain.getNx()==toDomain.getNx() &&
+                      fromDomain.getNy()==toDomain.getNy() &&
+                      fromDomain.getNz()==toDomain.getNz() );
+    to.getDataTransfer().attribute (
+            toDomain, fromDomain.x0-toDomain.x0, fromDomain.y0-toDomain.y0,
+            fromDomain.z0-toDomain.z0, from, kind );
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void convert (
+        SoaBlockLattice3D<T,Descriptor,S> const& from, Box3D fromDomain,
+        BlockLattice3D<T,Descriptor>& to, Box3D toDomain, modif::ModifT kind )
+{
+    PLB_PRECONDITION( fromDomain.getNx()==toDomain.getNx() &&
+                      fromDomain.getNy()==toDomain.getNy() &&
+                      fromDomain.getNz()==toDomain.getNz() );
+    plint deltaX = fromDomain.x0-toDomain.x0;
+    plint deltaY = fromDomain.y0-toDomain.y0;
+    plint deltaZ = fromDomain.z0-toDomain.z0;
+    bool copyDynamics = kind!=modif::staticVariables;
+    bool copyStatic = kind!=modif::dynamicVariables;
+    Cell<T,Descriptor> cell;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            for (plint iZ=toDomain.z0; iZ<=toDomain.z1; ++iZ) {
+                from.gatherCell(iX+deltaX,iY+deltaY,iZ+deltaZ, cell);
+                if (copyDynamics) {
+                    to.attributeDynamics(iX,iY,iZ, cell.getDynamics().clone());
+                }
+                if (copyStatic) {
+                    Cell<T,Descriptor>& toCell = to.get(iX,iY,iZ);
+                    for (plint iPop=0; iPop<Descriptor<T>::numPop; ++iPop) {
+                        toCell[iPop] = cell[iPop];
+                    }
+                    for (plint iExt=0; iExt<Descriptor<T>::ExternalField::numScalars; ++iExt) {
+                        *toCell.getExternal(iExt) = *cell.getExternal(iExt);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+bool SoaMrtKernel3D<T,descriptors::MRTD3Q19Descriptor>::classify (
+        Dynamics<T,descriptors::MRTD3Q19Descriptor> const& dynamics, std::vector<T>& collisionMatrix )
+{
+    static const int mrtId = MRTdynamics<T,descriptors::MRTD3Q19Descriptor>((T)1).getId();
+    if (dynamics.getId()!=mrtId) {
+        return false;
+    }
+    batchedDynamicsTemplates<T,descriptors::D3Q19DescriptorBase<T> >::template
+        computeMrtCollisionMatrix<descriptors::MRTD3Q19DescriptorBase<T> > (
+            dynamics.getOmega(), collisionMatrix );
+    return true;
+}
+
+template<typename T>
+bool SoaMrtKernel3D<T,descriptors::MRTD3Q27Descriptor>::classify (
+        Dynamics<T,descriptors::MRTD3Q27Descriptor> const& dynamics, std::vector<T>& collisionMatrix )
+{
+    static const int mrtId = MRTdynamics<T,descriptors::MRTD3Q27Descriptor>((T)1).getId();
+    if (dynamics.getId()!=mrtId) {
+        return false;
+    }
+    batchedDynamicsTemplates<T,descriptors::D3Q27DescriptorBase<T> >::template
+        computeMrtCollisionMatrix<descriptors::MRTD3Q27DescriptorBase<T> > (
+            dynamics.getOmega(), collisionMatrix );
+    return true;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageDensity(SoaBlockLattice3D<T,Descriptor,S> const& blockLattice) {
+    return Descriptor<T>::fullRho (
+               blockLattice.getInternalStatistics().getAverage (
+                  LatticeStatistics::avRhoBar ) );
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageEnergy(SoaBlockLattice3D<T,Descriptor,S> const& blockLattice) {
+    return 0.5 * blockLattice.getInternalStatistics().getAverage (
+                        LatticeStatistics::avUSqr );
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredMaxVelocity(SoaBlockLattice3D<T,Descriptor,S> const& blockLattice) {
+    return std::sqrt( blockLattice.getInternalStatistics().getMax (
+                             LatticeStatistics::maxUSqr ) );
+}
+
+}  // namespace plb
+
+#endif  // SOA_BLOCK_LATTICE_3D_HH
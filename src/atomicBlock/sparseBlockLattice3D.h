@@ -0,0 +1,290 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D block lattice which stores only a subset of its cells -- header file.
+ */
+#ifndef SPARSE_BLOCK_LATTICE_3D_H
+#define SPARSE_BLOCK_LATTICE_3D_H
+
+#include "core/globalDefs.h"
+#include "core/plbDebug.h"
+#include "core/cell.h"
+#include "atomicBlock/atomicBlock3D.h"
+#include "atomicBlock/dataField3D.h"
+#include "atomicBlock/dataProcessingFunctional3D.h"
+#include "core/blockIdentifiers.h"
+#include "core/blockStatistics.h"
+#include <vector>
+#include <map>
+
+namespace plb {
+
+template<typename T, template<typename U> class Descriptor> struct Dynamics;
+template<typename T, template<typename U> class Descriptor> class BlockLattice3D;
+template<typename T, template<typename U> class Descriptor> class SparseBlockLattice3D;
+
+
+/// Data transfer for the SparseBlockLattice3D.
+/** The byte-stream format is the one of BlockLatticeDataTransfer3D. Cells which
+ *  are not stored are sent as cells with NoDynamics and with zero (shifted)
+ *  populations and external scalars, and data which is received for them is
+ *  discarded. Data can therefore be exchanged between a SparseBlockLattice3D and
+ *  a BlockLattice3D through the usual communicators. The set of stored cells
+ *  is never modified by the data transfer.
+ */
+template<typename T, template<typename U> class Descriptor>
+class SparseBlockLatticeDataTransfer3D : public BlockDataTransfer3D {
+public:
+    SparseBlockLatticeDataTransfer3D();
+    virtual void setBlock(AtomicBlock3D& block);
+    virtual void setConstBlock(AtomicBlock3D const& block);
+    virtual SparseBlockLatticeDataTransfer3D<T,Descriptor>* clone() const;
+    virtual plint staticCellSize() const;
+    /// Send data from the lattice into a byte-stream.
+    virtual void send(Box3D domain, std::vector<char>& buffer, modif::ModifT kind) const;
+    /// Receive data from a byte-stream into the lattice.
+    virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind);
+    virtual void receive(Box3D domain, std::vector<char> const& buffer, modif::ModifT kind, Dot3D absoluteOffset) {
+        receive(domain, buffer, kind);
+    }
+    /// Receive data from a byte-stream into the block, and re-map IDs for dynamics if exist.
+    virtual void receive( Box3D domain, std::vector<char> const& buffer,
+                          modif::ModifT kind, std::map<int,std::string> const& foreignIds );
+    /// Attribute data between two lattices. The source can be a SparseBlockLattice3D,
+    ///   a BlockLattice3D, or any other block with a compatible byte-stream format.
+    virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                           AtomicBlock3D const& from, modif::ModifT kind);
+    virtual void attribute(Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+                           AtomicBlock3D const& from, modif::ModifT kind, Dot3D absoluteOffset)
+    {
+        attribute(toDomain, deltaX, deltaY, deltaZ, from, kind);
+    }
+private:
+    void send_static(Box3D domain, std::vector<char>& buffer) const;
+    void send_dynamic(Box3D domain, std::vector<char>& buffer) const;
+    void send_all(Box3D domain, std::vector<char>& buffer) const;
+
+    void receive_static(Box3D domain, std::vector<char> const& buffer);
+    void receive_dynamic(Box3D domain, std::vector<char> const& buffer);
+    void receive_all(Box3D domain, std::vector<char> const& buffer);
+    void receive_regenerate( Box3D domain, std::vector<char> const& buffer,
+                             std::map<int,int> const& idIndirect = (std::map<int,int>()) );
+
+    void attribute_static (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        SparseBlockLattice3D<T,Descriptor> const& from );
+private:
+    SparseBlockLattice3D<T,Descriptor>* lattice;
+    SparseBlockLattice3D<T,Descriptor> const* constLattice;
+};
+
+/// A regular lattice which stores only the cells selected at construction.
+/** The stored cells are kept in a compact array, in the order of increasing
+ *  x, y and z (the order in which a BlockLattice3D is traversed). The cells of
+ *  each column (iX,iY) are found through a table of column offsets, and for each
+ *  stored cell, the index of its neighbor in the directions 1 to q/2 is
+ *  precomputed. This indirect addressing is of interest when only a small
+ *  fraction of the cells are fluid cells, as in porous media or in vascular
+ *  geometries: the memory footprint and the cost of a time iteration are
+ *  proportional to the number of stored cells.
+ *
+ *  Collision and streaming are executed as in BlockLattice3D, with the swap
+ *  algorithm: each stored cell is collided, and its populations are then
+ *  swapped with the ones of its already collided neighbors. A population which
+ *  would be streamed from or into a cell which is not stored is bounced back.
+ *  A stored cell which is separated from the unstored cells by a layer of
+ *  BounceBack cells therefore evolves exactly as in a BlockLattice3D in which
+ *  the unstored cells have NoDynamics.
+ *
+ *  The cells which are not stored can still be accessed through get(), which
+ *  returns a single placeholder cell with NoDynamics. Modifications of this
+ *  cell, and dynamics attributed to cells which are not stored, are ignored.
+ *  Data processors which are written for the BlockLattice3D cannot be applied to
+ *  this lattice; use the functionals of the type SparseBoxProcessingFunctional3D_L
+ *  instead, which visit the stored cells only.
+ *
+ *  This class is not intended to be derived from.
+ */
+template<typename T, template<typename U> class Descriptor>
+class SparseBlockLattice3D : public AtomicBlock3D
+{
+public:
+    /// Construction of a lattice of the size of the mask, in which the cells
+    ///   with a non-zero mask value are stored.
+    SparseBlockLattice3D(ScalarField3D<int> const& mask, Dynamics<T,Descriptor>* backgroundDynamics_);
+    /// Construction of an nx_ by ny_ by nz_ lattice in which all cells are stored.
+    SparseBlockLattice3D(plint nx_, plint ny_, plint nz_, Dynamics<T,Descriptor>* backgroundDynamics_);
+    /// Destruction of the lattice
+    ~SparseBlockLattice3D();
+    /// Copy construction
+    SparseBlockLattice3D(SparseBlockLattice3D<T,Descriptor> const& rhs);
+    /// Copy assignment
+    SparseBlockLattice3D& operator=(SparseBlockLattice3D<T,Descriptor> const& rhs);
+    /// Swap the content of two SparseBlockLattices
+    void swap(SparseBlockLattice3D& rhs);
+public:
+    /// Read/write access to a cell. Cells which are not stored are mapped
+    ///   to a placeholder cell, whose content is undefined.
+    Cell<T,Descriptor>& get(plint iX, plint iY, plint iZ) {
+        plint iCell = getCellIndex(iX,iY,iZ);
+        return iCell>=0 ? cells[iCell] : solidCell;
+    }
+    /// Read-only access to a cell.
+    Cell<T,Descriptor> const& get(plint iX, plint iY, plint iZ) const {
+        plint iCell = getCellIndex(iX,iY,iZ);
+        return iCell>=0 ? cells[iCell] : solidCell;
+    }
+    /// Index of a cell in the array of stored cells, or -1 if the cell is not stored.
+    plint getCellIndex(plint iX, plint iY, plint iZ) const;
+    /// Tell whether a cell is stored.
+    bool isStored(plint iX, plint iY, plint iZ) const {
+        return getCellIndex(iX,iY,iZ) >= 0;
+    }
+    /// Number of stored cells.
+    plint getNumStoredCells() const { return (plint)cells.size(); }
+    /// Access to a stored cell through its index.
+    Cell<T,Descriptor>& getStoredCell(plint iCell) {
+        PLB_PRECONDITION( iCell>=0 && iCell<getNumStoredCells() );
+        return cells[iCell];
+    }
+    /// Read-only access to a stored cell through its index.
+    Cell<T,Descriptor> const& getStoredCell(plint iCell) const {
+        PLB_PRECONDITION( iCell>=0 && iCell<getNumStoredCells() );
+        return cells[iCell];
+    }
+    /// z-coordinate of a stored cell.
+    plint getStoredZ(plint iCell) const {
+        PLB_PRECONDITION( iCell>=0 && iCell<getNumStoredCells() );
+        return zCoordinates[iCell];
+    }
+    /// Range [begin,end) of indices of the stored cells of column (iX,iY)
+    ///   whose z-coordinate lies between z0 and z1.
+    void getColumnRange(plint iX, plint iY, plint z0, plint z1, plint& begin, plint& end) const;
+    /// Specify wheter statistics measurements are done on a rect. domain
+    void specifyStatisticsStatus(Box3D domain, bool status);
+    /// Apply collision step to a 3D sub-box
+    void collide(Box3D domain);
+    /// Apply collision step to the whole domain
+    void collide();
+    /// Apply streaming step to a 3D sub-box
+    void stream(Box3D domain);
+    /// Apply streaming step to the whole domain, with periodic boundaries
+    void stream();
+    /// Apply first collision, then streaming step to a 3D sub-box
+    /** Populations which would leave the sub-box are bounced back, and the cells
+     *  outside the sub-box are left untouched, as in BlockLattice3D. */
+    void collideAndStream(Box3D domain);
+    /// Apply first collision, then streaming step to the whole domain, with
+    ///   periodic boundaries.
+    void collideAndStream();
+    /// Increment time counter
+    /** Warning: don't call this method manually. Instead, call incrementTime()
+     *  on the multi-block lattice. Otherwise, the internal time of the multi-block
+     *  and the atomic-blocks get out of sync.
+     **/
+    void incrementTime();
+    TimeCounter& getTimeCounter() { return timeCounter; }
+    TimeCounter const& getTimeCounter() const { return timeCounter; }
+public:
+    /// Attribute dynamics to a cell. The lattice takes ownership of the object,
+    ///   which is deleted if the cell is not stored.
+    void attributeDynamics(plint iX, plint iY, plint iZ, Dynamics<T,Descriptor>* dynamics);
+    /// Attribute dynamics to a rectangular domain. The lattice takes ownership of the object.
+    void attributeDynamics(Box3D domain, Dynamics<T,Descriptor>* dynamics);
+    /// Get a const reference to the background dynamics
+    Dynamics<T,Descriptor> const& getBackgroundDynamics() const;
+    /// Get a const reference to the dynamics of the cells which are not stored.
+    Dynamics<T,Descriptor> const& getSolidDynamics() const;
+    /// Assign an independent copy of the same dynamics to every stored cell.
+    void resetDynamics(Dynamics<T,Descriptor> const& dynamics);
+private:
+    /// Helper method for memory allocation, from a mask with the size of the lattice.
+    void allocateAndInitialize(ScalarField3D<int> const* mask);
+    /// Helper method for memory de-allocation
+    void releaseMemory();
+    plint allocatedMemory() const;
+    void computeNeighbors();
+    void initializeStatistics();
+    void periodicDomain(Box3D domain);
+    void implementPeriodicity();
+private:
+    Dynamics<T,Descriptor>* backgroundDynamics;
+    Dynamics<T,Descriptor>* solidDynamics;
+    std::vector<Cell<T,Descriptor> > cells;
+    /// z-coordinate of each stored cell.
+    std::vector<int> zCoordinates;
+    /// Index of the first stored cell of each column (iX,iY), plus one
+    ///   past-the-end entry.
+    std::vector<plint> columnOffsets;
+    /// For each stored cell, the indices of the neighbors in the directions
+    ///   1 to q/2, or -1 for neighbors which are outside the lattice or not stored.
+    std::vector<int> neighbors;
+    Cell<T,Descriptor> solidCell;
+    TimeCounter timeCounter;
+    template<typename T_, template<typename U_> class Descriptor_>
+    friend class SparseBlockLatticeDataTransfer3D;
+};
+
+/// Easy instantiation of boxed data processor for a SparseBlockLattice3D.
+template<typename T, template<typename U> class Descriptor>
+struct SparseBoxProcessingFunctional3D_L : public BoxProcessingFunctional3D {
+    virtual void process(Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice) =0;
+    virtual SparseBoxProcessingFunctional3D_L<T,Descriptor>* clone() const =0;
+    /// Invoke parent-method "processGenericBlocks" through a type-cast
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks);
+};
+
+/// Easy instantiation of boxed data processor for SparseLattice-ScalarField coupling
+template<typename T1, template<typename U> class Descriptor, typename T2>
+struct SparseBoxProcessingFunctional3D_LS : public BoxProcessingFunctional3D {
+    virtual void process(Box3D domain, SparseBlockLattice3D<T1,Descriptor>& lattice,
+                                       ScalarField3D<T2>& field) =0;
+    virtual SparseBoxProcessingFunctional3D_LS<T1,Descriptor,T2>* clone() const =0;
+    /// Invoke parent-method "processGenericBlocks" through a type-cast
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks);
+};
+
+/// Easy instantiation of boxed data processor for SparseLattice-TensorField coupling
+template<typename T1, template<typename U> class Descriptor, typename T2, int nDim>
+struct SparseBoxProcessingFunctional3D_LT : public BoxProcessingFunctional3D {
+    virtual void process(Box3D domain, SparseBlockLattice3D<T1,Descriptor>& lattice,
+                                       TensorField3D<T2,nDim>& field) =0;
+    virtual SparseBoxProcessingFunctional3D_LT<T1,Descriptor,T2,nDim>* clone() const =0;
+    /// Invoke parent-method "processGenericBlocks" through a type-cast
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks);
+};
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageDensity(SparseBlockLattice3D<T,Descriptor> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageEnergy(SparseBlockLattice3D<T,Descriptor> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredMaxVelocity(SparseBlockLattice3D<T,Descriptor> const& blockLattice);
+
+}  // namespace plb
+
+#endif  // SPARSE_BLOCK_LATTICE_3D_H
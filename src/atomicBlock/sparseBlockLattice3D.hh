@@ -0,0 +1,971 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D block lattice which stores only a subset of its cells -- generic implementation.
+ */
+#ifndef SPARSE_BLOCK_LATTICE_3D_HH
+#define SPARSE_BLOCK_LATTICE_3D_HH
+
+#include "atomicBlock/sparseBlockLattice3D.h"
+#include "atomicBlock/blockLattice3D.h"
+#include "core/dynamics.h"
+#include "core/cell.h"
+#include "latticeBoltzmann/indexTemplates.h"
+#include "core/latticeStatistics.h"
+#include "core/dynamicsIdentifiers.h"
+#include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace plb {
+
+////////////////////// Class SparseBlockLattice3D /////////////////////////
+
+/** \param mask a scalar-field of the size of the lattice; the cells with
+ *         a non-zero value are stored
+ */
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor>::SparseBlockLattice3D (
+        ScalarField3D<int> const& mask,
+        Dynamics<T,Descriptor>* backgroundDynamics_ )
+   :  AtomicBlock3D(mask.getNx(), mask.getNy(), mask.getNz(),
+                    new SparseBlockLatticeDataTransfer3D<T,Descriptor>()),
+      backgroundDynamics(backgroundDynamics_),
+      solidDynamics(new NoDynamics<T,Descriptor>)
+{
+    allocateAndInitialize(&mask);
+    initializeStatistics();
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+/** \param nx_ lattice width (first index)
+ *  \param ny_ lattice height (second index)
+ *  \param nz_ lattice depth (third index)
+ */
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor>::SparseBlockLattice3D (
+        plint nx_, plint ny_, plint nz_,
+        Dynamics<T,Descriptor>* backgroundDynamics_ )
+   :  AtomicBlock3D(nx_, ny_, nz_, new SparseBlockLatticeDataTransfer3D<T,Descriptor>()),
+      backgroundDynamics(backgroundDynamics_),
+      solidDynamics(new NoDynamics<T,Descriptor>)
+{
+    allocateAndInitialize(0);
+    initializeStatistics();
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor>::~SparseBlockLattice3D()
+{
+    global::plbCounter("MEMORY_LATTICE").increment(-allocatedMemory());
+    releaseMemory();
+}
+
+/** The whole data of the lattice is duplicated, including the dynamics
+ *  objects. The internal processors are not copied.
+ */
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor>::SparseBlockLattice3D(SparseBlockLattice3D<T,Descriptor> const& rhs)
+    : AtomicBlock3D(rhs),
+      backgroundDynamics(rhs.backgroundDynamics->clone()),
+      solidDynamics(rhs.solidDynamics->clone()),
+      cells(rhs.cells),
+      zCoordinates(rhs.zCoordinates),
+      columnOffsets(rhs.columnOffsets),
+      neighbors(rhs.neighbors),
+      solidCell(rhs.solidCell),
+      timeCounter(rhs.timeCounter)
+{
+    for (pluint iCell=0; iCell<cells.size(); ++iCell) {
+        Cell<T,Descriptor>& cell = cells[iCell];
+        // Get an independent clone of the dynamics,
+        //   or assign backgroundDynamics
+        if (&cell.getDynamics()==rhs.backgroundDynamics) {
+            cell.attributeDynamics(backgroundDynamics);
+        }
+        else {
+            cell.attributeDynamics(cell.getDynamics().clone());
+        }
+    }
+    solidCell.attributeDynamics(solidDynamics);
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor>& SparseBlockLattice3D<T,Descriptor>::operator= (
+        SparseBlockLattice3D<T,Descriptor> const& rhs )
+{
+    SparseBlockLattice3D<T,Descriptor> tmp(rhs);
+    swap(tmp);
+    return *this;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::swap(SparseBlockLattice3D& rhs) {
+    global::plbCounter("MEMORY_LATTICE").increment(-allocatedMemory());
+    AtomicBlock3D::swap(rhs);
+    std::swap(backgroundDynamics, rhs.backgroundDynamics);
+    std::swap(solidDynamics, rhs.solidDynamics);
+    cells.swap(rhs.cells);
+    zCoordinates.swap(rhs.zCoordinates);
+    columnOffsets.swap(rhs.columnOffsets);
+    neighbors.swap(rhs.neighbors);
+    std::swap(solidCell, rhs.solidCell);
+    std::swap(timeCounter, rhs.timeCounter);
+    global::plbCounter("MEMORY_LATTICE").increment(allocatedMemory());
+}
+
+/** Inside a column, the stored cells are sorted by their z-coordinate. If the
+ *  column is full, the index is computed directly, and otherwise through a
+ *  binary search.
+ */
+template<typename T, template<typename U> class Descriptor>
+plint SparseBlockLattice3D<T,Descriptor>::getCellIndex(plint iX, plint iY, plint iZ) const
+{
+    PLB_PRECONDITION(iX>=0 && iX<this->getNx());
+    PLB_PRECONDITION(iY>=0 && iY<this->getNy());
+    PLB_PRECONDITION(iZ>=0 && iZ<this->getNz());
+    plint column = iX*this->getNy()+iY;
+    plint begin = columnOffsets[column];
+    plint end = columnOffsets[column+1];
+    if (end-begin == this->getNz()) {
+        return begin+iZ;
+    }
+    std::vector<int>::const_iterator it =
+        std::lower_bound(zCoordinates.begin()+begin, zCoordinates.begin()+end, (int)iZ);
+    if (it != zCoordinates.begin()+end && *it == iZ) {
+        return it-zCoordinates.begin();
+    }
+    return -1;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::getColumnRange (
+        plint iX, plint iY, plint z0, plint z1, plint& begin, plint& end ) const
+{
+    PLB_PRECONDITION(iX>=0 && iX<this->getNx());
+    PLB_PRECONDITION(iY>=0 && iY<this->getNy());
+    plint column = iX*this->getNy()+iY;
+    std::vector<int>::const_iterator columnBegin = zCoordinates.begin()+columnOffsets[column];
+    std::vector<int>::const_iterator columnEnd = zCoordinates.begin()+columnOffsets[column+1];
+    begin = std::lower_bound(columnBegin, columnEnd, (int)z0) - zCoordinates.begin();
+    end = std::upper_bound(columnBegin, columnEnd, (int)z1) - zCoordinates.begin();
+    if (end < begin) {
+        end = begin;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::specifyStatisticsStatus(Box3D domain, bool status) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                cells[iCell].specifyStatisticsStatus(status);
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::collide(Box3D domain) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                cells[iCell].collide(this->getInternalStatistics());
+                cells[iCell].revert();
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::collide() {
+    collide(this->getBoundingBox());
+}
+
+/** As in BlockLattice3D, the populations are swapped between neighboring
+ *  cells; the populations which would leave the domain, or reach a cell
+ *  which is not stored, are left untouched.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::stream(Box3D domain) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    static const plint half = Descriptor<T>::q/2;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                Cell<T,Descriptor>& cell = cells[iCell];
+                int const* next = &neighbors[iCell*half];
+                plint iZ = zCoordinates[iCell];
+                for (plint iPop=1; iPop<=half; ++iPop) {
+                    plint iNext = next[iPop-1];
+                    if ( iNext>=0 &&
+                         contained(iX+Descriptor<T>::c[iPop][0], iY+Descriptor<T>::c[iPop][1],
+                                   iZ+Descriptor<T>::c[iPop][2], domain) )
+                    {
+                        std::swap(cell[iPop+half], cells[iNext][iPop]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** At the end of this method, the methods finalizeIteration()
+ * and executeInternalProcessors() are automatically invoked.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::stream()
+{
+    stream(this->getBoundingBox());
+
+    implementPeriodicity();
+
+    this->executeInternalProcessors();
+    this->evaluateStatistics();
+    this->incrementTime();
+}
+
+/** The stored cells are traversed in the order of the BlockLattice3D. Each cell
+ *  is collided, and its populations are then reverted and swapped with the
+ *  neighbors in the directions 1 to q/2, which precede the cell and have
+ *  therefore already been collided. Only cells close to the boundary of the
+ *  domain need to verify that their neighbor is inside the domain.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
+    // Make sure domain is contained within current lattice
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+
+    global::profiler().start("collStream");
+
+    static const plint half = Descriptor<T>::q/2;
+    static const plint vicinity = Descriptor<T>::vicinity;
+    Box3D bulk(domain.enlarge(-vicinity));
+    BlockStatistics& statistics = this->getInternalStatistics();
+    plint numCells = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            numCells += end-begin;
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                Cell<T,Descriptor>& cell = cells[iCell];
+                cell.collide(statistics);
+                int const* next = &neighbors[iCell*half];
+                plint iZ = zCoordinates[iCell];
+                bool inBulk = contained(iX,iY,iZ, bulk);
+                for (plint iPop=1; iPop<=half; ++iPop) {
+                    T fTmp = cell[iPop];
+                    cell[iPop] = cell[iPop+half];
+                    plint iNext = next[iPop-1];
+                    if ( iNext>=0 &&
+                         ( inBulk ||
+                           contained(iX+Descriptor<T>::c[iPop][0], iY+Descriptor<T>::c[iPop][1],
+                                     iZ+Descriptor<T>::c[iPop][2], domain) ) )
+                    {
+                        cell[iPop+half] = cells[iNext][iPop];
+                        cells[iNext][iPop] = fTmp;
+                    }
+                    else {
+                        cell[iPop+half] = fTmp;
+                    }
+                }
+            }
+        }
+    }
+    global::profiler().increment("collStreamCells", numCells);
+    global::profiler().stop("collStream");
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::collideAndStream() {
+    collideAndStream(this->getBoundingBox());
+
+    implementPeriodicity();
+
+    this->executeInternalProcessors();
+    this->evaluateStatistics();
+    this->incrementTime();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::incrementTime() {
+    timeCounter.incrementTime();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::attributeDynamics (
+        plint iX, plint iY, plint iZ, Dynamics<T,Descriptor>* dynamics )
+{
+    plint iCell = getCellIndex(iX,iY,iZ);
+    if (iCell<0) {
+        delete dynamics;
+        return;
+    }
+    Dynamics<T,Descriptor>* previousDynamics = &cells[iCell].getDynamics();
+    if (previousDynamics != backgroundDynamics) {
+        delete previousDynamics;
+    }
+    cells[iCell].attributeDynamics(dynamics);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::attributeDynamics (
+        Box3D domain, Dynamics<T,Descriptor>* dynamics )
+{
+    PLB_PRECONDITION( contained(domain, this->getBoundingBox()) );
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                attributeDynamics(iX,iY,zCoordinates[iCell], dynamics->clone());
+            }
+        }
+    }
+    delete dynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+Dynamics<T,Descriptor> const& SparseBlockLattice3D<T,Descriptor>::getBackgroundDynamics() const {
+    return *backgroundDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+Dynamics<T,Descriptor> const& SparseBlockLattice3D<T,Descriptor>::getSolidDynamics() const {
+    return *solidDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::resetDynamics(Dynamics<T,Descriptor> const& dynamics) {
+    attributeDynamics(this->getBoundingBox(), dynamics.clone());
+}
+
+/** The stored cells are initialized with the background dynamics and zero
+ *  populations, as in BlockLattice3D.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::allocateAndInitialize(ScalarField3D<int> const* mask) {
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    PLB_ASSERT( !mask || (mask->getNx()==nx && mask->getNy()==ny && mask->getNz()==nz) );
+    columnOffsets.resize(nx*ny+1);
+    plint numCells = 0;
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            columnOffsets[iX*ny+iY] = numCells;
+            for (plint iZ=0; iZ<nz; ++iZ) {
+                if (!mask || mask->get(iX,iY,iZ)) {
+                    ++numCells;
+                }
+            }
+        }
+    }
+    columnOffsets[nx*ny] = numCells;
+    // The neighbor indices are stored on 32 bits.
+    PLB_ASSERT( numCells <= (plint)std::numeric_limits<int>::max() );
+
+    cells.assign(numCells, Cell<T,Descriptor>());
+    zCoordinates.resize(numCells);
+    plint iCell = 0;
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            for (plint iZ=0; iZ<nz; ++iZ) {
+                if (!mask || mask->get(iX,iY,iZ)) {
+                    zCoordinates[iCell] = (int)iZ;
+                    cells[iCell].attributeDynamics(backgroundDynamics);
+                    ++iCell;
+                }
+            }
+        }
+    }
+    solidCell.attributeDynamics(solidDynamics);
+    computeNeighbors();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::computeNeighbors() {
+    static const plint half = Descriptor<T>::q/2;
+    Box3D boundingBox(this->getBoundingBox());
+    neighbors.resize(cells.size()*half);
+    for (plint iX=0; iX<this->getNx(); ++iX) {
+        for (plint iY=0; iY<this->getNy(); ++iY) {
+            plint column = iX*this->getNy()+iY;
+            for (plint iCell=columnOffsets[column]; iCell<columnOffsets[column+1]; ++iCell) {
+                plint iZ = zCoordinates[iCell];
+                for (plint iPop=1; iPop<=half; ++iPop) {
+                    plint nextX = iX + Descriptor<T>::c[iPop][0];
+                    plint nextY = iY + Descriptor<T>::c[iPop][1];
+                    plint nextZ = iZ + Descriptor<T>::c[iPop][2];
+                    plint iNext = contained(nextX,nextY,nextZ, boundingBox) ?
+                                      getCellIndex(nextX,nextY,nextZ) : -1;
+                    neighbors[iCell*half+iPop-1] = (int)iNext;
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::initializeStatistics() {
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average rho-bar
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average uSqr
+    this->getInternalStatistics().subscribeMax();     // Subscribe max uSqr
+
+    // Attribute default value to the standard statistics, as in BlockLattice3D.
+    std::vector<double> average, sum, max;
+    std::vector<plint> intSum;
+    average.push_back(Descriptor<double>::rhoBar(1.));
+    average.push_back(0.);
+    max.push_back(0.);
+    plint numStatCells = 1;
+    this->getInternalStatistics().evaluate (average, sum, max, intSum, numStatCells);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::releaseMemory() {
+    for (pluint iCell=0; iCell<cells.size(); ++iCell) {
+        Dynamics<T,Descriptor>* dynamics = &cells[iCell].getDynamics();
+        if (dynamics != backgroundDynamics) {
+            delete dynamics;
+        }
+    }
+    delete backgroundDynamics;
+    delete solidDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint SparseBlockLattice3D<T,Descriptor>::allocatedMemory() const {
+    return (plint)cells.size()*
+           sizeof(T)* (Descriptor<T>::numPop + Descriptor<T>::ExternalField::numScalars);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::implementPeriodicity() {
+    static const plint vicinity = Descriptor<T>::vicinity;
+    plint maxX = this->getNx()-1;
+    plint maxY = this->getNy()-1;
+    plint maxZ = this->getNz()-1;
+    // Periodicity of planes orthogonal to x-axis.
+    periodicDomain(Box3D(-vicinity,-1, 0,maxY, 0,maxZ));
+    // Periodicity of planes orthogonal to y-axis.
+    periodicDomain(Box3D(0,maxX, -vicinity,-1, 0,maxZ));
+    // Periodicity of planes orthogonal to z-axis.
+    periodicDomain(Box3D(0,maxX, 0,maxY, -vicinity,-1));
+
+    // Periodicity of edges in y-z plane.
+    periodicDomain(Box3D(0,maxX, -vicinity,-1, -vicinity,-1));
+    periodicDomain(Box3D(0,maxX, -vicinity,-1, maxZ+1,maxZ+vicinity));
+
+    // Periodicity of edges in x-z plane.
+    periodicDomain(Box3D(-vicinity,-1, 0,maxY, -vicinity,-1));
+    periodicDomain(Box3D(maxX+1,maxX+vicinity, 0,maxY, -vicinity,-1));
+
+    // Periodicity of edges in x-y plane.
+    periodicDomain(Box3D(-vicinity,-1, -vicinity,-1, 0,maxZ));
+    periodicDomain(Box3D(-vicinity,-1, maxY+1,maxY+vicinity, 0,maxZ));
+
+    // Periodicity of corners.
+    periodicDomain(Box3D(maxX+1,maxX+vicinity, maxY+1,maxY+vicinity, maxZ+1,maxZ+vicinity));
+    periodicDomain(Box3D(maxX+1,maxX+vicinity, maxY+1,maxY+vicinity, -vicinity,-1));
+    periodicDomain(Box3D(maxX+1,maxX+vicinity, -vicinity,-1, maxZ+1,maxZ+vicinity));
+    periodicDomain(Box3D(maxX+1,maxX+vicinity, -vicinity,-1, -vicinity,-1));
+}
+
+/** Same as BlockLattice3D::periodicDomain(); pairs of populations which
+ *  involve a cell that is not stored are left untouched (bounced back).
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLattice3D<T,Descriptor>::periodicDomain(Box3D domain) {
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                for (plint iPop=1; iPop<Descriptor<T>::q; ++iPop) {
+                    plint prevX = iX - Descriptor<T>::c[iPop][0];
+                    plint prevY = iY - Descriptor<T>::c[iPop][1];
+                    plint prevZ = iZ - Descriptor<T>::c[iPop][2];
+
+                    if ( (prevX>=0 && prevX<nx) &&
+                         (prevY>=0 && prevY<ny) &&
+                         (prevZ>=0 && prevZ<nz) )
+                    {
+                        plint nextX = (iX+nx)%nx;
+                        plint nextY = (iY+ny)%ny;
+                        plint nextZ = (iZ+nz)%nz;
+                        plint iPrev = getCellIndex(prevX,prevY,prevZ);
+                        plint iNext = getCellIndex(nextX,nextY,nextZ);
+                        if (iPrev>=0 && iNext>=0) {
+                            std::swap (
+                                cells[iPrev][indexTemplates::opposite<Descriptor<T> >(iPop)],
+                                cells[iNext][iPop] );
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+////////////////////// Class SparseBlockLatticeDataTransfer3D /////////////////////////
+
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLatticeDataTransfer3D<T,Descriptor>::SparseBlockLatticeDataTransfer3D()
+    : lattice(0),
+      constLattice(0)
+{ }
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::setBlock(AtomicBlock3D& block) {
+    lattice = dynamic_cast<SparseBlockLattice3D<T,Descriptor>*>(&block);
+    PLB_ASSERT(lattice);
+    constLattice = lattice;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::setConstBlock(AtomicBlock3D const& block) {
+    constLattice = dynamic_cast<SparseBlockLattice3D<T,Descriptor> const*>(&block);
+    PLB_ASSERT(constLattice);
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLatticeDataTransfer3D<T,Descriptor>*
+    SparseBlockLatticeDataTransfer3D<T,Descriptor>::clone() const
+{
+    return new SparseBlockLatticeDataTransfer3D<T,Descriptor>(*this);
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint SparseBlockLatticeDataTransfer3D<T,Descriptor>::staticCellSize() const {
+    return sizeof(T)* (Descriptor<T>::numPop + Descriptor<T>::ExternalField::numScalars);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::send (
+        Box3D domain, std::vector<char>& buffer, modif::ModifT kind ) const
+{
+    PLB_PRECONDITION( constLattice );
+    PLB_PRECONDITION(contained(domain, constLattice->getBoundingBox()));
+    buffer.clear();
+    switch(kind) {
+        case modif::staticVariables:
+            send_static(domain, buffer); break;
+        case modif::dynamicVariables:
+            send_dynamic(domain, buffer); break;
+        // Serialization is the same no matter if the dynamics object
+        //   is being regenerated or not by the recipient.
+        case modif::allVariables:
+        case modif::dataStructure:
+            send_all(domain,buffer); break;
+        default: PLB_ASSERT(false);
+    }
+}
+
+/** In all the send and receive functions, the cells of a column are visited in
+ *  order of increasing z, and the next stored cell of the column is tracked, so
+ *  that no search for the cell indices is needed.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::send_static (
+        Box3D domain, std::vector<char>& buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    plint cellSize = staticCellSize();
+    pluint numBytes = domain.nCells()*cellSize;
+    // Avoid dereferencing uninitialized pointer.
+    if (numBytes==0) return;
+    buffer.resize(numBytes);
+    Cell<T,Descriptor> zeroCell;
+    plint iData=0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            constLattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                if (iCell<end && constLattice->zCoordinates[iCell]==iZ) {
+                    constLattice->cells[iCell].serialize(&buffer[iData]);
+                    ++iCell;
+                }
+                else {
+                    zeroCell.serialize(&buffer[iData]);
+                }
+                iData += cellSize;
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::send_dynamic (
+        Box3D domain, std::vector<char>& buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            constLattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                // The serialize function automatically reallocates memory for buffer.
+                if (iCell<end && constLattice->zCoordinates[iCell]==iZ) {
+                    serialize(constLattice->cells[iCell].getDynamics(), buffer);
+                    ++iCell;
+                }
+                else {
+                    serialize(*constLattice->solidDynamics, buffer);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::send_all (
+        Box3D domain, std::vector<char>& buffer ) const
+{
+    PLB_PRECONDITION( constLattice );
+    Cell<T,Descriptor> zeroCell;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            constLattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Cell<T,Descriptor> const* cell = &zeroCell;
+                Dynamics<T,Descriptor> const* dynamics = constLattice->solidDynamics;
+                if (iCell<end && constLattice->zCoordinates[iCell]==iZ) {
+                    cell = &constLattice->cells[iCell];
+                    dynamics = &cell->getDynamics();
+                    ++iCell;
+                }
+                // 1. Send dynamic info (automaic allocation of buffer memory).
+                serialize(*dynamics, buffer);
+                pluint pos = buffer.size();
+                // 2. Send static info (needs manual allocation of buffer memory).
+                if (staticCellSize()>0) {
+                    buffer.resize(pos+staticCellSize());
+                    cell->serialize(&buffer[pos]);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::receive (
+        Box3D domain, std::vector<char> const& buffer,
+        modif::ModifT kind, std::map<int,std::string> const& foreignIds )
+{
+    if (kind==modif::dataStructure && !foreignIds.empty()) {
+        std::map<int,int> idIndirect;
+        meta::createIdIndirection<T,Descriptor>(foreignIds, idIndirect);
+        receive_regenerate(domain, buffer, idIndirect);
+    }
+    else {
+        receive(domain, buffer, kind);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::receive (
+        Box3D domain, std::vector<char> const& buffer, modif::ModifT kind )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(domain, lattice->getBoundingBox()));
+    switch(kind) {
+        case modif::staticVariables:
+            receive_static(domain, buffer); break;
+        case modif::dynamicVariables:
+            receive_dynamic(domain, buffer); break;
+        case modif::allVariables:
+            receive_all(domain, buffer); break;
+        case modif::dataStructure:
+            receive_regenerate(domain, buffer); break;
+        default:
+            PLB_ASSERT( false );
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::receive_static (
+        Box3D domain, std::vector<char> const& buffer )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION( (plint) buffer.size() == domain.nCells()*staticCellSize() );
+    // Avoid dereferencing uninitialized pointer.
+    if (buffer.empty()) return;
+    plint cellSize = staticCellSize();
+    plint iData=0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (; iCell<end; ++iCell) {
+                plint iZ = lattice->zCoordinates[iCell];
+                lattice->cells[iCell].unSerialize(&buffer[iData+(iZ-domain.z0)*cellSize]);
+            }
+            iData += domain.getNz()*cellSize;
+        }
+    }
+}
+
+/** The dynamics objects which are received for cells that are not stored are
+ *  unserialized into a temporary object, to find their size in the byte-stream.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::receive_dynamic (
+        Box3D domain, std::vector<char> const& buffer )
+{
+    PLB_PRECONDITION( lattice );
+    pluint serializerPos = 0;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                if (iCell<end && lattice->zCoordinates[iCell]==iZ) {
+                    serializerPos =
+                        unserialize (
+                            lattice->cells[iCell].getDynamics(), buffer, serializerPos );
+                    ++iCell;
+                }
+                else {
+                    HierarchicUnserializer unserializer(buffer, serializerPos);
+                    delete meta::dynamicsRegistration<T,Descriptor>().generate(unserializer);
+                    serializerPos = unserializer.getCurrentPos();
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::receive_all (
+        Box3D domain, std::vector<char> const& buffer )
+{
+    PLB_PRECONDITION( lattice );
+    pluint posInBuffer = 0;
+    plint cellSize = staticCellSize();
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                bool isStored = iCell<end && lattice->zCoordinates[iCell]==iZ;
+                // 1. Unserialize dynamic data.
+                if (isStored) {
+                    posInBuffer =
+                        unserialize (
+                            lattice->cells[iCell].getDynamics(), buffer, posInBuffer );
+                }
+                else {
+                    HierarchicUnserializer unserializer(buffer, posInBuffer);
+                    delete meta::dynamicsRegistration<T,Descriptor>().generate(unserializer);
+                    posInBuffer = unserializer.getCurrentPos();
+                }
+                // 2. Unserialize static data.
+                if (staticCellSize()>0) {
+                    if (isStored) {
+                        lattice->cells[iCell].unSerialize(&buffer[posInBuffer]);
+                    }
+                    posInBuffer += cellSize;
+                }
+                if (isStored) {
+                    ++iCell;
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::receive_regenerate (
+        Box3D domain, std::vector<char> const& buffer, std::map<int,int> const& idIndirect )
+{
+    PLB_PRECONDITION( lattice );
+    pluint posInBuffer = 0;
+    plint cellSize = staticCellSize();
+    std::map<int,int> const* indirectPtr = idIndirect.empty() ? 0 : &idIndirect;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice->getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                bool isStored = iCell<end && lattice->zCoordinates[iCell]==iZ;
+                // 1. Generate dynamics object, and unserialize dynamic data.
+                HierarchicUnserializer unserializer(buffer, posInBuffer, indirectPtr);
+                Dynamics<T,Descriptor>* newDynamics =
+                    meta::dynamicsRegistration<T,Descriptor>().generate(unserializer);
+                posInBuffer = unserializer.getCurrentPos();
+                if (isStored) {
+                    lattice->attributeDynamics(iX,iY,iZ, newDynamics);
+                }
+                else {
+                    delete newDynamics;
+                }
+
+                // 2. Unserialize static data.
+                if (staticCellSize()>0) {
+                    PLB_ASSERT( !buffer.empty() );
+                    PLB_ASSERT( posInBuffer+cellSize<=buffer.size() );
+                    if (isStored) {
+                        lattice->cells[iCell].unSerialize(&buffer[posInBuffer]);
+                    }
+                    posInBuffer += cellSize;
+                }
+                if (isStored) {
+                    ++iCell;
+                }
+            }
+        }
+    }
+}
+
+/** Static data is copied directly between two sparse lattices. In all other
+ *  cases, the data is transferred through the byte-stream of the source.
+ */
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::attribute (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        AtomicBlock3D const& from, modif::ModifT kind )
+{
+    PLB_PRECONDITION( lattice );
+    PLB_PRECONDITION(contained(toDomain, lattice->getBoundingBox()));
+    SparseBlockLattice3D<T,Descriptor> const* fromLattice =
+        dynamic_cast<SparseBlockLattice3D<T,Descriptor> const*>(&from);
+    if (fromLattice && kind==modif::staticVariables) {
+        attribute_static(toDomain, deltaX, deltaY, deltaZ, *fromLattice);
+    }
+    else {
+        // Lattices with a different storage type have a different byte-stream format.
+        if (from.getDataTransfer().staticCellSize() != staticCellSize()) {
+            plbLogicError( "SparseBlockLatticeDataTransfer3D::attribute: the source block stores its cells with a "
+                           "different size; use convert() to copy between storage types." );
+        }
+        std::vector<char> buffer;
+        from.getDataTransfer().send(toDomain.shift(deltaX,deltaY,deltaZ), buffer, kind);
+        receive(toDomain, buffer, kind);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBlockLatticeDataTransfer3D<T,Descriptor>::attribute_static (
+        Box3D toDomain, plint deltaX, plint deltaY, plint deltaZ,
+        SparseBlockLattice3D<T,Descriptor> const& from )
+{
+    PLB_PRECONDITION( lattice );
+    Cell<T,Descriptor> zeroCell;
+    for (plint iX=toDomain.x0; iX<=toDomain.x1; ++iX) {
+        for (plint iY=toDomain.y0; iY<=toDomain.y1; ++iY) {
+            plint iCell, end;
+            lattice->getColumnRange(iX, iY, toDomain.z0, toDomain.z1, iCell, end);
+            for (; iCell<end; ++iCell) {
+                plint iZ = lattice->zCoordinates[iCell];
+                plint iFrom = from.getCellIndex(iX+deltaX,iY+deltaY,iZ+deltaZ);
+                lattice->cells[iCell].attributeValues (
+                        iFrom>=0 ? from.cells[iFrom] : zeroCell );
+            }
+        }
+    }
+}
+
+/* *************** SparseBoxProcessing3D_L ************************************* */
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxProcessingFunctional3D_L<T,Descriptor>::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks )
+{
+    PLB_PRECONDITION( atomicBlocks.size() == 1 );
+    process ( domain,
+              dynamic_cast<SparseBlockLattice3D<T,Descriptor>&>(*atomicBlocks[0]) );
+}
+
+/* *************** SparseBoxProcessing3D_LS ************************************ */
+
+template<typename T1, template<typename U> class Descriptor, typename T2>
+void SparseBoxProcessingFunctional3D_LS<T1,Descriptor,T2>::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks )
+{
+    PLB_PRECONDITION( atomicBlocks.size() == 2 );
+    process ( domain,
+              dynamic_cast<SparseBlockLattice3D<T1,Descriptor>&>(*atomicBlocks[0]),
+              dynamic_cast<ScalarField3D<T2>&>(*atomicBlocks[1]) );
+}
+
+/* *************** SparseBoxProcessing3D_LT ************************************ */
+
+template<typename T1, template<typename U> class Descriptor, typename T2, int nDim>
+void SparseBoxProcessingFunctional3D_LT<T1,Descriptor,T2,nDim>::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> atomicBlocks )
+{
+    PLB_PRECONDITION( atomicBlocks.size() == 2 );
+    process ( domain,
+              dynamic_cast<SparseBlockLattice3D<T1,Descriptor>&>(*atomicBlocks[0]),
+              dynamic_cast<TensorField3D<T2,nDim>&>(*atomicBlocks[1]) );
+}
+
+/////////// Free Functions //////////////////////////////
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageDensity(SparseBlockLattice3D<T,Descriptor> const& blockLattice) {
+    return Descriptor<T>::fullRho (
+               blockLattice.getInternalStatistics().getAverage (
+                  LatticeStatistics::avRhoBar ) );
+}
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageEnergy(SparseBlockLattice3D<T,Descriptor> const& blockLattice) {
+    return 0.5 * blockLattice.getInternalStatistics().getAverage (
+                        LatticeStatistics::avUSqr );
+}
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredMaxVelocity(SparseBlockLattice3D<T,Descriptor> const& blockLattice) {
+    return std::sqrt( blockLattice.getInternalStatistics().getMax (
+                             LatticeStatistics::maxUSqr ) );
+}
+
+}  // namespace plb
+
+#endif  // SPARSE_BLOCK_LATTICE_3D_HH
@@ -0,0 +1,110 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Collide-and-stream kernels in which the collision step is inlined for
+ * specific dynamics classes -- header file.
+ */
+#ifndef SPECIALIZED_COLLIDE_AND_STREAM_2D_H
+#define SPECIALIZED_COLLIDE_AND_STREAM_2D_H
+
+#include "core/globalDefs.h"
+#include "core/cell.h"
+#include "core/geometry2D.h"
+#include "atomicBlock/blockLattice2D.h"
+#include <map>
+#include <typeinfo>
+
+namespace plb {
+
+/// Collision step of the generic collideAndStream: a virtual call to the dynamics.
+template<typename T, template<typename U> class Descriptor>
+struct GenericCollision2D {
+    static void collide(Cell<T,Descriptor>& cell, BlockStatistics& statistics) {
+        cell.collide(statistics);
+    }
+};
+
+/// Collision step of the specialized collideAndStream: the collision of the cells
+///   whose dynamics is exactly of type DynamicsType is called non-virtually, and
+///   can be inlined. The other cells are treated through a virtual call.
+template<typename T, template<typename U> class Descriptor, class DynamicsType>
+struct SpecializedCollision2D {
+    static void collide(Cell<T,Descriptor>& cell, BlockStatistics& statistics) {
+        Dynamics<T,Descriptor>& dynamics = cell.getDynamics();
+        if (typeid(dynamics)==typeid(DynamicsType)) {
+            static_cast<DynamicsType&>(dynamics).DynamicsType::collide(cell, statistics);
+        }
+        else {
+            dynamics.collide(cell, statistics);
+        }
+    }
+};
+
+/// Registry of the dynamics classes for which BlockLattice2D uses a specialized
+///   collideAndStream kernel.
+/** The dynamics classes are identified by their dynamics ID (Dynamics::getId()).
+ *  BGKdynamics is registered by default, and so are RegularizedBGKdynamics and
+ *  SmagorinskyBGKdynamics on D2Q9 lattices, and KBCDynamics on the plain
+ *  D2Q9Descriptor. Additional classes are registered with the function
+ *  registerSpecializedCollideAndStream2D(), before the first time iteration.
+ */
+template<typename T, template<typename U> class Descriptor>
+class SpecializedCollideAndStreamRegistry2D {
+public:
+    typedef void (BlockLattice2D<T,Descriptor>::*Kernel)(Box2D domain);
+public:
+    void announce(int dynamicsId, Kernel kernel);
+    /// Return the kernel registered for a given dynamics ID, or 0 if there is none.
+    Kernel find(int dynamicsId) const;
+    /// Choose the kernel for the most frequent registered dynamics, based on a
+    ///   sample of 3x3 cells of the domain. Returns 0 if none is found.
+    Kernel choose(BlockLattice2D<T,Descriptor>& lattice, Box2D domain) const;
+private:
+    SpecializedCollideAndStreamRegistry2D();
+    SpecializedCollideAndStreamRegistry2D(SpecializedCollideAndStreamRegistry2D<T,Descriptor> const& rhs);
+    SpecializedCollideAndStreamRegistry2D<T,Descriptor>& operator= (
+            SpecializedCollideAndStreamRegistry2D<T,Descriptor> const& rhs );
+private:
+    std::map<int,Kernel> kernels;
+    template<typename T_, template<typename U_> class Descriptor_>
+    friend SpecializedCollideAndStreamRegistry2D<T_,Descriptor_>& specializedCollideAndStreamRegistry2D();
+};
+
+template<typename T, template<typename U> class Descriptor>
+SpecializedCollideAndStreamRegistry2D<T,Descriptor>& specializedCollideAndStreamRegistry2D();
+
+/// Use a specialized collideAndStream kernel on the cells whose dynamics has the same
+///   type as the prototype.
+/** Usage: registerSpecializedCollideAndStream2D<T,DESCRIPTOR>(MyDynamics<T,DESCRIPTOR>(omega));
+ *  The dynamics class must overload getId(), and its collide() method must not depend
+ *  on anything else than the cell and the dynamics object.
+ */
+template<typename T, template<typename U> class Descriptor, class DynamicsType>
+void registerSpecializedCollideAndStream2D(DynamicsType const& prototype);
+
+}  // namespace plb
+
+#endif  // SPECIALIZED_COLLIDE_AND_STREAM_2D_H
@@ -0,0 +1,148 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Collide-and-stream kernels in which the collision step is inlined for
+ * specific dynamics classes -- generic implementation.
+ */
+#ifndef SPECIALIZED_COLLIDE_AND_STREAM_2D_HH
+#define SPECIALIZED_COLLIDE_AND_STREAM_2D_HH
+
+#include "atomicBlock/specializedCollideAndStream2D.h"
+#include "basicDynamics/isoThermalDynamics.hh"
+#include "complexDynamics/smagorinskyDynamics.hh"
+#include "complexDynamics/kbcDynamics.hh"
+#include "latticeBoltzmann/nearestNeighborLattices2D.h"
+
+namespace plb {
+
+/// Dynamics classes registered by default: BGKdynamics on all lattices.
+template<typename T, template<typename U> class Descriptor, class BaseDescriptor>
+struct DefaultSpecializedCollideAndStream2D {
+    static void announce(SpecializedCollideAndStreamRegistry2D<T,Descriptor>& registry) {
+        registry.announce( BGKdynamics<T,Descriptor>((T)1).getId(),
+                           &BlockLattice2D<T,Descriptor>::template
+                               specializedBulkCollideAndStream<BGKdynamics<T,Descriptor> > );
+    }
+};
+
+/// KBCDynamics is only implemented for the plain D2Q9Descriptor.
+template<typename T, template<typename U> class Descriptor, class FullDescriptor>
+struct KBCSpecializedCollideAndStream2D {
+    static void announce(SpecializedCollideAndStreamRegistry2D<T,Descriptor>& registry)
+    { }
+};
+
+template<typename T, template<typename U> class Descriptor>
+struct KBCSpecializedCollideAndStream2D<T, Descriptor, descriptors::D2Q9Descriptor<T> > {
+    static void announce(SpecializedCollideAndStreamRegistry2D<T,Descriptor>& registry) {
+        registry.announce( KBCDynamics<T,Descriptor>((T)1).getId(),
+                           &BlockLattice2D<T,Descriptor>::template
+                               specializedBulkCollideAndStream<KBCDynamics<T,Descriptor> > );
+    }
+};
+
+/// On D2Q9 lattices, RegularizedBGKdynamics and SmagorinskyBGKdynamics are
+///   registered as well, and so is KBCDynamics on the plain D2Q9Descriptor.
+template<typename T, template<typename U> class Descriptor>
+struct DefaultSpecializedCollideAndStream2D<T, Descriptor, descriptors::D2Q9DescriptorBase<T> > {
+    static void announce(SpecializedCollideAndStreamRegistry2D<T,Descriptor>& registry) {
+        DefaultSpecializedCollideAndStream2D<T,Descriptor,void>::announce(registry);
+        registry.announce( RegularizedBGKdynamics<T,Descriptor>((T)1).getId(),
+                           &BlockLattice2D<T,Descriptor>::template
+                               specializedBulkCollideAndStream<RegularizedBGKdynamics<T,Descriptor> > );
+        registry.announce( SmagorinskyBGKdynamics<T,Descriptor>((T)1, (T)0.1).getId(),
+                           &BlockLattice2D<T,Descriptor>::template
+                               specializedBulkCollideAndStream<SmagorinskyBGKdynamics<T,Descriptor> > );
+        KBCSpecializedCollideAndStream2D<T,Descriptor,Descriptor<T> >::announce(registry);
+    }
+};
+
+template<typename T, template<typename U> class Descriptor>
+SpecializedCollideAndStreamRegistry2D<T,Descriptor>::SpecializedCollideAndStreamRegistry2D()
+{
+    DefaultSpecializedCollideAndStream2D <
+        T, Descriptor, typename Descriptor<T>::BaseDescriptor >::announce(*this);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SpecializedCollideAndStreamRegistry2D<T,Descriptor>::announce(int dynamicsId, Kernel kernel)
+{
+    kernels[dynamicsId] = kernel;
+}
+
+template<typename T, template<typename U> class Descriptor>
+typename SpecializedCollideAndStreamRegistry2D<T,Descriptor>::Kernel
+    SpecializedCollideAndStreamRegistry2D<T,Descriptor>::find(int dynamicsId) const
+{
+    typename std::map<int,Kernel>::const_iterator it = kernels.find(dynamicsId);
+    if (it==kernels.end()) {
+        return 0;
+    }
+    return it->second;
+}
+
+template<typename T, template<typename U> class Descriptor>
+typename SpecializedCollideAndStreamRegistry2D<T,Descriptor>::Kernel
+    SpecializedCollideAndStreamRegistry2D<T,Descriptor>::choose (
+            BlockLattice2D<T,Descriptor>& lattice, Box2D domain ) const
+{
+    plint xs[3] = { domain.x0, (domain.x0+domain.x1)/2, domain.x1 };
+    plint ys[3] = { domain.y0, (domain.y0+domain.y1)/2, domain.y1 };
+    std::map<int,plint> frequency;
+    for (plint iX=0; iX<3; ++iX) {
+        for (plint iY=0; iY<3; ++iY) {
+            ++frequency[lattice.get(xs[iX],ys[iY]).getDynamics().getId()];
+        }
+    }
+    Kernel kernel = 0;
+    plint maxFrequency = 0;
+    for (std::map<int,plint>::const_iterator it = frequency.begin(); it != frequency.end(); ++it) {
+        Kernel candidate = find(it->first);
+        if (candidate && it->second>maxFrequency) {
+            kernel = candidate;
+            maxFrequency = it->second;
+        }
+    }
+    return kernel;
+}
+
+template<typename T, template<typename U> class Descriptor>
+SpecializedCollideAndStreamRegistry2D<T,Descriptor>& specializedCollideAndStreamRegistry2D() {
+    static SpecializedCollideAndStreamRegistry2D<T,Descriptor> instance;
+    return instance;
+}
+
+template<typename T, template<typename U> class Descriptor, class DynamicsType>
+void registerSpecializedCollideAndStream2D(DynamicsType const& prototype)
+{
+    specializedCollideAndStreamRegistry2D<T,Descriptor>().announce (
+            prototype.getId(),
+            &BlockLattice2D<T,Descriptor>::template specializedBulkCollideAndStream<DynamicsType> );
+}
+
+}  // namespace plb
+
+#endif  // SPECIALIZED_COLLIDE_AND_STREAM_2D_HH
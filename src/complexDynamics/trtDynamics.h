@@ -58,6 +58,9 @@ public:
     /// Compute equilibrium distribution function
     virtual T computeEquilibrium(plint iPop, T rhoBar, Array<T,Descriptor<T>::d> const& j,
                                  T jSqr, T thetaBar=T()) const;
+
+    /// Relaxation rate of the antisymmetric part of the populations.
+    static T getOmegaMinus() { return sMinus; }
 private:
     static const T sMinus;
     static int id;
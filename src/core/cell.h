@@ -171,6 +171,8 @@ private:
     // Declare the BlockLatticeXD as a friend, to enable access to attributeDynamics.
     template<typename T_, template<typename U_> class Descriptor_> friend class BlockLattice2D;
     template<typename T_, template<typename U_> class Descriptor_> friend class BlockLattice3D;
+    template<typename T_, template<typename U_> class Descriptor_, typename S_> friend class SoaBlockLattice3D;
+    template<typename T_, template<typename U_> class Descriptor_> friend class SparseBlockLattice3D;
 #ifdef PLB_MPI_PARALLEL
     template<typename T_, template<typename U_> class Descriptor_> friend class ParallelCellAccess2D;
     template<typename T_, template<typename U_> class Descriptor_> friend class ParallelCellAccess3D;
@@ -34,7 +34,8 @@ IOpolicyClass::IOpolicyClass()
       endianSwitchOnBase64in(false),
       stlLowerBoundFlag(false),
       stlLowerBound(-1.),
-      parallelIOflag(true)
+      parallelIOflag(true),
+      checkpointCompressionFlag(false)
 { }
 
 void IOpolicyClass::setIndexOrderingForStreams(IndexOrdering::OrderingT streamOrdering_) {
@@ -85,6 +86,14 @@ bool IOpolicyClass::useParallelIO() const {
     return parallelIOflag;
 }
 
+void IOpolicyClass::activateCheckpointCompression(bool activate) {
+    checkpointCompressionFlag = activate;
+}
+
+bool IOpolicyClass::useCheckpointCompression() const {
+    return checkpointCompressionFlag;
+}
+
 /** Directories are default initialized to working directory.
  */
 Directories::Directories()
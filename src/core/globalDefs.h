@@ -227,6 +227,10 @@ public:
 
     void activateParallelIO(bool activate);
     bool useParallelIO() const;
+
+    /// Compress the data of checkpoints written by parallelIO::save(), without loss.
+    void activateCheckpointCompression(bool activate);
+    bool useCheckpointCompression() const;
 private:
     IOpolicyClass();
 private:
@@ -236,6 +240,7 @@ private:
     bool stlLowerBoundFlag;
     double stlLowerBound;
     bool parallelIOflag;
+    bool checkpointCompressionFlag;
     friend IOpolicyClass& IOpolicy();
 };
     
@@ -49,4 +49,5 @@
 #include "core/functions.h"
 #include "core/vectorFunction3D.h"
 #include "core/realFunction3D.h"
+#include "core/simdPack.h"
 
@@ -31,16 +31,30 @@
 #include "core/plbProfiler.h"
 #include "core/plbRandom.h"
 #include "core/runTimeDiagnostics.h"
+#include "parallelism/threadPool.h"
 #include <sstream>
+#include <cstdlib>
 
 namespace plb {
 
+/// The number of shared-memory threads per MPI process is read from
+///   the environment variable PLB_NUM_THREADS (default: 1).
+static void initThreadPool() {
+#ifdef PLB_SMP_PARALLEL
+    char const* numThreads = std::getenv("PLB_NUM_THREADS");
+    if (numThreads && std::atoi(numThreads)>0) {
+        global::threadPool().setNumThreads(std::atoi(numThreads));
+    }
+#endif
+}
+
 void plbInit(int *argc, char ***argv, bool verbous) {
     global::mpi().init(argc, argv, verbous);
     global::mainArguments().setArgs(*argc, argv);
     global::plbRandom<float>().seed(10);
     global::plbRandom<double>().seed(10);
     global::plbRandom<plint>().seed(10);
+    initThreadPool();
 }
 
 void plbInit() {
@@ -48,6 +62,7 @@ void plbInit() {
     global::plbRandom<float>().seed(10);
     global::plbRandom<double>().seed(10);
     global::plbRandom<plint>().seed(10);
+    initThreadPool();
 }
 
 namespace global {
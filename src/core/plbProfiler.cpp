@@ -32,7 +32,9 @@ namespace plb {
 
 namespace global {
 
-Profiler::Profiler() {
+Profiler::Profiler()
+    : suspendedFlag(false)
+{
     turnOff();
     automaticCycling();
     setReportFile("plbProfile");
@@ -59,6 +61,14 @@ void Profiler::turnOff() {
     profilingFlag = false;
 }
 
+void Profiler::suspend() {
+    suspendedFlag = true;
+}
+
+void Profiler::resume() {
+    suspendedFlag = false;
+}
+
 void Profiler::automaticCycling() {
     manualCycleFlag = false;
 }
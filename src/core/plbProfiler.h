@@ -58,6 +58,10 @@ class Profiler {
 public:
     void turnOn();
     void turnOff();
+    /// Temporarily ignore all timer and counter calls, for example while
+    ///   shared-memory threads are active.
+    void suspend();
+    void resume();
     void automaticCycling();
     void manualCycling();
     void cycle();
@@ -65,7 +69,7 @@ public:
         return !manualCycleFlag;
     }
     bool doProfiling() const {
-        return profilingFlag;
+        return profilingFlag && !suspendedFlag;
     }
     void start(char const* timer) {
         if (doProfiling()) {
@@ -110,6 +114,7 @@ private:
     Profiler();
 private:
     bool profilingFlag;
+    bool suspendedFlag;
     bool manualCycleFlag;
     FileName reportFile;
     std::set<std::string> validTimers;
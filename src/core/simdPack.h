@@ -0,0 +1,227 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Packs of floating-point values for explicit SIMD vectorization -- header file.
+ *
+ * The type simd::Pack<T> holds Pack<T>::width values of type T, and offers
+ * element-wise arithmetic. With AVX-512 (macro __AVX512F__) or AVX2 (macro
+ * __AVX2__) enabled in the compiler flags (e.g. -march=native), the packs
+ * of double and float are mapped to the corresponding intrinsic types.
+ * Otherwise, a pack is a plain array, which the compiler is free to
+ * auto-vectorize. The width is an enumerator rather than a static data member,
+ * so that it can be used in any expression, including as a function argument
+ * by reference, without an out-of-class definition.
+ */
+
+#ifndef SIMD_PACK_H
+#define SIMD_PACK_H
+
+#include "core/globalDefs.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace plb {
+
+namespace simd {
+
+/// Generic pack, used as scalar fallback.
+template<typename T>
+struct Pack {
+    enum { width = 4 };
+    T v[width];
+
+    static Pack broadcast(T x) {
+        Pack p;
+        for (plint i=0; i<width; ++i) p.v[i] = x;
+        return p;
+    }
+    /// Load width consecutive values; no alignment requirement.
+    static Pack load(T const* x) {
+        Pack p;
+        for (plint i=0; i<width; ++i) p.v[i] = x[i];
+        return p;
+    }
+    /// Store width consecutive values; no alignment requirement.
+    void store(T* x) const {
+        for (plint i=0; i<width; ++i) x[i] = v[i];
+    }
+    Pack& operator+=(Pack const& rhs) {
+        for (plint i=0; i<width; ++i) v[i] += rhs.v[i];
+        return *this;
+    }
+    Pack& operator-=(Pack const& rhs) {
+        for (plint i=0; i<width; ++i) v[i] -= rhs.v[i];
+        return *this;
+    }
+    Pack& operator*=(Pack const& rhs) {
+        for (plint i=0; i<width; ++i) v[i] *= rhs.v[i];
+        return *this;
+    }
+    Pack& operator/=(Pack const& rhs) {
+        for (plint i=0; i<width; ++i) v[i] /= rhs.v[i];
+        return *this;
+    }
+};
+
+#if defined(__AVX512F__)
+
+template<>
+struct Pack<double> {
+    enum { width = 8 };
+    __m512d v;
+
+    static Pack broadcast(double x) { Pack p; p.v = _mm512_set1_pd(x); return p; }
+    static Pack load(double const* x) { Pack p; p.v = _mm512_loadu_pd(x); return p; }
+    void store(double* x) const { _mm512_storeu_pd(x, v); }
+    Pack& operator+=(Pack const& rhs) { v = _mm512_add_pd(v, rhs.v); return *this; }
+    Pack& operator-=(Pack const& rhs) { v = _mm512_sub_pd(v, rhs.v); return *this; }
+    Pack& operator*=(Pack const& rhs) { v = _mm512_mul_pd(v, rhs.v); return *this; }
+    Pack& operator/=(Pack const& rhs) { v = _mm512_div_pd(v, rhs.v); return *this; }
+};
+
+template<>
+struct Pack<float> {
+    enum { width = 16 };
+    __m512 v;
+
+    static Pack broadcast(float x) { Pack p; p.v = _mm512_set1_ps(x); return p; }
+    static Pack load(float const* x) { Pack p; p.v = _mm512_loadu_ps(x); return p; }
+    void store(float* x) const { _mm512_storeu_ps(x, v); }
+    Pack& operator+=(Pack const& rhs) { v = _mm512_add_ps(v, rhs.v); return *this; }
+    Pack& operator-=(Pack const& rhs) { v = _mm512_sub_ps(v, rhs.v); return *this; }
+    Pack& operator*=(Pack const& rhs) { v = _mm512_mul_ps(v, rhs.v); return *this; }
+    Pack& operator/=(Pack const& rhs) { v = _mm512_div_ps(v, rhs.v); return *this; }
+};
+
+#elif defined(__AVX2__)
+
+template<>
+struct Pack<double> {
+    enum { width = 4 };
+    __m256d v;
+
+    static Pack broadcast(double x) { Pack p; p.v = _mm256_set1_pd(x); return p; }
+    static Pack load(double const* x) { Pack p; p.v = _mm256_loadu_pd(x); return p; }
+    void store(double* x) const { _mm256_storeu_pd(x, v); }
+    Pack& operator+=(Pack const& rhs) { v = _mm256_add_pd(v, rhs.v); return *this; }
+    Pack& operator-=(Pack const& rhs) { v = _mm256_sub_pd(v, rhs.v); return *this; }
+    Pack& operator*=(Pack const& rhs) { v = _mm256_mul_pd(v, rhs.v); return *this; }
+    Pack& operator/=(Pack const& rhs) { v = _mm256_div_pd(v, rhs.v); return *this; }
+};
+
+template<>
+struct Pack<float> {
+    enum { width = 8 };
+    __m256 v;
+
+    static Pack broadcast(float x) { Pack p; p.v = _mm256_set1_ps(x); return p; }
+    static Pack load(float const* x) { Pack p; p.v = _mm256_loadu_ps(x); return p; }
+    void store(float* x) const { _mm256_storeu_ps(x, v); }
+    Pack& operator+=(Pack const& rhs) { v = _mm256_add_ps(v, rhs.v); return *this; }
+    Pack& operator-=(Pack const& rhs) { v = _mm256_sub_ps(v, rhs.v); return *this; }
+    Pack& operator*=(Pack const& rhs) { v = _mm256_mul_ps(v, rhs.v); return *this; }
+    Pack& operator/=(Pack const& rhs) { v = _mm256_div_ps(v, rhs.v); return *this; }
+};
+
+#endif
+
+/// Load and store of width consecutive values in a storage type S, which
+///   can be narrower than the arithmetic type T of the pack.
+template<typename T, typename S>
+struct Converter {
+    static Pack<T> load(S const* x) {
+        T values[Pack<T>::width];
+        for (plint i=0; i<Pack<T>::width; ++i) values[i] = (T) x[i];
+        return Pack<T>::load(values);
+    }
+    static void store(Pack<T> const& p, S* x) {
+        T values[Pack<T>::width];
+        p.store(values);
+        for (plint i=0; i<Pack<T>::width; ++i) x[i] = (S) values[i];
+    }
+};
+
+template<typename T>
+struct Converter<T,T> {
+    static Pack<T> load(T const* x) { return Pack<T>::load(x); }
+    static void store(Pack<T> const& p, T* x) { p.store(x); }
+};
+
+#if defined(__AVX512F__)
+
+template<>
+struct Converter<double,float> {
+    static Pack<double> load(float const* x) {
+        Pack<double> p; p.v = _mm512_cvtps_pd(_mm256_loadu_ps(x)); return p;
+    }
+    static void store(Pack<double> const& p, float* x) { _mm256_storeu_ps(x, _mm512_cvtpd_ps(p.v)); }
+};
+
+#elif defined(__AVX2__)
+
+template<>
+struct Converter<double,float> {
+    static Pack<double> load(float const* x) {
+        Pack<double> p; p.v = _mm256_cvtps_pd(_mm_loadu_ps(x)); return p;
+    }
+    static void store(Pack<double> const& p, float* x) { _mm_storeu_ps(x, _mm256_cvtpd_ps(p.v)); }
+};
+
+#endif
+
+template<typename T>
+inline Pack<T> operator+(Pack<T> a, Pack<T> const& b) { return a += b; }
+
+template<typename T>
+inline Pack<T> operator-(Pack<T> a, Pack<T> const& b) { return a -= b; }
+
+template<typename T>
+inline Pack<T> operator*(Pack<T> a, Pack<T> const& b) { return a *= b; }
+
+template<typename T>
+inline Pack<T> operator/(Pack<T> a, Pack<T> const& b) { return a /= b; }
+
+template<typename T>
+inline Pack<T> operator-(Pack<T> const& a) { return Pack<T>::broadcast(T()) - a; }
+
+/// Name of the instruction set used by the packs of double.
+inline char const* instructionSet() {
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace simd
+
+}  // namespace plb
+
+#endif  // SIMD_PACK_H
@@ -33,4 +33,6 @@
 #include "dataProcessors/metaStuffWrapper3D.h"
 #include "dataProcessors/ntensorAnalysisFunctional3D.h"
 #include "dataProcessors/ntensorAnalysisWrapper3D.h"
+#include "dataProcessors/sparseLatticeFunctional3D.h"
+#include "dataProcessors/sparseLatticeWrapper3D.h"
 
@@ -33,6 +33,8 @@
 #include "dataProcessors/metaStuffWrapper3D.hh"
 #include "dataProcessors/ntensorAnalysisFunctional3D.hh"
 #include "dataProcessors/ntensorAnalysisWrapper3D.hh"
+#include "dataProcessors/sparseLatticeFunctional3D.hh"
+#include "dataProcessors/sparseLatticeWrapper3D.hh"
 // Include 2D versions, because they are required, for example to save 2D
 // images from 3D data.
 #include "dataProcessors/dataAnalysisFunctional2D.hh"
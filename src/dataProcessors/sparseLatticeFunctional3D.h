@@ -0,0 +1,117 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Data processors for the SparseBlockLattice3D -- header file.
+ */
+#ifndef SPARSE_LATTICE_FUNCTIONAL_3D_H
+#define SPARSE_LATTICE_FUNCTIONAL_3D_H
+
+#include "core/globalDefs.h"
+#include "atomicBlock/sparseBlockLattice3D.h"
+#include "atomicBlock/dataField3D.h"
+#include "dataProcessors/dataInitializerFunctional3D.h"
+
+namespace plb {
+
+/* ******************************************************************* */
+/* *************** Initialization of stored cells ******************** */
+/* ******************************************************************* */
+
+/// Execute a OneCellFunctional3D on the stored cells of a SparseBlockLattice3D.
+template<typename T, template<class U> class Descriptor>
+class GenericSparseLatticeFunctional3D : public SparseBoxProcessingFunctional3D_L<T,Descriptor>
+{
+public:
+    GenericSparseLatticeFunctional3D(OneCellFunctional3D<T,Descriptor>* f_);
+    GenericSparseLatticeFunctional3D(GenericSparseLatticeFunctional3D<T,Descriptor> const& rhs);
+    virtual ~GenericSparseLatticeFunctional3D();
+    GenericSparseLatticeFunctional3D<T,Descriptor>& operator=(GenericSparseLatticeFunctional3D<T,Descriptor> const& rhs);
+    virtual void process(Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice);
+    virtual GenericSparseLatticeFunctional3D<T,Descriptor>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual BlockDomain::DomainT appliesTo() const;
+private:
+    OneCellFunctional3D<T,Descriptor>* f;
+};
+
+/// Execute a OneCellIndexedFunctional3D on the stored cells of a SparseBlockLattice3D.
+template<typename T, template<class U> class Descriptor>
+class GenericIndexedSparseLatticeFunctional3D : public SparseBoxProcessingFunctional3D_L<T,Descriptor>
+{
+public:
+    GenericIndexedSparseLatticeFunctional3D(OneCellIndexedFunctional3D<T,Descriptor>* f_);
+    GenericIndexedSparseLatticeFunctional3D(GenericIndexedSparseLatticeFunctional3D<T,Descriptor> const& rhs);
+    virtual ~GenericIndexedSparseLatticeFunctional3D();
+    GenericIndexedSparseLatticeFunctional3D<T,Descriptor>& operator=(GenericIndexedSparseLatticeFunctional3D<T,Descriptor> const& rhs);
+    virtual void process(Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice);
+    virtual GenericIndexedSparseLatticeFunctional3D<T,Descriptor>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual BlockDomain::DomainT appliesTo() const;
+private:
+    OneCellIndexedFunctional3D<T,Descriptor>* f;
+};
+
+/* ******************************************************************* */
+/* *************** Analysis of the sparse lattice ******************** */
+/* ******************************************************************* */
+
+// In the following functionals, the cells which are not stored are assigned
+//   the value of the NoDynamics placeholder cell, as in a BlockLattice3D in
+//   which these cells have NoDynamics.
+
+template<typename T, template<typename U> class Descriptor>
+class SparseBoxDensityFunctional3D : public SparseBoxProcessingFunctional3D_LS<T,Descriptor,T>
+{
+public:
+    virtual void process(Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice,
+                                       ScalarField3D<T>& scalarField);
+    virtual SparseBoxDensityFunctional3D<T,Descriptor>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+};
+
+template<typename T, template<typename U> class Descriptor>
+class SparseBoxVelocityNormFunctional3D : public SparseBoxProcessingFunctional3D_LS<T,Descriptor,T>
+{
+public:
+    virtual void process(Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice,
+                                       ScalarField3D<T>& scalarField);
+    virtual SparseBoxVelocityNormFunctional3D<T,Descriptor>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+};
+
+template<typename T, template<typename U> class Descriptor>
+class SparseBoxVelocityFunctional3D :
+    public SparseBoxProcessingFunctional3D_LT<T,Descriptor,T,Descriptor<T>::d>
+{
+public:
+    virtual void process(Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice,
+                                       TensorField3D<T,Descriptor<T>::d>& tensorField);
+    virtual SparseBoxVelocityFunctional3D<T,Descriptor>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+};
+
+}  // namespace plb
+
+#endif  // SPARSE_LATTICE_FUNCTIONAL_3D_H
@@ -0,0 +1,286 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Data processors for the SparseBlockLattice3D -- generic implementation.
+ */
+#ifndef SPARSE_LATTICE_FUNCTIONAL_3D_HH
+#define SPARSE_LATTICE_FUNCTIONAL_3D_HH
+
+#include "dataProcessors/sparseLatticeFunctional3D.h"
+#include "atomicBlock/sparseBlockLattice3D.h"
+#include "atomicBlock/dataField3D.h"
+#include "core/util.h"
+#include <cmath>
+
+namespace plb {
+
+/* ******************************************************************* */
+/* *************** Initialization of stored cells ******************** */
+/* ******************************************************************* */
+
+template<typename T, template<class U> class Descriptor>
+GenericSparseLatticeFunctional3D<T,Descriptor>::GenericSparseLatticeFunctional3D (
+        OneCellFunctional3D<T,Descriptor>* f_ )
+    : f(f_)
+{ }
+
+template<typename T, template<class U> class Descriptor>
+GenericSparseLatticeFunctional3D<T,Descriptor>::GenericSparseLatticeFunctional3D (
+        GenericSparseLatticeFunctional3D<T,Descriptor> const& rhs )
+    : f(rhs.f->clone())
+{ }
+
+template<typename T, template<class U> class Descriptor>
+GenericSparseLatticeFunctional3D<T,Descriptor>::~GenericSparseLatticeFunctional3D() {
+    delete f;
+}
+
+template<typename T, template<class U> class Descriptor>
+GenericSparseLatticeFunctional3D<T,Descriptor>& GenericSparseLatticeFunctional3D<T,Descriptor>::operator= (
+        GenericSparseLatticeFunctional3D<T,Descriptor> const& rhs )
+{
+    delete f;
+    f = rhs.f->clone();
+    return *this;
+}
+
+template<typename T, template<class U> class Descriptor>
+void GenericSparseLatticeFunctional3D<T,Descriptor>::process (
+        Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice )
+{
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            lattice.getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                f->execute(lattice.getStoredCell(iCell));
+            }
+        }
+    }
+}
+
+template<typename T, template<class U> class Descriptor>
+GenericSparseLatticeFunctional3D<T,Descriptor>*
+    GenericSparseLatticeFunctional3D<T,Descriptor>::clone() const
+{
+    return new GenericSparseLatticeFunctional3D<T,Descriptor>(*this);
+}
+
+template<typename T, template<class U> class Descriptor>
+void GenericSparseLatticeFunctional3D<T,Descriptor>::getTypeOfModification (
+        std::vector<modif::ModifT>& modified ) const
+{
+    f->getTypeOfModification(modified);
+}
+
+template<typename T, template<class U> class Descriptor>
+BlockDomain::DomainT GenericSparseLatticeFunctional3D<T,Descriptor>::appliesTo() const {
+    return f->appliesTo();
+}
+
+
+template<typename T, template<class U> class Descriptor>
+GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::GenericIndexedSparseLatticeFunctional3D (
+        OneCellIndexedFunctional3D<T,Descriptor>* f_ )
+    : f(f_)
+{ }
+
+template<typename T, template<class U> class Descriptor>
+GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::GenericIndexedSparseLatticeFunctional3D (
+        GenericIndexedSparseLatticeFunctional3D<T,Descriptor> const& rhs )
+    : f(rhs.f->clone())
+{ }
+
+template<typename T, template<class U> class Descriptor>
+GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::~GenericIndexedSparseLatticeFunctional3D() {
+    delete f;
+}
+
+template<typename T, template<class U> class Descriptor>
+GenericIndexedSparseLatticeFunctional3D<T,Descriptor>&
+    GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::operator= (
+        GenericIndexedSparseLatticeFunctional3D<T,Descriptor> const& rhs )
+{
+    delete f;
+    f = rhs.f->clone();
+    return *this;
+}
+
+template<typename T, template<class U> class Descriptor>
+void GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::process (
+        Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice )
+{
+    Dot3D relativeOffset = lattice.getLocation();
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint begin, end;
+            lattice.getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+            for (plint iCell=begin; iCell<end; ++iCell) {
+                f->execute ( iX+relativeOffset.x,
+                             iY+relativeOffset.y,
+                             lattice.getStoredZ(iCell)+relativeOffset.z,
+                             lattice.getStoredCell(iCell) );
+            }
+        }
+    }
+}
+
+template<typename T, template<class U> class Descriptor>
+GenericIndexedSparseLatticeFunctional3D<T,Descriptor>*
+    GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::clone() const
+{
+    return new GenericIndexedSparseLatticeFunctional3D<T,Descriptor>(*this);
+}
+
+template<typename T, template<class U> class Descriptor>
+void GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::getTypeOfModification (
+        std::vector<modif::ModifT>& modified ) const
+{
+    f->getTypeOfModification(modified);
+}
+
+template<typename T, template<class U> class Descriptor>
+BlockDomain::DomainT GenericIndexedSparseLatticeFunctional3D<T,Descriptor>::appliesTo() const {
+    return f->appliesTo();
+}
+
+/* ******************************************************************* */
+/* *************** Analysis of the sparse lattice ******************** */
+/* ******************************************************************* */
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxDensityFunctional3D<T,Descriptor>::process (
+        Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice, ScalarField3D<T>& scalarField)
+{
+    Dot3D offset = computeRelativeDisplacement(lattice, scalarField);
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice.getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                T& rho = scalarField.get(iX+offset.x,iY+offset.y,iZ+offset.z);
+                if (iCell<end && lattice.getStoredZ(iCell)==iZ) {
+                    rho = lattice.getStoredCell(iCell).computeDensity();
+                    ++iCell;
+                }
+                else {
+                    rho = lattice.get(iX,iY,iZ).computeDensity();
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBoxDensityFunctional3D<T,Descriptor>* SparseBoxDensityFunctional3D<T,Descriptor>::clone() const
+{
+    return new SparseBoxDensityFunctional3D<T,Descriptor>(*this);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxDensityFunctional3D<T,Descriptor>::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    modified[0] = modif::nothing;
+    modified[1] = modif::staticVariables;
+}
+
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxVelocityNormFunctional3D<T,Descriptor>::process (
+        Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice, ScalarField3D<T>& scalarField)
+{
+    Dot3D offset = computeRelativeDisplacement(lattice, scalarField);
+    Array<T,Descriptor<T>::d> velocity;
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice.getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                if (iCell<end && lattice.getStoredZ(iCell)==iZ) {
+                    lattice.getStoredCell(iCell).computeVelocity(velocity);
+                    ++iCell;
+                }
+                else {
+                    lattice.get(iX,iY,iZ).computeVelocity(velocity);
+                }
+                scalarField.get(iX+offset.x,iY+offset.y,iZ+offset.z)
+                    = std::sqrt( (typename PlbTraits<T>::BaseType) VectorTemplate<T,Descriptor>::normSqr(velocity) );
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBoxVelocityNormFunctional3D<T,Descriptor>* SparseBoxVelocityNormFunctional3D<T,Descriptor>::clone() const
+{
+    return new SparseBoxVelocityNormFunctional3D<T,Descriptor>(*this);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxVelocityNormFunctional3D<T,Descriptor>::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    modified[0] = modif::nothing;
+    modified[1] = modif::staticVariables;
+}
+
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxVelocityFunctional3D<T,Descriptor>::process (
+        Box3D domain, SparseBlockLattice3D<T,Descriptor>& lattice,
+        TensorField3D<T,Descriptor<T>::d>& tensorField )
+{
+    Dot3D offset = computeRelativeDisplacement(lattice, tensorField);
+    for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+        for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+            plint iCell, end;
+            lattice.getColumnRange(iX, iY, domain.z0, domain.z1, iCell, end);
+            for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                Array<T,Descriptor<T>::d>& velocity =
+                    tensorField.get(iX+offset.x,iY+offset.y,iZ+offset.z);
+                if (iCell<end && lattice.getStoredZ(iCell)==iZ) {
+                    lattice.getStoredCell(iCell).computeVelocity(velocity);
+                    ++iCell;
+                }
+                else {
+                    lattice.get(iX,iY,iZ).computeVelocity(velocity);
+                }
+            }
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBoxVelocityFunctional3D<T,Descriptor>* SparseBoxVelocityFunctional3D<T,Descriptor>::clone() const
+{
+    return new SparseBoxVelocityFunctional3D<T,Descriptor>(*this);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void SparseBoxVelocityFunctional3D<T,Descriptor>::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    modified[0] = modif::nothing;
+    modified[1] = modif::staticVariables;
+}
+
+}  // namespace plb
+
+#endif  // SPARSE_LATTICE_FUNCTIONAL_3D_HH
@@ -0,0 +1,87 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Helper functions for the SparseBlockLattice3D -- header file.
+ */
+#ifndef SPARSE_LATTICE_WRAPPER_3D_H
+#define SPARSE_LATTICE_WRAPPER_3D_H
+
+#include "core/globalDefs.h"
+#include "multiBlock/multiSparseBlockLattice3D.h"
+#include "multiBlock/multiDataField3D.h"
+#include "dataProcessors/dataInitializerFunctional3D.h"
+#include <memory>
+
+namespace plb {
+
+/* *************** Initialization of stored cells ******************** */
+
+/// Execute a one-cell functional on the stored cells of a domain.
+template<typename T, template<class U> class Descriptor>
+void apply(MultiSparseBlockLattice3D<T,Descriptor>& lattice, Box3D domain, OneCellFunctional3D<T,Descriptor>* f);
+
+/// Execute a one-cell functional, with absolute coordinates, on the stored cells of a domain.
+template<typename T, template<class U> class Descriptor>
+void applyIndexed(MultiSparseBlockLattice3D<T,Descriptor>& lattice, Box3D domain, OneCellIndexedFunctional3D<T,Descriptor>* f);
+
+/* *************** Density ******************************************* */
+
+template<typename T, template<typename U> class Descriptor>
+void computeDensity(MultiSparseBlockLattice3D<T,Descriptor>& lattice, MultiScalarField3D<T>& density, Box3D domain);
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<T> > computeDensity(MultiSparseBlockLattice3D<T,Descriptor>& lattice, Box3D domain);
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<T> > computeDensity(MultiSparseBlockLattice3D<T,Descriptor>& lattice);
+
+/* *************** Velocity Norm ************************************* */
+
+template<typename T, template<typename U> class Descriptor>
+void computeVelocityNorm(MultiSparseBlockLattice3D<T,Descriptor>& lattice, MultiScalarField3D<T>& velocityNorm, Box3D domain);
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<T> > computeVelocityNorm(MultiSparseBlockLattice3D<T,Descriptor>& lattice, Box3D domain);
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<T> > computeVelocityNorm(MultiSparseBlockLattice3D<T,Descriptor>& lattice);
+
+/* *************** Velocity ****************************************** */
+
+template<typename T, template<typename U> class Descriptor>
+void computeVelocity(MultiSparseBlockLattice3D<T,Descriptor>& lattice,
+                     MultiTensorField3D<T,Descriptor<T>::d>& velocity, Box3D domain);
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiTensorField3D<T,Descriptor<T>::d> >
+    computeVelocity(MultiSparseBlockLattice3D<T,Descriptor>& lattice, Box3D domain);
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiTensorField3D<T,Descriptor<T>::d> >
+    computeVelocity(MultiSparseBlockLattice3D<T,Descriptor>& lattice);
+
+}  // namespace plb
+
+#endif  // SPARSE_LATTICE_WRAPPER_3D_H
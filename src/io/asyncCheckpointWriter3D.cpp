@@ -0,0 +1,281 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Asynchronous checkpointing of 3D multi-blocks -- implementation.
+ */
+
+#include "io/asyncCheckpointWriter3D.h"
+#include "io/multiBlockWriter3D.h"
+#include "io/parallelIO.h"
+#include "parallelism/mpiManager.h"
+#include "libraryInterfaces/TINYXML_xmlIO.h"
+#include "libraryInterfaces/TINYXML_xmlIO.hh"
+#include "core/plbDebug.h"
+#include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+#ifdef PLB_USE_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace plb {
+
+namespace parallelIO {
+
+AsyncCheckpointWriter3D::AsyncCheckpointWriter3D(plint numStagingBuffers, bool syncToDisk_)
+    : syncToDisk(syncToDisk_),
+      buffers(numStagingBuffers)
+#ifdef PLB_SMP_PARALLEL
+      , shutdown(false)
+#endif
+{
+    PLB_PRECONDITION( numStagingBuffers>=1 );
+#ifdef PLB_SMP_PARALLEL
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&workCondition, 0);
+    pthread_cond_init(&writtenCondition, 0);
+    pthread_create(&ioThread, 0, ioThreadMain, this);
+#endif
+}
+
+/** The destructor executes no collective operation, because it may be called
+ *  on a single process while an exception is unwinding the stack. The data of
+ *  the pending checkpoints is written to disk, but their .plb file is not, as
+ *  the processes cannot agree on the success of the writes. Errors are only
+ *  logged locally.
+ */
+AsyncCheckpointWriter3D::~AsyncCheckpointWriter3D() {
+#ifdef PLB_SMP_PARALLEL
+    // The I/O thread empties the write queue before it stops.
+    pthread_mutex_lock(&mutex);
+    shutdown = true;
+    pthread_cond_signal(&workCondition);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(ioThread, 0);
+    pthread_cond_destroy(&writtenCondition);
+    pthread_cond_destroy(&workCondition);
+    pthread_mutex_destroy(&mutex);
+#endif
+    for (pluint iPending=0; iPending<pending.size(); ++iPending) {
+        Checkpoint const& checkpoint = buffers[pending[iPending]];
+        if (checkpoint.ioError) {
+            std::cerr << "Unsuccessful writing into file " << checkpoint.dataName << std::endl;
+        }
+        if (global::mpi().isMainProcessor()) {
+            std::cerr << "Checkpoint " << checkpoint.specName
+                      << " is incomplete: AsyncCheckpointWriter3D::wait() was not called." << std::endl;
+        }
+    }
+}
+
+void AsyncCheckpointWriter3D::save(MultiBlock3D& multiBlock, FileName fName, bool dynamicContent)
+{
+    global::profiler().start("io");
+    FileName dataName(fName);
+    dataName.defaultPath(global::directories().getOutputDir());
+    dataName.defaultExt("dat");
+    FileName specName(fName);
+    specName.setExt("plb");
+    specName.defaultPath(global::directories().getOutputDir());
+
+    // A file which is still being written is not overwritten before its
+    //   checkpoint is complete, and all staging buffers may be in use.
+    bool sameFile = true;
+    while (sameFile) {
+        sameFile = false;
+        for (pluint iPending=0; iPending<pending.size(); ++iPending) {
+            if (buffers[pending[iPending]].dataName==dataName.get()) {
+                sameFile = true;
+            }
+        }
+        if (sameFile) {
+            completeOldest();
+        }
+    }
+    if (pending.size()==buffers.size()) {
+        completeOldest();
+    }
+    plint iBuffer = 0;
+    while (std::find(pending.begin(), pending.end(), iBuffer)!=pending.end()) {
+        ++iBuffer;
+    }
+
+    // The vectors of the staging buffer keep their capacity from the
+    //   previous checkpoint.
+    Checkpoint& checkpoint = buffers[iBuffer];
+    checkpoint.dataName = dataName.get();
+    checkpoint.specName = specName.get();
+    checkpoint.written = false;
+    checkpoint.ioError = false;
+    dumpData(multiBlock, dynamicContent, checkpoint.offset, checkpoint.myBlockIds, checkpoint.data);
+    if (global::IOpolicy().useCheckpointCompression()) {
+        compressDumpedData(multiBlock, checkpoint.offset, checkpoint.myBlockIds, checkpoint.data);
+    }
+    XMLwriter xml;
+    createXmlSpec(multiBlock, fName, checkpoint.offset, dynamicContent, xml);
+    std::ostringstream specStream;
+    xml.toOutputStream(specStream);
+    checkpoint.spec = specStream.str();
+
+    // The data file is created (or truncated) before any process writes into it.
+    bool errorFlag = false;
+    if (global::mpi().isMainProcessor()) {
+        FILE* fp = fopen(checkpoint.dataName.c_str(), "wb");
+        errorFlag = !fp;
+        if (fp) {
+            fclose(fp);
+        }
+    }
+    plbIOError(errorFlag, std::string("Could not create file ")+checkpoint.dataName);
+
+    pending.push_back(iBuffer);
+#ifdef PLB_SMP_PARALLEL
+    pthread_mutex_lock(&mutex);
+    writeQueue.push_back(iBuffer);
+    pthread_cond_signal(&workCondition);
+    pthread_mutex_unlock(&mutex);
+#else
+    writeData(checkpoint);
+    checkpoint.written = true;
+#endif
+    global::profiler().stop("io");
+}
+
+void AsyncCheckpointWriter3D::wait() {
+    while (!pending.empty()) {
+        completeOldest();
+    }
+}
+
+plint AsyncCheckpointWriter3D::getNumPending() const {
+    return (plint)pending.size();
+}
+
+void AsyncCheckpointWriter3D::completeOldest() {
+    PLB_ASSERT( !pending.empty() );
+    Checkpoint& checkpoint = buffers[pending.front()];
+#ifdef PLB_SMP_PARALLEL
+    pthread_mutex_lock(&mutex);
+    while (!checkpoint.written) {
+        pthread_cond_wait(&writtenCondition, &mutex);
+    }
+    pthread_mutex_unlock(&mutex);
+#endif
+    pending.pop_front();
+    // IMPORTANT: plbIOError synchronizes the processes, which guarantees that
+    //   all of them have written their data before the .plb file is written.
+    plbIOError(checkpoint.ioError, std::string("Unsuccessful writing into file ")+checkpoint.dataName);
+    if (global::mpi().isMainProcessor()) {
+        FILE* fp = fopen(checkpoint.specName.c_str(), "w");
+        bool specError = !fp;
+        if (fp) {
+            specError = fwrite(checkpoint.spec.c_str(), 1, checkpoint.spec.size(), fp)!=checkpoint.spec.size();
+            specError = fclose(fp)!=0 || specError;
+        }
+        checkpoint.ioError = specError;
+    }
+    plbIOError(checkpoint.ioError, std::string("Unsuccessful writing into file ")+checkpoint.specName);
+}
+
+/** The offsets of the blocks are the same as in parallelIO::writeRawData(). **/
+void AsyncCheckpointWriter3D::writeData(Checkpoint& checkpoint) const {
+    bool errorFlag = false;
+#ifdef PLB_USE_POSIX
+    int fd = open(checkpoint.dataName.c_str(), O_WRONLY);
+    errorFlag = fd<0;
+    for (pluint iBlock=0; iBlock<checkpoint.myBlockIds.size() && !errorFlag; ++iBlock) {
+        plint blockId = checkpoint.myBlockIds[iBlock];
+        plint nextOffset = blockId==0 ? 0 : checkpoint.offset[blockId-1];
+        std::vector<char> const& data = checkpoint.data[iBlock];
+        plint numWritten = 0;
+        while (numWritten<(plint)data.size() && !errorFlag) {
+            ssize_t written = pwrite(fd, &data[numWritten], data.size()-numWritten, nextOffset+numWritten);
+            errorFlag = written<=0;
+            numWritten += written;
+        }
+    }
+    if (fd>=0) {
+        if (syncToDisk && !errorFlag) {
+            errorFlag = fsync(fd)!=0;
+        }
+        errorFlag = close(fd)!=0 || errorFlag;
+    }
+#else
+    FILE* fp = fopen(checkpoint.dataName.c_str(), "r+b");
+    errorFlag = !fp;
+    for (pluint iBlock=0; iBlock<checkpoint.myBlockIds.size() && !errorFlag; ++iBlock) {
+        plint blockId = checkpoint.myBlockIds[iBlock];
+        plint nextOffset = blockId==0 ? 0 : checkpoint.offset[blockId-1];
+        std::vector<char> const& data = checkpoint.data[iBlock];
+        errorFlag = fseek(fp, (long int)nextOffset, SEEK_SET)!=0;
+        if (!errorFlag && !data.empty()) {
+            errorFlag = fwrite(&data[0], 1, data.size(), fp)!=data.size();
+        }
+    }
+    if (fp) {
+        errorFlag = fclose(fp)!=0 || errorFlag;
+    }
+#endif
+    checkpoint.ioError = errorFlag;
+}
+
+#ifdef PLB_SMP_PARALLEL
+
+void AsyncCheckpointWriter3D::work() {
+    pthread_mutex_lock(&mutex);
+    while (true) {
+        while (writeQueue.empty() && !shutdown) {
+            pthread_cond_wait(&workCondition, &mutex);
+        }
+        if (writeQueue.empty()) {
+            break;
+        }
+        Checkpoint& checkpoint = buffers[writeQueue.front()];
+        pthread_mutex_unlock(&mutex);
+        writeData(checkpoint);
+        pthread_mutex_lock(&mutex);
+        writeQueue.pop_front();
+        checkpoint.written = true;
+        pthread_cond_broadcast(&writtenCondition);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+void* AsyncCheckpointWriter3D::ioThreadMain(void* argument) {
+    static_cast<AsyncCheckpointWriter3D*>(argument)->work();
+    return 0;
+}
+
+#endif  // PLB_SMP_PARALLEL
+
+}  // namespace parallelIO
+
+}  // namespace plb
@@ -0,0 +1,120 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Asynchronous checkpointing of 3D multi-blocks -- header file.
+ */
+#ifndef ASYNC_CHECKPOINT_WRITER_3D_H
+#define ASYNC_CHECKPOINT_WRITER_3D_H
+
+#include "core/globalDefs.h"
+#include "multiBlock/multiBlock3D.h"
+#include "io/plbFiles.h"
+#include <string>
+#include <vector>
+#include <deque>
+
+#ifdef PLB_SMP_PARALLEL
+#include <pthread.h>
+#endif
+
+namespace plb {
+
+namespace parallelIO {
+
+/// Writes checkpoints in the format of parallelIO::save() from a background thread.
+/** save() serializes the multi-block into a staging buffer and returns; the
+ *  buffer is then written to disk by an I/O thread on each process, while the
+ *  simulation goes on. The staging buffers are reused from one checkpoint to the
+ *  next, and their number bounds the memory: when all of them are in use, save()
+ *  first waits for the oldest checkpoint to be written. With two buffers (the
+ *  default), a checkpoint can be taken while the previous one is being written.
+ *
+ *  A checkpoint is complete when the data of all processes has been written (and
+ *  synchronized to disk with fsync if syncToDisk is true). Only then is its .plb
+ *  file written, so that an existing .plb file always refers to complete data.
+ *  Checkpoints are completed in order, by save() when a staging buffer is
+ *  needed, or by wait(). The functions save() and wait() must be called by all
+ *  processes. Write errors are reported by wait() (or save()) through
+ *  plbIOError(). Call wait() before the writer is destroyed: the destructor
+ *  writes the data of the pending checkpoints, but not their .plb file, and only
+ *  logs errors locally, as it must not synchronize the processes.
+ *
+ *  Without PLB_SMP_PARALLEL, the data is written synchronously by save().
+ */
+class AsyncCheckpointWriter3D {
+public:
+    AsyncCheckpointWriter3D(plint numStagingBuffers=2, bool syncToDisk_=true);
+    ~AsyncCheckpointWriter3D();
+    /// Take a checkpoint, readable by parallelIO::load(). The multi-block can be
+    ///   modified as soon as the function returns.
+    void save(MultiBlock3D& multiBlock, FileName fName, bool dynamicContent=true);
+    /// Wait until all checkpoints are complete.
+    void wait();
+    /// Number of checkpoints taken with save() which are not yet complete.
+    plint getNumPending() const;
+private:
+    AsyncCheckpointWriter3D(AsyncCheckpointWriter3D const& rhs);
+    AsyncCheckpointWriter3D& operator=(AsyncCheckpointWriter3D const& rhs);
+    struct Checkpoint {
+        Checkpoint() : written(false), ioError(false) { }
+        std::string dataName;
+        std::string specName;
+        std::string spec;
+        std::vector<plint> offset;
+        std::vector<plint> myBlockIds;
+        std::vector<std::vector<char> > data;
+        bool written;
+        bool ioError;
+    };
+    /// Wait for the oldest pending checkpoint and write its .plb file.
+    void completeOldest();
+    /// Write the local data of a checkpoint into its data file.
+    void writeData(Checkpoint& checkpoint) const;
+#ifdef PLB_SMP_PARALLEL
+    void work();
+    static void* ioThreadMain(void* argument);
+#endif
+private:
+    bool syncToDisk;
+    std::vector<Checkpoint> buffers;
+    /// Buffers of the pending checkpoints, oldest first.
+    std::deque<plint> pending;
+#ifdef PLB_SMP_PARALLEL
+    /// Buffers which remain to be written by the I/O thread, oldest first.
+    std::deque<plint> writeQueue;
+    pthread_t ioThread;
+    pthread_mutex_t mutex;
+    pthread_cond_t workCondition;
+    pthread_cond_t writtenCondition;
+    bool shutdown;
+#endif
+};
+
+}  // namespace parallelIO
+
+}  // namespace plb
+
+#endif  // ASYNC_CHECKPOINT_WRITER_3D_H
@@ -0,0 +1,444 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Compression of serialized data -- implementation.
+ */
+
+#include "io/compression.h"
+#include "core/plbDebug.h"
+#include "core/runTimeDiagnostics.h"
+#include "parallelism/threadPool.h"
+#include <cstring>
+#include <cmath>
+#include <string>
+
+namespace plb {
+
+/* The compressed data starts with a header of headerSize bytes:
+ *   bytes 0-3:   the characters "PLBZ",
+ *   byte 4:      the codec (codecLossless or codecLossy),
+ *   byte 5:      the item size,
+ *   bytes 8-15:  the size of the uncompressed data,
+ *   bytes 16-23: (lossy codec only) the quantization step, as a double.
+ * It is followed by the LZ77 stream of the shuffled bytes.
+ *
+ * The LZ77 stream is a sequence of literals and matches, in the format used by
+ * the LZ4 block codec: a token byte holds the number of literals (upper four bits)
+ * and the length of the match minus minMatch (lower four bits), a value of 15
+ * being continued by additional bytes. The token is followed by the literals, by
+ * the distance to the match (two bytes, little endian), and by the continuation
+ * of the match length. The last sequence has literals only.
+ */
+
+const unsigned char codecLossless = 0;
+const unsigned char codecLossy = 1;
+const pluint headerSize = 16;
+const pluint lossyHeaderSize = 24;
+const plint minMatch = 4;
+const plint maxDistance = 65535;
+const int hashLog = 16;
+// The last bytes of the input are always stored as literals, which makes it
+//   possible to read four bytes at every position examined for matches.
+const plint lastLiterals = 8;
+
+static inline unsigned int read32(unsigned char const* p) {
+    unsigned int value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+static inline unsigned int hash32(unsigned int value) {
+    return (value*2654435761U) >> (32-hashLog);
+}
+
+static void writeLength(plint length, std::vector<char>& out) {
+    while (length>=255) {
+        out.push_back((char)255);
+        length -= 255;
+    }
+    out.push_back((char)length);
+}
+
+static void writeSequence( unsigned char const* literals, plint numLiterals,
+                    plint distance, plint matchLength, std::vector<char>& out )
+{
+    plint extraMatch = matchLength-minMatch;
+    unsigned char token = (unsigned char)((numLiterals<15 ? numLiterals : 15) << 4);
+    if (matchLength>0) {
+        token |= (unsigned char)(extraMatch<15 ? extraMatch : 15);
+    }
+    out.push_back((char)token);
+    if (numLiterals>=15) {
+        writeLength(numLiterals-15, out);
+    }
+    out.insert(out.end(), (char const*)literals, (char const*)literals+numLiterals);
+    if (matchLength>0) {
+        out.push_back((char)(distance & 0xff));
+        out.push_back((char)(distance >> 8));
+        if (extraMatch>=15) {
+            writeLength(extraMatch-15, out);
+        }
+    }
+}
+
+static void compressLZ(unsigned char const* in, plint size, std::vector<char>& out)
+{
+    std::vector<plint> table((plint)1 << hashLog, -1);
+    plint anchor = 0;
+    plint pos = 0;
+    plint limit = size-lastLiterals;
+    while (pos<limit) {
+        unsigned int sequence = read32(in+pos);
+        plint& entry = table[hash32(sequence)];
+        plint match = entry;
+        entry = pos;
+        if (match>=0 && pos-match<=maxDistance && read32(in+match)==sequence) {
+            plint length = minMatch;
+            while (pos+length<limit && in[match+length]==in[pos+length]) {
+                ++length;
+            }
+            writeSequence(in+anchor, pos-anchor, pos-match, length, out);
+            pos += length;
+            anchor = pos;
+        }
+        else {
+            ++pos;
+        }
+    }
+    writeSequence(in+anchor, size-anchor, 0, 0, out);
+}
+
+static plint readLength(unsigned char const*& ip, unsigned char const* end) {
+    plint length = 0;
+    unsigned char next = 255;
+    while (next==255) {
+        if (ip>=end) {
+            plbIOError("Corrupted compressed data.");
+        }
+        next = *ip++;
+        length += next;
+    }
+    return length;
+}
+
+static void decompressLZ(unsigned char const* ip, unsigned char const* end, std::vector<char>& out)
+{
+    pluint pos = 0;
+    while (ip<end) {
+        unsigned char token = *ip++;
+        plint numLiterals = token >> 4;
+        if (numLiterals==15) {
+            numLiterals += readLength(ip, end);
+        }
+        if (end-ip<numLiterals || out.size()-pos<(pluint)numLiterals) {
+            plbIOError("Corrupted compressed data.");
+        }
+        memcpy(&out[0]+pos, ip, numLiterals);
+        ip += numLiterals;
+        pos += numLiterals;
+        if (ip==end) {
+            break;
+        }
+        if (end-ip<2) {
+            plbIOError("Corrupted compressed data.");
+        }
+        pluint distance = (pluint)ip[0] | ((pluint)ip[1] << 8);
+        ip += 2;
+        plint matchLength = (token & 15);
+        if (matchLength==15) {
+            matchLength += readLength(ip, end);
+        }
+        matchLength += minMatch;
+        if (distance==0 || distance>pos || out.size()-pos<(pluint)matchLength) {
+            plbIOError("Corrupted compressed data.");
+        }
+        // The match may overlap with the bytes it produces: copy byte by byte.
+        for (plint iByte=0; iByte<matchLength; ++iByte, ++pos) {
+            out[pos] = out[pos-distance];
+        }
+    }
+    if (pos!=out.size()) {
+        plbIOError("Corrupted compressed data.");
+    }
+}
+
+static void shuffleBytes(char const* data, pluint size, plint typeSize, std::vector<char>& shuffled)
+{
+    shuffled.resize(size);
+    pluint numItems = size/typeSize;
+    for (plint iByte=0; iByte<typeSize; ++iByte) {
+        char* target = &shuffled[0]+iByte*numItems;
+        for (pluint iItem=0; iItem<numItems; ++iItem) {
+            target[iItem] = data[iItem*typeSize+iByte];
+        }
+    }
+    // Remaining bytes which do not form a complete item.
+    for (pluint iByte=numItems*typeSize; iByte<size; ++iByte) {
+        shuffled[iByte] = data[iByte];
+    }
+}
+
+static void unshuffleBytes(std::vector<char> const& shuffled, plint typeSize, std::vector<char>& data)
+{
+    pluint size = shuffled.size();
+    data.resize(size);
+    if (size==0) {
+        return;
+    }
+    pluint numItems = size/typeSize;
+    for (plint iByte=0; iByte<typeSize; ++iByte) {
+        char const* source = &shuffled[0]+iByte*numItems;
+        for (pluint iItem=0; iItem<numItems; ++iItem) {
+            data[iItem*typeSize+iByte] = source[iItem];
+        }
+    }
+    for (pluint iByte=numItems*typeSize; iByte<size; ++iByte) {
+        data[iByte] = shuffled[iByte];
+    }
+}
+
+static void writeHeader( unsigned char codec, plint typeSize, pluint rawSize,
+                  std::vector<char>& compressed )
+{
+    compressed.assign(headerSize, 0);
+    memcpy(&compressed[0], "PLBZ", 4);
+    compressed[4] = (char)codec;
+    compressed[5] = (char)typeSize;
+    unsigned long long size = rawSize;
+    memcpy(&compressed[8], &size, 8);
+}
+
+static void shuffleAndCompress( char const* data, pluint size, plint typeSize,
+                         std::vector<char>& compressed )
+{
+    if (size==0) {
+        return;
+    }
+    std::vector<char> shuffled;
+    shuffleBytes(data, size, typeSize, shuffled);
+    compressLZ((unsigned char const*)&shuffled[0], (plint)size, compressed);
+}
+
+static void decompressAndUnshuffle( unsigned char const* begin, unsigned char const* end, pluint rawSize,
+                             plint typeSize, std::vector<char>& data )
+{
+    std::vector<char> shuffled(rawSize);
+    if (rawSize>0) {
+        decompressLZ(begin, end, shuffled);
+    }
+    unshuffleBytes(shuffled, typeSize, data);
+}
+
+template<typename T>
+static void compressLossyGeneric( T const* values, pluint numValues, double errorBound,
+                           std::vector<char>& compressed )
+{
+    PLB_PRECONDITION( errorBound>0. );
+    double step = 2.*errorBound;
+    // The quantization indices are stored as differences to the previous index,
+    //   with the sign in the lowest bit, which makes them small for smooth data.
+    std::vector<unsigned long long> codes(numValues);
+    long long previous = 0;
+    for (pluint iValue=0; iValue<numValues; ++iValue) {
+        double value = (double)values[iValue];
+        if (!(std::fabs(value/step)<4.e18)) {
+            compressLossless((char const*)values, numValues*sizeof(T), sizeof(T), compressed);
+            return;
+        }
+        long long index = (long long)std::floor(value/step+0.5);
+        // Rounding errors of the reconstruction are corrected by a neighbor index.
+        if (std::fabs((double)(T)(index*step)-value) > errorBound) {
+            if (std::fabs((double)(T)((index-1)*step)-value) <= errorBound) {
+                --index;
+            }
+            else if (std::fabs((double)(T)((index+1)*step)-value) <= errorBound) {
+                ++index;
+            }
+            else {
+                compressLossless((char const*)values, numValues*sizeof(T), sizeof(T), compressed);
+                return;
+            }
+        }
+        long long delta = index-previous;
+        codes[iValue] = delta<0 ? ((unsigned long long)(-(delta+1)) << 1) | 1ULL
+                                : (unsigned long long)delta << 1;
+        previous = index;
+    }
+    writeHeader(codecLossy, sizeof(T), numValues*sizeof(T), compressed);
+    compressed.resize(lossyHeaderSize);
+    memcpy(&compressed[headerSize], &step, 8);
+    if (numValues>0) {
+        shuffleAndCompress((char const*)&codes[0], numValues*sizeof(unsigned long long),
+                           sizeof(unsigned long long), compressed);
+    }
+}
+
+template<typename T>
+static void decompressLossyGeneric( unsigned char const* begin, unsigned char const* end,
+                             pluint numValues, double step, std::vector<char>& data )
+{
+    std::vector<char> codeBytes;
+    decompressAndUnshuffle(begin, end, numValues*sizeof(unsigned long long),
+                           sizeof(unsigned long long), codeBytes);
+    data.resize(numValues*sizeof(T));
+    long long index = 0;
+    for (pluint iValue=0; iValue<numValues; ++iValue) {
+        unsigned long long code;
+        memcpy(&code, &codeBytes[iValue*sizeof(code)], sizeof(code));
+        long long delta = (code & 1ULL) ? -(long long)(code >> 1)-1 : (long long)(code >> 1);
+        index += delta;
+        T value = (T)(index*step);
+        memcpy(&data[iValue*sizeof(T)], &value, sizeof(T));
+    }
+}
+
+void compressLossless(char const* data, pluint size, plint typeSize, std::vector<char>& compressed)
+{
+    PLB_PRECONDITION( typeSize>=1 && typeSize<=255 );
+    writeHeader(codecLossless, typeSize, size, compressed);
+    shuffleAndCompress(data, size, typeSize, compressed);
+}
+
+void compressLossy(float const* values, pluint numValues, double errorBound, std::vector<char>& compressed)
+{
+    compressLossyGeneric(values, numValues, errorBound, compressed);
+}
+
+void compressLossy(double const* values, pluint numValues, double errorBound, std::vector<char>& compressed)
+{
+    compressLossyGeneric(values, numValues, errorBound, compressed);
+}
+
+void compressData( char const* data, pluint size, CompressionMode::ModeT mode, plint typeSize,
+                   double errorBound, std::vector<char>& compressed )
+{
+    if (mode==CompressionMode::lossy) {
+        if (typeSize==(plint)sizeof(float)) {
+            compressLossy((float const*)data, size/sizeof(float), errorBound, compressed);
+        }
+        else if (typeSize==(plint)sizeof(double)) {
+            compressLossy((double const*)data, size/sizeof(double), errorBound, compressed);
+        }
+        else {
+            plbLogicError("Lossy compression is only available for float and double values.");
+        }
+    }
+    else {
+        compressLossless(data, size, typeSize, compressed);
+    }
+}
+
+void decompressData(char const* compressed, pluint size, std::vector<char>& data)
+{
+    if (size<headerSize || memcmp(compressed, "PLBZ", 4)!=0) {
+        plbIOError("The data was not compressed by Palabos.");
+    }
+    unsigned char const* begin = (unsigned char const*)compressed;
+    unsigned char const* end = begin+size;
+    unsigned char codec = begin[4];
+    plint typeSize = begin[5];
+    unsigned long long rawSize;
+    memcpy(&rawSize, compressed+8, 8);
+    if (codec==codecLossless) {
+        if (typeSize==0) {
+            plbIOError("Corrupted compressed data.");
+        }
+        decompressAndUnshuffle(begin+headerSize, end, rawSize, typeSize, data);
+    }
+    else if (codec==codecLossy) {
+        if (size<lossyHeaderSize) {
+            plbIOError("Corrupted compressed data.");
+        }
+        double step;
+        memcpy(&step, compressed+headerSize, 8);
+        if (typeSize==(plint)sizeof(float)) {
+            decompressLossyGeneric<float>(begin+lossyHeaderSize, end, rawSize/sizeof(float), step, data);
+        }
+        else if (typeSize==(plint)sizeof(double)) {
+            decompressLossyGeneric<double>(begin+lossyHeaderSize, end, rawSize/sizeof(double), step, data);
+        }
+        else {
+            plbIOError("Corrupted compressed data.");
+        }
+    }
+    else {
+        plbIOError(std::string("Unknown compression codec."));
+    }
+}
+
+/// Compresses or decompresses one buffer per task.
+class CompressBuffersTask : public ThreadPoolTask {
+public:
+    CompressBuffersTask( std::vector<std::vector<char> >& buffers_, bool decompress_,
+                         CompressionMode::ModeT mode_, plint typeSize_, double errorBound_ )
+        : buffers(buffers_),
+          decompress(decompress_),
+          mode(mode_),
+          typeSize(typeSize_),
+          errorBound(errorBound_)
+    { }
+    virtual void execute(plint iTask) {
+        std::vector<char>& buffer = buffers[iTask];
+        std::vector<char> result;
+        if (decompress) {
+            decompressData(buffer.empty() ? 0 : &buffer[0], buffer.size(), result);
+        }
+        else {
+            compressData(buffer.empty() ? 0 : &buffer[0], buffer.size(), mode, typeSize, errorBound, result);
+        }
+        buffer.swap(result);
+    }
+private:
+    std::vector<std::vector<char> >& buffers;
+    bool decompress;
+    CompressionMode::ModeT mode;
+    plint typeSize;
+    double errorBound;
+};
+
+void compressBuffers( std::vector<std::vector<char> >& buffers, CompressionMode::ModeT mode,
+                      plint typeSize, double errorBound )
+{
+    CompressBuffersTask task(buffers, false, mode, typeSize, errorBound);
+    global::threadPool().execute(task, std::vector<int>(buffers.size(), 0));
+}
+
+void decompressBuffers(std::vector<std::vector<char> >& buffers)
+{
+    CompressBuffersTask task(buffers, true, CompressionMode::lossless, 1, 0.);
+    bool errorFlag = false;
+    std::string message;
+    try {
+        global::threadPool().execute(task, std::vector<int>(buffers.size(), 0));
+    }
+    catch (PlbException const& exception) {
+        errorFlag = true;
+        message = exception.what();
+    }
+    plbIOError(errorFlag, "Decompression of the data failed. "+message);
+}
+
+}  // namespace plb
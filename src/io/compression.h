@@ -0,0 +1,78 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Compression of serialized data -- header file.
+ */
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include "core/globalDefs.h"
+#include <vector>
+
+namespace plb {
+
+struct CompressionMode {
+    enum ModeT { lossless, lossy };
+};
+
+/// Lossless compression of data made of items of typeSize bytes.
+/** The bytes of the items are first regrouped by position (byte shuffle), which
+ *  puts for example the sign and exponent bytes of floating-point values next to
+ *  each other. The result is compressed with an LZ77 codec.
+ */
+void compressLossless(char const* data, pluint size, plint typeSize, std::vector<char>& compressed);
+
+/// Lossy compression of floating-point values, with an absolute error not larger than errorBound.
+/** The values are quantized in steps of 2*errorBound, and the differences between
+ *  successive quantization indices are compressed with compressLossless(). If a
+ *  value cannot be quantized (because it is not finite or too large compared to
+ *  errorBound), all values are compressed without loss.
+ */
+void compressLossy(float const* values, pluint numValues, double errorBound, std::vector<char>& compressed);
+void compressLossy(double const* values, pluint numValues, double errorBound, std::vector<char>& compressed);
+
+/// Compress with compressLossless() or compressLossy(). In the lossy case, typeSize
+///   must be the size of float or double.
+void compressData( char const* data, pluint size, CompressionMode::ModeT mode, plint typeSize,
+                   double errorBound, std::vector<char>& compressed );
+
+/// Restore data compressed by one of the functions above.
+/** Corrupted input is reported through plbIOError(). */
+void decompressData(char const* compressed, pluint size, std::vector<char>& data);
+
+/// Replace every buffer by its compressed version. The buffers are compressed
+///   in parallel by the threads of global::threadPool().
+void compressBuffers( std::vector<std::vector<char> >& buffers, CompressionMode::ModeT mode,
+                      plint typeSize, double errorBound=0. );
+
+/// Replace every buffer compressed by compressBuffers() by its original version.
+/** Errors are reported collectively: this function must be called by all processes.
+ */
+void decompressBuffers(std::vector<std::vector<char> >& buffers);
+
+}  // namespace plb
+
+#endif  // COMPRESSION_H
@@ -29,6 +29,7 @@
 #include "io/base64.h"
 #include "io/serializerIO.h"
 #include "io/serializerIO_3D.h"
+#include "io/compression.h"
 #include "io/vtkDataOutput.h"
 #include "io/sparseVtkDataOutput.h"
 #include "io/vtkStructuredDataOutput.h"
@@ -39,6 +40,8 @@
 #include "io/plbFiles.h"
 #include "io/multiBlockReader3D.h"
 #include "io/multiBlockWriter3D.h"
+#include "io/asyncCheckpointWriter3D.h"
+#include "io/incrementalCheckpoint3D.h"
 #include "io/utilIO_3D.h"
 #include "io/transientStatistics3D.h"
 
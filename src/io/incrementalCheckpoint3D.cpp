@@ -0,0 +1,362 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Incremental checkpoints of 3D multi-blocks -- implementation.
+ */
+
+#include "io/incrementalCheckpoint3D.h"
+#include "io/multiBlockReader3D.h"
+#include "io/multiBlockWriter3D.h"
+#include "io/mpiParallelIO.h"
+#include "parallelism/mpiManager.h"
+#include "libraryInterfaces/TINYXML_xmlIO.h"
+#include "libraryInterfaces/TINYXML_xmlIO.hh"
+#include "core/plbDebug.h"
+#include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
+#include <memory>
+
+namespace plb {
+
+namespace parallelIO {
+
+/// Data files of a checkpoint, and the location of every atomic-block in them.
+struct CheckpointChain3D {
+    std::vector<std::string> files;
+    std::vector<plint> blockFile;
+    std::vector<plint> blockOffset;
+    /// Empty if the checkpoint was written by save().
+    std::vector<unsigned long long> blockHash;
+};
+
+/// 64-bit FNV-1a hash of the serialized data of an atomic-block.
+static unsigned long long hashCheckpointBlock(std::vector<char> const& data)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (pluint iByte=0; iByte<data.size(); ++iByte) {
+        hash ^= (unsigned long long)(unsigned char)data[iByte];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static plint checkpointBlockSize(std::vector<plint> const& offset, plint blockId)
+{
+    return blockId==0 ? offset[0] : offset[blockId]-offset[blockId-1];
+}
+
+/// Read the Data/Incremental section of the .plb file, and return false if there is none.
+///   In this case, the chain is filled with the unique data file of the checkpoint.
+static bool readCheckpointChain( FileName fName, FileName const& data_fName,
+                                 std::vector<plint> const& offset, CheckpointChain3D& chain )
+{
+    fName.defaultPath(global::directories().getInputDir());
+    fName.setExt("plb");
+    plint numBlocks = (plint)offset.size();
+    chain.files.clear();
+    XMLreader reader(fName);
+    XMLreaderProxy incremental(0);
+    try {
+        incremental = reader["Block3D"]["Data"]["Incremental"];
+    }
+    catch(PlbIOException const&) {
+        chain.files.push_back(data_fName.get());
+        chain.blockFile.assign(numBlocks, 0);
+        chain.blockOffset.resize(numBlocks);
+        for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+            chain.blockOffset[iBlock] = iBlock==0 ? 0 : offset[iBlock-1];
+        }
+        chain.blockHash.clear();
+        return false;
+    }
+    // As for Data/File, data files without path specification are taken
+    //   to be in the same directory as the xml file.
+    XMLreaderProxy file = incremental["File"];
+    for (; file.isValid(); file = file.iterId()) {
+        std::string file_str;
+        file.read(file_str);
+        chain.files.push_back(FileName(file_str).defaultPath(fName.getPath()).get());
+    }
+    incremental["BlockFile"].read(chain.blockFile);
+    incremental["BlockOffset"].read(chain.blockOffset);
+    incremental["BlockHash"].read(chain.blockHash);
+    if ( (plint)chain.blockFile.size()!=numBlocks || (plint)chain.blockOffset.size()!=numBlocks ||
+         (plint)chain.blockHash.size()!=numBlocks )
+    {
+        plbIOError(std::string("Incremental data does not match number of components in XML file."));
+    }
+    for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+        if (chain.blockFile[iBlock]<0 || chain.blockFile[iBlock]>=(plint)chain.files.size()) {
+            plbIOError(std::string("Invalid data file index in XML file ")+fName.get());
+        }
+    }
+    return true;
+}
+
+/// Read the local atomic-blocks from the data files of the chain, one file after the other.
+static void loadChainData( CheckpointChain3D const& chain, std::vector<plint> const& myBlockIds,
+                           std::vector<plint> const& offset, std::vector<std::vector<char> >& data )
+{
+    PLB_ASSERT( myBlockIds.size() == data.size() );
+    for (plint iFile=0; iFile<(plint)chain.files.size(); ++iFile) {
+        std::vector<plint> localIds, chunkOffset, chunkSize;
+        for (plint iBlock=0; iBlock<(plint)myBlockIds.size(); ++iBlock) {
+            plint blockId = myBlockIds[iBlock];
+            if (chain.blockFile[blockId]==iFile) {
+                localIds.push_back(iBlock);
+                chunkOffset.push_back(chain.blockOffset[blockId]);
+                chunkSize.push_back(checkpointBlockSize(offset, blockId));
+            }
+        }
+        std::vector<std::vector<char> > chunks(localIds.size());
+        loadRawChunks(FileName(chain.files[iFile]), chunkOffset, chunkSize, chunks);
+        for (pluint iChunk=0; iChunk<localIds.size(); ++iChunk) {
+            data[localIds[iChunk]].swap(chunks[iChunk]);
+        }
+    }
+}
+
+/// Read the chain of the base checkpoint, after verifying that it is compatible
+///   with the multi-block. Returns false if the base has no hashes.
+static bool readCheckpointBase( MultiBlock3D& multiBlock, FileName const& baseName, bool dynamicContent,
+                                std::vector<plint>& baseOffset, CheckpointChain3D& chain )
+{
+    Box3D boundingBox;
+    plint envelopeWidth, gridLevel, cellDim;
+    std::string dataType, descriptor, family;
+    std::vector<Box3D> components;
+    bool baseDynamicContent;
+    FileName data_fName;
+    readXmlSpec( baseName, boundingBox, baseOffset, envelopeWidth, gridLevel, cellDim, dataType,
+                 descriptor, family, components, baseDynamicContent, data_fName );
+
+    std::map<plint,Box3D> const& bulks =
+        multiBlock.getMultiBlockManagement().getSparseBlockStructure().getBulks();
+    bool compatible = family==multiBlock.getBlockName() && dataType==multiBlock.getTypeInfo()[0] &&
+                      baseDynamicContent==dynamicContent && components.size()==bulks.size() &&
+                      readXmlCompression(baseName)==global::IOpolicy().useCheckpointCompression();
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (pluint iComp=0; compatible && iComp<components.size(); ++iComp, ++it) {
+        compatible = components[iComp]==it->second;
+    }
+    if (!compatible) {
+        plbIOError( std::string("The checkpoint ") + baseName.get() + " differs from the multi-block in "
+                    "its structure, data type or compression, and cannot be used as a base." );
+    }
+    return readCheckpointChain(baseName, data_fName, baseOffset, chain);
+}
+
+/// Name of a data file, as written into the .plb file in directory specPath.
+static std::string checkpointFileEntry(FileName const& file, std::string const& specPath)
+{
+    if (file.getPath()==specPath) {
+        return FileName(file).setPath("").get();
+    }
+    else {
+        return file.get();
+    }
+}
+
+/// Common implementation of saveIncrementalBase() (baseName==0) and saveIncremental().
+static void saveCheckpoint( MultiBlock3D& multiBlock, FileName fName, FileName const* baseName,
+                            bool dynamicContent )
+{
+    global::profiler().start("io");
+    std::vector<plint> offset;
+    std::vector<plint> myBlockIds;
+    std::vector<std::vector<char> > data;
+    dumpData(multiBlock, dynamicContent, offset, myBlockIds, data);
+    if (global::IOpolicy().useCheckpointCompression()) {
+        compressDumpedData(multiBlock, offset, myBlockIds, data);
+    }
+    plint numBlocks = (plint)offset.size();
+
+    // Every process gets the hash of all blocks, and can decide by itself which
+    //   ones have changed.
+    std::vector<unsigned long long> blockHash(numBlocks, 0);
+    for (pluint iBlock=0; iBlock<myBlockIds.size(); ++iBlock) {
+        blockHash[myBlockIds[iBlock]] = hashCheckpointBlock(data[iBlock]);
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(blockHash, MPI_SUM);
+#endif
+
+    FileName dataName(fName);
+    dataName.setExt("dat").defaultPath(global::directories().getOutputDir());
+    FileName specName(fName);
+    specName.setExt("plb").defaultPath(global::directories().getOutputDir());
+
+    CheckpointChain3D chain;
+    std::vector<bool> changed(numBlocks, true);
+    if (baseName) {
+        std::vector<plint> baseOffset;
+        std::vector<std::vector<char> > baseData;
+        bool hashedBase = readCheckpointBase(multiBlock, *baseName, dynamicContent, baseOffset, chain);
+        if (!hashedBase) {
+            baseData.resize(myBlockIds.size());
+            loadChainData(chain, myBlockIds, baseOffset, baseData);
+            chain.blockHash.assign(numBlocks, 0);
+            for (pluint iBlock=0; iBlock<myBlockIds.size(); ++iBlock) {
+                chain.blockHash[myBlockIds[iBlock]] = hashCheckpointBlock(baseData[iBlock]);
+            }
+#ifdef PLB_MPI_PARALLEL
+            global::mpi().allReduceVect(chain.blockHash, MPI_SUM);
+#endif
+        }
+        for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+            changed[iBlock] = blockHash[iBlock]!=chain.blockHash[iBlock] ||
+                checkpointBlockSize(offset, iBlock)!=checkpointBlockSize(baseOffset, iBlock);
+        }
+        // When the data of the base has been read, blocks with equal hashes are
+        //   also compared byte by byte, to exclude hash collisions.
+        if (!hashedBase) {
+            std::vector<int> collision(numBlocks, 0);
+            for (pluint iBlock=0; iBlock<myBlockIds.size(); ++iBlock) {
+                plint blockId = myBlockIds[iBlock];
+                if (!changed[blockId] && data[iBlock]!=baseData[iBlock]) {
+                    collision[blockId] = 1;
+                }
+            }
+#ifdef PLB_MPI_PARALLEL
+            global::mpi().allReduceVect(collision, MPI_SUM);
+#endif
+            for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+                changed[iBlock] = changed[iBlock] || collision[iBlock]!=0;
+            }
+        }
+        for (pluint iFile=0; iFile<chain.files.size(); ++iFile) {
+            if (chain.files[iFile]==dataName.get()) {
+                plbIOError( std::string("The data file ") + dataName.get() +
+                            " is used by the base checkpoint, and cannot be overwritten." );
+            }
+        }
+    }
+    else {
+        chain.blockFile.resize(numBlocks);
+        chain.blockOffset.resize(numBlocks);
+    }
+    chain.blockHash.swap(blockHash);
+
+    // The changed blocks are written contiguously into the new data file.
+    std::vector<plint> newOffset, newBlockId(numBlocks, -1), myNewBlockIds;
+    std::vector<std::vector<char> > newData;
+    plint newFile = (plint)chain.files.size();
+    for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+        if (changed[iBlock]) {
+            newBlockId[iBlock] = (plint)newOffset.size();
+            chain.blockFile[iBlock] = newFile;
+            chain.blockOffset[iBlock] = newOffset.empty() ? 0 : newOffset.back();
+            newOffset.push_back(chain.blockOffset[iBlock]+checkpointBlockSize(offset, iBlock));
+        }
+    }
+    for (pluint iBlock=0; iBlock<myBlockIds.size(); ++iBlock) {
+        plint blockId = myBlockIds[iBlock];
+        if (changed[blockId]) {
+            myNewBlockIds.push_back(newBlockId[blockId]);
+            newData.push_back(std::vector<char>());
+            newData.back().swap(data[iBlock]);
+        }
+    }
+    if (!newOffset.empty()) {
+        chain.files.push_back(dataName.get());
+        writeRawData(dataName, myNewBlockIds, newOffset, newData);
+    }
+
+    // Data files which are no longer used are removed from the chain.
+    std::vector<plint> fileIndex(chain.files.size(), -1);
+    std::vector<std::string> usedFiles;
+    for (plint iBlock=0; iBlock<numBlocks; ++iBlock) {
+        plint& iFile = fileIndex[chain.blockFile[iBlock]];
+        if (iFile<0) {
+            iFile = (plint)usedFiles.size();
+            usedFiles.push_back(chain.files[chain.blockFile[iBlock]]);
+        }
+        chain.blockFile[iBlock] = iFile;
+    }
+    chain.files.swap(usedFiles);
+
+    // The .plb file is written last, so that it always refers to complete data.
+    XMLwriter xml;
+    createXmlSpec(multiBlock, fName, offset, dynamicContent, xml);
+    XMLwriter& xmlIncremental = xml["Block3D"]["Data"]["Incremental"];
+    if (baseName) {
+        xmlIncremental["Base"].setString(baseName->get());
+    }
+    for (plint iFile=0; iFile<(plint)chain.files.size(); ++iFile) {
+        xmlIncremental["File"][iFile].setString (
+                checkpointFileEntry(FileName(chain.files[iFile]), specName.getPath()) );
+    }
+    xmlIncremental["BlockFile"].set(chain.blockFile);
+    xmlIncremental["BlockOffset"].set(chain.blockOffset);
+    xmlIncremental["BlockHash"].set(chain.blockHash);
+    xml.print(specName.get());
+    global::profiler().stop("io");
+}
+
+void saveIncrementalBase( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent )
+{
+    saveCheckpoint(multiBlock, fName, 0, dynamicContent);
+}
+
+void saveIncremental( MultiBlock3D& multiBlock, FileName fName, FileName baseName,
+                      bool dynamicContent )
+{
+    saveCheckpoint(multiBlock, fName, &baseName, dynamicContent);
+}
+
+void compactCheckpoint( FileName fName, FileName compactName )
+{
+    Box3D boundingBox;
+    std::vector<plint> offset;
+    plint envelopeWidth, gridLevel, cellDim;
+    std::string dataType, descriptor, family;
+    std::vector<Box3D> components;
+    bool dynamicContent;
+    FileName data_fName;
+    readXmlSpec( fName, boundingBox, offset, envelopeWidth, gridLevel, cellDim, dataType,
+                 descriptor, family, components, dynamicContent, data_fName );
+
+    // The whole chain is read before anything is written, which makes it
+    //   possible to overwrite the checkpoint by its compacted version.
+    std::auto_ptr<MultiBlock3D> multiBlock(load3D(fName));
+    saveCheckpoint(*multiBlock, compactName, 0, dynamicContent);
+}
+
+void loadCheckpointData( FileName fName, FileName data_fName, std::vector<plint> const& myBlockIds,
+                         std::vector<plint> const& offset, std::vector<std::vector<char> >& data )
+{
+    CheckpointChain3D chain;
+    if (readCheckpointChain(fName, data_fName, offset, chain)) {
+        loadChainData(chain, myBlockIds, offset, data);
+    }
+    else {
+        loadRawData(data_fName, myBlockIds, offset, data);
+    }
+}
+
+}  // namespace parallelIO
+
+}  // namespace plb
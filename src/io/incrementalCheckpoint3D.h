@@ -0,0 +1,92 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Incremental checkpoints of 3D multi-blocks -- header file.
+ */
+#ifndef INCREMENTAL_CHECKPOINT_3D_H
+#define INCREMENTAL_CHECKPOINT_3D_H
+
+#include "core/globalDefs.h"
+#include "multiBlock/multiBlock3D.h"
+#include "io/plbFiles.h"
+#include <vector>
+
+namespace plb {
+
+namespace parallelIO {
+
+/** An incremental checkpoint only writes the atomic-blocks whose serialized content
+ *  differs from a previous checkpoint, its base. The other blocks are read from the
+ *  data files of the base. The .plb file of every checkpoint in the chain (the
+ *  manifest) has the content written by save(), plus a section Data/Incremental which
+ *  lists, for every atomic-block, the data file and the position of its content, as
+ *  well as a hash of the content. A manifest is therefore self-sufficient: a checkpoint
+ *  is restored with load() (or load3D()), which follows the chain, and the
+ *  intermediate manifests of the chain can be deleted. The data files referenced by
+ *  the manifest must however be kept, until the chain is merged into a single data
+ *  file by compactCheckpoint().
+ *
+ *  Changed blocks are detected by comparison of a 64-bit hash of their content, and
+ *  of their size. If the base has been written by save(), its data is read anyway,
+ *  and blocks with equal hashes are also compared byte by byte. Otherwise, the
+ *  detection is probabilistic: a hash collision, which has a probability of about
+ *  2^-64 per modified block, leaves the content of the base in the checkpoint. When
+ *  this is not acceptable, write a full checkpoint with saveIncrementalBase() or
+ *  save(), or take a checkpoint of save() as the base. The block structure of the
+ *  multi-block must be the same as in the base, but the repartition of the blocks
+ *  among processes may differ. The base must have been written with the same value
+ *  of global::IOpolicy().useCheckpointCompression(). All functions must be called
+ *  by all processes.
+ */
+
+/// Save a full checkpoint (like save()), which can be used as the base of incremental checkpoints.
+void saveIncrementalBase( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent = true );
+
+/// Save a checkpoint which contains only the atomic-blocks modified since the checkpoint baseName.
+/** The base can be a checkpoint of saveIncrementalBase(), saveIncremental(), or save().
+ *  In the last case, the data of the base is read to compute the hash of the blocks.
+ */
+void saveIncremental( MultiBlock3D& multiBlock, FileName fName, FileName baseName,
+                      bool dynamicContent = true );
+
+/// Merge the chain of an incremental checkpoint into the self-contained checkpoint compactName,
+///   which can be used as the base of further incremental checkpoints.
+void compactCheckpoint( FileName fName, FileName compactName );
+
+/// Read the serialized data of the atomic-blocks myBlockIds of the checkpoint fName,
+///   following the chain of data files if it is incremental.
+/** @var offset: The offsets of the Data/Offsets section in the .plb file.
+ *  @var data_fName: The data file of the Data/File section, used if the
+ *                   checkpoint is not incremental.
+ **/
+void loadCheckpointData( FileName fName, FileName data_fName, std::vector<plint> const& myBlockIds,
+                         std::vector<plint> const& offset, std::vector<std::vector<char> >& data );
+
+}  // namespace parallelIO
+
+}  // namespace plb
+
+#endif  // INCREMENTAL_CHECKPOINT_3D_H
@@ -185,8 +185,8 @@ void writeRawData( FileName fName, std::vector<plint> const& myBlockIds,
     }
 }
 
-void loadRawData_mpi( FileName fName, std::vector<plint> const& myBlockIds,
-                      std::vector<plint> const& offset, std::vector<std::vector<char> >& data )
+void loadRawData_mpi( FileName fName, std::vector<plint> const& chunkOffset,
+                      std::vector<plint> const& chunkSize, std::vector<std::vector<char> >& data )
 {
 #ifdef PLB_MPI_PARALLEL
     char fNameBuf[1024];
@@ -201,17 +201,9 @@ void loadRawData_mpi( FileName fName, std::vector<plint> const& myBlockIds,
                              MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
     plbIOError(err!=MPI_SUCCESS, "Could not open file "+fName.get());
     bool ioError = false;
-    for (plint iBlock=0; iBlock<(plint)myBlockIds.size(); ++iBlock) {
-        plint blockId = myBlockIds[iBlock];
-        plint nextOffset=0;
-        plint nextSize=0;
-        if (blockId==0) {
-            nextSize = offset[0];
-        }
-        else {
-            nextSize = offset[blockId]-offset[blockId-1];
-            nextOffset = offset[blockId-1];
-        }
+    for (plint iBlock=0; iBlock<(plint)chunkOffset.size(); ++iBlock) {
+        plint nextOffset = chunkOffset[iBlock];
+        plint nextSize = chunkSize[iBlock];
         data[iBlock].resize(nextSize);
         MPI_File_seek(fh, nextOffset, MPI_SEEK_SET);
         if (err != MPI_SUCCESS) {
@@ -242,25 +234,17 @@ void loadRawData_mpi( FileName fName, std::vector<plint> const& myBlockIds,
 #endif
 }
 
-void loadRawData_posix( FileName fName, std::vector<plint> const& myBlockIds,
-                        std::vector<plint> const& offset, std::vector<std::vector<char> >& data )
+void loadRawData_posix( FileName fName, std::vector<plint> const& chunkOffset,
+                        std::vector<plint> const& chunkSize, std::vector<std::vector<char> >& data )
 {
     for (plint iProcess=0; iProcess<global::mpi().getSize(); ++iProcess) {
         bool errorFlag = false;
         if (global::mpi().getRank()==iProcess) {
             FILE *fp = fopen(fName.get().c_str(), "rb");
             errorFlag = !fp;
-            for (plint iBlock=0; iBlock<(plint)myBlockIds.size() && !errorFlag; ++iBlock) {
-                plint blockId = myBlockIds[iBlock];
-                plint nextOffset=0;
-                plint nextSize=0;
-                if (blockId==0) {
-                    nextSize = offset[0];
-                }
-                else {
-                    nextSize = offset[blockId]-offset[blockId-1];
-                    nextOffset = offset[blockId-1];
-                }
+            for (plint iBlock=0; iBlock<(plint)chunkOffset.size() && !errorFlag; ++iBlock) {
+                plint nextOffset = chunkOffset[iBlock];
+                plint nextSize = chunkSize[iBlock];
                 data[iBlock].resize(nextSize);
 #if defined PLB_MAC_OS_X || defined PLB_BSD
                 int fSeekVal = fseek(fp, (long int)nextOffset, SEEK_SET);
@@ -289,14 +273,34 @@ void loadRawData( FileName fName, std::vector<plint> const& myBlockIds,
                   std::vector<plint> const& offset, std::vector<std::vector<char> >& data )
 {
     PLB_ASSERT( myBlockIds.size() == data.size() );
+    std::vector<plint> chunkOffset(myBlockIds.size()), chunkSize(myBlockIds.size());
+    for (plint iBlock=0; iBlock<(plint)myBlockIds.size(); ++iBlock) {
+        plint blockId = myBlockIds[iBlock];
+        if (blockId==0) {
+            chunkOffset[iBlock] = 0;
+            chunkSize[iBlock] = offset[0];
+        }
+        else {
+            chunkOffset[iBlock] = offset[blockId-1];
+            chunkSize[iBlock] = offset[blockId]-offset[blockId-1];
+        }
+    }
+    loadRawChunks(fName, chunkOffset, chunkSize, data);
+}
+
+void loadRawChunks( FileName fName, std::vector<plint> const& chunkOffset,
+                    std::vector<plint> const& chunkSize, std::vector<std::vector<char> >& data )
+{
+    PLB_ASSERT( chunkOffset.size() == data.size() );
+    PLB_ASSERT( chunkSize.size() == data.size() );
     fName.defaultPath(global::directories().getInputDir());
     fName.defaultExt("dat");
     if (global::IOpolicy().useParallelIO() && global::mpi().getSize()>1) {
-        loadRawData_mpi(fName, myBlockIds, offset, data);
+        loadRawData_mpi(fName, chunkOffset, chunkSize, data);
     }
     else {
         // Works in parallel too, but has no parallel efficiency.
-        loadRawData_posix(fName, myBlockIds, offset, data);
+        loadRawData_posix(fName, chunkOffset, chunkSize, data);
     }
 }
 
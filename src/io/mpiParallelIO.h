@@ -44,6 +44,11 @@ void writeRawData( FileName fName, std::vector<plint> const& myBlockIds,
 void loadRawData( FileName fName,  std::vector<plint> const& myBlockIds,
                   std::vector<plint> const& offset, std::vector<std::vector<char> >& data );
 
+/// Read data[i] from the chunkSize[i] bytes at position chunkOffset[i] of the file.
+///   Like loadRawData(), this function must be called by all processes.
+void loadRawChunks( FileName fName, std::vector<plint> const& chunkOffset,
+                    std::vector<plint> const& chunkSize, std::vector<std::vector<char> >& data );
+
 }  // namespace parallelIO
 
 }  // namespace plb
@@ -39,6 +39,8 @@
 #include "multiBlock/nonLocalTransfer3D.h"
 #include "multiBlock/multiBlockOperations3D.h"
 #include "io/plbFiles.h"
+#include "io/incrementalCheckpoint3D.h"
+#include "io/compression.h"
 #include <numeric>
 #include <algorithm>
 #include <memory>
@@ -88,6 +90,23 @@ void createDynamicsForeignIds3D(FileName fName, std::map<int,std::string>& forei
     }
 }
 
+bool readXmlCompression(FileName fName) {
+    fName.defaultPath(global::directories().getInputDir());
+    fName.setExt("plb");
+    XMLreader reader(fName);
+    std::string compression;
+    try {
+        reader["Block3D"]["Data"]["Compression"].read(compression);
+    }
+    catch(PlbIOException const&) {
+        return false;
+    }
+    if (compression!="shuffleLZ") {
+        plbIOError(std::string("Unknown compression: ")+compression);
+    }
+    return true;
+}
+
 void readXmlProcessors(FileName fName, MultiBlock3D& block) {
     std::vector<MultiBlock3D::ProcessorStorage3D> processors;
     fName.defaultPath(global::directories().getInputDir());
@@ -251,7 +270,10 @@ MultiBlock3D* load3D(FileName fName)
                     dataType, descriptor, family, management, cellDim );
     PLB_ASSERT( newBlock );
     std::vector<std::vector<char> > data(myBlockIds.size());
-    loadRawData( data_fName, myBlockIds, offsets, data);
+    loadCheckpointData( fName, data_fName, myBlockIds, offsets, data);
+    if (readXmlCompression(fName)) {
+        decompressBuffers(data);
+    }
     std::map<int,std::string> foreignIds;
     createDynamicsForeignIds3D(fName, foreignIds);
     dumpRestoreData(*newBlock, dynamicContent, myBlockIds, data, foreignIds);
@@ -287,7 +309,13 @@ SavedFullMultiBlockSerializer3D::SavedFullMultiBlockSerializer3D(FileName fName)
     reader["Block3D"]["Structure"]["NumComponents"].read(numComponents);
     reader["Block3D"]["Data"]["Offsets"].read(numberOfBytes);
     reader["Block3D"]["Data"]["File"].read(data_fName_str);
-    reader["Block3D"]["Data"]["IndexOrdering"].read(ordering);
+    // Checkpoints of save() have no index ordering, and are always forward-ordered.
+    try {
+        reader["Block3D"]["Data"]["IndexOrdering"].read(ordering);
+    }
+    catch(PlbIOException const&) {
+        ordering = "zIsFastest";
+    }
 
     data_fName = FileName(data_fName_str);
     data_fName.defaultPath(global::directories().getInputDir());
@@ -329,18 +357,36 @@ SavedFullMultiBlockSerializer3D::SavedFullMultiBlockSerializer3D(FileName fName)
     }
 
     typeSize=NativeTypeConstructor(str_dataType).getTypeSize();
-    if (typeSize*cellDim*boundingBox.nCells() != numberOfBytes) {
-        plbIOError("Number of bytes does not match up with block dimensions in file.");
-    }
     pos = 0;
     sizeOfChunk = 1000000; // Treat 1 MB at a time.
-    if (global::mpi().isMainProcessor()) {
-        fp = fopen(data_fName.get().c_str(), "rb");
+    fp = 0;
+    compressed = readXmlCompression(fName);
+    if (compressed) {
+        // A compressed block cannot be read chunk by chunk: it is read and
+        //   decompressed at once by the main process.
+        std::vector<plint> myBlockIds;
+        if (global::mpi().isMainProcessor()) {
+            myBlockIds.push_back(0);
+        }
+        std::vector<plint> offsets(1, numberOfBytes);
+        std::vector<std::vector<char> > data(myBlockIds.size());
+        loadCheckpointData(fName, data_fName, myBlockIds, offsets, data);
+        decompressBuffers(data);
+        if (global::mpi().isMainProcessor()) {
+            decompressedData.swap(data[0]);
+        }
+        plbMainProcIOError( typeSize*cellDim*boundingBox.nCells() != (plint)decompressedData.size(),
+                            "Number of bytes does not match up with block dimensions in file." );
     }
     else {
-        fp = 0;
+        if (typeSize*cellDim*boundingBox.nCells() != numberOfBytes) {
+            plbIOError("Number of bytes does not match up with block dimensions in file.");
+        }
+        if (global::mpi().isMainProcessor()) {
+            fp = fopen(data_fName.get().c_str(), "rb");
+        }
+        plbMainProcIOError(!fp, "Could not open file "+data_fName.get());
     }
-    plbMainProcIOError(!fp, "Could not open file "+data_fName.get());
 }
 
 SavedFullMultiBlockSerializer3D::SavedFullMultiBlockSerializer3D (
@@ -351,8 +397,14 @@ SavedFullMultiBlockSerializer3D::SavedFullMultiBlockSerializer3D (
       data_fName(rhs.data_fName),
       str_dataType(rhs.str_dataType),
       forwardOrdering(rhs.forwardOrdering),
-      pos(rhs.pos)
+      compressed(rhs.compressed),
+      decompressedData(rhs.decompressedData),
+      pos(rhs.pos),
+      fp(0)
 {  
+    if (compressed) {
+        return;
+    }
     if (global::mpi().isMainProcessor()) {
         fp = fopen(data_fName.get().c_str(), "rb");
 #if defined PLB_MAC_OS_X || defined PLB_BSD
@@ -361,15 +413,12 @@ SavedFullMultiBlockSerializer3D::SavedFullMultiBlockSerializer3D (
         fseeko64(fp, pos, SEEK_SET);
 #endif
     }
-    else {
-        fp = 0;
-    }
     plbMainProcIOError(!fp, "Could not open file "+data_fName.get());
 }
 
 SavedFullMultiBlockSerializer3D::~SavedFullMultiBlockSerializer3D()
 {
-    if (global::mpi().isMainProcessor()) {
+    if (fp) {
         fclose(fp);
     }
 }
@@ -389,7 +438,13 @@ const char* SavedFullMultiBlockSerializer3D::getNextDataBuffer(pluint& bufferSiz
     buffer.resize(bufferSize);
     plint numRead=0;
     if (global::mpi().isMainProcessor()) {
-        numRead = (plint) fread( &buffer[0], 1, bufferSize, fp );
+        if (compressed) {
+            std::copy(decompressedData.begin()+pos, decompressedData.begin()+pos+bufferSize, buffer.begin());
+            numRead = (plint) bufferSize;
+        }
+        else {
+            numRead = (plint) fread( &buffer[0], 1, bufferSize, fp );
+        }
     }
     pos += bufferSize;
     plbMainProcIOError(numRead!=(plint)bufferSize, "Error while reading from file "+data_fName.get());
@@ -47,6 +47,15 @@ void readkXmlSpec (
     std::string& dataType, std::string& descriptor, std::string& family,
     std::vector<Box3D>& components, bool& dynamicContent, std::string& data_fName );
 
+void readXmlSpec (
+    FileName fName, Box3D& boundingBox, std::vector<plint>& offsets,
+    plint& envelopeWidth, plint& gridLevel, plint& cellDim,
+    std::string& dataType, std::string& descriptor, std::string& family,
+    std::vector<Box3D>& components, bool& dynamicContent, FileName& data_fName );
+
+/// True if the data of the checkpoint was compressed by compressDumpedData().
+bool readXmlCompression(FileName fName);
+
 MultiBlock3D* load3D(FileName fName);
 
 void load(FileName fName, MultiBlock3D& intoBlock, bool dynamicContent = true );
@@ -73,6 +82,10 @@ private:
     FileName data_fName;
     std::string str_dataType;
     bool forwardOrdering;
+    /// If the checkpoint is compressed, the main process holds its full
+    ///   decompressed data, and no file is kept open.
+    bool compressed;
+    std::vector<char> decompressedData;
     mutable plint pos;
     mutable std::vector<char> buffer;
     FILE *fp;
@@ -30,6 +30,7 @@
 #include "parallelism/mpiManager.h"
 #include "io/multiBlockWriter3D.h"
 #include "io/mpiParallelIO.h"
+#include "io/compression.h"
 #include "libraryInterfaces/TINYXML_xmlIO.h"
 #include "libraryInterfaces/TINYXML_xmlIO.hh"
 #include "core/util.h"
@@ -52,6 +53,15 @@ namespace parallelIO {
 
 void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
                    std::vector<plint> const& offset, bool dynamicContent )
+{
+    XMLwriter xml;
+    createXmlSpec(multiBlock, fName, offset, dynamicContent, xml);
+    fName.setExt("plb");
+    xml.print(FileName(fName).defaultPath(global::directories().getOutputDir()));
+}
+
+void createXmlSpec( MultiBlock3D& multiBlock, FileName fName,
+                    std::vector<plint> const& offset, bool dynamicContent, XMLwriter& xml )
 {
     fName.setExt("plb");
     MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
@@ -61,7 +71,6 @@ void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
     std::string blockName = multiBlock.getBlockName();
     PLB_ASSERT( !typeInfo.empty() );
 
-    XMLwriter xml;
     XMLwriter& xmlMultiBlock = xml["Block3D"];
     xmlMultiBlock["General"]["Family"].setString(blockName);
     xmlMultiBlock["General"]["Datatype"].setString(typeInfo[0]);
@@ -91,6 +100,9 @@ void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
     if (!offset.empty()) {
         xmlMultiBlock["Data"]["Offsets"].set(offset);
     }
+    if (global::IOpolicy().useCheckpointCompression()) {
+        xmlMultiBlock["Data"]["Compression"].setString("shuffleLZ");
+    }
 
     // The following prints a unique list of dynamics-id pairs for all dynamics
     //   classes used in the multi-block. This is necessary, because dynamics
@@ -133,7 +145,6 @@ void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
             xmlProcessors[iProcessor]["Blocks"].set(processors[iProcessor].getMultiBlockIds());
         }
     }
-    xml.print(FileName(fName).defaultPath(global::directories().getOutputDir()));
 }
 
 void writeOneBlockXmlSpec( MultiBlock3D const& multiBlock, FileName fName, plint dataSize,
@@ -206,6 +217,9 @@ void save( MultiBlock3D& multiBlock, FileName fName, bool dynamicContent )
     std::vector<std::vector<char> > data;
 
     dumpData(multiBlock, dynamicContent, offset, myBlockIds, data);
+    if (global::IOpolicy().useCheckpointCompression()) {
+        compressDumpedData(multiBlock, offset, myBlockIds, data);
+    }
 
     writeXmlSpec(multiBlock, fName, offset, dynamicContent);
     writeRawData(fName, myBlockIds, offset, data);
@@ -311,6 +325,30 @@ void dumpData( MultiBlock3D& multiBlock, bool dynamicContent,
     std::partial_sum(blockSize.begin(), blockSize.end(), offset.begin());
 }
 
+void compressDumpedData( MultiBlock3D const& multiBlock, std::vector<plint>& offset,
+                         std::vector<plint> const& myBlockIds,
+                         std::vector<std::vector<char> >& data )
+{
+    // The bytes are shuffled according to the size of the basic data type,
+    //   which is the size of most of the serialized variables.
+    plint typeSize = 1;
+    try {
+        typeSize = NativeTypeConstructor(multiBlock.getTypeInfo()[0]).getTypeSize();
+    }
+    catch(PlbLogicException const&) { }
+    compressBuffers(data, CompressionMode::lossless, typeSize);
+
+    plint numBlocks = (plint)offset.size();
+    std::vector<plint> blockSize(numBlocks, 0);
+    for (pluint iBlock=0; iBlock<myBlockIds.size(); ++iBlock) {
+        blockSize[myBlockIds[iBlock]] = (plint)data[iBlock].size();
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(blockSize, MPI_SUM);
+#endif
+    std::partial_sum(blockSize.begin(), blockSize.end(), offset.begin());
+}
+
 }  // namespace parallelIO
 
 }  // namespace plb
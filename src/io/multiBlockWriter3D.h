@@ -36,6 +36,7 @@
 
 namespace plb {
 
+class XMLwriter;
 
 namespace parallelIO {
 
@@ -60,9 +61,22 @@ void dumpData( MultiBlock3D& multiBlock, bool dynamicContent,
                std::vector<plint>& offset, std::vector<plint>& myBlockIds,
                std::vector<std::vector<char> >& data );
 
+/// Compress the data of dumpData() block by block, without loss, and update
+///   the offsets, which then refer to the compressed data.
+void compressDumpedData( MultiBlock3D const& multiBlock, std::vector<plint>& offset,
+                         std::vector<plint> const& myBlockIds,
+                         std::vector<std::vector<char> >& data );
+
 void writeXmlSpec( MultiBlock3D& multiBlock, FileName fName,
                    std::vector<plint> const& offset, bool dynamicContent );
 
+/// Fill the XML description written by writeXmlSpec() into xml, without writing it.
+/** If global::IOpolicy().useCheckpointCompression() is true, the description
+ *  states that the data was compressed by compressDumpedData().
+ */
+void createXmlSpec( MultiBlock3D& multiBlock, FileName fName,
+                    std::vector<plint> const& offset, bool dynamicContent, XMLwriter& xml );
+
 }  // namespace parallelIO
 
 }  // namespace plb
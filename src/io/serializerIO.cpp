@@ -26,6 +26,7 @@
 #include "io/base64.h"
 #include "io/base64.hh"
 #include "io/endianness.h"
+#include "io/compression.h"
 #include "core/plbDebug.h"
 #include "core/plbProfiler.h"
 #include "core/globalDefs.h"
@@ -35,6 +36,7 @@
 #include <istream>
 #include <ostream>
 #include <fstream>
+#include <cstring>
 
 namespace plb {
 
@@ -149,6 +151,86 @@ void RawBinaryWriter::writeData(char const* dataBuffer, pluint bufferSize)
 }
 
 
+/* *************** Class CompressedWriter ******************************** */
+
+/// Collects the data, compresses it, and forwards the compressed data to another writer.
+class CompressedWriter : public SerializedWriter {
+public:
+    CompressedWriter( SerializedWriter* writer_, CompressionMode::ModeT mode_,
+                      plint typeSize_, double errorBound_ );
+    CompressedWriter(CompressedWriter const& rhs);
+    virtual CompressedWriter* clone() const;
+    ~CompressedWriter();
+    virtual void writeHeader(pluint dataSize);
+    virtual void writeData(char const* dataBuffer, pluint bufferSize);
+private:
+    void flush();
+private:
+    SerializedWriter* writer;
+    CompressionMode::ModeT mode;
+    plint typeSize;
+    double errorBound;
+    pluint dataSize;
+    std::vector<char> data;
+};
+
+CompressedWriter::CompressedWriter( SerializedWriter* writer_, CompressionMode::ModeT mode_,
+                                    plint typeSize_, double errorBound_ )
+    : writer(writer_),
+      mode(mode_),
+      typeSize(typeSize_),
+      errorBound(errorBound_),
+      dataSize(0)
+{ }
+
+CompressedWriter::CompressedWriter(CompressedWriter const& rhs)
+    : writer(rhs.writer->clone()),
+      mode(rhs.mode),
+      typeSize(rhs.typeSize),
+      errorBound(rhs.errorBound),
+      dataSize(rhs.dataSize),
+      data(rhs.data)
+{ }
+
+CompressedWriter* CompressedWriter::clone() const {
+    return new CompressedWriter(*this);
+}
+
+CompressedWriter::~CompressedWriter() {
+    delete writer;
+}
+
+void CompressedWriter::writeHeader(pluint dataSize_) {
+    dataSize = dataSize_;
+    data.clear();
+    data.reserve(dataSize);
+    if (dataSize==0) {
+        flush();
+    }
+}
+
+void CompressedWriter::writeData(char const* dataBuffer, pluint bufferSize)
+{
+    PLB_PRECONDITION( data.size()+bufferSize <= dataSize );
+    data.insert(data.end(), dataBuffer, dataBuffer+bufferSize);
+    // The size of the compressed data, needed for the header of the
+    //   underlying writer, is known once all the data has arrived.
+    if (data.size()==dataSize) {
+        flush();
+    }
+}
+
+void CompressedWriter::flush() {
+    global::profiler().start("io");
+    std::vector<char> compressed;
+    compressData(data.empty() ? 0 : &data[0], data.size(), mode, typeSize, errorBound, compressed);
+    std::vector<char>().swap(data);
+    global::profiler().stop("io");
+    writer->writeHeader(compressed.size());
+    writer->writeData(&compressed[0], compressed.size());
+}
+
+
 /* *************** Class Base64Reader ******************************** */
 
 class Base64Reader : public SerializedReader {
@@ -223,6 +305,78 @@ void Base64Reader::readData(char* dataBuffer, pluint bufferSize) const
 }
 
 
+/* *************** Class CompressedReader ******************************** */
+
+/// Reads the compressed data in raw binary or Base64 format, and decompresses it.
+class CompressedReader : public SerializedReader {
+public:
+    CompressedReader(std::istream* istr_, bool base64_, bool switchEndianness_);
+    virtual CompressedReader* clone() const;
+    virtual void readHeader(pluint dataSize) const;
+    virtual void readData(char* dataBuffer, pluint bufferSize) const;
+private:
+    std::istream* istr;
+    bool base64;
+    bool switchEndianness;
+    mutable std::vector<char> data;
+    mutable pluint pos;
+};
+
+CompressedReader::CompressedReader(std::istream* istr_, bool base64_, bool switchEndianness_)
+    : istr(istr_),
+      base64(base64_),
+      switchEndianness(switchEndianness_),
+      pos(0)
+{ }
+
+CompressedReader* CompressedReader::clone() const {
+    return new CompressedReader(*this);
+}
+
+void CompressedReader::readHeader(pluint dataSize) const {
+    PLB_PRECONDITION( istr && (bool)(*istr) );
+    global::profiler().start("io");
+    pluint compressedSize = 0;
+    std::vector<char> compressed;
+    if (base64) {
+        Base64Decoder<pluint> sizeDecoder(*istr, 1);
+        sizeDecoder.decode(&compressedSize, 1);
+        if (switchEndianness) {
+            endianByteSwap(compressedSize);
+        }
+        compressed.resize(compressedSize);
+        Base64Decoder<char> dataDecoder(*istr, compressedSize);
+        dataDecoder.decode(&compressed[0], compressedSize);
+    }
+    else {
+        istr->read((char*)&compressedSize, sizeof(compressedSize));
+        if (!(*istr)) {
+            plbIOError("Could not read compressed data.");
+        }
+        compressed.resize(compressedSize);
+        istr->read(&compressed[0], compressedSize);
+    }
+    if (!(*istr)) {
+        plbIOError("Could not read compressed data.");
+    }
+    decompressData(&compressed[0], compressed.size(), data);
+    if (data.size()!=dataSize) {
+        plbIOError("Size of the compressed data does not match.");
+    }
+    pos = 0;
+    global::profiler().stop("io");
+}
+
+void CompressedReader::readData(char* dataBuffer, pluint bufferSize) const
+{
+    PLB_PRECONDITION( pos+bufferSize <= data.size() );
+    if (bufferSize>0) {
+        memcpy(dataBuffer, &data[pos], bufferSize);
+    }
+    pos += bufferSize;
+}
+
+
 /* *************** Free functions ************************************ */
 
 void serializerToBase64Stream(DataSerializer const* serializer, std::ostream* ostr, bool enforceUint, bool mainProcOnly)
@@ -252,4 +406,30 @@ void base64StreamToUnSerializer( std::istream* istr, DataUnSerializer* unSeriali
             mainProcOnly );
 }
 
+void serializerToCompressedStream (
+        DataSerializer const* serializer, std::ostream* ostr, CompressionMode::ModeT mode,
+        plint typeSize, double errorBound, bool base64, bool mainProcOnly )
+{
+    SerializedWriter* writer = 0;
+    if (base64) {
+        writer = new Base64Writer(ostr, false, global::IOpolicy().getEndianSwitchOnBase64out());
+    }
+    else {
+        writer = new RawBinaryWriter(ostr);
+    }
+    serializerToSink (
+            serializer,
+            new CompressedWriter(writer, mode, typeSize, errorBound),
+            mainProcOnly );
+}
+
+void compressedStreamToUnSerializer( std::istream* istr, DataUnSerializer* unSerializer,
+                                     bool base64, bool mainProcOnly )
+{
+    sourceToUnSerializer (
+            new CompressedReader(istr, base64, global::IOpolicy().getEndianSwitchOnBase64in()),
+            unSerializer,
+            mainProcOnly );
+}
+
 } // namespace plb
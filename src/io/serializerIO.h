@@ -27,6 +27,7 @@
 
 #include "core/globalDefs.h"
 #include "core/serializer.h"
+#include "io/compression.h"
 #include <iosfwd>
 #include <iomanip>
 
@@ -55,6 +56,20 @@ void serializerToRawBinaryStream (
 void base64StreamToUnSerializer(std::istream* istr, DataUnSerializer* unSerializer,
                                 bool enforceUint=false, bool mainProcOnly=true );
 
+/// Take a Serializer, compress, and stream into output stream in raw binary or Base64 format.
+/** The data is compressed on the processor which writes it. It is preceded by the
+ *  size of the compressed data. In lossy mode, the data must be made of floating-point
+ *  values of size typeSize, which are restored with an absolute error not larger
+ *  than errorBound.
+ */
+void serializerToCompressedStream (
+        DataSerializer const* serializer, std::ostream* ostr, CompressionMode::ModeT mode,
+        plint typeSize, double errorBound=0., bool base64=false, bool mainProcOnly=true );
+
+/// Take an input stream written by serializerToCompressedStream, and stream into an unSerializer.
+void compressedStreamToUnSerializer( std::istream* istr, DataUnSerializer* unSerializer,
+                                     bool base64=false, bool mainProcOnly=true );
+
 /// Take a Serializer, convert and stream into output in ASCII format.
 /** Number of digits in the ASCII representation of numbers is given by the variable numDigits.
  */
@@ -0,0 +1,292 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Batched variants of the collision templates, which treat
+ * simd::Pack<T>::width cells at once -- generic implementation.
+ *
+ * The populations of the cells are held in an Array of packs, one pack per
+ * direction, as they are obtained from a structure-of-arrays storage. The
+ * efficient, hand-unrolled specializations for the D3Q19 and the D3Q27
+ * lattice are found in batchedDynamicsTemplates3D.h.
+ */
+
+#ifndef BATCHED_DYNAMICS_TEMPLATES_H
+#define BATCHED_DYNAMICS_TEMPLATES_H
+
+#include "core/globalDefs.h"
+#include "core/array.h"
+#include "core/simdPack.h"
+#include <vector>
+
+namespace plb {
+
+/// Moments and equilibria of a batch of cells; specialized for some lattices.
+template<typename T, class Descriptor>
+struct batchedDynamicsTemplatesImpl {
+
+typedef simd::Pack<T> Pack;
+
+static void get_rhoBar_j(Array<Pack,Descriptor::q> const& f, Pack& rhoBar, Array<Pack,Descriptor::d>& j) {
+    rhoBar = f[0];
+    for (plint iD=0; iD<Descriptor::d; ++iD) {
+        j[iD] = Pack::broadcast(T());
+    }
+    for (plint iPop=1; iPop<Descriptor::q; ++iPop) {
+        rhoBar += f[iPop];
+        for (plint iD=0; iD<Descriptor::d; ++iD) {
+            if (Descriptor::c[iPop][iD]==1) {
+                j[iD] += f[iPop];
+            }
+            else if (Descriptor::c[iPop][iD]==-1) {
+                j[iD] -= f[iPop];
+            }
+            else if (Descriptor::c[iPop][iD]!=0) {
+                j[iD] += Pack::broadcast((T)Descriptor::c[iPop][iD]) * f[iPop];
+            }
+        }
+    }
+}
+
+static void bgk_ma2_equilibria( Pack const& rhoBar, Pack const& invRho, Array<Pack,Descriptor::d> const& j,
+                                Pack const& jSqr, Array<Pack,Descriptor::q>& eqPop )
+{
+    Pack invCs2 = Pack::broadcast(Descriptor::invCs2);
+    Pack halfInvCs2Sqr = Pack::broadcast(Descriptor::invCs2*Descriptor::invCs2/(T)2);
+    Pack C1 = rhoBar - Pack::broadcast(Descriptor::invCs2/(T)2)*invRho*jSqr;
+    for (plint iPop=0; iPop<Descriptor::q; ++iPop) {
+        Pack c_j = Pack::broadcast(T());
+        for (plint iD=0; iD<Descriptor::d; ++iD) {
+            if (Descriptor::c[iPop][iD]!=0) {
+                c_j += Pack::broadcast((T)Descriptor::c[iPop][iD]) * j[iD];
+            }
+        }
+        eqPop[iPop] = Pack::broadcast(Descriptor::t[iPop]) *
+                      (C1 + invCs2*c_j + halfInvCs2Sqr*invRho*c_j*c_j);
+    }
+}
+
+};  // struct batchedDynamicsTemplatesImpl
+
+/// Batched BGK, TRT and MRT collisions, for use by the bulk collide-and-stream.
+/** The functions have the same meaning as their counterparts in dynamicsTemplates,
+ *  mrtTemplates and momentTemplates, but operate on simd::Pack<T>::width cells
+ *  at once. The returned value is the square of the velocity, per cell.
+ */
+template<typename T, class Descriptor>
+struct batchedDynamicsTemplates {
+
+typedef simd::Pack<T> Pack;
+typedef batchedDynamicsTemplatesImpl<T,Descriptor> Impl;
+
+/// Load the populations of Pack::width consecutive cells, starting at
+///   iCell, from the arrays f[0], ..., f[q-1]. The arrays can be stored in
+///   a narrower type S than T.
+template<typename S>
+static void load(S const* const* f, plint iCell, Array<Pack,Descriptor::q>& fPack) {
+    for (plint iPop=0; iPop<Descriptor::q; ++iPop) {
+        fPack[iPop] = simd::Converter<T,S>::load(f[iPop]+iCell);
+    }
+}
+
+/// Store the populations of Pack::width consecutive cells, starting at
+///   iCell, into the arrays f[0], ..., f[q-1].
+template<typename S>
+static void store(Array<Pack,Descriptor::q> const& fPack, S* const* f, plint iCell) {
+    for (plint iPop=0; iPop<Descriptor::q; ++iPop) {
+        simd::Converter<T,S>::store(fPack[iPop], f[iPop]+iCell);
+    }
+}
+
+static void get_rhoBar_j(Array<Pack,Descriptor::q> const& f, Pack& rhoBar, Array<Pack,Descriptor::d>& j) {
+    Impl::get_rhoBar_j(f, rhoBar, j);
+}
+
+/// The inverse density is evaluated cell by cell, to respect the round-off policy of the descriptor.
+static Pack invRho(Pack const& rhoBar) {
+    T values[Pack::width];
+    rhoBar.store(values);
+    for (plint i=0; i<Pack::width; ++i) {
+        values[i] = Descriptor::invRho(values[i]);
+    }
+    return Pack::load(values);
+}
+
+static Pack normSqr(Array<Pack,Descriptor::d> const& j) {
+    Pack jSqr = j[0]*j[0];
+    for (plint iD=1; iD<Descriptor::d; ++iD) {
+        jSqr += j[iD]*j[iD];
+    }
+    return jSqr;
+}
+
+static void bgk_ma2_equilibria( Pack const& rhoBar, Pack const& invRho, Array<Pack,Descriptor::d> const& j,
+                                Pack const& jSqr, Array<Pack,Descriptor::q>& eqPop )
+{
+    Impl::bgk_ma2_equilibria(rhoBar, invRho, j, jSqr, eqPop);
+}
+
+static Pack bgk_ma2_collision(Array<Pack,Descriptor::q>& f, Pack const& rhoBar,
+                              Array<Pack,Descriptor::d> const& j, T omega)
+{
+    Pack invRho_ = invRho(rhoBar);
+    Pack jSqr = normSqr(j);
+    Array<Pack,Descriptor::q> eq;
+    Impl::bgk_ma2_equilibria(rhoBar, invRho_, j, jSqr, eq);
+    Pack one_m_omega = Pack::broadcast((T)1-omega);
+    Pack omega_ = Pack::broadcast(omega);
+    for (plint iPop=0; iPop<Descriptor::q; ++iPop) {
+        f[iPop] *= one_m_omega;
+        f[iPop] += omega_*eq[iPop];
+    }
+    return invRho_*invRho_*jSqr;
+}
+
+/// TRT collision, with the same conventions as TRTdynamics: the population
+///   opposite to iPop>0 is iPop+q/2.
+static Pack trt_ma2_collision(Array<Pack,Descriptor::q>& f, Pack const& rhoBar,
+                              Array<Pack,Descriptor::d> const& j, T sPlus, T sMinus)
+{
+    static const plint half = Descriptor::q/2;
+    Pack invRho_ = invRho(rhoBar);
+    Pack jSqr = normSqr(j);
+    Array<Pack,Descriptor::q> eq;
+    Impl::bgk_ma2_equilibria(rhoBar, invRho_, j, jSqr, eq);
+    Pack oneHalf = Pack::broadcast((T)0.5);
+    Pack sPlus_ = Pack::broadcast(sPlus);
+    Pack sMinus_ = Pack::broadcast(sMinus);
+    f[0] += sPlus_*(eq[0]-f[0]);
+    for (plint i=1; i<=half; ++i) {
+        Pack eq_plus  = oneHalf*(eq[i] + eq[i+half]);
+        Pack eq_minus = oneHalf*(eq[i] - eq[i+half]);
+        Pack f_plus   = oneHalf*(f[i] + f[i+half]);
+        Pack f_minus  = oneHalf*(f[i] - f[i+half]);
+        Pack relaxPlus  = sPlus_*(f_plus-eq_plus);
+        Pack relaxMinus = sMinus_*(f_minus-eq_minus);
+        f[i]      -= relaxPlus + relaxMinus;
+        f[i+half] -= relaxPlus - relaxMinus;
+    }
+    return invRho_*invRho_*jSqr;
+}
+
+/// MRT collision f -= K (f-fEq), with the collision matrix K = invM S M obtained
+///   from computeMrtCollisionMatrix(). It is equivalent to the collision in moment
+///   space of mrtTemplates, because the equilibrium moments of the latter are the
+///   moments of the second-order equilibrium.
+/** As every moment is either even or odd in the lattice velocities, K maps the
+ *  symmetric parts f[i]+f[i+q/2] and the antisymmetric parts f[i]-f[i+q/2] of the
+ *  populations separately, which halves the number of operations.
+ */
+static Pack mrt_ma2_collision(Array<Pack,Descriptor::q>& f, Pack const& rhoBar,
+                              Array<Pack,Descriptor::d> const& j, T const* collisionMatrix)
+{
+    static const plint half = Descriptor::q/2;
+    Pack invRho_ = invRho(rhoBar);
+    Pack jSqr = normSqr(j);
+    Array<Pack,Descriptor::q> eq;
+    Impl::bgk_ma2_equilibria(rhoBar, invRho_, j, jSqr, eq);
+    Array<Pack,half+1> fNeqPlus, fNeqMinus;
+    fNeqPlus[0] = f[0]-eq[0];
+    for (plint k=1; k<=half; ++k) {
+        Pack fNeq = f[k]-eq[k];
+        Pack fNeqOpp = f[k+half]-eq[k+half];
+        fNeqPlus[k] = fNeq+fNeqOpp;
+        fNeqMinus[k] = fNeq-fNeqOpp;
+    }
+    T const* evenMatrix = collisionMatrix;
+    T const* oddMatrix = collisionMatrix+(half+1)*(half+1);
+    for (plint i=0; i<=half; ++i) {
+        T const* evenRow = evenMatrix+i*(half+1);
+        Pack evenTerm = Pack::broadcast(evenRow[0])*fNeqPlus[0];
+        for (plint k=1; k<=half; ++k) {
+            evenTerm += Pack::broadcast(evenRow[k])*fNeqPlus[k];
+        }
+        if (i==0) {
+            f[0] -= evenTerm;
+        }
+        else {
+            T const* oddRow = oddMatrix+(i-1)*half;
+            Pack oddTerm = Pack::broadcast(oddRow[0])*fNeqMinus[1];
+            for (plint k=2; k<=half; ++k) {
+                oddTerm += Pack::broadcast(oddRow[k-1])*fNeqMinus[k];
+            }
+            f[i]      -= evenTerm + oddTerm;
+            f[i+half] -= evenTerm - oddTerm;
+        }
+    }
+    return invRho_*invRho_*jSqr;
+}
+
+/// Compute the collision matrix K = invM S M of the MRT model, in the form used
+///   by mrt_ma2_collision().
+/** The relaxation rates S are those of MRTDescriptor, except for the ones related
+ *  to the shear viscosity, which are replaced by omega. The result contains the
+ *  (q/2+1)x(q/2+1) matrix acting on the symmetric parts of the populations,
+ *  followed by the (q/2)x(q/2) matrix acting on the antisymmetric parts, both
+ *  stored row by row.
+ */
+template<class MRTDescriptor>
+static void computeMrtCollisionMatrix(T omega, std::vector<T>& collisionMatrix) {
+    static const plint q = Descriptor::q;
+    static const plint half = Descriptor::q/2;
+    Array<T,q> s;
+    for (plint iPop=0; iPop<q; ++iPop) {
+        s[iPop] = MRTDescriptor::S[iPop];
+    }
+    for (plint iA=0; iA<MRTDescriptor::shearIndexes; ++iA) {
+        s[MRTDescriptor::shearViscIndexes[iA]] = omega;
+    }
+    std::vector<T> K(q*q);
+    for (plint iPop=0; iPop<q; ++iPop) {
+        for (plint jPop=0; jPop<q; ++jPop) {
+            T k = T();
+            for (plint m=0; m<q; ++m) {
+                k += MRTDescriptor::invM[iPop][m] * s[m] * MRTDescriptor::M[m][jPop];
+            }
+            K[iPop*q+jPop] = k;
+        }
+    }
+    collisionMatrix.resize((half+1)*(half+1)+half*half);
+    for (plint i=0; i<=half; ++i) {
+        collisionMatrix[i*(half+1)] = K[i*q];
+        for (plint k=1; k<=half; ++k) {
+            collisionMatrix[i*(half+1)+k] = (T)0.5*(K[i*q+k]+K[i*q+k+half]);
+        }
+    }
+    T* oddMatrix = &collisionMatrix[(half+1)*(half+1)];
+    for (plint i=1; i<=half; ++i) {
+        for (plint k=1; k<=half; ++k) {
+            oddMatrix[(i-1)*half+k-1] = (T)0.5*(K[i*q+k]-K[i*q+k+half]);
+        }
+    }
+}
+
+};  // struct batchedDynamicsTemplates
+
+}  // namespace plb
+
+#include "latticeBoltzmann/batchedDynamicsTemplates3D.h"
+
+#endif  // BATCHED_DYNAMICS_TEMPLATES_H
@@ -0,0 +1,260 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at 
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/** \file
+ * Template specializations of the batched collision templates
+ * (batchedDynamicsTemplates.h) for the D3Q19 and the D3Q27 lattice.
+ */
+
+#ifndef BATCHED_DYNAMICS_TEMPLATES_3D_H
+#define BATCHED_DYNAMICS_TEMPLATES_3D_H
+
+#include "core/globalDefs.h"
+#include "latticeBoltzmann/nearestNeighborLattices3D.h"
+
+namespace plb {
+
+// Efficient specialization for D3Q19 lattice
+template<typename T>
+struct batchedDynamicsTemplatesImpl<T, descriptors::D3Q19DescriptorBase<T> > {
+
+typedef descriptors::D3Q19DescriptorBase<T> D;
+typedef simd::Pack<T> Pack;
+
+static void get_rhoBar_j(Array<Pack,D::q> const& f, Pack& rhoBar, Array<Pack,3>& j) {
+    Pack surfX_M1 = f[1] + f[4] + f[5] + f[6] + f[7];
+    Pack surfX_P1 = f[10] + f[13] + f[14] + f[15] + f[16];
+    Pack surfX_0  = f[0] + f[2] + f[3] + f[8] +
+                    f[9] + f[11] + f[12] + f[17] + f[18];
+
+    Pack surfY_M1 = f[2] + f[4] + f[8] + f[9] + f[14];
+    Pack surfY_P1 = f[5] + f[11] + f[13] + f[17] + f[18];
+
+    Pack surfZ_M1 = f[3] + f[6] + f[8] + f[16] + f[18];
+    Pack surfZ_P1 = f[7] + f[9] + f[12] + f[15] + f[17];
+
+    rhoBar = surfX_M1 + surfX_0 + surfX_P1;
+    j[0] = surfX_P1 - surfX_M1;
+    j[1] = surfY_P1 - surfY_M1;
+    j[2] = surfZ_P1 - surfZ_M1;
+}
+
+static void bgk_ma2_equilibria( Pack const& rhoBar, Pack const& invRho, Array<Pack,3> const& j,
+                                Pack const& jSqr, Array<Pack,D::q>& eqPop )
+{
+    Pack t0 = Pack::broadcast(D::t[0]);
+    Pack t1 = Pack::broadcast(D::t[1]);
+    Pack t4 = Pack::broadcast(D::t[4]);
+    Pack three = Pack::broadcast((T)3);
+    Pack halfInvRho = invRho*Pack::broadcast((T)0.5);
+    Pack kx     = three * j[0];
+    Pack ky     = three * j[1];
+    Pack kz     = three * j[2];
+    Pack kxSqr_ = halfInvRho * kx*kx;
+    Pack kySqr_ = halfInvRho * ky*ky;
+    Pack kzSqr_ = halfInvRho * kz*kz;
+    Pack kxky_  = invRho * kx*ky;
+    Pack kxkz_  = invRho * kx*kz;
+    Pack kykz_  = invRho * ky*kz;
+    Pack C1 = rhoBar + invRho*three*jSqr;
+    Pack C2, C3;
+    // i=0
+    C3 = -kxSqr_ - kySqr_ - kzSqr_;
+    eqPop[0] = t0 * (C1+C3);
+    // i=1 and i=10
+    C2 = -kx;
+    C3 = -kySqr_ - kzSqr_;
+    eqPop[1]  = t1 * (C1+C2+C3);
+    eqPop[10] = t1 * (C1-C2+C3);
+    // i=2 and i=11
+    C2 = -ky;
+    C3 = -kxSqr_ - kzSqr_;
+    eqPop[2]  = t1 * (C1+C2+C3);
+    eqPop[11] = t1 * (C1-C2+C3);
+    // i=3 and i=12
+    C2 = -kz;
+    C3 = -kxSqr_ - kySqr_;
+    eqPop[3]  = t1 * (C1+C2+C3);
+    eqPop[12] = t1 * (C1-C2+C3);
+    // i=4 and i=13
+    C2 = -kx - ky;
+    C3 = kxky_ - kzSqr_;
+    eqPop[4]  = t4 * (C1+C2+C3);
+    eqPop[13] = t4 * (C1-C2+C3);
+    // i=5 and i=14
+    C2 = -kx + ky;
+    C3 = -kxky_ - kzSqr_;
+    eqPop[5]  = t4 * (C1+C2+C3);
+    eqPop[14] = t4 * (C1-C2+C3);
+    // i=6 and i=15
+    C2 = -kx - kz;
+    C3 = kxkz_ - kySqr_;
+    eqPop[6]  = t4 * (C1+C2+C3);
+    eqPop[15] = t4 * (C1-C2+C3);
+    // i=7 and i=16
+    C2 = -kx + kz;
+    C3 = -kxkz_ - kySqr_;
+    eqPop[7]  = t4 * (C1+C2+C3);
+    eqPop[16] = t4 * (C1-C2+C3);
+    // i=8 and i=17
+    C2 = -ky - kz;
+    C3 = kykz_ - kxSqr_;
+    eqPop[8]  = t4 * (C1+C2+C3);
+    eqPop[17] = t4 * (C1-C2+C3);
+    // i=9 and i=18
+    C2 = -ky + kz;
+    C3 = -kykz_ - kxSqr_;
+    eqPop[9]  = t4 * (C1+C2+C3);
+    eqPop[18] = t4 * (C1-C2+C3);
+}
+
+};  //struct batchedDynamicsTemplatesImpl<D3Q19DescriptorBase>
+
+// Efficient specialization for D3Q27 lattice
+template<typename T>
+struct batchedDynamicsTemplatesImpl<T, descriptors::D3Q27DescriptorBase<T> > {
+
+typedef descriptors::D3Q27DescriptorBase<T> D;
+typedef simd::Pack<T> Pack;
+
+static void get_rhoBar_j(Array<Pack,D::q> const& f, Pack& rhoBar, Array<Pack,3>& j) {
+    Pack surfX_M1 = f[1] + f[4] + f[5] + f[6] + f[7] +
+                    f[10] + f[11] + f[12] + f[13];
+    Pack surfX_P1 = f[14] + f[17] + f[18] + f[19] + f[20] +
+                    f[23] + f[24] + f[25] + f[26];
+    Pack surfX_0  = f[0] + f[2] + f[3] + f[8] +
+                    f[9] + f[15] + f[16] + f[21] + f[22];
+
+    Pack surfY_M1 = f[2] + f[4] + f[8] + f[9] + f[10] +
+                    f[11] + f[18] + f[25] + f[26];
+    Pack surfY_P1 = f[5] + f[12] + f[13] + f[15] + f[17] +
+                    f[21] + f[22] + f[23] + f[24];
+
+    Pack surfZ_M1 = f[3] + f[6] + f[8] + f[10] + f[12] +
+                    f[20] + f[22] + f[24] + f[26];
+    Pack surfZ_P1 = f[7] + f[9] + f[11] + f[13] + f[16] +
+                    f[19] + f[21] + f[23] + f[25];
+
+    rhoBar = surfX_M1 + surfX_0 + surfX_P1;
+    j[0] = surfX_P1 - surfX_M1;
+    j[1] = surfY_P1 - surfY_M1;
+    j[2] = surfZ_P1 - surfZ_M1;
+}
+
+static void bgk_ma2_equilibria( Pack const& rhoBar, Pack const& invRho, Array<Pack,3> const& j,
+                                Pack const& jSqr, Array<Pack,D::q>& eqPop )
+{
+    Pack t0 = Pack::broadcast(D::t[0]);
+    Pack t1 = Pack::broadcast(D::t[1]);
+    Pack t4 = Pack::broadcast(D::t[4]);
+    Pack t10 = Pack::broadcast(D::t[10]);
+    Pack three = Pack::broadcast((T)3);
+    Pack halfInvRho = invRho*Pack::broadcast((T)0.5);
+    Pack kx     = three * j[0];
+    Pack ky     = three * j[1];
+    Pack kz     = three * j[2];
+    Pack kxSqr_ = halfInvRho * kx*kx;
+    Pack kySqr_ = halfInvRho * ky*ky;
+    Pack kzSqr_ = halfInvRho * kz*kz;
+    Pack kxky_  = invRho * kx*ky;
+    Pack kxkz_  = invRho * kx*kz;
+    Pack kykz_  = invRho * ky*kz;
+    Pack C1 = rhoBar + invRho*three*jSqr;
+    Pack C2, C3;
+    // i=0
+    C3 = -kxSqr_ - kySqr_ - kzSqr_;
+    eqPop[0] = t0 * (C1+C3);
+    // i=1 and i=14
+    C2 = -kx;
+    C3 = -kySqr_ - kzSqr_;
+    eqPop[1]  = t1 * (C1+C2+C3);
+    eqPop[14] = t1 * (C1-C2+C3);
+    // i=2 and i=15
+    C2 = -ky;
+    C3 = -kxSqr_ - kzSqr_;
+    eqPop[2]  = t1 * (C1+C2+C3);
+    eqPop[15] = t1 * (C1-C2+C3);
+    // i=3 and i=16
+    C2 = -kz;
+    C3 = -kxSqr_ - kySqr_;
+    eqPop[3]  = t1 * (C1+C2+C3);
+    eqPop[16] = t1 * (C1-C2+C3);
+    // i=4 and i=17
+    C2 = -kx - ky;
+    C3 = kxky_ - kzSqr_;
+    eqPop[4]  = t4 * (C1+C2+C3);
+    eqPop[17] = t4 * (C1-C2+C3);
+    // i=5 and i=18
+    C2 = -kx + ky;
+    C3 = -kxky_ - kzSqr_;
+    eqPop[5]  = t4 * (C1+C2+C3);
+    eqPop[18] = t4 * (C1-C2+C3);
+    // i=6 and i=19
+    C2 = -kx - kz;
+    C3 = kxkz_ - kySqr_;
+    eqPop[6]  = t4 * (C1+C2+C3);
+    eqPop[19] = t4 * (C1-C2+C3);
+    // i=7 and i=20
+    C2 = -kx + kz;
+    C3 = -kxkz_ - kySqr_;
+    eqPop[7]  = t4 * (C1+C2+C3);
+    eqPop[20] = t4 * (C1-C2+C3);
+    // i=8 and i=21
+    C2 = -ky - kz;
+    C3 = kykz_ - kxSqr_;
+    eqPop[8]  = t4 * (C1+C2+C3);
+    eqPop[21] = t4 * (C1-C2+C3);
+    // i=9 and i=22
+    C2 = -ky + kz;
+    C3 = -kykz_ - kxSqr_;
+    eqPop[9]  = t4 * (C1+C2+C3);
+    eqPop[22] = t4 * (C1-C2+C3);
+    // i=10 and i=23
+    C2 = -kx - ky - kz;
+    C3 = kxky_ + kxkz_ + kykz_;
+    eqPop[10] = t10 * (C1+C2+C3);
+    eqPop[23] = t10 * (C1-C2+C3);
+    // i=11 and i=24
+    C2 = -kx - ky + kz;
+    C3 = kxky_ - kxkz_ - kykz_;
+    eqPop[11] = t10 * (C1+C2+C3);
+    eqPop[24] = t10 * (C1-C2+C3);
+    // i=12 and i=25
+    C2 = -kx + ky - kz;
+    C3 = -kxky_ + kxkz_ - kykz_;
+    eqPop[12] = t10 * (C1+C2+C3);
+    eqPop[25] = t10 * (C1-C2+C3);
+    // i=13 and i=26
+    C2 = -kx + ky + kz;
+    C3 = -kxky_ - kxkz_ + kykz_;
+    eqPop[13] = t10 * (C1+C2+C3);
+    eqPop[26] = t10 * (C1-C2+C3);
+}
+
+};  //struct batchedDynamicsTemplatesImpl<D3Q27DescriptorBase>
+
+}  // namespace plb
+
+#endif  // BATCHED_DYNAMICS_TEMPLATES_3D_H
@@ -69,6 +69,55 @@ plint findVelocity(Array<int,Descriptor::d> const& v) {
     return Descriptor::q;
 }
 
+/// Skew factors of a cache-blocked swap-and-stream in 2D.
+/** In the swap-based streaming, a cell is swapped with its neighbors
+ *  x+c_i (1 <= i <= q/2), which must have been collided before. With the
+ *  tile coordinates (x, y+skewY*dx), where dx is the offset in the current
+ *  x-tile, all these neighbors are contained in the same tile or in a
+ *  previous one.
+ */
+template <typename Descriptor> void streamingSkew2D(plint& skewY) {
+    skewY = 0;
+    for (plint iPop=1; iPop<=Descriptor::q/2; ++iPop) {
+        plint cx = Descriptor::c[iPop][0];
+        plint cy = Descriptor::c[iPop][1];
+        if (cx<0 && cy>0) {
+            skewY = std::max(skewY, (cy-cx-1)/(-cx));
+        }
+    }
+}
+
+/// Skew factors of a cache-blocked swap-and-stream in 3D.
+/** The tile coordinates are (x, y', z+skewZx*dx+skewZy*dy), where
+ *  y'=y+skewY*dx, and dx and dy are the offsets of x and y' in the
+ *  current tile. \sa streamingSkew2D()
+ */
+template <typename Descriptor> void streamingSkew3D(plint& skewY, plint& skewZx, plint& skewZy) {
+    skewY = 0;
+    skewZx = 0;
+    skewZy = 0;
+    for (plint iPop=1; iPop<=Descriptor::q/2; ++iPop) {
+        plint cx = Descriptor::c[iPop][0];
+        plint cy = Descriptor::c[iPop][1];
+        plint cz = Descriptor::c[iPop][2];
+        if (cx<0 && cy>0) {
+            skewY = std::max(skewY, (cy-cx-1)/(-cx));
+        }
+        if (cx==0 && cy<0 && cz>0) {
+            skewZy = std::max(skewZy, (cz-cy-1)/(-cy));
+        }
+    }
+    for (plint iPop=1; iPop<=Descriptor::q/2; ++iPop) {
+        plint cx = Descriptor::c[iPop][0];
+        plint cy = Descriptor::c[iPop][1];
+        plint cz = Descriptor::c[iPop][2];
+        plint shiftZ = cz + skewZy*(cy+skewY*cx);
+        if (cx<0 && shiftZ>0) {
+            skewZx = std::max(skewZx, (shiftZ-cx-1)/(-cx));
+        }
+    }
+}
+
 /// Compute the index corresponding to a specular reflection
 template <typename Descriptor, int orientation> inline plint specularReflection(plint iPop) {
     if (iPop==0) return 0;
@@ -45,6 +45,38 @@ struct BlockCommunicator3D {
      *  is being transmitted.
      **/
     virtual void duplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const =0;
+    /// First half of duplicateOverlaps: the data is sent, but its reception is not awaited.
+    /** Between startDuplicateOverlaps() and completeDuplicateOverlaps(), the bulk of the
+     *  multi-block may be modified everywhere except in the cells which are being sent,
+     *  and the envelopes must not be accessed. No other communication may be launched
+     *  through the same communicator in between. The default implementation is blocking:
+     *  it executes the full duplicateOverlaps().
+     **/
+    virtual void startDuplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const {
+        duplicateOverlaps(multiBlock, whichData);
+    }
+    /// Second half of duplicateOverlaps: wait for the data launched by startDuplicateOverlaps().
+    virtual void completeDuplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const
+    { }
+    /// Restricted version of duplicateOverlaps(multiBlock, modif::staticVariables), valid after
+    ///   a collision and streaming step which is executed on the bulk and the envelope of every
+    ///   block, and after which nothing else has been modified.
+    /** Only the populations which enter the envelopes from outside the blocks are
+     *  transmitted (see BlockDataTransfer3D::getStreamedPopulations()); the others have
+     *  been computed locally from envelope data which was already up to date. The default
+     *  implementation transmits the full static content.
+     **/
+    virtual void duplicateStreamedPopulations(MultiBlock3D& multiBlock) const {
+        duplicateOverlaps(multiBlock, modif::staticVariables);
+    }
+    /// First half of duplicateStreamedPopulations(), see startDuplicateOverlaps().
+    virtual void startDuplicateStreamedPopulations(MultiBlock3D& multiBlock) const {
+        startDuplicateOverlaps(multiBlock, modif::staticVariables);
+    }
+    /// Second half of duplicateStreamedPopulations(), see completeDuplicateOverlaps().
+    virtual void completeDuplicateStreamedPopulations(MultiBlock3D& multiBlock) const {
+        completeDuplicateOverlaps(multiBlock, modif::staticVariables);
+    }
     /// Transmit data between two multi-blocks, according to a user-defined pattern.
     /** The variable whichData specifies which type of content (static/dynamic/full dynamics object)
      *  is being transmitted.
@@ -32,9 +32,58 @@
 
 namespace plb {
 
+CombinedStatistics::CombinedStatistics()
+    : laggedReduction(false),
+      pendingReduction(false)
+{ }
+
 CombinedStatistics::~CombinedStatistics()
 { }
 
+void CombinedStatistics::toggleLaggedReduction(bool laggedReduction_) {
+    laggedReduction = laggedReduction_;
+}
+
+bool CombinedStatistics::isLaggedReductionOn() const {
+    return laggedReduction;
+}
+
+void CombinedStatistics::startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
+{
+    this->reduceStatistics (
+            averageObservables, sumWeights,
+            sumObservables,
+            maxObservables,
+            intSumObservables );
+    pendingAverage = averageObservables;
+    pendingSum = sumObservables;
+    pendingMax = maxObservables;
+    pendingIntSum = intSumObservables;
+    pendingReduction = true;
+}
+
+bool CombinedStatistics::completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
+{
+    if (!pendingReduction) {
+        return false;
+    }
+    averageObservables.swap(pendingAverage);
+    sumObservables.swap(pendingSum);
+    maxObservables.swap(pendingMax);
+    intSumObservables.swap(pendingIntSum);
+    pendingReduction = false;
+    return true;
+}
+
 void CombinedStatistics::computeLocalAverage (
             std::vector<BlockStatistics const*> const& individualStatistics,
             std::vector<double>& averageObservables,
@@ -126,6 +175,31 @@ void CombinedStatistics::combine (
     std::vector<plint> intSumObservables(result.getIntSumVect().size());
     computeLocalIntSum(individualStatistics, intSumObservables);
 
+    // A reduction left over from the lagged mode is completed in any case.
+    std::vector<double> laggedAverage, laggedSum, laggedMax;
+    std::vector<plint> laggedIntSum;
+    bool laggedResult = this->completeReduction (
+            laggedAverage, laggedSum, laggedMax, laggedIntSum );
+
+    if (laggedReduction) {
+        this->startReduction (
+                averageObservables, sumWeights,
+                sumObservables,
+                maxObservables,
+                intSumObservables );
+        // The result of the previous call is discarded if the number of
+        //   observables has changed in between.
+        if ( laggedResult &&
+             laggedAverage.size()==averageObservables.size() &&
+             laggedSum.size()==sumObservables.size() &&
+             laggedMax.size()==maxObservables.size() &&
+             laggedIntSum.size()==intSumObservables.size() )
+        {
+            result.evaluate(laggedAverage, laggedSum, laggedMax, laggedIntSum, 0);
+        }
+        return;
+    }
+
     // Compute global, cross-core statistics
     this->reduceStatistics (
             averageObservables, sumWeights,
@@ -36,11 +36,19 @@ namespace plb {
 
 class CombinedStatistics {
 public:
+    CombinedStatistics();
     virtual ~CombinedStatistics();
     virtual CombinedStatistics* clone() const =0;
     void combine (
             std::vector<BlockStatistics const*>& individualStatistics,
             BlockStatistics& result ) const;
+    /// In lagged mode, combine() only starts the reduction of the statistics,
+    ///   and completes it during its next call: the result then holds the
+    ///   statistics of the previous call (after the first call, it is left
+    ///   unchanged). This removes the synchronization between processes
+    ///   which the reduction otherwise implies at every call.
+    void toggleLaggedReduction(bool laggedReduction_);
+    bool isLaggedReductionOn() const;
 protected:
     virtual void reduceStatistics (
             std::vector<double>& averageObservables,
@@ -48,6 +56,21 @@ protected:
             std::vector<double>& sumObservables,
             std::vector<double>& maxObservables,
             std::vector<plint>& intSumObservables ) const =0;
+    /// Start the reduction of the statistics, which is completed by completeReduction().
+    ///   The default implementation reduces immediately with reduceStatistics().
+    virtual void startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const;
+    /// Get the result of the reduction started by startReduction(), or return false
+    ///   if there is none.
+    virtual bool completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const;
 private:
     void computeLocalAverage (
             std::vector<BlockStatistics const*> const& individualStatistics,
@@ -62,6 +85,11 @@ private:
     void computeLocalIntSum (
             std::vector<BlockStatistics const*> const& individualStatistics,
             std::vector<plint>& intSumObservables ) const;
+private:
+    bool laggedReduction;
+    mutable bool pendingReduction;
+    mutable std::vector<double> pendingAverage, pendingSum, pendingMax;
+    mutable std::vector<plint> pendingIntSum;
 };
 
 class SerialCombinedStatistics : public CombinedStatistics {
@@ -32,11 +32,14 @@
 #include "multiBlock/multiContainerBlock3D.h"
 #include "multiBlock/multiBlockManagement3D.h"
 #include "multiBlock/multiBlockLattice3D.h"
+#include "multiBlock/multiSoaBlockLattice3D.h"
+#include "multiBlock/multiSparseBlockLattice3D.h"
 #include "multiBlock/multiDataField3D.h"
 #include "multiBlock/serialMultiBlockLattice3D.h"
 #include "multiBlock/serialMultiDataField3D.h"
 #include "multiBlock/serialBlockCommunicator3D.h"
 #include "multiBlock/staticRepartitions3D.h"
+#include "multiBlock/redistribution3D.h"
 #include "multiBlock/defaultMultiBlockPolicy3D.h"
 #include "multiBlock/multiDataProcessorWrapper3D.h"
 #include "multiBlock/reductiveMultiDataProcessorWrapper3D.h"
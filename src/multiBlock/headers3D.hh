@@ -27,6 +27,8 @@
  */
 
 #include "multiBlock/multiBlockLattice3D.hh"
+#include "multiBlock/multiSoaBlockLattice3D.hh"
+#include "multiBlock/multiSparseBlockLattice3D.hh"
 #include "multiBlock/coupling3D.hh"
 #include "multiBlock/group3D.hh"
 #include "multiBlock/multiDataField3D.hh"
@@ -33,6 +33,7 @@
 #include "multiBlock/multiBlockSerializer3D.h"
 #include "multiBlock/defaultMultiBlockPolicy3D.h"
 #include "atomicBlock/atomicBlock3D.h"
+#include "parallelism/threadPool.h"
 #include <cmath>
 #include <algorithm>
 
@@ -246,6 +247,10 @@ MultiBlock3D::MultiBlock3D( MultiBlockManagement3D const& multiBlockManagement_,
                             CombinedStatistics* combinedStatistics_ )
     : multiBlockManagement(multiBlockManagement_),
       maxProcessorLevel(-1),
+      processorScheduling(false),
+      processorScheduleModified(true),
+      processorScheduleValid(false),
+      blockCostMeasurement(false),
       blockCommunicator(blockCommunicator_),
       internalStatistics(),
       combinedStatistics(combinedStatistics_),
@@ -261,6 +266,10 @@ MultiBlock3D::MultiBlock3D(plint nx, plint ny, plint nz, plint envelopeWidth)
     : multiBlockManagement(defaultMultiBlockPolicy3D().getMultiBlockManagement (
                                Box3D(0,nx-1,0,ny-1,0,nz-1), envelopeWidth) ),
       maxProcessorLevel(-1),
+      processorScheduling(false),
+      processorScheduleModified(true),
+      processorScheduleValid(false),
+      blockCostMeasurement(false),
       blockCommunicator(defaultMultiBlockPolicy3D().getBlockCommunicator()),
       internalStatistics(),
       combinedStatistics(defaultMultiBlockPolicy3D().getCombinedStatistics()),
@@ -278,6 +287,10 @@ MultiBlock3D::MultiBlock3D(MultiBlock3D const& rhs)
       multiBlocksChangedByAutomaticProcessors(rhs.multiBlocksChangedByAutomaticProcessors),
       maxProcessorLevel(rhs.maxProcessorLevel),
       storedProcessors(rhs.storedProcessors),
+      processorScheduling(rhs.processorScheduling),
+      processorScheduleModified(true),
+      processorScheduleValid(false),
+      blockCostMeasurement(rhs.blockCostMeasurement),
       blockCommunicator(rhs.blockCommunicator->clone()),
       internalStatistics(rhs.internalStatistics),
       combinedStatistics(rhs.combinedStatistics -> clone()),
@@ -293,6 +306,10 @@ MultiBlock3D::MultiBlock3D(MultiBlock3D const& rhs, Box3D subDomain, bool crop)
     : multiBlockManagement( intersect(rhs.getMultiBlockManagement(), subDomain, crop) ),
       maxProcessorLevel(-1),
       storedProcessors(rhs.storedProcessors),
+      processorScheduling(rhs.processorScheduling),
+      processorScheduleModified(true),
+      processorScheduleValid(false),
+      blockCostMeasurement(rhs.blockCostMeasurement),
       blockCommunicator(rhs.blockCommunicator->clone()),
       internalStatistics(),
       combinedStatistics(rhs.combinedStatistics->clone()),
@@ -310,6 +327,11 @@ void MultiBlock3D::swap(MultiBlock3D& rhs) {
     multiBlocksChangedByAutomaticProcessors.swap(rhs.multiBlocksChangedByAutomaticProcessors);
     std::swap(maxProcessorLevel, rhs.maxProcessorLevel);
     storedProcessors.swap(rhs.storedProcessors);
+    std::swap(processorScheduling, rhs.processorScheduling);
+    processorScheduleModified = true;
+    rhs.processorScheduleModified = true;
+    std::swap(blockCostMeasurement, rhs.blockCostMeasurement);
+    blockCosts.swap(rhs.blockCosts);
     std::swap(blockCommunicator, rhs.blockCommunicator);
     std::swap(internalStatistics, rhs.internalStatistics);
     std::swap(combinedStatistics, rhs.combinedStatistics);
@@ -318,6 +340,15 @@ void MultiBlock3D::swap(MultiBlock3D& rhs) {
     std::swap(internalModifT, rhs.internalModifT);
 }
 
+void MultiBlock3D::swapDistribution(MultiBlock3D& rhs) {
+    multiBlockManagement.swap(rhs.multiBlockManagement);
+    std::swap(blockCommunicator, rhs.blockCommunicator);
+    processorScheduleModified = true;
+    rhs.processorScheduleModified = true;
+    blockCosts.clear();
+    rhs.blockCosts.clear();
+}
+
 MultiBlock3D::~MultiBlock3D() {
     delete blockCommunicator;
     delete combinedStatistics;
@@ -388,6 +419,14 @@ void MultiBlock3D::duplicateOverlaps(modif::ModifT whichData) {
     this->getBlockCommunicator().duplicateOverlaps(*this, whichData);
 }
 
+void MultiBlock3D::startDuplicateOverlaps(modif::ModifT whichData) {
+    this->getBlockCommunicator().startDuplicateOverlaps(*this, whichData);
+}
+
+void MultiBlock3D::completeDuplicateOverlaps(modif::ModifT whichData) {
+    this->getBlockCommunicator().completeDuplicateOverlaps(*this, whichData);
+}
+
 void MultiBlock3D::signalPeriodicity() {
     getBlockCommunicator().signalPeriodicity();
 }
@@ -453,6 +492,14 @@ bool MultiBlock3D::isInternalStatisticsOn() const {
     return statisticsOn;
 }
 
+void MultiBlock3D::toggleLaggedStatistics(bool laggedStatistics) {
+    combinedStatistics->toggleLaggedReduction(laggedStatistics);
+}
+
+bool MultiBlock3D::isLaggedStatisticsOn() const {
+    return combinedStatistics->isLaggedReductionOn();
+}
+
 PeriodicitySwitch3D const& MultiBlock3D::periodicity() const {
     return periodicitySwitch;
 }
@@ -469,6 +516,7 @@ modif::ModifT MultiBlock3D::getInternalTypeOfModification() const
 void MultiBlock3D::setInternalTypeOfModification(modif::ModifT internalModifT_)
 {
     internalModifT = internalModifT_;
+    processorScheduleModified = true;
 }
 
 void MultiBlock3D::setRefinementLevel(plint newLevel)
@@ -486,11 +534,42 @@ void MultiBlock3D::setDataTransfer(BlockDataTransfer3D* newDataTransfer) {
 }
 
 
+/// Executes the internal data processors of a range of levels on a list of atomic-blocks,
+///   one per task.
+class InternalProcessorsTask3D : public ThreadPoolTask {
+public:
+    InternalProcessorsTask3D(std::vector<AtomicBlock3D*> const& blocks_,
+                             plint firstLevel_, plint lastLevel_)
+        : blocks(blocks_),
+          firstLevel(firstLevel_),
+          lastLevel(lastLevel_)
+    { }
+    virtual void execute(plint iTask) {
+        for (plint iLevel=firstLevel; iLevel<=lastLevel; ++iLevel) {
+            blocks[iTask]->executeInternalProcessors(iLevel);
+        }
+    }
+private:
+    std::vector<AtomicBlock3D*> const& blocks;
+    plint firstLevel, lastLevel;
+};
+
 void MultiBlock3D::executeInternalProcessors() {
     global::profiler().start("dataProcessor");
+    if (processorScheduling && maxProcessorLevel>=0) {
+        if (processorScheduleModified) {
+            processorScheduleValid = computeProcessorSchedule();
+            processorScheduleModified = false;
+        }
+    }
     // Execute all automatic internal processors.
-    for (plint iLevel=0; iLevel<=maxProcessorLevel; ++iLevel) {
-        executeInternalProcessors(iLevel);
+    if (processorScheduling && maxProcessorLevel>=0 && processorScheduleValid) {
+        executeScheduledProcessors();
+    }
+    else {
+        for (plint iLevel=0; iLevel<=maxProcessorLevel; ++iLevel) {
+            executeInternalProcessors(iLevel);
+        }
     }
     // Duplicate boundaries at least once in case there is no automatic processor.
     if (maxProcessorLevel==-1) {
@@ -501,15 +580,66 @@ void MultiBlock3D::executeInternalProcessors() {
     global::profiler().stop("dataProcessor");
 }
 
+void MultiBlock3D::executeBlockTasks (
+        ThreadPoolTask& task, std::vector<plint> const& blockIds,
+        std::vector<int> const& preferredThread )
+{
+    PLB_PRECONDITION( blockIds.size() == preferredThread.size() );
+    if (!blockCostMeasurement) {
+        global::threadPool().execute(task, preferredThread);
+        return;
+    }
+    std::vector<double> taskTimes(blockIds.size(), 0.);
+    TimedThreadPoolTask timedTask(task, taskTimes);
+    global::threadPool().execute(timedTask, preferredThread);
+    for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+        blockCosts[blockIds[iBlock]] += taskTimes[iBlock];
+    }
+}
+
+plint MultiBlock3D::getMaxProcessorLevel() const {
+    return maxProcessorLevel;
+}
+
+void MultiBlock3D::toggleProcessorScheduling(bool processorScheduling_) {
+    processorScheduling = processorScheduling_;
+}
+
+bool MultiBlock3D::isProcessorSchedulingOn() const {
+    return processorScheduling;
+}
+
+void MultiBlock3D::toggleBlockCostMeasurement(bool blockCostMeasurement_) {
+    blockCostMeasurement = blockCostMeasurement_;
+}
+
+bool MultiBlock3D::isBlockCostMeasurementOn() const {
+    return blockCostMeasurement;
+}
+
+std::map<plint,double> const& MultiBlock3D::getLocalBlockCosts() const {
+    return blockCosts;
+}
+
+void MultiBlock3D::resetBlockCosts() {
+    blockCosts.clear();
+}
+
 void MultiBlock3D::executeInternalProcessors(plint level, bool communicate) {
     if (level < 0) {
       global::timer("execute_dp").start();
     }
     std::vector<plint> const& blocks = getLocalInfo().getBlocks();
+    std::vector<AtomicBlock3D*> components(blocks.size());
+    std::vector<int> preferredThread(blocks.size());
+    ThreadAttribution const& threadAttribution = multiBlockManagement.getThreadAttribution();
     for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
         plint blockId = blocks[iBlock];
-        getComponent(blockId).executeInternalProcessors(level);
+        components[iBlock] = &getComponent(blockId);
+        preferredThread[iBlock] = threadAttribution.getLocalThreadId(blockId);
     }
+    InternalProcessorsTask3D task(components, level, level);
+    executeBlockTasks(task, blocks, preferredThread);
     if (level < 0) {
         global::timer("execute_dp").stop();
         global::timer("communicate_dp").start();
@@ -529,6 +659,7 @@ void MultiBlock3D::subscribeProcessor (
         bool includesEnvelope )
 {
     maxProcessorLevel = std::max(level, maxProcessorLevel);
+    processorScheduleModified = true;
 
     if (level>=0) {
         addModifiedBlocks(level,
@@ -547,6 +678,7 @@ void MultiBlock3D::storeProcessor (
         std::vector<MultiBlock3D*> multiBlocks, plint level)
 {
     storedProcessors.push_back(ProcessorStorage3D(generator,multiBlocks,level));
+    processorScheduleModified = true;
 }
 
 std::vector<MultiBlock3D::ProcessorStorage3D> const&
@@ -652,6 +784,164 @@ void MultiBlock3D::duplicateOverlapsAtLevelZero (
     }
 }
 
+/// Position of a multi-block in a list of blocks with type of modification, or -1.
+static plint findBlockAndModif (
+        std::vector<MultiBlock3D::BlockAndModif> const& blocks, MultiBlock3D const* block )
+{
+    for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
+        if (blocks[iBlock].first==block) {
+            return (plint)iBlock;
+        }
+    }
+    return -1;
+}
+
+static void addBlockAndModif (
+        std::vector<MultiBlock3D::BlockAndModif>& blocks, MultiBlock3D::BlockAndModif const& block )
+{
+    plint iBlock = findBlockAndModif(blocks, block.first);
+    if (iBlock==-1) {
+        blocks.push_back(block);
+    }
+    else {
+        blocks[iBlock].second = combine(blocks[iBlock].second, block.second);
+    }
+}
+
+/** The multi-blocks read by a level are the arguments of its stored processors.
+ *  A level starts a new phase if it reads a multi-block which has been modified
+ *  within the current phase. Otherwise, it only depends on the processors executed
+ *  on the same atomic-block, provided that all arguments have the block distribution
+ *  of this multi-block (a processor attached to a given atomic-block then accesses
+ *  only the components with the same block ID). The envelope updates which are
+ *  pending at the end of a phase are launched in the same order on all processes.
+ *  Updates of static variables are non-blocking: they are completed before the
+ *  first phase which reads the multi-block, or at the end. Other updates, which
+ *  require a transmission of the message sizes, are executed right away, because
+ *  the messages of several simultaneous updates could otherwise be mismatched.
+ */
+bool MultiBlock3D::computeProcessorSchedule() {
+    processorSchedule.clear();
+    completeAfterSchedule.clear();
+    plint numLevels = maxProcessorLevel+1;
+
+    std::vector<std::vector<BlockAndModif> > readBlocks(numLevels);
+    for (pluint iProc=0; iProc<storedProcessors.size(); ++iProc) {
+        plint level = storedProcessors[iProc].getLevel();
+        if (level<0 || level>=numLevels) {
+            continue;
+        }
+        std::vector<id_t> const& ids = storedProcessors[iProc].getMultiBlockIds();
+        for (pluint iBlock=0; iBlock<ids.size(); ++iBlock) {
+            MultiBlock3D* block = multiBlockRegistration3D().find(ids[iBlock]);
+            if (!block || !block->getMultiBlockManagement().equivalentTo(multiBlockManagement)) {
+                return false;
+            }
+            addBlockAndModif(readBlocks[level], BlockAndModif(block, modif::nothing));
+        }
+    }
+
+    std::vector<std::vector<BlockAndModif> > modifiedBlocks(numLevels);
+    for (plint iLevel=0; iLevel<numLevels; ++iLevel) {
+        if (iLevel<(plint)multiBlocksChangedByAutomaticProcessors.size()) {
+            modifiedBlocks[iLevel] = multiBlocksChangedByAutomaticProcessors[iLevel];
+        }
+        // A modified block which is not among the stored arguments means that
+        //   some processors were not added through addInternalProcessor().
+        for (pluint iBlock=0; iBlock<modifiedBlocks[iLevel].size(); ++iBlock) {
+            if (findBlockAndModif(readBlocks[iLevel], modifiedBlocks[iLevel][iBlock].first)==-1) {
+                return false;
+            }
+        }
+    }
+    // As in duplicateOverlapsAtLevelZero(), the envelope of this multi-block is
+    //   always updated after level 0.
+    addBlockAndModif(modifiedBlocks[0], BlockAndModif(this, internalModifT));
+
+    std::vector<BlockAndModif> pending;
+    ProcessorPhase3D phase;
+    phase.firstLevel = 0;
+    std::vector<BlockAndModif> phaseModifications;
+    for (plint iLevel=0; iLevel<numLevels; ++iLevel) {
+        bool dependsOnPhase = false;
+        for (pluint iBlock=0; iBlock<readBlocks[iLevel].size(); ++iBlock) {
+            if (findBlockAndModif(phaseModifications, readBlocks[iLevel][iBlock].first)!=-1) {
+                dependsOnPhase = true;
+                break;
+            }
+        }
+        if (dependsOnPhase) {
+            phase.lastLevel = iLevel-1;
+            phase.startAfter = phaseModifications;
+            processorSchedule.push_back(phase);
+            for (pluint iBlock=0; iBlock<phaseModifications.size(); ++iBlock) {
+                if (phaseModifications[iBlock].second==modif::staticVariables) {
+                    pending.push_back(phaseModifications[iBlock]);
+                }
+            }
+            phase = ProcessorPhase3D();
+            phase.firstLevel = iLevel;
+            phaseModifications.clear();
+        }
+        // Pending updates are completed before the phase in which they are read.
+        for (pluint iBlock=0; iBlock<readBlocks[iLevel].size(); ++iBlock) {
+            plint iPending = findBlockAndModif(pending, readBlocks[iLevel][iBlock].first);
+            if (iPending!=-1) {
+                phase.completeBefore.push_back(pending[iPending]);
+                pending.erase(pending.begin()+iPending);
+            }
+        }
+        for (pluint iBlock=0; iBlock<modifiedBlocks[iLevel].size(); ++iBlock) {
+            addBlockAndModif(phaseModifications, modifiedBlocks[iLevel][iBlock]);
+        }
+    }
+    phase.lastLevel = numLevels-1;
+    phase.startAfter = phaseModifications;
+    processorSchedule.push_back(phase);
+    for (pluint iBlock=0; iBlock<phaseModifications.size(); ++iBlock) {
+        if (phaseModifications[iBlock].second==modif::staticVariables) {
+            pending.push_back(phaseModifications[iBlock]);
+        }
+    }
+    completeAfterSchedule = pending;
+    return true;
+}
+
+void MultiBlock3D::executeScheduledProcessors() {
+    std::vector<plint> const& blocks = getLocalInfo().getBlocks();
+    std::vector<AtomicBlock3D*> components(blocks.size());
+    std::vector<int> preferredThread(blocks.size());
+    ThreadAttribution const& threadAttribution = multiBlockManagement.getThreadAttribution();
+    for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
+        plint blockId = blocks[iBlock];
+        components[iBlock] = &getComponent(blockId);
+        preferredThread[iBlock] = threadAttribution.getLocalThreadId(blockId);
+    }
+    for (pluint iPhase=0; iPhase<processorSchedule.size(); ++iPhase) {
+        ProcessorPhase3D const& phase = processorSchedule[iPhase];
+        for (pluint iBlock=0; iBlock<phase.completeBefore.size(); ++iBlock) {
+            phase.completeBefore[iBlock].first->completeDuplicateOverlaps (
+                    phase.completeBefore[iBlock].second );
+        }
+        InternalProcessorsTask3D task(components, phase.firstLevel, phase.lastLevel);
+        executeBlockTasks(task, blocks, preferredThread);
+        for (pluint iBlock=0; iBlock<phase.startAfter.size(); ++iBlock) {
+            MultiBlock3D* block = phase.startAfter[iBlock].first;
+            modif::ModifT whichData = phase.startAfter[iBlock].second;
+            if (whichData==modif::staticVariables) {
+                block->startDuplicateOverlaps(whichData);
+            }
+            else {
+                block->duplicateOverlaps(whichData);
+            }
+        }
+    }
+    for (pluint iBlock=0; iBlock<completeAfterSchedule.size(); ++iBlock) {
+        completeAfterSchedule[iBlock].first->completeDuplicateOverlaps (
+                completeAfterSchedule[iBlock].second );
+    }
+}
+
 /* *************** Class MultiBlockRegistration3D ******************************** */
 
 MultiBlockRegistration3D::MultiBlockRegistration3D()
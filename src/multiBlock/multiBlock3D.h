@@ -41,12 +41,14 @@
 #include <utility>
 #include <string>
 #include <vector>
+#include <map>
 
 namespace plb {
 
 class AtomicBlock3D;
 class MultiBlock3D;
 class MultiBlockRegistration3D;
+struct ThreadPoolTask;
 template <typename T> class TypedAtomicBlock3D;
 template <typename T> class EulerianAtomicBlock3D;
 
@@ -141,6 +143,33 @@ public:
     void executeInternalProcessors();
     /// Execute all internal dataProcessors at a given level.
     void executeInternalProcessors(plint level, bool communicate=true);
+    /// Highest level of the automatic internal processors, or -1 if there are none.
+    plint getMaxProcessorLevel() const;
+    /// Execute the automatic internal processors according to their data dependencies,
+    ///   instead of separating all levels by an envelope update.
+    /** The dependencies are deduced from the processors stored with storeProcessor()
+     *  (i.e. added with addInternalProcessor()): the envelope of a multi-block modified
+     *  at a given level is only updated before the next level which takes this
+     *  multi-block as an argument, or at the end of executeInternalProcessors().
+     *  Consecutive levels which do not depend on such an update are executed by the
+     *  thread pool in one go, block by block, and envelope updates of static
+     *  variables are launched as soon as their last producer has been executed and
+     *  completed only when needed. The result is identical to the level-by-level
+     *  execution. If not all the arguments of the stored processors have the block
+     *  distribution of this multi-block, the levels are executed one by one as usual.
+     *  All the automatic internal processors must have been added through
+     *  addInternalProcessor().
+     */
+    void toggleProcessorScheduling(bool processorScheduling_);
+    bool isProcessorSchedulingOn() const;
+    /// Measure the time spent on every local atomic-block by the collision-streaming
+    ///   and by the automatic internal processors, as a cost for load balancing
+    ///   (see rebalance() in multiBlock/redistribution3D.h).
+    void toggleBlockCostMeasurement(bool blockCostMeasurement_);
+    bool isBlockCostMeasurementOn() const;
+    /// Time, in seconds, measured for every local atomic-block since the last reset.
+    std::map<plint,double> const& getLocalBlockCosts() const;
+    void resetBlockCosts();
     /// After adding an internal processor to the atomic-blocks, subscribe it
     /// in the multi-block to guarantee it will be executed.
     void subscribeProcessor(plint level,
@@ -167,6 +196,11 @@ public:
     CombinedStatistics const& getCombinedStatistics() const;
     void toggleInternalStatistics(bool statisticsOn_);
     bool isInternalStatisticsOn() const;
+    /// Reduce the internal statistics without blocking. Each call to
+    ///   evaluateStatistics() then publishes the statistics of the previous call,
+    ///   for example of the previous time step. See CombinedStatistics.
+    void toggleLaggedStatistics(bool laggedStatistics);
+    bool isLaggedStatisticsOn() const;
     PeriodicitySwitch3D const& periodicity() const;
     PeriodicitySwitch3D& periodicity();
     /// Returns: which kind of data is modified by level-0 processors and by
@@ -192,6 +226,11 @@ private:
     void duplicateOverlapsInModifiedMultiBlocks(plint level);
     void duplicateOverlapsInModifiedMultiBlocks(std::vector<BlockAndModif>& multiBlocks);
     void duplicateOverlapsAtLevelZero(std::vector<BlockAndModif>& multiBlocks);
+    /// Group the automatic processor levels into phases, and compute the envelope
+    ///   updates which are completed before and launched after each phase. Returns
+    ///   false if the dependencies cannot be deduced from the stored processors.
+    bool computeProcessorSchedule();
+    void executeScheduledProcessors();
     void reduceStatistics();
 public:
     BlockCommunicator3D const& getBlockCommunicator() const;
@@ -199,6 +238,11 @@ public:
                 MultiBlock3D const& fromBlock, Box3D const& fromDomain,
                 Box3D const& toDomain, modif::ModifT whichData=modif::dataStructure ) =0;
     void duplicateOverlaps(modif::ModifT whichData);
+    /// Launch duplicateOverlaps(whichData) without waiting for its completion; see
+    ///   BlockCommunicator3D::startDuplicateOverlaps() for the restrictions which apply
+    ///   until completeDuplicateOverlaps(whichData) is called.
+    void startDuplicateOverlaps(modif::ModifT whichData);
+    void completeDuplicateOverlaps(modif::ModifT whichData);
     void signalPeriodicity();
     virtual DataSerializer* getBlockSerializer (
             Box3D const& domain, IndexOrdering::OrderingT ordering ) const;
@@ -213,6 +257,18 @@ public:
     /// Get one or two string identifiers for the template parameters of the block.
     ///   E.g. "double" and "d3q19"
     virtual std::vector<std::string> getTypeInfo() const =0;
+    /// Exchange the atomic-blocks and the block distribution with rhs, which must be
+    ///   of the same type. All other properties, like the data processors stored in the
+    ///   multi-blocks, are left unchanged. Used for the redistribution of a multi-block
+    ///   in place, with rhs obtained from clone(newManagement).
+    virtual void swapComponents(MultiBlock3D& rhs) =0;
+protected:
+    /// Part of swapComponents() which is common to all multi-blocks.
+    void swapDistribution(MultiBlock3D& rhs);
+    /// Execute one task per local block with the thread pool. If the block costs
+    ///   are measured, the execution time of every task is added to its block.
+    void executeBlockTasks(ThreadPoolTask& task, std::vector<plint> const& blockIds,
+                           std::vector<int> const& preferredThread);
 private:
     MultiBlockManagement3D multiBlockManagement;
     /// List of MultiBlocks which are modified by the manual processors and require
@@ -223,6 +279,23 @@ private:
     std::vector<std::vector<BlockAndModif> > multiBlocksChangedByAutomaticProcessors;
     plint maxProcessorLevel;
     std::vector<ProcessorStorage3D> storedProcessors;
+    /// Consecutive levels of automatic processors executed without an envelope update
+    ///   in between, as computed by computeProcessorSchedule().
+    struct ProcessorPhase3D {
+        plint firstLevel, lastLevel;
+        /// Envelope updates which must be completed before the phase.
+        std::vector<BlockAndModif> completeBefore;
+        /// Envelope updates which are launched after the phase.
+        std::vector<BlockAndModif> startAfter;
+    };
+    bool processorScheduling;
+    bool processorScheduleModified;
+    bool processorScheduleValid;
+    std::vector<ProcessorPhase3D> processorSchedule;
+    /// Envelope updates which are still pending after the last phase.
+    std::vector<BlockAndModif> completeAfterSchedule;
+    bool blockCostMeasurement;
+    std::map<plint,double> blockCosts;
     BlockCommunicator3D* blockCommunicator;
     BlockStatistics internalStatistics;
     CombinedStatistics* combinedStatistics;
@@ -91,6 +91,7 @@ public:
     /// Attention: data-processors of rhs, which were pointing at rhs, will continue pointing
     /// to rhs, and not to *this.
     void swap(MultiBlockLattice3D& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
     /// Attention: data-processors of rhs, which were pointing at rhs, will continue pointing
     /// to rhs, and not to *this.
     MultiBlockLattice3D<T,Descriptor>& operator=(MultiBlockLattice3D<T,Descriptor> const& rhs);
@@ -109,6 +110,48 @@ public:
     virtual void collideAndStream(Box3D domain);
     virtual void collideAndStream();
     void externalCollideAndStream();
+    /// Overlap the communication of the envelopes with the collision and streaming
+    ///   of the cells which are not involved in the communication.
+    /** This is only effective if there are no automatic internal data processors
+     *  and no co-processors; otherwise, collideAndStream() falls back to the
+     *  regular sequence. The populations are identical in both cases.
+     */
+    void toggleCommunicationOverlap(bool communicationOverlap_);
+    bool isCommunicationOverlapOn() const;
+    /// After the collision and streaming step, send to the envelopes only the
+    ///   populations which are streamed into them from outside the collision
+    ///   domain of the receiving block.
+    /** The other populations of the envelope cells are already correct after the
+     *  local collision and streaming, provided that the envelopes were consistent
+     *  before the step. This is therefore only correct if the populations are not
+     *  modified through get() without a subsequent duplicateOverlaps(), and if the
+     *  external scalars of the envelope cells are not modified, as they are not
+     *  exchanged. The option is only effective if there are no automatic internal
+     *  data processors and if the internal type of modification is
+     *  modif::staticVariables; otherwise, collideAndStream() updates the full
+     *  envelopes.
+     */
+    void toggleStreamedPopulationsExchange(bool streamedPopulationsExchange_);
+    bool isStreamedPopulationsExchangeOn() const;
+    /// Use the in-place "AA" propagation pattern in collideAndStream(), which
+    ///   alternates between a local collision (even step) and a collision with
+    ///   pull and push from and to the neighbors (odd step).
+    /** After an even step, the populations are not in their natural layout (see
+     *  BlockLattice3D::collideAndStreamAA()). If there are automatic internal data
+     *  processors, the layout is therefore restored at the end of every step, before
+     *  their execution. In all other cases, restoreNaturalLayout() must be called
+     *  before the populations are accessed between two time steps (e.g. for output
+     *  or checkpointing). The envelope width must be at least twice the vicinity of
+     *  the descriptor, because the odd step on the envelope cells pulls populations
+     *  from their neighbors. The AA pattern is not used with co-processors.
+     */
+    void toggleAAStreaming(bool aaStreaming_);
+    bool isAAStreamingOn() const;
+    /// True if the populations are not in their natural layout.
+    bool isAAOddStep() const;
+    /// Complete the streaming which is pending after an even AA step, and
+    ///   update the envelopes. Does nothing after an odd AA step.
+    void restoreNaturalLayout();
     virtual void incrementTime();
     virtual void resetTime(pluint value);
     virtual BlockLattice3D<T,Descriptor>& getComponent(plint blockId);
@@ -130,6 +173,8 @@ public:
     static std::string descriptorType();
 private:
     void collideAndStreamImplementation();
+    void overlappedCollideAndStreamImplementation(bool streamedExchange);
+    void collideAndStreamAAImplementation(bool restore);
     void streamImplementation();
     void allocateAndInitialize();
     void eliminateStatisticsInEnvelope();
@@ -138,6 +183,10 @@ private:
     Dynamics<T,Descriptor>* backgroundDynamics;
     MultiCellAccess3D<T,Descriptor>* multiCellAccess;
     BlockMap blockLattices;
+    bool communicationOverlap;
+    bool streamedPopulationsExchange;
+    bool aaStreaming;
+    bool aaOddStep;
 public:
     static const int staticId;
 };
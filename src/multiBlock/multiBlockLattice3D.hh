@@ -37,9 +37,11 @@
 #include "core/plbTypenames.h"
 #include "core/multiBlockIdentifiers3D.h"
 #include "core/plbProfiler.h"
+#include "core/runTimeDiagnostics.h"
 #include "core/dynamicsIdentifiers.h"
 #include "dataProcessors/metaStuffWrapper3D.h"
 #include "coProcessors/coProcessor3D.h"
+#include "parallelism/threadPool.h"
 #include <algorithm>
 #include <limits>
 #include <cmath>
@@ -65,7 +67,11 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D (
         Dynamics<T,Descriptor>* backgroundDynamics_ )
     : MultiBlock3D(multiBlockManagement_, blockCommunicator_, combinedStatistics_ ),
       backgroundDynamics(backgroundDynamics_),
-      multiCellAccess(multiCellAccess_)
+      multiCellAccess(multiCellAccess_),
+      communicationOverlap(false),
+      streamedPopulationsExchange(false),
+      aaStreaming(false),
+      aaOddStep(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -78,7 +84,11 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D (
         Dynamics<T,Descriptor>* backgroundDynamics_ )
     : MultiBlock3D(nx,ny,nz,Descriptor<T>::vicinity),
       backgroundDynamics(backgroundDynamics_),
-      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>())
+      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>()),
+      communicationOverlap(false),
+      streamedPopulationsExchange(false),
+      aaStreaming(false),
+      aaOddStep(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -101,7 +111,11 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D(MultiBlockLattice3D<T,Des
     : BlockLatticeBase3D<T,Descriptor>(rhs),
       MultiBlock3D(rhs),
       backgroundDynamics(rhs.backgroundDynamics->clone()),
-      multiCellAccess(rhs.multiCellAccess->clone())
+      multiCellAccess(rhs.multiCellAccess->clone()),
+      communicationOverlap(rhs.communicationOverlap),
+      streamedPopulationsExchange(rhs.streamedPopulationsExchange),
+      aaStreaming(rhs.aaStreaming),
+      aaOddStep(rhs.aaOddStep)
 {
     for ( typename  BlockMap::const_iterator it = rhs.blockLattices.begin();
           it != rhs.blockLattices.end(); ++it )
@@ -115,7 +129,11 @@ MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D(MultiBlock3D const& rhs)
       // Use MultiBlock's sub-domain constructor to avoid that the data-processors are copied
     : MultiBlock3D(rhs, rhs.getBoundingBox(), false),
       backgroundDynamics(new NoDynamics<T,Descriptor>),
-      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>())
+      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>()),
+      communicationOverlap(false),
+      streamedPopulationsExchange(false),
+      aaStreaming(false),
+      aaOddStep(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -125,7 +143,11 @@ template<typename T, template<typename U> class Descriptor>
 MultiBlockLattice3D<T,Descriptor>::MultiBlockLattice3D(MultiBlock3D const& rhs, Box3D subDomain, bool crop)
     : MultiBlock3D(rhs, subDomain, crop),
       backgroundDynamics(new NoDynamics<T,Descriptor>),
-      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>())
+      multiCellAccess(defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>()),
+      communicationOverlap(false),
+      streamedPopulationsExchange(false),
+      aaStreaming(false),
+      aaOddStep(false)
 {
     allocateAndInitialize();
     eliminateStatisticsInEnvelope();
@@ -138,6 +160,22 @@ void MultiBlockLattice3D<T,Descriptor>::swap(MultiBlockLattice3D<T,Descriptor>&
     std::swap(backgroundDynamics, rhs.backgroundDynamics);
     std::swap(multiCellAccess, rhs.multiCellAccess);
     blockLattices.swap(rhs.blockLattices);
+    std::swap(communicationOverlap, rhs.communicationOverlap);
+    std::swap(streamedPopulationsExchange, rhs.streamedPopulationsExchange);
+    std::swap(aaStreaming, rhs.aaStreaming);
+    std::swap(aaOddStep, rhs.aaOddStep);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::swapComponents(MultiBlock3D& rhs) {
+    MultiBlockLattice3D<T,Descriptor>* rhsLattice = dynamic_cast<MultiBlockLattice3D<T,Descriptor>*>(&rhs);
+    PLB_ASSERT( rhsLattice );
+    MultiBlock3D::swapDistribution(rhs);
+    std::swap(multiCellAccess, rhsLattice->multiCellAccess);
+    blockLattices.swap(rhsLattice->blockLattices);
+    // The atomic-blocks keep the time of the multi-block they belong to.
+    resetTime(this->getTimeCounter().getTime());
+    rhsLattice->resetTime(rhsLattice->getTimeCounter().getTime());
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -334,8 +372,35 @@ void MultiBlockLattice3D<T,Descriptor>::collideAndStream(Box3D domain) {
 template<typename T, template<typename U> class Descriptor>
 void MultiBlockLattice3D<T,Descriptor>::collideAndStream() {
     global::profiler().start("cycle");
-    collideAndStreamImplementation();
-    this->executeInternalProcessors();
+    bool hasCoProcessors = this->getMultiBlockManagement().getThreadAttribution().hasCoProcessors();
+    if (aaStreaming && !hasCoProcessors) {
+        collideAndStreamAAImplementation(false);
+        aaOddStep = !aaOddStep;
+        if (aaOddStep && this->getMaxProcessorLevel()>=0) {
+            // The data processors expect the natural layout. Completing the
+            //   streaming locally is equivalent to the regular collideAndStream().
+            collideAndStreamAAImplementation(true);
+            aaOddStep = false;
+        }
+        this->executeInternalProcessors();
+    }
+    else {
+        bool streamedExchange = streamedPopulationsExchange && this->getMaxProcessorLevel()<0 &&
+                                this->getInternalTypeOfModification()==modif::staticVariables;
+        if (communicationOverlap && this->getMaxProcessorLevel()<0 && !hasCoProcessors) {
+            overlappedCollideAndStreamImplementation(streamedExchange);
+        }
+        else if (streamedExchange) {
+            collideAndStreamImplementation();
+            global::profiler().start("envelope-update");
+            this->getBlockCommunicator().duplicateStreamedPopulations(*this);
+            global::profiler().stop("envelope-update");
+        }
+        else {
+            collideAndStreamImplementation();
+            this->executeInternalProcessors();
+        }
+    }
     this->evaluateStatistics();
     this->incrementTime();
     global::profiler().stop("cycle");
@@ -377,16 +442,158 @@ void MultiBlockLattice3D<T,Descriptor>::collideAndStreamImplementation() {
         }
     }
     else  {
+        // The local blocks are dispatched to the shared-memory threads.
+        std::vector<plint> blockIds;
+        std::vector<BlockLattice3D<T,Descriptor>*> lattices;
+        std::vector<Box3D> domains;
+        std::vector<int> preferredThread;
         for ( typename BlockMap::iterator it = blockLattices.begin();
               it != blockLattices.end(); ++it)
         {
+            blockIds.push_back(it->first);
             SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
             // CollideAndStream must be applied to full domain,
             //   including currently active envelopes.
             Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
                                           this->getMultiBlockManagement().getEnvelopeWidth());
-            it->second -> collideAndStream( bulk.toLocal(domain) );
+            lattices.push_back(it->second);
+            domains.push_back(bulk.toLocal(domain));
+            preferredThread.push_back(threadAttribution.getLocalThreadId(it->first));
         }
+        CollideAndStreamTask<BlockLattice3D<T,Descriptor> > task(lattices, domains);
+        this->executeBlockTasks(task, blockIds, preferredThread);
+    }
+}
+
+/** The cells of each block which are sent to other blocks are collided and streamed
+ *  first. The communication of the envelopes is then launched, and completed after
+ *  the collision and streaming of the remaining cells, which are at a distance larger
+ *  than the envelope width from the bulk boundary.
+ */
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::overlappedCollideAndStreamImplementation(bool streamedExchange) {
+    ThreadAttribution const& threadAttribution=this->getMultiBlockManagement().getThreadAttribution();
+    plint envelopeWidth = this->getMultiBlockManagement().getEnvelopeWidth();
+    std::vector<plint> blockIds;
+    std::vector<BlockLattice3D<T,Descriptor>*> lattices;
+    std::vector<Box3D> domains;
+    std::vector<Box3D> interiors;
+    std::vector<int> preferredThread;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        blockIds.push_back(it->first);
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(), envelopeWidth);
+        lattices.push_back(it->second);
+        domains.push_back(bulk.toLocal(domain));
+        // The interior excludes the cells which are sent to other blocks, and the
+        //   cells whose populations are streamed into them.
+        interiors.push_back(bulk.toLocal(bulk.getBulk()).enlarge(-envelopeWidth-Descriptor<T>::vicinity));
+        preferredThread.push_back(threadAttribution.getLocalThreadId(it->first));
+    }
+
+    CollideAndStreamPartTask<BlockLattice3D<T,Descriptor> > shellTask(lattices, domains, interiors, true);
+    this->executeBlockTasks(shellTask, blockIds, preferredThread);
+
+    global::profiler().start("envelope-update");
+    if (streamedExchange) {
+        this->getBlockCommunicator().startDuplicateStreamedPopulations(*this);
+    }
+    else {
+        this->startDuplicateOverlaps(this->getInternalTypeOfModification());
+    }
+    global::profiler().stop("envelope-update");
+
+    CollideAndStreamPartTask<BlockLattice3D<T,Descriptor> > interiorTask(lattices, domains, interiors, false);
+    this->executeBlockTasks(interiorTask, blockIds, preferredThread);
+
+    global::profiler().start("envelope-update");
+    if (streamedExchange) {
+        this->getBlockCommunicator().completeDuplicateStreamedPopulations(*this);
+    }
+    else {
+        this->completeDuplicateOverlaps(this->getInternalTypeOfModification());
+    }
+    global::profiler().stop("envelope-update");
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleCommunicationOverlap(bool communicationOverlap_) {
+    communicationOverlap = communicationOverlap_;
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isCommunicationOverlapOn() const {
+    return communicationOverlap;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleStreamedPopulationsExchange(bool streamedPopulationsExchange_) {
+    streamedPopulationsExchange = streamedPopulationsExchange_;
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isStreamedPopulationsExchangeOn() const {
+    return streamedPopulationsExchange;
+}
+
+/** With an envelope of width 2*vicinity, the odd AA step is exact on the bulk
+ *  and on the envelope cells at a distance up to vicinity from the bulk, which
+ *  are the only ones to push populations into the bulk. The regular envelope
+ *  update after each step is therefore sufficient.
+ */
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::collideAndStreamAAImplementation(bool restore) {
+    ThreadAttribution const& threadAttribution=this->getMultiBlockManagement().getThreadAttribution();
+    std::vector<plint> blockIds;
+    std::vector<BlockLattice3D<T,Descriptor>*> lattices;
+    std::vector<Box3D> domains;
+    std::vector<int> preferredThread;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        blockIds.push_back(it->first);
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
+                                      this->getMultiBlockManagement().getEnvelopeWidth());
+        lattices.push_back(it->second);
+        domains.push_back(bulk.toLocal(domain));
+        preferredThread.push_back(threadAttribution.getLocalThreadId(it->first));
+    }
+    CollideAndStreamAATask<BlockLattice3D<T,Descriptor> > task(lattices, domains, restore);
+    this->executeBlockTasks(task, blockIds, preferredThread);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::toggleAAStreaming(bool aaStreaming_) {
+    if (aaStreaming_) {
+        plbLogicError( this->getMultiBlockManagement().getEnvelopeWidth() < 2*Descriptor<T>::vicinity,
+                       "The AA propagation pattern requires an envelope width of at least "
+                       "twice the vicinity of the lattice descriptor." );
+    }
+    else {
+        restoreNaturalLayout();
+    }
+    aaStreaming = aaStreaming_;
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isAAStreamingOn() const {
+    return aaStreaming;
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool MultiBlockLattice3D<T,Descriptor>::isAAOddStep() const {
+    return aaOddStep;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiBlockLattice3D<T,Descriptor>::restoreNaturalLayout() {
+    if (aaOddStep) {
+        collideAndStreamAAImplementation(true);
+        aaOddStep = false;
+        this->duplicateOverlaps(this->getInternalTypeOfModification());
     }
 }
 
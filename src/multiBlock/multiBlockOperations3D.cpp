@@ -116,11 +116,11 @@ void executeDataProcessor( ReductiveDataProcessorGenerator3D& generator,
 }
 
 
-void addInternalProcessor( DataProcessorGenerator3D const& generator, MultiBlock3D& actor,
-                           std::vector<MultiBlock3D*> multiBlockArgs, plint level )
+/// Add the processors generated by multiProcessing to the atomic-blocks of the actor.
+static void addAtomicInternalProcessors (
+        MultiProcessing3D<DataProcessorGenerator3D const, DataProcessorGenerator3D >& multiProcessing,
+        MultiBlock3D& actor, std::vector<MultiBlock3D*> const& multiBlockArgs, plint level )
 {
-    MultiProcessing3D<DataProcessorGenerator3D const, DataProcessorGenerator3D >
-        multiProcessing(generator, multiBlockArgs);
     std::vector<DataProcessorGenerator3D*> const& retainedGenerators = multiProcessing.getRetainedGenerators();
     std::vector<std::vector<plint> > const& atomicBlockNumbers = multiProcessing.getAtomicBlockNumbers();
 
@@ -136,6 +136,14 @@ void addInternalProcessor( DataProcessorGenerator3D const& generator, MultiBlock
         // Delegate to the "AtomicBlock version" of addInternal.
         plb::addInternalProcessor(*retainedGenerators[iGenerator], atomicActor, extractedAtomicBlocks, level);
     }
+}
+
+void addInternalProcessor( DataProcessorGenerator3D const& generator, MultiBlock3D& actor,
+                           std::vector<MultiBlock3D*> multiBlockArgs, plint level )
+{
+    MultiProcessing3D<DataProcessorGenerator3D const, DataProcessorGenerator3D >
+        multiProcessing(generator, multiBlockArgs);
+    addAtomicInternalProcessors(multiProcessing, actor, multiBlockArgs, level);
     // Subscribe the processor in the multi-block. This guarantees that the multi-block is aware
     //   of the maximal current processor level, and it instantiates the communication pattern
     //   for an update of envelopes after processor execution.
@@ -149,6 +157,14 @@ void addInternalProcessor( DataProcessorGenerator3D const& generator, MultiBlock
     actor.storeProcessor(generator, multiBlockArgs, level);
 }
 
+void reinstantiateInternalProcessor( DataProcessorGenerator3D const& generator, MultiBlock3D& actor,
+                                     std::vector<MultiBlock3D*> multiBlockArgs, plint level )
+{
+    MultiProcessing3D<DataProcessorGenerator3D const, DataProcessorGenerator3D >
+        multiProcessing(generator, multiBlockArgs);
+    addAtomicInternalProcessors(multiProcessing, actor, multiBlockArgs, level);
+}
+
 void addInternalProcessor( DataProcessorGenerator3D const& generator,
                            std::vector<MultiBlock3D*> multiBlocks, plint level )
 {
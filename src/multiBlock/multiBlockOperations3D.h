@@ -72,6 +72,12 @@ void addInternalProcessor( DataProcessorGenerator3D const& generator,
                            MultiBlock3D& object1, MultiBlock3D& object2,
                            plint level=0 );
 
+/// Re-create the atomic-block instances of an internal processor which has already been
+///   added to the actor with addInternalProcessor(), for example after a redistribution
+///   of the atomic-blocks. The processor is neither subscribed nor stored a second time.
+void reinstantiateInternalProcessor( DataProcessorGenerator3D const& generator, MultiBlock3D& actor,
+                                     std::vector<MultiBlock3D*> multiBlockArgs, plint level=0 );
+
 
 
 template<class OriginalGenerator, class MutableGenerator>
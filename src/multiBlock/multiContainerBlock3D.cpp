@@ -107,6 +107,13 @@ void MultiContainerBlock3D::swap(MultiContainerBlock3D& rhs) {
     MultiBlock3D::swap(rhs);
 }
 
+void MultiContainerBlock3D::swapComponents(MultiBlock3D& rhs) {
+    MultiContainerBlock3D* rhsContainer = dynamic_cast<MultiContainerBlock3D*>(&rhs);
+    PLB_ASSERT( rhsContainer );
+    MultiBlock3D::swapDistribution(rhs);
+    blocks.swap(rhsContainer->blocks);
+}
+
 void MultiContainerBlock3D::allocateBlocks() 
 {
     for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock)
@@ -52,6 +52,7 @@ public:
     MultiContainerBlock3D* clone() const;
     MultiContainerBlock3D* clone(MultiBlockManagement3D const& multiBlockManagement) const;
     void swap(MultiContainerBlock3D& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
 public:
     virtual AtomicContainerBlock3D& getComponent(plint iBlock);
     virtual AtomicContainerBlock3D const& getComponent(plint iBlock) const;
@@ -81,6 +81,7 @@ public:
     virtual MultiScalarField3D<T>* clone() const;
     virtual MultiScalarField3D<T>* clone(MultiBlockManagement3D const& newMultiBlockManagement) const;
     void swap(MultiScalarField3D<T>& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
 public: 
     virtual void reset();
     virtual T& get(plint iX, plint iY, plint iZ);
@@ -160,6 +161,7 @@ public:
     virtual MultiTensorField3D<T,nDim>* clone() const;
     virtual MultiTensorField3D<T,nDim>* clone(MultiBlockManagement3D const& newMultiBlockManagement) const;
     void swap(MultiTensorField3D<T,nDim>& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
 public:
     virtual void reset();
     virtual Array<T,nDim>& get(plint iX, plint iY, plint iZ);
@@ -242,6 +244,7 @@ public:
     virtual MultiNTensorField3D<T>* clone() const;
     virtual MultiNTensorField3D<T>* clone(MultiBlockManagement3D const& newMultiBlockManagement) const;
     void swap(MultiNTensorField3D<T>& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
 public:
     virtual void reset();
     virtual T* get(plint iX, plint iY, plint iZ);
@@ -176,6 +176,16 @@ void MultiScalarField3D<T>::swap(MultiScalarField3D<T>& rhs) {
     std::swap(nTensorViewBlock, rhs.nTensorViewBlock);
 }
 
+template<typename T>
+void MultiScalarField3D<T>::swapComponents(MultiBlock3D& rhs) {
+    MultiScalarField3D<T>* rhsField = dynamic_cast<MultiScalarField3D<T>*>(&rhs);
+    PLB_ASSERT( rhsField );
+    MultiBlock3D::swapDistribution(rhs);
+    fields.swap(rhsField->fields);
+    std::swap(multiScalarAccess, rhsField->multiScalarAccess);
+    std::swap(nTensorViewBlock, rhsField->nTensorViewBlock);
+}
+
 template<typename T>
 void MultiScalarField3D<T>::reset() {
     for ( typename BlockMap::iterator it = fields.begin();
@@ -463,6 +473,16 @@ void MultiTensorField3D<T,nDim>::swap(MultiTensorField3D<T,nDim>& rhs) {
     std::swap(nTensorViewBlock, rhs.nTensorViewBlock);
 }
 
+template<typename T, int nDim>
+void MultiTensorField3D<T,nDim>::swapComponents(MultiBlock3D& rhs) {
+    MultiTensorField3D<T,nDim>* rhsField = dynamic_cast<MultiTensorField3D<T,nDim>*>(&rhs);
+    PLB_ASSERT( rhsField );
+    MultiBlock3D::swapDistribution(rhs);
+    fields.swap(rhsField->fields);
+    std::swap(multiTensorAccess, rhsField->multiTensorAccess);
+    std::swap(nTensorViewBlock, rhsField->nTensorViewBlock);
+}
+
 template<typename T, int nDim>
 void MultiTensorField3D<T,nDim>::reset() {
     for ( typename BlockMap::iterator it = fields.begin();
@@ -791,6 +811,16 @@ void MultiNTensorField3D<T>::swap(MultiNTensorField3D<T>& rhs) {
     std::swap(scalarOrTensorView, rhs.scalarOrTensorView);
 }
 
+template<typename T>
+void MultiNTensorField3D<T>::swapComponents(MultiBlock3D& rhs) {
+    MultiNTensorField3D<T>* rhsField = dynamic_cast<MultiNTensorField3D<T>*>(&rhs);
+    PLB_ASSERT( rhsField );
+    MultiBlock3D::swapDistribution(rhs);
+    fields.swap(rhsField->fields);
+    std::swap(multiNTensorAccess, rhsField->multiNTensorAccess);
+    std::swap(scalarOrTensorView, rhsField->scalarOrTensorView);
+}
+
 template<typename T>
 void MultiNTensorField3D<T>::reset() {
     for ( typename BlockMap::iterator it = fields.begin();
@@ -27,7 +27,9 @@
 #include "multiBlock/multiDataField3D.h"
 #include "multiBlock/multiBlockOperations3D.h"
 #include "atomicBlock/dataProcessor3D.h"
+#include "atomicBlock/fusedProcessingFunctional3D.h"
 #include "core/plbDebug.h"
+#include <algorithm>
 
 namespace plb {
 
@@ -58,6 +60,56 @@ void integrateProcessingFunctional(BoxProcessingFunctional3D* functional, Box3D
 }
 
 
+/* *************** Fused BoxProcessing, general case ********************** */
+
+/// Create a fused functional, and the list of all distinct multi-blocks it acts on.
+static FusedProcessingFunctional3D* fuseProcessingFunctionals (
+        std::vector<BoxProcessingFunctional3D*> const& functionals,
+        std::vector<std::vector<MultiBlock3D*> > const& multiBlocks, plint tileSize,
+        std::vector<MultiBlock3D*>& fusedMultiBlocks )
+{
+    PLB_PRECONDITION( !functionals.empty() );
+    PLB_PRECONDITION( functionals.size()==multiBlocks.size() );
+    FusedProcessingFunctional3D* fused = new FusedProcessingFunctional3D(tileSize);
+    fusedMultiBlocks.clear();
+    for (pluint iFunctional=0; iFunctional<functionals.size(); ++iFunctional) {
+        std::vector<plint> blockIds(multiBlocks[iFunctional].size());
+        for (pluint iBlock=0; iBlock<blockIds.size(); ++iBlock) {
+            MultiBlock3D* multiBlock = multiBlocks[iFunctional][iBlock];
+            std::vector<MultiBlock3D*>::iterator it =
+                std::find(fusedMultiBlocks.begin(), fusedMultiBlocks.end(), multiBlock);
+            blockIds[iBlock] = it-fusedMultiBlocks.begin();
+            if (it==fusedMultiBlocks.end()) {
+                fusedMultiBlocks.push_back(multiBlock);
+            }
+        }
+        fused->addFunctional(functionals[iFunctional], blockIds);
+    }
+    return fused;
+}
+
+void applyFusedProcessingFunctionals (
+        std::vector<BoxProcessingFunctional3D*> const& functionals, Box3D domain,
+        std::vector<std::vector<MultiBlock3D*> > const& multiBlocks, plint tileSize )
+{
+    std::vector<MultiBlock3D*> fusedMultiBlocks;
+    FusedProcessingFunctional3D* fused =
+        fuseProcessingFunctionals(functionals, multiBlocks, tileSize, fusedMultiBlocks);
+    applyProcessingFunctional(fused, domain, fusedMultiBlocks);
+}
+
+void integrateFusedProcessingFunctionals (
+        std::vector<BoxProcessingFunctional3D*> const& functionals, Box3D domain,
+        std::vector<std::vector<MultiBlock3D*> > const& multiBlocks,
+        plint level, plint tileSize )
+{
+    std::vector<MultiBlock3D*> fusedMultiBlocks;
+    FusedProcessingFunctional3D* fused =
+        fuseProcessingFunctionals(functionals, multiBlocks, tileSize, fusedMultiBlocks);
+    integrateProcessingFunctional(fused, domain, fusedMultiBlocks, level);
+}
+
+
 /* *************** DotProcessing, general case ***************************** */
 
 void applyProcessingFunctional(DotProcessingFunctional3D* functional,
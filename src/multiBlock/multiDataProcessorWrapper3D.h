@@ -70,6 +70,22 @@ void integrateProcessingFunctional(BoxProcessingFunctional3D* functional, Box3D
                                    MultiBlock3D& actor, std::vector<MultiBlock3D*> multiBlockArgs,
                                    plint level=0);
 
+/// Apply a sequence of point-wise functionals in a single traversal of the
+/// domain (see FusedProcessingFunctional3D). The functional functionals[i]
+/// acts on the multi-blocks multiBlocks[i].
+void applyFusedProcessingFunctionals (
+        std::vector<BoxProcessingFunctional3D*> const& functionals, Box3D domain,
+        std::vector<std::vector<MultiBlock3D*> > const& multiBlocks, plint tileSize=16 );
+
+/// Integrate a sequence of point-wise functionals, which are executed in a
+/// single traversal of the domain (see FusedProcessingFunctional3D). The
+/// functional functionals[i] acts on the multi-blocks multiBlocks[i]. The
+/// processor is added to the first multi-block of multiBlocks[0].
+void integrateFusedProcessingFunctionals (
+        std::vector<BoxProcessingFunctional3D*> const& functionals, Box3D domain,
+        std::vector<std::vector<MultiBlock3D*> > const& multiBlocks,
+        plint level=0, plint tileSize=16 );
+
 /// Apply a functional on a sequence of block-lattices. If the number
 /// of lattices is 1 or 2, you should prefer the _L and _LL version
 /// of the functional.
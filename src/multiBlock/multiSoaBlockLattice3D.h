@@ -0,0 +1,175 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D multiblock lattice with structure-of-arrays population storage -- header file.
+ */
+#ifndef MULTI_SOA_BLOCK_LATTICE_3D_H
+#define MULTI_SOA_BLOCK_LATTICE_3D_H
+
+#include "core/globalDefs.h"
+#include "multiBlock/multiBlock3D.h"
+#include "multiBlock/multiBlockLattice3D.h"
+#include "atomicBlock/soaBlockLattice3D.h"
+#include <vector>
+#include <map>
+#include <memory>
+
+namespace plb {
+
+/// A multi-block lattice whose atomic-blocks are SoaBlockLattice3D.
+/** The block distribution, the envelopes, the communicators and the combined
+ *  statistics are handled exactly as in the MultiBlockLattice3D; only the memory
+ *  layout of the atomic-blocks differs. The usual way to use this class is to
+ *  set up the simulation (dynamics, boundary conditions, initial condition) on a
+ *  MultiBlockLattice3D, to convert it into a MultiSoaBlockLattice3D with the same
+ *  block management for the time iterations, and to copy the populations back
+ *  whenever data processors or post-processing functions are needed.
+ *
+ *  The populations are stored in type S (see SoaBlockLattice3D). For a speed-up
+ *  over the MultiBlockLattice3D, use S=float with T=double; with S=T, both
+ *  lattices perform about equally. The envelope exchanges and the checkpoints
+ *  (saveBinaryBlock, loadBinaryBlock) use the storage type as well; a checkpoint
+ *  can therefore only be loaded into a lattice with the same storage type.
+ */
+template<typename T, template<typename U> class Descriptor, typename S=T>
+class MultiSoaBlockLattice3D : public MultiBlock3D {
+public:
+    typedef std::map<plint,SoaBlockLattice3D<T,Descriptor,S>*> BlockMap;
+public:
+    MultiSoaBlockLattice3D(MultiBlockManagement3D const& multiBlockManagement,
+                           BlockCommunicator3D* blockCommunicator_,
+                           CombinedStatistics* combinedStatistics_,
+                           Dynamics<T,Descriptor>* backgroundDynamics_);
+    MultiSoaBlockLattice3D(plint nx, plint ny, plint nz, Dynamics<T,Descriptor>* backgroundDynamics_);
+    /// Construct a lattice with the same block management, periodicity and content as
+    ///   the given MultiBlockLattice3D (the data-processors are not copied).
+    explicit MultiSoaBlockLattice3D(MultiBlockLattice3D<T,Descriptor> const& lattice);
+    ~MultiSoaBlockLattice3D();
+    MultiSoaBlockLattice3D(MultiSoaBlockLattice3D<T,Descriptor,S> const& rhs);
+    virtual MultiSoaBlockLattice3D<T,Descriptor,S>* clone() const;
+    virtual MultiSoaBlockLattice3D<T,Descriptor,S>* clone(MultiBlockManagement3D const& newManagement) const;
+    /// Attention: data-processors of rhs, which were pointing at rhs, will continue pointing
+    /// to rhs, and not to *this.
+    void swap(MultiSoaBlockLattice3D& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
+    /// Attention: data-processors of rhs, which were pointing at rhs, will continue pointing
+    /// to rhs, and not to *this.
+    MultiSoaBlockLattice3D<T,Descriptor,S>& operator=(MultiSoaBlockLattice3D<T,Descriptor,S> const& rhs);
+    /// Assign the same dynamics to every cell.
+    void resetDynamics(Dynamics<T,Descriptor> const& dynamics);
+    /// Attribute dynamics to a rectangular domain. The lattice takes ownership of the object.
+    void defineDynamics(Box3D domain, Dynamics<T,Descriptor>* dynamics);
+
+    Dynamics<T,Descriptor> const& getBackgroundDynamics() const;
+    void specifyStatisticsStatus(Box3D domain, bool status);
+    void collideAndStream();
+    void externalCollideAndStream();
+    void incrementTime();
+    void resetTime(pluint value);
+    TimeCounter& getTimeCounter() { return timeCounter; }
+    TimeCounter const& getTimeCounter() const { return timeCounter; }
+    virtual SoaBlockLattice3D<T,Descriptor,S>& getComponent(plint blockId);
+    virtual SoaBlockLattice3D<T,Descriptor,S> const& getComponent(plint blockId) const;
+    virtual plint sizeOfCell() const;
+    virtual plint getCellDim() const;
+    virtual int getStaticId() const;
+    virtual void copyReceive (
+                MultiBlock3D const& fromBlock, Box3D const& fromDomain,
+                Box3D const& toDomain, modif::ModifT whichData=modif::dataStructure );
+public:
+    BlockMap& getBlockLattices();
+    BlockMap const& getBlockLattices() const;
+    virtual void getDynamicsDict(Box3D domain, std::map<std::string,int>& dict);
+    virtual std::string getBlockName() const;
+    virtual std::vector<std::string> getTypeInfo() const;
+    static std::string blockName();
+    static std::string basicType();
+    static std::string descriptorType();
+private:
+    void collideAndStreamImplementation();
+    void allocateAndInitialize();
+    void eliminateStatisticsInEnvelope();
+    Box3D extendPeriodic(Box3D const& box, plint envelopeWidth) const;
+private:
+    Dynamics<T,Descriptor>* backgroundDynamics;
+    BlockMap blockLattices;
+    TimeCounter timeCounter;
+public:
+    static const int staticId;
+};
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::auto_ptr<MultiSoaBlockLattice3D<T,Descriptor,S> > defaultGenerateMultiSoaBlockLattice3D (
+        MultiBlockManagement3D const& management, plint unnamedDummyArg=1 );
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>& findMultiSoaBlockLattice3D(id_t id);
+
+template<typename T, template<typename U> class Descriptor>
+MultiSoaBlockLattice3D<T,Descriptor>& findMultiSoaBlockLattice3D(id_t id);
+
+/// Copy data from a MultiBlockLattice3D into a MultiSoaBlockLattice3D.
+/** The two blocks are not required to have same parallelization. The
+ *  populations are converted to the storage type. */
+template<typename T, template<typename U> class Descriptor, typename S>
+void copy (
+        MultiBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiSoaBlockLattice3D<T,Descriptor,S>& to, Box3D const& toDomain,
+        modif::ModifT whichContent );
+
+/// Copy data from a MultiSoaBlockLattice3D into a MultiBlockLattice3D.
+/** The two blocks are not required to have same parallelization. */
+template<typename T, template<typename U> class Descriptor, typename S>
+void copy (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from, Box3D const& fromDomain,
+        MultiBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent );
+
+/// Copy data between two MultiSoaBlockLattice3D.
+template<typename T, template<typename U> class Descriptor, typename S>
+void copy (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from, Box3D const& fromDomain,
+        MultiSoaBlockLattice3D<T,Descriptor,S>& to, Box3D const& toDomain,
+        modif::ModifT whichContent );
+
+/// Copy the populations and external scalars from a MultiSoaBlockLattice3D into a
+///   MultiBlockLattice3D, on the full domain.
+template<typename T, template<typename U> class Descriptor, typename S>
+void copyPopulations (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from,
+        MultiBlockLattice3D<T,Descriptor>& to );
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageDensity(MultiSoaBlockLattice3D<T,Descriptor,S> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageEnergy(MultiSoaBlockLattice3D<T,Descriptor,S> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredMaxVelocity(MultiSoaBlockLattice3D<T,Descriptor,S> const& blockLattice);
+
+}  // namespace plb
+
+#endif  // MULTI_SOA_BLOCK_LATTICE_3D_H
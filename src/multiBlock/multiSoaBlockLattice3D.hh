@@ -0,0 +1,678 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D multiblock lattice with structure-of-arrays population storage -- generic implementation.
+ */
+#ifndef MULTI_SOA_BLOCK_LATTICE_3D_HH
+#define MULTI_SOA_BLOCK_LATTICE_3D_HH
+
+#include "multiBlock/multiSoaBlockLattice3D.h"
+#include "atomicBlock/soaBlockLattice3D.h"
+#include "multiBlock/defaultMultiBlockPolicy3D.h"
+#include "multiBlock/nonLocalTransfer3D.h"
+#include "core/latticeStatistics.h"
+#include "core/plbTypenames.h"
+#include "core/multiBlockIdentifiers3D.h"
+#include "core/plbProfiler.h"
+#include "parallelism/threadPool.h"
+#include "core/dynamicsIdentifiers.h"
+#include "basicDynamics/dynamicsProcessor3D.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace plb {
+
+////////////////////// Class MultiSoaBlockLattice3D /////////////////////////
+
+template<typename T, template<typename U> class Descriptor, typename S>
+const int MultiSoaBlockLattice3D<T,Descriptor,S>::staticId =
+meta::registerMultiBlock3D ( MultiSoaBlockLattice3D<T,Descriptor,S>::basicType(),
+                             MultiSoaBlockLattice3D<T,Descriptor,S>::descriptorType(),
+                             MultiSoaBlockLattice3D<T,Descriptor,S>::blockName(),
+                             defaultGenerateMultiSoaBlockLattice3D<T,Descriptor,S> );
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>::MultiSoaBlockLattice3D (
+        MultiBlockManagement3D const& multiBlockManagement_,
+        BlockCommunicator3D* blockCommunicator_,
+        CombinedStatistics* combinedStatistics_,
+        Dynamics<T,Descriptor>* backgroundDynamics_ )
+    : MultiBlock3D(multiBlockManagement_, blockCommunicator_, combinedStatistics_ ),
+      backgroundDynamics(backgroundDynamics_)
+{
+    allocateAndInitialize();
+    eliminateStatisticsInEnvelope();
+    this->evaluateStatistics(); // Reset statistics to default.
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>::MultiSoaBlockLattice3D (
+        plint nx, plint ny, plint nz,
+        Dynamics<T,Descriptor>* backgroundDynamics_ )
+    : MultiBlock3D(nx,ny,nz,Descriptor<T>::vicinity),
+      backgroundDynamics(backgroundDynamics_)
+{
+    allocateAndInitialize();
+    eliminateStatisticsInEnvelope();
+    this->evaluateStatistics(); // Reset statistics to default.
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>::MultiSoaBlockLattice3D (
+        MultiBlockLattice3D<T,Descriptor> const& lattice )
+    : MultiBlock3D( lattice.getMultiBlockManagement(),
+                    lattice.getBlockCommunicator().clone(),
+                    lattice.getCombinedStatistics().clone() ),
+      backgroundDynamics(lattice.getBackgroundDynamics().clone())
+{
+    this->periodicity() = lattice.periodicity();
+    this->setInternalTypeOfModification(lattice.getInternalTypeOfModification());
+    this->toggleInternalStatistics(lattice.isInternalStatisticsOn());
+    allocateAndInitialize();
+    eliminateStatisticsInEnvelope();
+    this->evaluateStatistics(); // Reset statistics to default.
+    copy(lattice, lattice.getBoundingBox(), *this, this->getBoundingBox(), modif::dataStructure);
+    resetTime(lattice.getTimeCounter().getTime());
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>::~MultiSoaBlockLattice3D() {
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        delete it->second;
+    }
+    delete backgroundDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>::MultiSoaBlockLattice3D(MultiSoaBlockLattice3D<T,Descriptor,S> const& rhs)
+    : MultiBlock3D(rhs),
+      backgroundDynamics(rhs.backgroundDynamics->clone()),
+      timeCounter(rhs.timeCounter)
+{
+    for ( typename  BlockMap::const_iterator it = rhs.blockLattices.begin();
+          it != rhs.blockLattices.end(); ++it )
+    {
+        blockLattices[it->first] = new SoaBlockLattice3D<T,Descriptor,S>(*it->second);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::swap(MultiSoaBlockLattice3D<T,Descriptor,S>& rhs) {
+    MultiBlock3D::swap(rhs);
+    std::swap(backgroundDynamics, rhs.backgroundDynamics);
+    blockLattices.swap(rhs.blockLattices);
+    std::swap(timeCounter, rhs.timeCounter);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::swapComponents(MultiBlock3D& rhs) {
+    MultiSoaBlockLattice3D<T,Descriptor,S>* rhsLattice =
+        dynamic_cast<MultiSoaBlockLattice3D<T,Descriptor,S>*>(&rhs);
+    PLB_ASSERT( rhsLattice );
+    MultiBlock3D::swapDistribution(rhs);
+    blockLattices.swap(rhsLattice->blockLattices);
+    // The atomic-blocks keep the time of the multi-block they belong to.
+    resetTime(timeCounter.getTime());
+    rhsLattice->resetTime(rhsLattice->timeCounter.getTime());
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>& MultiSoaBlockLattice3D<T,Descriptor,S>::operator= (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& rhs )
+{
+    MultiSoaBlockLattice3D<T,Descriptor,S> tmp(rhs);
+    swap(tmp);
+    return *this;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>*
+    MultiSoaBlockLattice3D<T,Descriptor,S>::clone() const
+{
+    return new MultiSoaBlockLattice3D<T,Descriptor,S>(*this);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>*
+    MultiSoaBlockLattice3D<T,Descriptor,S>::clone(MultiBlockManagement3D const& newManagement) const
+{
+    MultiSoaBlockLattice3D<T,Descriptor,S>* newLattice =
+        new MultiSoaBlockLattice3D<T,Descriptor,S> (
+                newManagement,
+                this->getBlockCommunicator().clone(),
+                this->getCombinedStatistics().clone(),
+                getBackgroundDynamics().clone() );
+    // Use the same domain in the "from" and "to" argument, so that the data is not shifted
+    // in space during the creation of the new block.
+    copy(*this, newLattice->getBoundingBox(), *newLattice, newLattice->getBoundingBox(), modif::dataStructure);
+    return newLattice;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::resetDynamics(Dynamics<T,Descriptor> const& dynamics)
+{
+    for ( typename  BlockMap::const_iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it )
+    {
+        it->second->resetDynamics(dynamics);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::defineDynamics (
+        Box3D domain, Dynamics<T,Descriptor>* dynamics )
+{
+    Box3D inters;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.computeEnvelope(), inters ) ) {
+            it->second -> attributeDynamics(bulk.toLocal(inters), dynamics->clone());
+        }
+    }
+    delete dynamics;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+Dynamics<T,Descriptor> const& MultiSoaBlockLattice3D<T,Descriptor,S>::getBackgroundDynamics() const {
+    return *backgroundDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::specifyStatisticsStatus (Box3D domain, bool status) {
+    Box3D inters;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.getBulk(), inters ) ) {
+            inters = bulk.toLocal(inters);
+            it->second -> specifyStatisticsStatus(inters, status);
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+Box3D MultiSoaBlockLattice3D<T,Descriptor,S>::extendPeriodic(Box3D const& box, plint envelopeWidth) const
+{
+    Box3D boundingBox(this->getBoundingBox());
+    Box3D periodicBox(box);
+    bool periodicX = this->periodicity().get(0);
+    bool periodicY = this->periodicity().get(1);
+    bool periodicZ = this->periodicity().get(2);
+    if (periodicX) {
+        if (periodicBox.x0 == boundingBox.x0) {
+            periodicBox.x0 -= envelopeWidth;
+        }
+        if (periodicBox.x1 == boundingBox.x1) {
+            periodicBox.x1 += envelopeWidth;
+        }
+    }
+    if (periodicY) {
+        if (periodicBox.y0 == boundingBox.y0) {
+            periodicBox.y0 -= envelopeWidth;
+        }
+        if (periodicBox.y1 == boundingBox.y1) {
+            periodicBox.y1 += envelopeWidth;
+        }
+    }
+    if (periodicZ) {
+        if (periodicBox.z0 == boundingBox.z0) {
+            periodicBox.z0 -= envelopeWidth;
+        }
+        if (periodicBox.z1 == boundingBox.z1) {
+            periodicBox.z1 += envelopeWidth;
+        }
+    }
+    return periodicBox;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::collideAndStream() {
+    global::profiler().start("cycle");
+    collideAndStreamImplementation();
+    this->executeInternalProcessors();
+    this->evaluateStatistics();
+    this->incrementTime();
+    global::profiler().stop("cycle");
+    if (global::profiler().cyclingIsAutomatic()) {
+        global::profiler().cycle();
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::externalCollideAndStream() {
+    global::profiler().start("cycle");
+    collideAndStreamImplementation();
+    if (global::profiler().cyclingIsAutomatic()) {
+        global::profiler().cycle();
+    }
+    global::profiler().stop("cycle");
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::collideAndStreamImplementation() {
+    ThreadAttribution const& threadAttribution=this->getMultiBlockManagement().getThreadAttribution();
+    std::vector<plint> blockIds;
+    std::vector<SoaBlockLattice3D<T,Descriptor,S>*> lattices;
+    std::vector<Box3D> domains;
+    std::vector<int> preferredThread;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        blockIds.push_back(it->first);
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        // CollideAndStream must be applied to full domain,
+        //   including currently active envelopes.
+        Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
+                                      this->getMultiBlockManagement().getEnvelopeWidth());
+        lattices.push_back(it->second);
+        domains.push_back(bulk.toLocal(domain));
+        preferredThread.push_back(threadAttribution.getLocalThreadId(it->first));
+    }
+    CollideAndStreamTask<SoaBlockLattice3D<T,Descriptor,S> > task(lattices, domains);
+    this->executeBlockTasks(task, blockIds, preferredThread);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::incrementTime() {
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> incrementTime();
+    }
+    timeCounter.incrementTime();
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::resetTime(pluint value)
+{
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> getTimeCounter().resetTime(value);
+    }
+    timeCounter.resetTime(value);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::allocateAndInitialize()
+{
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average rho-bar
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average uSqr
+    this->getInternalStatistics().subscribeMax();     // Subscribe max uSqr
+
+    for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock) {
+        plint blockId = this->getLocalInfo().getBlocks()[iBlock];
+        SmartBulk3D bulk(this->getMultiBlockManagement(), blockId);
+        Box3D envelope = bulk.computeEnvelope();
+        SoaBlockLattice3D<T,Descriptor,S>* newLattice
+            = new SoaBlockLattice3D<T,Descriptor,S> (
+                    envelope.getNx(), envelope.getNy(), envelope.getNz(),
+                    backgroundDynamics->clone() );
+        newLattice -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
+        blockLattices[blockId] = newLattice;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::eliminateStatisticsInEnvelope()
+{
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it )
+    {
+        plint envelopeWidth = this->getMultiBlockManagement().getEnvelopeWidth();
+        SoaBlockLattice3D<T,Descriptor,S>& block = *it->second;
+        plint maxX = block.getNx()-1;
+        plint maxY = block.getNy()-1;
+        plint maxZ = block.getNz()-1;
+
+        block.specifyStatisticsStatus(Box3D(0, maxX, 0, maxY, 0, envelopeWidth-1), false);
+        block.specifyStatisticsStatus(Box3D(0, maxX, 0, maxY, maxZ-envelopeWidth+1, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(0, maxX, 0, envelopeWidth-1, 0, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(0, maxX, maxY-envelopeWidth+1, maxY, 0, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(0, envelopeWidth-1, 0, maxY, 0, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(maxX-envelopeWidth+1, maxX,  0, maxY, 0, maxZ), false);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::map<plint,SoaBlockLattice3D<T,Descriptor,S>*>&
+    MultiSoaBlockLattice3D<T,Descriptor,S>::getBlockLattices()
+{
+    return blockLattices;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::map<plint,SoaBlockLattice3D<T,Descriptor,S>*> const&
+    MultiSoaBlockLattice3D<T,Descriptor,S>::getBlockLattices() const
+{
+    return blockLattices;
+}
+
+/** The IDs of the dynamics objects (including the base dynamics of composite
+ *  dynamics) are read from the dynamics tables of the atomic-blocks, and
+ *  reduced over all processes.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::getDynamicsDict(Box3D domain, std::map<std::string,int>& dict)
+{
+    std::vector<int> isPresent(meta::dynamicsRegistration<T,Descriptor>().getNumId()+1, 0);
+    Box3D inters;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.getBulk(), inters ) ) {
+            inters = bulk.toLocal(inters);
+            SoaBlockLattice3D<T,Descriptor,S> const& block = *it->second;
+            std::vector<bool> isUsed(block.getNumDynamics(), false);
+            for (plint iX=inters.x0; iX<=inters.x1; ++iX) {
+                for (plint iY=inters.y0; iY<=inters.y1; ++iY) {
+                    for (plint iZ=inters.z0; iZ<=inters.z1; ++iZ) {
+                        plint iDynamics = block.getDynamicsIndex(iX,iY,iZ);
+                        if (!isUsed[iDynamics]) {
+                            isUsed[iDynamics] = true;
+                            std::vector<int> chain;
+                            constructIdChain(block.getDynamics(iX,iY,iZ), chain);
+                            for (pluint iChain=0; iChain<chain.size(); ++iChain) {
+                                if (chain[iChain]>=0 && chain[iChain]<(int)isPresent.size()) {
+                                    isPresent[chain[iChain]] = 1;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(isPresent, MPI_MAX);
+#endif
+    dict.clear();
+    for (pluint id=0; id<isPresent.size(); ++id) {
+        if (isPresent[id]) {
+            std::string name = meta::dynamicsRegistration<T,Descriptor>().getName((int)id);
+            dict.insert(std::pair<std::string,int>(name,(int)id));
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::string MultiSoaBlockLattice3D<T,Descriptor,S>::getBlockName() const {
+    return blockName();
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::vector<std::string> MultiSoaBlockLattice3D<T,Descriptor,S>::getTypeInfo() const {
+    std::vector<std::string> info;
+    info.push_back(basicType());
+    info.push_back(descriptorType());
+    return info;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::string MultiSoaBlockLattice3D<T,Descriptor,S>::blockName() {
+    std::string storageType(NativeType<S>::getName());
+    if (storageType == NativeType<T>::getName()) {
+        return std::string("SoaBlockLattice3D");
+    }
+    // Lattices with a different storage type have a different byte-stream format.
+    return std::string("SoaBlockLattice3D_") + storageType;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::string MultiSoaBlockLattice3D<T,Descriptor,S>::basicType() {
+    return std::string(NativeType<T>::getName());
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::string MultiSoaBlockLattice3D<T,Descriptor,S>::descriptorType() {
+    return std::string(Descriptor<T>::name);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLattice3D<T,Descriptor,S>& MultiSoaBlockLattice3D<T,Descriptor,S>::getComponent(plint blockId) {
+    typename BlockMap::iterator it = blockLattices.find(blockId);
+    PLB_ASSERT (it != blockLattices.end());
+    return *it->second;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+SoaBlockLattice3D<T,Descriptor,S> const& MultiSoaBlockLattice3D<T,Descriptor,S>::getComponent(plint blockId) const {
+    typename BlockMap::const_iterator it = blockLattices.find(blockId);
+    PLB_ASSERT (it != blockLattices.end());
+    return *it->second;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+plint MultiSoaBlockLattice3D<T,Descriptor,S>::sizeOfCell() const {
+    return sizeof(S)*Descriptor<T>::numPop + sizeof(T)*Descriptor<T>::ExternalField::numScalars;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+plint MultiSoaBlockLattice3D<T,Descriptor,S>::getCellDim() const {
+    return Descriptor<T>::numPop + Descriptor<T>::ExternalField::numScalars;
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+int MultiSoaBlockLattice3D<T,Descriptor,S>::getStaticId() const {
+    return staticId;
+}
+
+/** The source can be a MultiSoaBlockLattice3D or a MultiBlockLattice3D. */
+template<typename T, template<typename U> class Descriptor, typename S>
+void MultiSoaBlockLattice3D<T,Descriptor,S>::copyReceive (
+                MultiBlock3D const& fromBlock, Box3D const& fromDomain,
+                Box3D const& toDomain, modif::ModifT whichData )
+{
+    PLB_ASSERT( (dynamic_cast<MultiSoaBlockLattice3D<T,Descriptor,S> const* >(&fromBlock) ||
+                 dynamic_cast<MultiBlockLattice3D<T,Descriptor> const* >(&fromBlock)) );
+    copy_generic(fromBlock, fromDomain, *this, toDomain, whichData);
+}
+
+/////////// Free Functions //////////////////////////////
+
+template<typename T, template<typename U> class Descriptor, typename S>
+std::auto_ptr<MultiSoaBlockLattice3D<T,Descriptor,S> > defaultGenerateMultiSoaBlockLattice3D (
+        MultiBlockManagement3D const& management, plint unnamedDummyArg )
+{
+    return std::auto_ptr<MultiSoaBlockLattice3D<T,Descriptor,S> > (
+        new MultiSoaBlockLattice3D<T,Descriptor,S> (
+            management,
+            defaultMultiBlockPolicy3D().getBlockCommunicator(),
+            defaultMultiBlockPolicy3D().getCombinedStatistics(),
+            new NoDynamics<T,Descriptor> )
+    );
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+MultiSoaBlockLattice3D<T,Descriptor,S>& findMultiSoaBlockLattice3D(id_t id) {
+    MultiBlock3D* multiBlock = multiBlockRegistration3D().find(id);
+    if (!multiBlock || multiBlock->getStaticId() != MultiSoaBlockLattice3D<T,Descriptor,S>::staticId) {
+        throw PlbLogicException("Trying to access a multi block SoA lattice that is not registered.");
+    }
+    return (MultiSoaBlockLattice3D<T,Descriptor,S>&)(*multiBlock);
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSoaBlockLattice3D<T,Descriptor>& findMultiSoaBlockLattice3D(id_t id) {
+    return findMultiSoaBlockLattice3D<T,Descriptor,T>(id);
+}
+
+/// Conversion, block by block, between the bulks of two lattices with the
+///   same block management.
+template<typename T, template<typename U> class Descriptor, typename S>
+void convertComponents (
+        MultiBlockLattice3D<T,Descriptor> const& from,
+        MultiSoaBlockLattice3D<T,Descriptor,S>& to,
+        Box3D const& domain, modif::ModifT whichContent )
+{
+    Box3D inters;
+    typename MultiSoaBlockLattice3D<T,Descriptor,S>::BlockMap& blocks = to.getBlockLattices();
+    for ( typename MultiSoaBlockLattice3D<T,Descriptor,S>::BlockMap::iterator it = blocks.begin();
+          it != blocks.end(); ++it)
+    {
+        SmartBulk3D bulk(to.getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.getBulk(), inters)) {
+            inters = bulk.toLocal(inters);
+            convert(from.getComponent(it->first), inters, *it->second, inters, whichContent);
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void convertComponents (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from,
+        MultiBlockLattice3D<T,Descriptor>& to,
+        Box3D const& domain, modif::ModifT whichContent )
+{
+    Box3D inters;
+    typename MultiSoaBlockLattice3D<T,Descriptor,S>::BlockMap const& blocks = from.getBlockLattices();
+    for ( typename MultiSoaBlockLattice3D<T,Descriptor,S>::BlockMap::const_iterator it = blocks.begin();
+          it != blocks.end(); ++it)
+    {
+        SmartBulk3D bulk(from.getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.getBulk(), inters)) {
+            inters = bulk.toLocal(inters);
+            convert(*it->second, inters, to.getComponent(it->first), inters, whichContent);
+        }
+    }
+}
+
+/// True if the data of two lattices can be converted block by block.
+inline bool sameBlockDistribution (
+        MultiBlock3D const& from, Box3D const& fromDomain,
+        MultiBlock3D const& to, Box3D const& toDomain )
+{
+    return fromDomain == toDomain &&
+           from.getMultiBlockManagement().getEnvelopeWidth() ==
+               to.getMultiBlockManagement().getEnvelopeWidth() &&
+           from.getMultiBlockManagement().equivalentTo(to.getMultiBlockManagement());
+}
+
+/** If the populations are stored in a narrower type than T, the byte-stream
+ *  formats of the two lattices differ. The data is then converted block by block;
+ *  if the two lattices have a different block distribution, it is first
+ *  redistributed in full precision into a temporary MultiBlockLattice3D.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void copy (
+        MultiBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiSoaBlockLattice3D<T,Descriptor,S>& to, Box3D const& toDomain,
+        modif::ModifT whichContent )
+{
+    if (from.sizeOfCell() == to.sizeOfCell()) {
+        copy_generic(from, fromDomain, to, toDomain, whichContent);
+        return;
+    }
+    if (sameBlockDistribution(from, fromDomain, to, toDomain)) {
+        convertComponents(from, to, toDomain, whichContent);
+    }
+    else {
+        MultiBlockLattice3D<T,Descriptor> tmp (
+                to.getMultiBlockManagement(),
+                defaultMultiBlockPolicy3D().getBlockCommunicator(),
+                defaultMultiBlockPolicy3D().getCombinedStatistics(),
+                defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>(),
+                new NoDynamics<T,Descriptor> );
+        copy_generic(from, fromDomain, tmp, toDomain, whichContent);
+        convertComponents(tmp, to, toDomain, whichContent);
+    }
+    to.duplicateOverlaps(whichContent);
+}
+
+/** See the copy from a MultiBlockLattice3D for the case where the populations
+ *  are stored in a narrower type than T.
+ */
+template<typename T, template<typename U> class Descriptor, typename S>
+void copy (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from, Box3D const& fromDomain,
+        MultiBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent )
+{
+    if (from.sizeOfCell() == to.sizeOfCell()) {
+        copy_generic(from, fromDomain, to, toDomain, whichContent);
+        return;
+    }
+    if (sameBlockDistribution(from, fromDomain, to, toDomain)) {
+        convertComponents(from, to, fromDomain, whichContent);
+        to.duplicateOverlaps(whichContent);
+    }
+    else {
+        MultiBlockLattice3D<T,Descriptor> tmp (
+                from.getMultiBlockManagement(),
+                defaultMultiBlockPolicy3D().getBlockCommunicator(),
+                defaultMultiBlockPolicy3D().getCombinedStatistics(),
+                defaultMultiBlockPolicy3D().getMultiCellAccess<T,Descriptor>(),
+                new NoDynamics<T,Descriptor> );
+        convertComponents(from, tmp, fromDomain, whichContent);
+        copy_generic(tmp, fromDomain, to, toDomain, whichContent);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void copy (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from, Box3D const& fromDomain,
+        MultiSoaBlockLattice3D<T,Descriptor,S>& to, Box3D const& toDomain,
+        modif::ModifT whichContent )
+{
+    copy_generic(from, fromDomain, to, toDomain, whichContent);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+void copyPopulations (
+        MultiSoaBlockLattice3D<T,Descriptor,S> const& from,
+        MultiBlockLattice3D<T,Descriptor>& to )
+{
+    copy(from, from.getBoundingBox(), to, to.getBoundingBox(), modif::staticVariables);
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageDensity(MultiSoaBlockLattice3D<T,Descriptor,S> const& blockLattice) {
+    return Descriptor<T>::fullRho (
+               blockLattice.getInternalStatistics().getAverage (
+                  LatticeStatistics::avRhoBar ) );
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredAverageEnergy(MultiSoaBlockLattice3D<T,Descriptor,S> const& blockLattice) {
+    return 0.5 * blockLattice.getInternalStatistics().getAverage (
+                        LatticeStatistics::avUSqr );
+}
+
+template<typename T, template<typename U> class Descriptor, typename S>
+double getStoredMaxVelocity(MultiSoaBlockLattice3D<T,Descriptor,S> const& blockLattice) {
+    return std::sqrt( blockLattice.getInternalStatistics().getMax (
+                             LatticeStatistics::maxUSqr ) );
+}
+
+}  // namespace plb
+
+#endif  // MULTI_SOA_BLOCK_LATTICE_3D_HH
@@ -0,0 +1,222 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D multiblock lattice which stores only a subset of its cells -- header file.
+ */
+#ifndef MULTI_SPARSE_BLOCK_LATTICE_3D_H
+#define MULTI_SPARSE_BLOCK_LATTICE_3D_H
+
+#include "core/globalDefs.h"
+#include "multiBlock/multiBlock3D.h"
+#include "multiBlock/multiBlockLattice3D.h"
+#include "multiBlock/multiDataField3D.h"
+#include "atomicBlock/sparseBlockLattice3D.h"
+#include <vector>
+#include <map>
+#include <memory>
+
+namespace plb {
+
+/// A multi-block lattice whose atomic-blocks are SparseBlockLattice3D.
+/** The block distribution, the envelopes, the communicators and the combined
+ *  statistics are handled exactly as in the MultiBlockLattice3D; the atomic-blocks
+ *  however store only the cells selected by a mask. The usual way to use this
+ *  class is to set up the simulation (dynamics, boundary conditions, initial
+ *  condition) on a MultiBlockLattice3D, in which the solid cells that are not
+ *  adjacent to the fluid have NoDynamics, and to convert it into a
+ *  MultiSparseBlockLattice3D with the same block management for the time
+ *  iterations. The cells with NoDynamics are then not stored.
+ *
+ *  Data processors are written on the basis of the SparseBoxProcessingFunctional3D_L
+ *  and related classes. The data can also be copied back into a MultiBlockLattice3D
+ *  at any time, as the byte-stream formats of the two lattices are identical.
+ */
+template<typename T, template<typename U> class Descriptor>
+class MultiSparseBlockLattice3D : public MultiBlock3D {
+public:
+    typedef std::map<plint,SparseBlockLattice3D<T,Descriptor>*> BlockMap;
+public:
+    /// Construct a lattice in which the cells with a non-zero mask value are stored.
+    /** The mask must have the same block management as the lattice, and its
+     *  envelopes must be up to date. */
+    MultiSparseBlockLattice3D(MultiBlockManagement3D const& multiBlockManagement,
+                              BlockCommunicator3D* blockCommunicator_,
+                              CombinedStatistics* combinedStatistics_,
+                              Dynamics<T,Descriptor>* backgroundDynamics_,
+                              MultiScalarField3D<int> const& mask);
+    /// Construct a lattice in which all cells are stored.
+    MultiSparseBlockLattice3D(MultiBlockManagement3D const& multiBlockManagement,
+                              BlockCommunicator3D* blockCommunicator_,
+                              CombinedStatistics* combinedStatistics_,
+                              Dynamics<T,Descriptor>* backgroundDynamics_);
+    /// Construct a lattice with the same block management, periodicity and content as
+    ///   the given MultiBlockLattice3D, in which the cells with NoDynamics are not stored
+    ///   (the data-processors are not copied).
+    explicit MultiSparseBlockLattice3D(MultiBlockLattice3D<T,Descriptor> const& lattice);
+    ~MultiSparseBlockLattice3D();
+    MultiSparseBlockLattice3D(MultiSparseBlockLattice3D<T,Descriptor> const& rhs);
+    virtual MultiSparseBlockLattice3D<T,Descriptor>* clone() const;
+    /// The set of stored cells is preserved by the new block distribution.
+    virtual MultiSparseBlockLattice3D<T,Descriptor>* clone(MultiBlockManagement3D const& newManagement) const;
+    /// Attention: data-processors of rhs, which were pointing at rhs, will continue pointing
+    /// to rhs, and not to *this.
+    void swap(MultiSparseBlockLattice3D& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
+    /// Attention: data-processors of rhs, which were pointing at rhs, will continue pointing
+    /// to rhs, and not to *this.
+    MultiSparseBlockLattice3D<T,Descriptor>& operator=(MultiSparseBlockLattice3D<T,Descriptor> const& rhs);
+    /// Assign the same dynamics to every stored cell.
+    void resetDynamics(Dynamics<T,Descriptor> const& dynamics);
+    /// Attribute dynamics to the stored cells of a rectangular domain. The lattice
+    ///   takes ownership of the object.
+    void defineDynamics(Box3D domain, Dynamics<T,Descriptor>* dynamics);
+    /// A scalar-field with the block management of the lattice, which is equal
+    ///   to 1 on the stored cells and 0 elsewhere.
+    std::auto_ptr<MultiScalarField3D<int> > computeStorageMask() const;
+    /// Total number of stored cells in the bulks of the atomic-blocks.
+    plint getNumStoredCells() const;
+
+    Dynamics<T,Descriptor> const& getBackgroundDynamics() const;
+    void specifyStatisticsStatus(Box3D domain, bool status);
+    void collideAndStream();
+    void externalCollideAndStream();
+    void incrementTime();
+    void resetTime(pluint value);
+    TimeCounter& getTimeCounter() { return timeCounter; }
+    TimeCounter const& getTimeCounter() const { return timeCounter; }
+    virtual SparseBlockLattice3D<T,Descriptor>& getComponent(plint blockId);
+    virtual SparseBlockLattice3D<T,Descriptor> const& getComponent(plint blockId) const;
+    virtual plint sizeOfCell() const;
+    virtual plint getCellDim() const;
+    virtual int getStaticId() const;
+    virtual void copyReceive (
+                MultiBlock3D const& fromBlock, Box3D const& fromDomain,
+                Box3D const& toDomain, modif::ModifT whichData=modif::dataStructure );
+public:
+    BlockMap& getBlockLattices();
+    BlockMap const& getBlockLattices() const;
+    virtual void getDynamicsDict(Box3D domain, std::map<std::string,int>& dict);
+    virtual std::string getBlockName() const;
+    virtual std::vector<std::string> getTypeInfo() const;
+    static std::string blockName();
+    static std::string basicType();
+    static std::string descriptorType();
+private:
+    void collideAndStreamImplementation();
+    void allocateAndInitialize(MultiScalarField3D<int> const* mask);
+    void eliminateStatisticsInEnvelope();
+    Box3D extendPeriodic(Box3D const& box, plint envelopeWidth) const;
+private:
+    Dynamics<T,Descriptor>* backgroundDynamics;
+    BlockMap blockLattices;
+    TimeCounter timeCounter;
+public:
+    static const int staticId;
+};
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiSparseBlockLattice3D<T,Descriptor> > defaultGenerateMultiSparseBlockLattice3D (
+        MultiBlockManagement3D const& management, plint unnamedDummyArg=1 );
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>& findMultiSparseBlockLattice3D(id_t id);
+
+/// A scalar-field with the block management of the lattice, which is equal to 1 on
+///   the cells which do not have NoDynamics, and 0 elsewhere.
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<int> > computeSparseStorageMask (
+        MultiBlockLattice3D<T,Descriptor> const& lattice );
+
+/// Copy data from a MultiBlockLattice3D into a MultiSparseBlockLattice3D.
+/** The two blocks are not required to have same parallelization. The data
+ *  of the cells which are not stored is discarded. */
+template<typename T, template<typename U> class Descriptor>
+void copy (
+        MultiBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiSparseBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent );
+
+/// Copy data from a MultiSparseBlockLattice3D into a MultiBlockLattice3D.
+/** The two blocks are not required to have same parallelization. The cells
+ *  which are not stored receive NoDynamics and zero populations. */
+template<typename T, template<typename U> class Descriptor>
+void copy (
+        MultiSparseBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent );
+
+/// Copy data between two MultiSparseBlockLattice3D.
+template<typename T, template<typename U> class Descriptor>
+void copy (
+        MultiSparseBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiSparseBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent );
+
+template<typename T, template<typename U> class Descriptor>
+void applyProcessingFunctional (
+        SparseBoxProcessingFunctional3D_L<T,Descriptor>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T,Descriptor>& lattice );
+
+template<typename T, template<typename U> class Descriptor>
+void integrateProcessingFunctional (
+        SparseBoxProcessingFunctional3D_L<T,Descriptor>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T,Descriptor>& lattice, plint level=0 );
+
+template<typename T1, template<typename U> class Descriptor, typename T2>
+void applyProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LS<T1,Descriptor,T2>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiScalarField3D<T2>& field );
+
+template<typename T1, template<typename U> class Descriptor, typename T2>
+void integrateProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LS<T1,Descriptor,T2>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiScalarField3D<T2>& field, plint level=0 );
+
+template<typename T1, template<typename U> class Descriptor, typename T2, int nDim>
+void applyProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LT<T1,Descriptor,T2,nDim>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiTensorField3D<T2,nDim>& field );
+
+template<typename T1, template<typename U> class Descriptor, typename T2, int nDim>
+void integrateProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LT<T1,Descriptor,T2,nDim>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiTensorField3D<T2,nDim>& field, plint level=0 );
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageDensity(MultiSparseBlockLattice3D<T,Descriptor> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageEnergy(MultiSparseBlockLattice3D<T,Descriptor> const& blockLattice);
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredMaxVelocity(MultiSparseBlockLattice3D<T,Descriptor> const& blockLattice);
+
+}  // namespace plb
+
+#endif  // MULTI_SPARSE_BLOCK_LATTICE_3D_H
@@ -0,0 +1,722 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * A 3D multiblock lattice which stores only a subset of its cells -- generic implementation.
+ */
+#ifndef MULTI_SPARSE_BLOCK_LATTICE_3D_HH
+#define MULTI_SPARSE_BLOCK_LATTICE_3D_HH
+
+#include "multiBlock/multiSparseBlockLattice3D.h"
+#include "atomicBlock/sparseBlockLattice3D.h"
+#include "multiBlock/defaultMultiBlockPolicy3D.h"
+#include "multiBlock/nonLocalTransfer3D.h"
+#include "multiBlock/multiBlockOperations3D.h"
+#include "atomicBlock/dataProcessorWrapper3D.h"
+#include "core/latticeStatistics.h"
+#include "core/plbTypenames.h"
+#include "core/multiBlockIdentifiers3D.h"
+#include "core/plbProfiler.h"
+#include "parallelism/threadPool.h"
+#include "core/dynamicsIdentifiers.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace plb {
+
+////////////////////// Class MultiSparseBlockLattice3D /////////////////////////
+
+template<typename T, template<typename U> class Descriptor>
+const int MultiSparseBlockLattice3D<T,Descriptor>::staticId =
+meta::registerMultiBlock3D ( MultiSparseBlockLattice3D<T,Descriptor>::basicType(),
+                             MultiSparseBlockLattice3D<T,Descriptor>::descriptorType(),
+                             MultiSparseBlockLattice3D<T,Descriptor>::blockName(),
+                             defaultGenerateMultiSparseBlockLattice3D<T,Descriptor> );
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>::MultiSparseBlockLattice3D (
+        MultiBlockManagement3D const& multiBlockManagement_,
+        BlockCommunicator3D* blockCommunicator_,
+        CombinedStatistics* combinedStatistics_,
+        Dynamics<T,Descriptor>* backgroundDynamics_,
+        MultiScalarField3D<int> const& mask )
+    : MultiBlock3D(multiBlockManagement_, blockCommunicator_, combinedStatistics_ ),
+      backgroundDynamics(backgroundDynamics_)
+{
+    PLB_ASSERT( mask.getMultiBlockManagement().equivalentTo(multiBlockManagement_) );
+    allocateAndInitialize(&mask);
+    eliminateStatisticsInEnvelope();
+    this->evaluateStatistics(); // Reset statistics to default.
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>::MultiSparseBlockLattice3D (
+        MultiBlockManagement3D const& multiBlockManagement_,
+        BlockCommunicator3D* blockCommunicator_,
+        CombinedStatistics* combinedStatistics_,
+        Dynamics<T,Descriptor>* backgroundDynamics_ )
+    : MultiBlock3D(multiBlockManagement_, blockCommunicator_, combinedStatistics_ ),
+      backgroundDynamics(backgroundDynamics_)
+{
+    allocateAndInitialize(0);
+    eliminateStatisticsInEnvelope();
+    this->evaluateStatistics(); // Reset statistics to default.
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>::MultiSparseBlockLattice3D (
+        MultiBlockLattice3D<T,Descriptor> const& lattice )
+    : MultiBlock3D( lattice.getMultiBlockManagement(),
+                    lattice.getBlockCommunicator().clone(),
+                    lattice.getCombinedStatistics().clone() ),
+      backgroundDynamics(lattice.getBackgroundDynamics().clone())
+{
+    this->periodicity() = lattice.periodicity();
+    this->setInternalTypeOfModification(lattice.getInternalTypeOfModification());
+    this->toggleInternalStatistics(lattice.isInternalStatisticsOn());
+    std::auto_ptr<MultiScalarField3D<int> > mask = computeSparseStorageMask(lattice);
+    allocateAndInitialize(mask.get());
+    eliminateStatisticsInEnvelope();
+    this->evaluateStatistics(); // Reset statistics to default.
+    copy(lattice, lattice.getBoundingBox(), *this, this->getBoundingBox(), modif::dataStructure);
+    resetTime(lattice.getTimeCounter().getTime());
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>::~MultiSparseBlockLattice3D() {
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        delete it->second;
+    }
+    delete backgroundDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>::MultiSparseBlockLattice3D (
+        MultiSparseBlockLattice3D<T,Descriptor> const& rhs )
+    : MultiBlock3D(rhs),
+      backgroundDynamics(rhs.backgroundDynamics->clone()),
+      timeCounter(rhs.timeCounter)
+{
+    for ( typename  BlockMap::const_iterator it = rhs.blockLattices.begin();
+          it != rhs.blockLattices.end(); ++it )
+    {
+        blockLattices[it->first] = new SparseBlockLattice3D<T,Descriptor>(*it->second);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::swap(MultiSparseBlockLattice3D<T,Descriptor>& rhs) {
+    MultiBlock3D::swap(rhs);
+    std::swap(backgroundDynamics, rhs.backgroundDynamics);
+    blockLattices.swap(rhs.blockLattices);
+    std::swap(timeCounter, rhs.timeCounter);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::swapComponents(MultiBlock3D& rhs) {
+    MultiSparseBlockLattice3D<T,Descriptor>* rhsLattice =
+        dynamic_cast<MultiSparseBlockLattice3D<T,Descriptor>*>(&rhs);
+    PLB_ASSERT( rhsLattice );
+    MultiBlock3D::swapDistribution(rhs);
+    blockLattices.swap(rhsLattice->blockLattices);
+    // The atomic-blocks keep the time of the multi-block they belong to.
+    resetTime(timeCounter.getTime());
+    rhsLattice->resetTime(rhsLattice->timeCounter.getTime());
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>& MultiSparseBlockLattice3D<T,Descriptor>::operator= (
+        MultiSparseBlockLattice3D<T,Descriptor> const& rhs )
+{
+    MultiSparseBlockLattice3D<T,Descriptor> tmp(rhs);
+    swap(tmp);
+    return *this;
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>*
+    MultiSparseBlockLattice3D<T,Descriptor>::clone() const
+{
+    return new MultiSparseBlockLattice3D<T,Descriptor>(*this);
+}
+
+/** The storage mask is first redistributed to the new block management, and
+ *  the new lattice is allocated from it before the data is copied.
+ */
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>*
+    MultiSparseBlockLattice3D<T,Descriptor>::clone(MultiBlockManagement3D const& newManagement) const
+{
+    std::auto_ptr<MultiScalarField3D<int> > mask = computeStorageMask();
+    MultiScalarField3D<int> newMask (
+            newManagement,
+            defaultMultiBlockPolicy3D().getBlockCommunicator(),
+            defaultMultiBlockPolicy3D().getCombinedStatistics(),
+            defaultMultiBlockPolicy3D().getMultiScalarAccess<int>() );
+    newMask.periodicity() = this->periodicity();
+    copy(*mask, mask->getBoundingBox(), newMask, newMask.getBoundingBox());
+    newMask.duplicateOverlaps(modif::staticVariables);
+
+    MultiSparseBlockLattice3D<T,Descriptor>* newLattice =
+        new MultiSparseBlockLattice3D<T,Descriptor> (
+                newManagement,
+                this->getBlockCommunicator().clone(),
+                this->getCombinedStatistics().clone(),
+                getBackgroundDynamics().clone(),
+                newMask );
+    // Use the same domain in the "from" and "to" argument, so that the data is not shifted
+    // in space during the creation of the new block.
+    copy(*this, newLattice->getBoundingBox(), *newLattice, newLattice->getBoundingBox(), modif::dataStructure);
+    return newLattice;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::resetDynamics(Dynamics<T,Descriptor> const& dynamics)
+{
+    for ( typename  BlockMap::const_iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it )
+    {
+        it->second->resetDynamics(dynamics);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::defineDynamics (
+        Box3D domain, Dynamics<T,Descriptor>* dynamics )
+{
+    Box3D inters;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.computeEnvelope(), inters ) ) {
+            it->second -> attributeDynamics(bulk.toLocal(inters), dynamics->clone());
+        }
+    }
+    delete dynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<int> > MultiSparseBlockLattice3D<T,Descriptor>::computeStorageMask() const
+{
+    std::auto_ptr<MultiScalarField3D<int> > mask(new MultiScalarField3D<int>(*this));
+    mask->periodicity() = this->periodicity();
+    for ( typename BlockMap::const_iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SparseBlockLattice3D<T,Descriptor> const& block = *it->second;
+        ScalarField3D<int>& maskComponent = mask->getComponent(it->first);
+        for (plint iX=0; iX<block.getNx(); ++iX) {
+            for (plint iY=0; iY<block.getNy(); ++iY) {
+                plint begin, end;
+                block.getColumnRange(iX, iY, 0, block.getNz()-1, begin, end);
+                for (plint iCell=begin; iCell<end; ++iCell) {
+                    maskComponent.get(iX,iY,block.getStoredZ(iCell)) = 1;
+                }
+            }
+        }
+    }
+    return mask;
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint MultiSparseBlockLattice3D<T,Descriptor>::getNumStoredCells() const
+{
+    plint numCells = 0;
+    for ( typename BlockMap::const_iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        Box3D domain(bulk.toLocal(bulk.getBulk()));
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                plint begin, end;
+                it->second->getColumnRange(iX, iY, domain.z0, domain.z1, begin, end);
+                numCells += end-begin;
+            }
+        }
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().reduceAndBcast(numCells, MPI_SUM);
+#endif
+    return numCells;
+}
+
+template<typename T, template<typename U> class Descriptor>
+Dynamics<T,Descriptor> const& MultiSparseBlockLattice3D<T,Descriptor>::getBackgroundDynamics() const {
+    return *backgroundDynamics;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::specifyStatisticsStatus (Box3D domain, bool status) {
+    Box3D inters;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.getBulk(), inters ) ) {
+            inters = bulk.toLocal(inters);
+            it->second -> specifyStatisticsStatus(inters, status);
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+Box3D MultiSparseBlockLattice3D<T,Descriptor>::extendPeriodic(Box3D const& box, plint envelopeWidth) const
+{
+    Box3D boundingBox(this->getBoundingBox());
+    Box3D periodicBox(box);
+    bool periodicX = this->periodicity().get(0);
+    bool periodicY = this->periodicity().get(1);
+    bool periodicZ = this->periodicity().get(2);
+    if (periodicX) {
+        if (periodicBox.x0 == boundingBox.x0) {
+            periodicBox.x0 -= envelopeWidth;
+        }
+        if (periodicBox.x1 == boundingBox.x1) {
+            periodicBox.x1 += envelopeWidth;
+        }
+    }
+    if (periodicY) {
+        if (periodicBox.y0 == boundingBox.y0) {
+            periodicBox.y0 -= envelopeWidth;
+        }
+        if (periodicBox.y1 == boundingBox.y1) {
+            periodicBox.y1 += envelopeWidth;
+        }
+    }
+    if (periodicZ) {
+        if (periodicBox.z0 == boundingBox.z0) {
+            periodicBox.z0 -= envelopeWidth;
+        }
+        if (periodicBox.z1 == boundingBox.z1) {
+            periodicBox.z1 += envelopeWidth;
+        }
+    }
+    return periodicBox;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::collideAndStream() {
+    global::profiler().start("cycle");
+    collideAndStreamImplementation();
+    this->executeInternalProcessors();
+    this->evaluateStatistics();
+    this->incrementTime();
+    global::profiler().stop("cycle");
+    if (global::profiler().cyclingIsAutomatic()) {
+        global::profiler().cycle();
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::externalCollideAndStream() {
+    global::profiler().start("cycle");
+    collideAndStreamImplementation();
+    if (global::profiler().cyclingIsAutomatic()) {
+        global::profiler().cycle();
+    }
+    global::profiler().stop("cycle");
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::collideAndStreamImplementation() {
+    ThreadAttribution const& threadAttribution=this->getMultiBlockManagement().getThreadAttribution();
+    std::vector<plint> blockIds;
+    std::vector<SparseBlockLattice3D<T,Descriptor>*> lattices;
+    std::vector<Box3D> domains;
+    std::vector<int> preferredThread;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        blockIds.push_back(it->first);
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        // CollideAndStream must be applied to full domain,
+        //   including currently active envelopes.
+        Box3D domain = extendPeriodic(bulk.computeNonPeriodicEnvelope(),
+                                      this->getMultiBlockManagement().getEnvelopeWidth());
+        lattices.push_back(it->second);
+        domains.push_back(bulk.toLocal(domain));
+        preferredThread.push_back(threadAttribution.getLocalThreadId(it->first));
+    }
+    CollideAndStreamTask<SparseBlockLattice3D<T,Descriptor> > task(lattices, domains);
+    this->executeBlockTasks(task, blockIds, preferredThread);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::incrementTime() {
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> incrementTime();
+    }
+    timeCounter.incrementTime();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::resetTime(pluint value)
+{
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        it->second -> getTimeCounter().resetTime(value);
+    }
+    timeCounter.resetTime(value);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::allocateAndInitialize(MultiScalarField3D<int> const* mask)
+{
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average rho-bar
+    this->getInternalStatistics().subscribeAverage(); // Subscribe average uSqr
+    this->getInternalStatistics().subscribeMax();     // Subscribe max uSqr
+
+    for (pluint iBlock=0; iBlock<this->getLocalInfo().getBlocks().size(); ++iBlock) {
+        plint blockId = this->getLocalInfo().getBlocks()[iBlock];
+        SmartBulk3D bulk(this->getMultiBlockManagement(), blockId);
+        Box3D envelope = bulk.computeEnvelope();
+        SparseBlockLattice3D<T,Descriptor>* newLattice = 0;
+        if (mask) {
+            newLattice = new SparseBlockLattice3D<T,Descriptor> (
+                    mask->getComponent(blockId), backgroundDynamics->clone() );
+        }
+        else {
+            newLattice = new SparseBlockLattice3D<T,Descriptor> (
+                    envelope.getNx(), envelope.getNy(), envelope.getNz(),
+                    backgroundDynamics->clone() );
+        }
+        newLattice -> setLocation(Dot3D(envelope.x0, envelope.y0, envelope.z0));
+        blockLattices[blockId] = newLattice;
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::eliminateStatisticsInEnvelope()
+{
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it )
+    {
+        plint envelopeWidth = this->getMultiBlockManagement().getEnvelopeWidth();
+        SparseBlockLattice3D<T,Descriptor>& block = *it->second;
+        plint maxX = block.getNx()-1;
+        plint maxY = block.getNy()-1;
+        plint maxZ = block.getNz()-1;
+
+        block.specifyStatisticsStatus(Box3D(0, maxX, 0, maxY, 0, envelopeWidth-1), false);
+        block.specifyStatisticsStatus(Box3D(0, maxX, 0, maxY, maxZ-envelopeWidth+1, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(0, maxX, 0, envelopeWidth-1, 0, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(0, maxX, maxY-envelopeWidth+1, maxY, 0, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(0, envelopeWidth-1, 0, maxY, 0, maxZ), false);
+        block.specifyStatisticsStatus(Box3D(maxX-envelopeWidth+1, maxX,  0, maxY, 0, maxZ), false);
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::map<plint,SparseBlockLattice3D<T,Descriptor>*>&
+    MultiSparseBlockLattice3D<T,Descriptor>::getBlockLattices()
+{
+    return blockLattices;
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::map<plint,SparseBlockLattice3D<T,Descriptor>*> const&
+    MultiSparseBlockLattice3D<T,Descriptor>::getBlockLattices() const
+{
+    return blockLattices;
+}
+
+/** The cells which are not stored contribute the ID of NoDynamics. */
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::getDynamicsDict(Box3D domain, std::map<std::string,int>& dict)
+{
+    std::vector<int> isPresent(meta::dynamicsRegistration<T,Descriptor>().getNumId()+1, 0);
+    Box3D inters;
+    for ( typename BlockMap::iterator it = blockLattices.begin();
+          it != blockLattices.end(); ++it)
+    {
+        SmartBulk3D bulk(this->getMultiBlockManagement(), it->first);
+        if (intersect(domain, bulk.getBulk(), inters ) ) {
+            inters = bulk.toLocal(inters);
+            SparseBlockLattice3D<T,Descriptor> const& block = *it->second;
+            plint numStored = 0;
+            std::vector<int> chain;
+            for (plint iX=inters.x0; iX<=inters.x1; ++iX) {
+                for (plint iY=inters.y0; iY<=inters.y1; ++iY) {
+                    plint begin, end;
+                    block.getColumnRange(iX, iY, inters.z0, inters.z1, begin, end);
+                    numStored += end-begin;
+                    for (plint iCell=begin; iCell<end; ++iCell) {
+                        chain.clear();
+                        constructIdChain(block.getStoredCell(iCell).getDynamics(), chain);
+                        for (pluint iChain=0; iChain<chain.size(); ++iChain) {
+                            if (chain[iChain]>=0 && chain[iChain]<(int)isPresent.size()) {
+                                isPresent[chain[iChain]] = 1;
+                            }
+                        }
+                    }
+                }
+            }
+            if (numStored < inters.nCells()) {
+                isPresent[block.getSolidDynamics().getId()] = 1;
+            }
+        }
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(isPresent, MPI_MAX);
+#endif
+    dict.clear();
+    for (pluint id=0; id<isPresent.size(); ++id) {
+        if (isPresent[id]) {
+            std::string name = meta::dynamicsRegistration<T,Descriptor>().getName((int)id);
+            dict.insert(std::pair<std::string,int>(name,(int)id));
+        }
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::string MultiSparseBlockLattice3D<T,Descriptor>::getBlockName() const {
+    return blockName();
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::vector<std::string> MultiSparseBlockLattice3D<T,Descriptor>::getTypeInfo() const {
+    std::vector<std::string> info;
+    info.push_back(basicType());
+    info.push_back(descriptorType());
+    return info;
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::string MultiSparseBlockLattice3D<T,Descriptor>::blockName() {
+    return std::string("SparseBlockLattice3D");
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::string MultiSparseBlockLattice3D<T,Descriptor>::basicType() {
+    return std::string(NativeType<T>::getName());
+}
+
+template<typename T, template<typename U> class Descriptor>
+std::string MultiSparseBlockLattice3D<T,Descriptor>::descriptorType() {
+    return std::string(Descriptor<T>::name);
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor>& MultiSparseBlockLattice3D<T,Descriptor>::getComponent(plint blockId) {
+    typename BlockMap::iterator it = blockLattices.find(blockId);
+    PLB_ASSERT (it != blockLattices.end());
+    return *it->second;
+}
+
+template<typename T, template<typename U> class Descriptor>
+SparseBlockLattice3D<T,Descriptor> const& MultiSparseBlockLattice3D<T,Descriptor>::getComponent(plint blockId) const {
+    typename BlockMap::const_iterator it = blockLattices.find(blockId);
+    PLB_ASSERT (it != blockLattices.end());
+    return *it->second;
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint MultiSparseBlockLattice3D<T,Descriptor>::sizeOfCell() const {
+    return sizeof(T) * (Descriptor<T>::numPop + Descriptor<T>::ExternalField::numScalars);
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint MultiSparseBlockLattice3D<T,Descriptor>::getCellDim() const {
+    return Descriptor<T>::numPop + Descriptor<T>::ExternalField::numScalars;
+}
+
+template<typename T, template<typename U> class Descriptor>
+int MultiSparseBlockLattice3D<T,Descriptor>::getStaticId() const {
+    return staticId;
+}
+
+/** The source can be a MultiSparseBlockLattice3D or a MultiBlockLattice3D. */
+template<typename T, template<typename U> class Descriptor>
+void MultiSparseBlockLattice3D<T,Descriptor>::copyReceive (
+                MultiBlock3D const& fromBlock, Box3D const& fromDomain,
+                Box3D const& toDomain, modif::ModifT whichData )
+{
+    PLB_ASSERT( (dynamic_cast<MultiSparseBlockLattice3D<T,Descriptor> const* >(&fromBlock) ||
+                 dynamic_cast<MultiBlockLattice3D<T,Descriptor> const* >(&fromBlock)) );
+    copy_generic(fromBlock, fromDomain, *this, toDomain, whichData);
+}
+
+/////////// Free Functions //////////////////////////////
+
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiSparseBlockLattice3D<T,Descriptor> > defaultGenerateMultiSparseBlockLattice3D (
+        MultiBlockManagement3D const& management, plint unnamedDummyArg )
+{
+    return std::auto_ptr<MultiSparseBlockLattice3D<T,Descriptor> > (
+        new MultiSparseBlockLattice3D<T,Descriptor> (
+            management,
+            defaultMultiBlockPolicy3D().getBlockCommunicator(),
+            defaultMultiBlockPolicy3D().getCombinedStatistics(),
+            new NoDynamics<T,Descriptor> )
+    );
+}
+
+template<typename T, template<typename U> class Descriptor>
+MultiSparseBlockLattice3D<T,Descriptor>& findMultiSparseBlockLattice3D(id_t id) {
+    MultiBlock3D* multiBlock = multiBlockRegistration3D().find(id);
+    if (!multiBlock || multiBlock->getStaticId() != MultiSparseBlockLattice3D<T,Descriptor>::staticId) {
+        throw PlbLogicException("Trying to access a multi block sparse lattice that is not registered.");
+    }
+    return (MultiSparseBlockLattice3D<T,Descriptor>&)(*multiBlock);
+}
+
+/** The mask is computed on all cells of the atomic-blocks, and the envelopes
+ *  are then overwritten with the values of the neighboring bulks, so that each
+ *  cell is either stored or not stored in all atomic-blocks that contain it.
+ */
+template<typename T, template<typename U> class Descriptor>
+std::auto_ptr<MultiScalarField3D<int> > computeSparseStorageMask (
+        MultiBlockLattice3D<T,Descriptor> const& lattice )
+{
+    std::auto_ptr<MultiScalarField3D<int> > mask(new MultiScalarField3D<int>(lattice));
+    mask->periodicity() = lattice.periodicity();
+    int noDynamicsId = NoDynamics<T,Descriptor>().getId();
+    typename MultiBlockLattice3D<T,Descriptor>::BlockMap const& blocks = lattice.getBlockLattices();
+    for ( typename MultiBlockLattice3D<T,Descriptor>::BlockMap::const_iterator it = blocks.begin();
+          it != blocks.end(); ++it)
+    {
+        BlockLattice3D<T,Descriptor> const& block = *it->second;
+        ScalarField3D<int>& maskComponent = mask->getComponent(it->first);
+        for (plint iX=0; iX<block.getNx(); ++iX) {
+            for (plint iY=0; iY<block.getNy(); ++iY) {
+                for (plint iZ=0; iZ<block.getNz(); ++iZ) {
+                    maskComponent.get(iX,iY,iZ) =
+                        block.get(iX,iY,iZ).getDynamics().getId() != noDynamicsId ? 1 : 0;
+                }
+            }
+        }
+    }
+    mask->duplicateOverlaps(modif::staticVariables);
+    return mask;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void copy (
+        MultiBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiSparseBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent )
+{
+    copy_generic(from, fromDomain, to, toDomain, whichContent);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void copy (
+        MultiSparseBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent )
+{
+    copy_generic(from, fromDomain, to, toDomain, whichContent);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void copy (
+        MultiSparseBlockLattice3D<T,Descriptor> const& from, Box3D const& fromDomain,
+        MultiSparseBlockLattice3D<T,Descriptor>& to, Box3D const& toDomain,
+        modif::ModifT whichContent )
+{
+    copy_generic(from, fromDomain, to, toDomain, whichContent);
+}
+
+template<typename T, template<typename U> class Descriptor>
+void applyProcessingFunctional (
+        SparseBoxProcessingFunctional3D_L<T,Descriptor>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T,Descriptor>& lattice )
+{
+    executeDataProcessor( BoxProcessorGenerator3D(functional, domain), lattice );
+}
+
+template<typename T, template<typename U> class Descriptor>
+void integrateProcessingFunctional (
+        SparseBoxProcessingFunctional3D_L<T,Descriptor>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T,Descriptor>& lattice, plint level )
+{
+    addInternalProcessor( BoxProcessorGenerator3D(functional, domain), lattice, level );
+}
+
+template<typename T1, template<typename U> class Descriptor, typename T2>
+void applyProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LS<T1,Descriptor,T2>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiScalarField3D<T2>& field )
+{
+    executeDataProcessor( BoxProcessorGenerator3D(functional, domain), lattice, field );
+}
+
+template<typename T1, template<typename U> class Descriptor, typename T2>
+void integrateProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LS<T1,Descriptor,T2>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiScalarField3D<T2>& field, plint level )
+{
+    addInternalProcessor( BoxProcessorGenerator3D(functional, domain), lattice, field, level );
+}
+
+template<typename T1, template<typename U> class Descriptor, typename T2, int nDim>
+void applyProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LT<T1,Descriptor,T2,nDim>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiTensorField3D<T2,nDim>& field )
+{
+    executeDataProcessor( BoxProcessorGenerator3D(functional, domain), lattice, field );
+}
+
+template<typename T1, template<typename U> class Descriptor, typename T2, int nDim>
+void integrateProcessingFunctional (
+        SparseBoxProcessingFunctional3D_LT<T1,Descriptor,T2,nDim>* functional,
+        Box3D domain, MultiSparseBlockLattice3D<T1,Descriptor>& lattice,
+        MultiTensorField3D<T2,nDim>& field, plint level )
+{
+    addInternalProcessor( BoxProcessorGenerator3D(functional, domain), lattice, field, level );
+}
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageDensity(MultiSparseBlockLattice3D<T,Descriptor> const& blockLattice) {
+    return Descriptor<T>::fullRho (
+               blockLattice.getInternalStatistics().getAverage (
+                  LatticeStatistics::avRhoBar ) );
+}
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredAverageEnergy(MultiSparseBlockLattice3D<T,Descriptor> const& blockLattice) {
+    return 0.5 * blockLattice.getInternalStatistics().getAverage (
+                        LatticeStatistics::avUSqr );
+}
+
+template<typename T, template<typename U> class Descriptor>
+double getStoredMaxVelocity(MultiSparseBlockLattice3D<T,Descriptor> const& blockLattice) {
+    return std::sqrt( blockLattice.getInternalStatistics().getMax (
+                             LatticeStatistics::maxUSqr ) );
+}
+
+}  // namespace plb
+
+#endif  // MULTI_SPARSE_BLOCK_LATTICE_3D_HH
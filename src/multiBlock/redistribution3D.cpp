@@ -28,6 +28,13 @@
 
 #include "core/globalDefs.h"
 #include "multiBlock/redistribution3D.h"
+#include "multiBlock/multiBlock3D.h"
+#include "atomicBlock/atomicBlock3D.h"
+#include "multiBlock/multiBlockOperations3D.h"
+#include "parallelism/mpiManager.h"
+#include "parallelism/threadPool.h"
+#include "core/runTimeDiagnostics.h"
+#include <algorithm>
 #include <cstdlib>
 
 namespace plb {
@@ -69,5 +76,265 @@ MultiBlockManagement3D RandomRedistribute3D::redistribute (
             original.getEnvelopeWidth(), original.getRefinementLevel() );
 }
 
+
+/// Position of a point along a 3D Hilbert curve which visits 2^numBits points in each
+///   direction (transposition algorithm of J. Skilling, AIP Conf. Proc. 707, 2004).
+static unsigned long long hilbertIndex3D(plint x, plint y, plint z, int numBits)
+{
+    unsigned long long coord[3] = {
+        (unsigned long long)x, (unsigned long long)y, (unsigned long long)z };
+    unsigned long long highBit = 1ULL << (numBits-1);
+    // Inverse undo of the excess work.
+    for (unsigned long long q=highBit; q>1; q>>=1) {
+        unsigned long long p = q-1;
+        for (int i=0; i<3; ++i) {
+            if (coord[i] & q) {
+                coord[0] ^= p;
+            }
+            else {
+                unsigned long long t = (coord[0]^coord[i]) & p;
+                coord[0] ^= t;
+                coord[i] ^= t;
+            }
+        }
+    }
+    // Gray encoding.
+    coord[1] ^= coord[0];
+    coord[2] ^= coord[1];
+    unsigned long long t = 0;
+    for (unsigned long long q=highBit; q>1; q>>=1) {
+        if (coord[2] & q) {
+            t ^= q-1;
+        }
+    }
+    for (int i=0; i<3; ++i) {
+        coord[i] ^= t;
+    }
+    // Interleave the bits of the transposed index.
+    unsigned long long index = 0;
+    for (int bit=numBits-1; bit>=0; --bit) {
+        for (int i=0; i<3; ++i) {
+            index = (index<<1) | ((coord[i]>>bit) & 1ULL);
+        }
+    }
+    return index;
+}
+
+/// Cost of every block of the sparse block structure. Missing costs are estimated
+///   from the volume of the block.
+static std::map<plint,double> completeBlockCosts (
+        std::map<plint,double> const& blockCosts, SparseBlockStructure3D const& sparseBlock )
+{
+    std::map<plint,Box3D> const& bulks = sparseBlock.getBulks();
+    double knownCost = 0.;
+    double knownVolume = 0.;
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (; it != bulks.end(); ++it) {
+        std::map<plint,double>::const_iterator cost = blockCosts.find(it->first);
+        if (cost != blockCosts.end()) {
+            knownCost += cost->second;
+            knownVolume += (double) it->second.nCells();
+        }
+    }
+    double costPerCell = (knownCost>0. && knownVolume>0.) ? knownCost/knownVolume : 1.;
+    std::map<plint,double> allCosts;
+    for (it = bulks.begin(); it != bulks.end(); ++it) {
+        std::map<plint,double>::const_iterator cost = blockCosts.find(it->first);
+        if (cost != blockCosts.end() && knownCost>0.) {
+            allCosts[it->first] = cost->second;
+        }
+        else {
+            allCosts[it->first] = costPerCell * (double) it->second.nCells();
+        }
+    }
+    return allCosts;
+}
+
+MeasuredCostRedistribute3D::MeasuredCostRedistribute3D (
+        std::map<plint,double> const& blockCosts_ )
+    : blockCosts(blockCosts_)
+{ }
+
+MultiBlockManagement3D MeasuredCostRedistribute3D::redistribute (
+        MultiBlockManagement3D const& original ) const
+{
+    SparseBlockStructure3D const& originalSparseBlock = original.getSparseBlockStructure();
+    std::map<plint,Box3D> const& bulks = originalSparseBlock.getBulks();
+    std::map<plint,double> costs = completeBlockCosts(blockCosts, originalSparseBlock);
+
+    // The doubled block centers are mapped to a curve with 2^numBits points per
+    //   direction; larger domains are coarsened accordingly.
+    static const int numBits = 20;
+    Box3D boundingBox = originalSparseBlock.getBoundingBox();
+    plint extent = 2*std::max(boundingBox.getNx(), std::max(boundingBox.getNy(), boundingBox.getNz()));
+    int shift = 0;
+    while ((extent>>shift) >= ((plint)1<<numBits)) {
+        ++shift;
+    }
+    std::vector<std::pair<unsigned long long,plint> > curve;
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (; it != bulks.end(); ++it) {
+        Box3D const& bulk = it->second;
+        plint x = (bulk.x0+bulk.x1-2*boundingBox.x0) >> shift;
+        plint y = (bulk.y0+bulk.y1-2*boundingBox.y0) >> shift;
+        plint z = (bulk.z0+bulk.z1-2*boundingBox.z0) >> shift;
+        curve.push_back(std::make_pair(hilbertIndex3D(x,y,z,numBits), it->first));
+    }
+    std::sort(curve.begin(), curve.end());
+
+    double totalCost = 0.;
+    for (pluint iBlock=0; iBlock<curve.size(); ++iBlock) {
+        totalCost += costs[curve[iBlock].second];
+    }
+    // A block is attributed to the piece of the curve which contains its middle.
+    plint numProcesses = global::mpi().getSize();
+    plint numThreads = global::threadPool().getNumThreads();
+    ExplicitThreadAttribution* newAttribution = new ExplicitThreadAttribution;
+    double cumulativeCost = 0.;
+    for (pluint iBlock=0; iBlock<curve.size(); ++iBlock) {
+        plint blockId = curve[iBlock].second;
+        double cost = costs[blockId];
+        double position = totalCost>0. ?
+            (cumulativeCost+0.5*cost)/totalCost * (double)numProcesses : 0.;
+        cumulativeCost += cost;
+        plint mpiProcess = std::min((plint)position, numProcesses-1);
+        plint localThread = std::min((plint)((position-(double)mpiProcess)*(double)numThreads),
+                                     numThreads-1);
+        newAttribution->addBlock(blockId, mpiProcess, localThread);
+    }
+
+    return MultiBlockManagement3D (
+            originalSparseBlock, newAttribution,
+            original.getEnvelopeWidth(), original.getRefinementLevel() );
+}
+
+std::map<plint,double> gatherBlockCosts(std::vector<MultiBlock3D*> const& multiBlocks)
+{
+    PLB_PRECONDITION( !multiBlocks.empty() );
+    std::map<plint,Box3D> const& bulks = multiBlocks[0]->getSparseBlockStructure().getBulks();
+    std::map<plint,plint> position;
+    std::map<plint,Box3D>::const_iterator it = bulks.begin();
+    for (; it != bulks.end(); ++it) {
+        plint pos = (plint) position.size();
+        position[it->first] = pos;
+    }
+    std::vector<double> costs(position.size(), 0.);
+    for (pluint iMulti=0; iMulti<multiBlocks.size(); ++iMulti) {
+        std::map<plint,double> const& localCosts = multiBlocks[iMulti]->getLocalBlockCosts();
+        std::map<plint,double>::const_iterator cost = localCosts.begin();
+        for (; cost != localCosts.end(); ++cost) {
+            std::map<plint,plint>::const_iterator pos = position.find(cost->first);
+            PLB_ASSERT( pos != position.end() );
+            costs[pos->second] += cost->second;
+        }
+    }
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().allReduceVect(costs, MPI_SUM);
+#endif
+    std::map<plint,double> blockCosts;
+    std::map<plint,plint>::const_iterator pos = position.begin();
+    for (; pos != position.end(); ++pos) {
+        blockCosts[pos->first] = costs[pos->second];
+    }
+    return blockCosts;
+}
+
+double computeLoadImbalance(std::map<plint,double> const& blockCosts,
+                            MultiBlockManagement3D const& management)
+{
+    std::map<plint,double> costs =
+        completeBlockCosts(blockCosts, management.getSparseBlockStructure());
+    ThreadAttribution const& attribution = management.getThreadAttribution();
+    std::vector<double> processCosts(global::mpi().getSize(), 0.);
+    double totalCost = 0.;
+    std::map<plint,double>::const_iterator it = costs.begin();
+    for (; it != costs.end(); ++it) {
+        processCosts[attribution.getMpiProcess(it->first)] += it->second;
+        totalCost += it->second;
+    }
+    if (totalCost<=0.) {
+        return 1.;
+    }
+    double maxCost = *std::max_element(processCosts.begin(), processCosts.end());
+    return maxCost / (totalCost / (double)processCosts.size());
+}
+
+void redistributeInPlace( std::vector<MultiBlock3D*> multiBlocks,
+                          MultiBlockRedistribute3D const& redistribution )
+{
+    PLB_PRECONDITION( !multiBlocks.empty() );
+    for (pluint iMulti=0; iMulti<multiBlocks.size(); ++iMulti) {
+        MultiBlock3D& multiBlock = *multiBlocks[iMulti];
+        plbLogicError( multiBlock.getMultiBlockManagement().getThreadAttribution().hasCoProcessors(),
+                       "Multi-blocks with co-processors cannot be redistributed." );
+        plbLogicError( multiBlock.getSparseBlockStructure().getBulks() !=
+                       multiBlocks[0]->getSparseBlockStructure().getBulks(),
+                       "The multi-blocks redistributed together must have the same block structure." );
+        std::vector<MultiBlock3D::ProcessorStorage3D> const& processors = multiBlock.getStoredProcessors();
+        for (pluint iProcessor=0; iProcessor<processors.size(); ++iProcessor) {
+            std::vector<MultiBlock3D*> arguments = processors[iProcessor].getMultiBlocks();
+            for (pluint iArg=0; iArg<arguments.size(); ++iArg) {
+                plbLogicError( std::find(multiBlocks.begin(), multiBlocks.end(), arguments[iArg]) ==
+                               multiBlocks.end(),
+                               "All multi-blocks coupled by internal data processors must be "
+                               "redistributed together." );
+            }
+        }
+    }
+
+    MultiBlockManagement3D newManagement =
+        redistribution.redistribute(multiBlocks[0]->getMultiBlockManagement());
+    for (pluint iMulti=0; iMulti<multiBlocks.size(); ++iMulti) {
+        MultiBlock3D& multiBlock = *multiBlocks[iMulti];
+        MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
+        MultiBlock3D* newBlock = multiBlock.clone( MultiBlockManagement3D (
+                management.getSparseBlockStructure(),
+                newManagement.getThreadAttribution().clone(),
+                management.getEnvelopeWidth(), management.getRefinementLevel() ) );
+        multiBlock.swapComponents(*newBlock);
+        delete newBlock;
+        // The new atomic-blocks take over the statistics subscribed in the multi-block.
+        std::vector<plint> const& blocks = multiBlock.getLocalInfo().getBlocks();
+        for (pluint iBlock=0; iBlock<blocks.size(); ++iBlock) {
+            BlockStatistics statistics(multiBlock.getInternalStatistics());
+            multiBlock.getComponent(blocks[iBlock]).getInternalStatistics().swap(statistics);
+        }
+        multiBlock.signalPeriodicity();
+        multiBlock.duplicateOverlaps(modif::dataStructure);
+    }
+
+    // The processors are re-created once all their arguments have been redistributed.
+    for (pluint iMulti=0; iMulti<multiBlocks.size(); ++iMulti) {
+        std::vector<MultiBlock3D::ProcessorStorage3D> const& processors =
+            multiBlocks[iMulti]->getStoredProcessors();
+        for (pluint iProcessor=0; iProcessor<processors.size(); ++iProcessor) {
+            reinstantiateInternalProcessor (
+                    processors[iProcessor].getGenerator(), *multiBlocks[iMulti],
+                    processors[iProcessor].getMultiBlocks(), processors[iProcessor].getLevel() );
+        }
+    }
+}
+
+bool rebalance(std::vector<MultiBlock3D*> multiBlocks, double tolerance)
+{
+    PLB_PRECONDITION( !multiBlocks.empty() );
+    std::map<plint,double> blockCosts = gatherBlockCosts(multiBlocks);
+    for (pluint iMulti=0; iMulti<multiBlocks.size(); ++iMulti) {
+        multiBlocks[iMulti]->resetBlockCosts();
+    }
+    MultiBlockManagement3D const& management = multiBlocks[0]->getMultiBlockManagement();
+    MeasuredCostRedistribute3D redistribution(blockCosts);
+    double imbalance = computeLoadImbalance(blockCosts, management);
+    if (imbalance <= 1.+tolerance) {
+        return false;
+    }
+    double newImbalance = computeLoadImbalance(blockCosts, redistribution.redistribute(management));
+    if (newImbalance >= imbalance) {
+        return false;
+    }
+    redistributeInPlace(multiBlocks, redistribution);
+    return true;
+}
+
 }  // namespace plb
 
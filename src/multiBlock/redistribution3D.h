@@ -32,9 +32,13 @@
 #include "parallelism/mpiManager.h"
 #include "core/globalDefs.h"
 #include "multiBlock/multiBlockManagement3D.h"
+#include <map>
+#include <vector>
 
 namespace plb {
 
+class MultiBlock3D;
+
 struct MultiBlockRedistribute3D {
     virtual ~MultiBlockRedistribute3D() { }
     virtual MultiBlockManagement3D redistribute(MultiBlockManagement3D const& original) const=0;
@@ -48,6 +52,55 @@ private:
     pluint rseed;
 };
 
+/// Attributes the blocks to the MPI processes according to their cost, for example
+///   the execution time measured with MultiBlock3D::toggleBlockCostMeasurement().
+/** The blocks are ordered along a Hilbert space-filling curve through their centers,
+ *  and the curve is cut into one piece of equal cost per MPI process, and each
+ *  piece again into one piece per shared-memory thread. Blocks which are close on
+ *  the curve are close in space, so that the blocks of a process form compact
+ *  clusters, and the amount of communication between processes remains low.
+ *
+ *  Blocks without a cost entry are attributed a cost proportional to their volume,
+ *  based on the average cost per cell of the other blocks.
+ */
+class MeasuredCostRedistribute3D : public MultiBlockRedistribute3D {
+public:
+    MeasuredCostRedistribute3D(std::map<plint,double> const& blockCosts_);
+    virtual MultiBlockManagement3D redistribute(MultiBlockManagement3D const& original) const;
+private:
+    std::map<plint,double> blockCosts;
+};
+
+/// Sum, over the multi-blocks and over all processes, of the costs measured for
+///   each block (see MultiBlock3D::toggleBlockCostMeasurement()). The multi-blocks
+///   must have the same block structure.
+std::map<plint,double> gatherBlockCosts(std::vector<MultiBlock3D*> const& multiBlocks);
+
+/// Ratio between the largest cost of an MPI process and the average cost per process,
+///   for the distribution of the blocks in management. Blocks without a cost entry
+///   are treated as in MeasuredCostRedistribute3D.
+double computeLoadImbalance(std::map<plint,double> const& blockCosts,
+                            MultiBlockManagement3D const& management);
+
+/// Move the atomic-blocks of the multi-blocks, with their content, to the processes
+///   obtained from redistribution.redistribute() for the first multi-block. The
+///   multi-blocks are modified in place, so that all references to them remain valid.
+/** The multi-blocks must have the same block structure, and the list must contain
+ *  all multi-blocks which are coupled by internal data processors. The processors
+ *  stored in the multi-blocks (see addInternalProcessor()) are re-created on the new
+ *  atomic-blocks; processors which were added to the atomic-blocks directly are lost.
+ *  The data is transferred with the BlockDataTransfer3D of the atomic-blocks, and
+ *  the content of MultiContainerBlock3D objects, which cannot be transferred, is reset.
+ */
+void redistributeInPlace( std::vector<MultiBlock3D*> multiBlocks,
+                          MultiBlockRedistribute3D const& redistribution );
+
+/// Redistribute the multi-blocks in place according to the block costs measured since
+///   the last call, with a MeasuredCostRedistribute3D, if the load imbalance exceeds
+///   1+tolerance and is reduced by the new distribution. The measured costs are reset.
+///   Returns true if the multi-blocks have been redistributed.
+bool rebalance(std::vector<MultiBlock3D*> multiBlocks, double tolerance=0.1);
+
 }  // namespace plb
 
 #endif  // REDISTRIBUTION_3D_H
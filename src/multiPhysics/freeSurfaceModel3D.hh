@@ -1679,7 +1679,7 @@ void FreeSurfaceComputeInterfaceLists3D<T,Descriptor>
     
     // Where interface cells have become fluid, neighboring cells must be prevented from
     //   being empty, because otherwise there's no interface cell between empty and fluid.
-    typename std::set<Node>::iterator iEle = param.interfaceToFluid().begin();
+    typename InterfaceLists<T,Descriptor>::NodeSet::iterator iEle = param.interfaceToFluid().begin();
     for (; iEle != param.interfaceToFluid().end(); ++iEle) {
         // The node here may belong to the 1st envelope.
         Node node = *iEle;
@@ -1726,7 +1726,7 @@ void FreeSurfaceIniInterfaceToAnyNodes3D<T,Descriptor>
     
     // 1. For interface->fluid nodes, update in the flag matrix,
     //   and compute and store mass excess from these cells.
-    typename std::set<Node>::iterator iEle = param.interfaceToFluid().begin();
+    typename InterfaceLists<T,Descriptor>::NodeSet::iterator iEle = param.interfaceToFluid().begin();
     for (; iEle != param.interfaceToFluid().end(); ++iEle) {
         Node node = *iEle;
         
@@ -1819,7 +1819,7 @@ void FreeSurfaceIniEmptyToInterfaceNodes3D<T,Descriptor>
     //   It is sufficient to do this is bulk+0.
     //   This loop performs read-only access to the lattice.
     plint i=0;
-    typename std::set<Node>::iterator iEle = param.emptyToInterface().begin();
+    typename InterfaceLists<T,Descriptor>::NodeSet::iterator iEle = param.emptyToInterface().begin();
     for (; iEle != param.emptyToInterface().end(); ++iEle, ++i ) 
     {
         Node node = *iEle;
@@ -1973,13 +1973,13 @@ void FreeSurfaceEqualMassExcessReDistribution3D<T,Descriptor>
         ::processGenericBlocks(Box3D domain,std::vector<AtomicBlock3D*> atomicBlocks)
 {
     typedef Descriptor<T> D;
-    typedef typename InterfaceLists<T,Descriptor>::Node Node;
     using namespace freeSurfaceFlag;
     FreeSurfaceProcessorParam3D<T,Descriptor> param(atomicBlocks);
 
     Box3D originalDomain(domain);
         
-    typename std::map<Node,T>::iterator iEle = param.massExcess().begin();
+    std::vector<int> indX, indY, indZ;
+    typename InterfaceLists<T,Descriptor>::NodeMap::iterator iEle = param.massExcess().begin();
     for (; iEle != param.massExcess().end(); ++iEle) {
         Array<plint,3> node = iEle->first;
         plint iX = node[0];
@@ -1988,7 +1988,9 @@ void FreeSurfaceEqualMassExcessReDistribution3D<T,Descriptor>
 
         // Check for valid interface neighbors to re-distribute mass
         if (contained(iX,iY,iZ,domain.enlarge(1)))  {
-            std::vector<int> indX, indY, indZ;
+            indX.clear();
+            indY.clear();
+            indZ.clear();
             plint numValidNeighbors = 0;
 
             // Check for interface neighbors in the LB directions.
@@ -39,6 +39,8 @@
 #include <vector>
 #include <set>
 #include <string>
+#include <utility>
+#include <algorithm>
 
 namespace plb {
 
@@ -122,18 +124,163 @@ std::vector<MultiBlock3D*> aggregateFreeSurfaceParams (
     return aggregation;
 }
 
+/// Set of nodes, stored in a flat vector which is sorted lazily.
+/** Nodes inserted in increasing order (the usual case when the domain is traversed
+ *  lexicographically) are appended without further cost. Out-of-order insertions and
+ *  removals are buffered and merged before the next access to the content. The
+ *  iteration order is the same as for a std::set. The memory is kept by clear(),
+ *  so that the lists are recycled from one time step to the next.
+ */
+template<typename Node>
+class FlatNodeSet {
+public:
+    typedef typename std::vector<Node>::const_iterator iterator;
+    typedef typename std::vector<Node>::const_iterator const_iterator;
+public:
+    FlatNodeSet()
+        : sorted(true)
+    { }
+    void insert(Node const& node) {
+        if (!removed.empty()) {
+            normalize();
+        }
+        if (nodes.empty() || nodes.back() < node) {
+            nodes.push_back(node);
+        }
+        else if (!(nodes.back() == node)) {
+            nodes.push_back(node);
+            sorted = false;
+        }
+    }
+    void erase(Node const& node) {
+        removed.push_back(node);
+    }
+    void clear() {
+        nodes.clear();
+        removed.clear();
+        sorted = true;
+    }
+    pluint size() const {
+        normalize();
+        return nodes.size();
+    }
+    bool empty() const {
+        return size()==0;
+    }
+    const_iterator begin() const {
+        normalize();
+        return nodes.begin();
+    }
+    const_iterator end() const {
+        normalize();
+        return nodes.end();
+    }
+private:
+    void normalize() const {
+        if (!sorted) {
+            std::sort(nodes.begin(), nodes.end());
+            nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+            sorted = true;
+        }
+        if (!removed.empty()) {
+            std::sort(removed.begin(), removed.end());
+            typename std::vector<Node>::iterator out = nodes.begin();
+            typename std::vector<Node>::const_iterator rem = removed.begin();
+            for (typename std::vector<Node>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+                while (rem != removed.end() && *rem < *it) {
+                    ++rem;
+                }
+                if (rem == removed.end() || !(*rem == *it)) {
+                    *out = *it;
+                    ++out;
+                }
+            }
+            nodes.erase(out, nodes.end());
+            removed.clear();
+        }
+    }
+private:
+    mutable std::vector<Node> nodes;
+    mutable std::vector<Node> removed;
+    mutable bool sorted;
+};
+
+/// Map from nodes to values, stored in a flat vector which is sorted lazily.
+/** As for a std::map, the value of the first insertion of a node is kept, and
+ *  the nodes are traversed in increasing order. The memory is kept by clear().
+ */
+template<typename Node, typename V>
+class FlatNodeMap {
+public:
+    typedef std::pair<Node,V> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+public:
+    FlatNodeMap()
+        : sorted(true)
+    { }
+    void insert(value_type const& entry) {
+        if (entries.empty() || entries.back().first < entry.first) {
+            entries.push_back(entry);
+        }
+        else if (!(entries.back().first == entry.first)) {
+            entries.push_back(entry);
+            sorted = false;
+        }
+    }
+    void clear() {
+        entries.clear();
+        sorted = true;
+    }
+    pluint size() {
+        normalize();
+        return entries.size();
+    }
+    bool empty() const {
+        return entries.empty();
+    }
+    iterator begin() {
+        normalize();
+        return entries.begin();
+    }
+    iterator end() {
+        normalize();
+        return entries.end();
+    }
+private:
+    static bool lessKey(value_type const& A, value_type const& B) {
+        return A.first < B.first;
+    }
+    static bool equalKey(value_type const& A, value_type const& B) {
+        return A.first == B.first;
+    }
+    void normalize() {
+        if (!sorted) {
+            // The stable sort keeps the first insertion of a node in front.
+            std::stable_sort(entries.begin(), entries.end(), lessKey);
+            entries.erase(std::unique(entries.begin(), entries.end(), equalKey), entries.end());
+            sorted = true;
+        }
+    }
+private:
+    std::vector<value_type> entries;
+    bool sorted;
+};
+
 /// Data structure for holding lists of cells along the free surface in an AtomicContainerBlock.
 template< typename T,template<typename U> class Descriptor>
 struct InterfaceLists : public ContainerBlockData {
     typedef Array<plint,Descriptor<T>::d> Node;
+    typedef FlatNodeSet<Node> NodeSet;
+    typedef FlatNodeMap<Node,T> NodeMap;
     /// Holds all nodes which have excess mass.
-    std::map<Node,T> massExcess;
+    NodeMap massExcess;
     /// Holds all nodes that need to change status from interface to fluid.
-    std::set<Node>   interfaceToFluid;
+    NodeSet interfaceToFluid;
     /// Holds all nodes that need to change status from interface to empty.
-    std::set<Node>   interfaceToEmpty;
+    NodeSet interfaceToEmpty;
     /// Holds all nodes that need to change status from empty to interface.
-    std::set<Node>   emptyToInterface;
+    NodeSet emptyToInterface;
 
     virtual InterfaceLists<T,Descriptor>* clone() const {
         return new InterfaceLists<T,Descriptor>(*this);
@@ -616,10 +763,10 @@ public:
         return(divergence);
     }
 
-    std::map<Node,T>& massExcess() { return interfaceLists_ -> massExcess; }
-    std::set<Node>& interfaceToFluid() { return interfaceLists_ -> interfaceToFluid; }
-    std::set<Node>& interfaceToEmpty() { return interfaceLists_ -> interfaceToEmpty; }
-    std::set<Node>& emptyToInterface() { return interfaceLists_ -> emptyToInterface; }
+    typename InterfaceLists<T,Descriptor>::NodeMap& massExcess() { return interfaceLists_ -> massExcess; }
+    typename InterfaceLists<T,Descriptor>::NodeSet& interfaceToFluid() { return interfaceLists_ -> interfaceToFluid; }
+    typename InterfaceLists<T,Descriptor>::NodeSet& interfaceToEmpty() { return interfaceLists_ -> interfaceToEmpty; }
+    typename InterfaceLists<T,Descriptor>::NodeSet& emptyToInterface() { return interfaceLists_ -> emptyToInterface; }
 
     BlockLattice3D<T,Descriptor>* latticeP() { return fluid_; }
     ScalarField3D<T>* rhoBarP() { return rhoBar_; }
@@ -40,17 +40,24 @@ public:
     virtual bool isExtrapolated() const;
     virtual void prepareCell (
             Dot3D const& cellLocation, AtomicContainerBlock3D& container );
+    virtual bool updateCells (
+            std::vector<Dot3D> const& cellLocations, AtomicContainerBlock3D& container );
     virtual void boundaryCompletion (
             AtomicBlock3D& lattice, AtomicContainerBlock3D& container,
             std::vector<AtomicBlock3D *> const& args );
     virtual ContainerBlockData* generateOffLatticeInfo() const;
     virtual Array<T,3> getLocalForce(AtomicContainerBlock3D& container) const;
+public:
+    class GuoOffLatticeInfo3D;
 private:
+    /// Append cellLocation to the dry nodes of info if it is a solid cell with fluid neighbors.
+    void computeDryNode (
+            Dot3D const& cellLocation, Dot3D const& offset, GuoOffLatticeInfo3D& info );
     void cellCompletion (
             BlockLattice3D<T,Descriptor>& lattice,
             Dot3D const& guoNode,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections,
-            std::vector<plint> const& dryNodeIds, Dot3D const& absoluteOffset,
+            std::pair<int,int> const* dryNodeFluidDirections,
+            plint const* dryNodeIds, plint numDirections, Dot3D const& absoluteOffset,
             Array<T,3>& localForce, std::vector<AtomicBlock3D *> const& args );
     void computeRhoBarJPiNeqAlongDirection (
               BlockLattice3D<T,Descriptor> const& lattice, Dot3D const& guoNode,
@@ -72,20 +79,44 @@ private:
     bool useAllDirections;
 public:
     /// Store the location of wall nodes, as well as the pattern of missing vs. known
-    ///   populations.
+    ///   populations. The fluid directions and triangle ids of all wall nodes are stored
+    ///   contiguously: those of dry node iDry are the entries getDirectionOffsets()[iDry]
+    ///   to getDirectionOffsets()[iDry+1]-1.
     class GuoOffLatticeInfo3D : public ContainerBlockData {
     public:
+        GuoOffLatticeInfo3D()
+            : directionOffsets(1, 0)
+        { }
+        /// Append a dry node, together with its numDirections fluid directions
+        ///   and triangle ids.
+        void addDryNode( Dot3D const& dryNode, std::pair<int,int> const* fluidDirections,
+                         plint const* ids, plint numDirections )
+        {
+            dryNodes.push_back(dryNode);
+            dryNodeFluidDirections.insert(dryNodeFluidDirections.end(), fluidDirections, fluidDirections+numDirections);
+            dryNodeIds.insert(dryNodeIds.end(), ids, ids+numDirections);
+            directionOffsets.push_back((plint)dryNodeIds.size());
+        }
+        /// Exchange the dry nodes and their data with the ones of rhs.
+        void swapDryNodes(GuoOffLatticeInfo3D& rhs) {
+            dryNodes.swap(rhs.dryNodes);
+            directionOffsets.swap(rhs.directionOffsets);
+            dryNodeFluidDirections.swap(rhs.dryNodeFluidDirections);
+            dryNodeIds.swap(rhs.dryNodeIds);
+        }
+        plint                                                   getNumDirections(plint iDry) const
+        { return directionOffsets[iDry+1]-directionOffsets[iDry]; }
+        std::pair<int,int> const*                               getDryNodeFluidDirections(plint iDry) const
+        { return &dryNodeFluidDirections[directionOffsets[iDry]]; }
+        plint const*                                            getDryNodeIds(plint iDry) const
+        { return &dryNodeIds[directionOffsets[iDry]]; }
         std::vector<Dot3D> const&                               getDryNodes() const
         { return dryNodes; }
-        std::vector<Dot3D>&                                     getDryNodes()
-        { return dryNodes; }
-        std::vector<std::vector<std::pair<int,int> > > const&   getDryNodeFluidDirections() const
-        { return dryNodeFluidDirections; }
-        std::vector<std::vector<std::pair<int,int> > >&         getDryNodeFluidDirections()
+        std::vector<plint> const&                               getDirectionOffsets() const
+        { return directionOffsets; }
+        std::vector<std::pair<int,int> > const&                 getDryNodeFluidDirections() const
         { return dryNodeFluidDirections; }
-        std::vector<std::vector<plint> > const&                 getDryNodeIds() const
-        { return dryNodeIds; }
-        std::vector<std::vector<plint> >&                       getDryNodeIds()
+        std::vector<plint> const&                               getDryNodeIds() const
         { return dryNodeIds; }
         std::vector<bool> const&                                getIsConnected() const
         { return isConnected; }
@@ -99,9 +130,10 @@ public:
             return new GuoOffLatticeInfo3D(*this);
         }
     private:
-        std::vector<Dot3D> dryNodes;
-        std::vector<std::vector<std::pair<int,int> > >   dryNodeFluidDirections;
-        std::vector<std::vector<plint> >                 dryNodeIds;
+        std::vector<Dot3D>                               dryNodes;
+        std::vector<plint>                               directionOffsets;
+        std::vector<std::pair<int,int> >                 dryNodeFluidDirections;
+        std::vector<plint>                               dryNodeIds;
         std::vector<bool>                                isConnected;
         Array<T,3>                                       localForce;
     };
@@ -144,8 +176,8 @@ private:
     void cellCompletion (
             BlockLattice3D<T,Descriptor>& lattice,
             Dot3D const& guoNode,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections,
-            std::vector<plint> const& dryNodeIds, Dot3D const& absoluteOffset,
+            std::pair<int,int> const* dryNodeFluidDirections,
+            plint const* dryNodeIds, plint numDirections, Dot3D const& absoluteOffset,
             const std::pair<int,int> &xDerivDirAndOrder, 
             const std::pair<int,int> &yDerivDirAndOrder, 
             const std::pair<int,int> &zDerivDirAndOrder,
@@ -157,18 +189,27 @@ public:
     ///   populations.
     class GuoOffLatticeInfo3D : public ContainerBlockData {
     public:
+        GuoOffLatticeInfo3D()
+            : directionOffsets(1, 0)
+        { }
+        /// Append a dry node, together with its numDirections fluid directions
+        ///   and triangle ids.
+        void addDryNode( Dot3D const& dryNode, std::pair<int,int> const* fluidDirections,
+                         plint const* ids, plint numDirections )
+        {
+            dryNodes.push_back(dryNode);
+            dryNodeFluidDirections.insert(dryNodeFluidDirections.end(), fluidDirections, fluidDirections+numDirections);
+            dryNodeIds.insert(dryNodeIds.end(), ids, ids+numDirections);
+            directionOffsets.push_back((plint)dryNodeIds.size());
+        }
+        plint                                                   getNumDirections(plint iDry) const
+        { return directionOffsets[iDry+1]-directionOffsets[iDry]; }
+        std::pair<int,int> const*                               getDryNodeFluidDirections(plint iDry) const
+        { return &dryNodeFluidDirections[directionOffsets[iDry]]; }
+        plint const*                                            getDryNodeIds(plint iDry) const
+        { return &dryNodeIds[directionOffsets[iDry]]; }
         std::vector<Dot3D> const&                               getDryNodes() const
         { return dryNodes; }
-        std::vector<Dot3D>&                                     getDryNodes()
-        { return dryNodes; }
-        std::vector<std::vector<std::pair<int,int> > > const&   getDryNodeFluidDirections() const
-        { return dryNodeFluidDirections; }
-        std::vector<std::vector<std::pair<int,int> > >&         getDryNodeFluidDirections()
-        { return dryNodeFluidDirections; }
-        std::vector<std::vector<plint> > const&                 getDryNodeIds() const
-        { return dryNodeIds; }
-        std::vector<std::vector<plint> >&                       getDryNodeIds()
-        { return dryNodeIds; }
         std::vector<std::pair<int,int> > const&                 getXderivDirAndOrder() const
         { return xDerivDirAndOrder; }
         std::vector<std::pair<int,int> >&                       getXderivDirAndOrder()
@@ -189,9 +230,10 @@ public:
             return new GuoOffLatticeInfo3D(*this);
         }
     private:
-        std::vector<Dot3D> dryNodes;
-        std::vector<std::vector<std::pair<int,int> > >   dryNodeFluidDirections;
-        std::vector<std::vector<plint> >                 dryNodeIds;
+        std::vector<Dot3D>                               dryNodes;
+        std::vector<plint>                               directionOffsets;
+        std::vector<std::pair<int,int> >                 dryNodeFluidDirections;
+        std::vector<plint>                               dryNodeIds;
         std::vector<std::pair<int,int> > xDerivDirAndOrder, yDerivDirAndOrder, zDerivDirAndOrder;
         Array<T,3>                                       localForce;
     };
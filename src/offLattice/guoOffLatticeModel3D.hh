@@ -86,10 +86,54 @@ void GuoOffLatticeModel3D<T,Descriptor>::prepareCell (
         Dot3D const& cellLocation,
         AtomicContainerBlock3D& container )
 {
-    Dot3D offset = container.getLocation();
     GuoOffLatticeInfo3D* info =
         dynamic_cast<GuoOffLatticeInfo3D*>(container.getData());
     PLB_ASSERT( info );
+    computeDryNode(cellLocation, container.getLocation(), *info);
+}
+
+template<typename T, template<typename U> class Descriptor>
+bool GuoOffLatticeModel3D<T,Descriptor>::updateCells (
+        std::vector<Dot3D> const& cellLocations,
+        AtomicContainerBlock3D& container )
+{
+    GuoOffLatticeInfo3D* info =
+        dynamic_cast<GuoOffLatticeInfo3D*>(container.getData());
+    PLB_ASSERT( info );
+    Dot3D offset = container.getLocation();
+    std::vector<Dot3D> const& dryNodes = info->getDryNodes();
+    // The dry nodes and the cells to update are both sorted in x-major order. They
+    //   are merged such that the dry nodes end up in the same order as after a call
+    //   to prepareCell on every cell.
+    GuoOffLatticeInfo3D updatedInfo;
+    plint numDryNodes = (plint)dryNodes.size();
+    plint iDry = 0;
+    for (pluint iCell=0; iCell<cellLocations.size(); ++iCell) {
+        Dot3D const& cellLocation = cellLocations[iCell];
+        for (; iDry<numDryNodes && dryNodes[iDry]<cellLocation; ++iDry) {
+            updatedInfo.addDryNode (
+                    dryNodes[iDry], info->getDryNodeFluidDirections(iDry),
+                    info->getDryNodeIds(iDry), info->getNumDirections(iDry) );
+        }
+        if (iDry<numDryNodes && dryNodes[iDry]==cellLocation) {
+            ++iDry;
+        }
+        computeDryNode(cellLocation, offset, updatedInfo);
+    }
+    for (; iDry<numDryNodes; ++iDry) {
+        updatedInfo.addDryNode (
+                dryNodes[iDry], info->getDryNodeFluidDirections(iDry),
+                info->getDryNodeIds(iDry), info->getNumDirections(iDry) );
+    }
+    info->swapDryNodes(updatedInfo);
+    return true;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void GuoOffLatticeModel3D<T,Descriptor>::computeDryNode (
+        Dot3D const& cellLocation, Dot3D const& offset,
+        GuoOffLatticeInfo3D& info )
+{
     std::vector<LiquidNeighbor> liquidNeighbors;
     if (this->isSolid(cellLocation+offset)) {
         for (int iNeighbor=0; iNeighbor<NextNeighbor<T>::numNeighbors; ++iNeighbor) {
@@ -135,7 +179,6 @@ void GuoOffLatticeModel3D<T,Descriptor>::prepareCell (
             }
         }
         if (!liquidNeighbors.empty()) {
-            info->getDryNodes().push_back(cellLocation);
             std::sort(liquidNeighbors.begin(), liquidNeighbors.end());
             std::vector<std::pair<int,int> > neighborDepthPairs;
             std::vector<plint> ids;
@@ -150,8 +193,7 @@ void GuoOffLatticeModel3D<T,Descriptor>::prepareCell (
                 neighborDepthPairs.push_back(std::make_pair(liquidNeighbors[i].iNeighbor, liquidNeighbors[i].depth));
                 ids.push_back(liquidNeighbors[i].iTriangle);
             }
-            info->getDryNodeFluidDirections().push_back(neighborDepthPairs);
-            info->getDryNodeIds().push_back(ids);
+            info.addDryNode(cellLocation, &neighborDepthPairs[0], &ids[0], (plint)ids.size());
         }
     }
 }
@@ -186,11 +228,7 @@ void GuoOffLatticeModel3D<T,Descriptor>::boundaryCompletion (
     PLB_ASSERT( info );
     std::vector<Dot3D> const&
         dryNodes = info->getDryNodes();
-    std::vector<std::vector<std::pair<int,int> > > const&
-        dryNodeFluidDirections = info->getDryNodeFluidDirections();
-    std::vector<std::vector<plint> > const&
-        dryNodeIds = info->getDryNodeIds();
-    if (dryNodes.size() != dryNodeFluidDirections.size()) {
+    if (dryNodes.size()+1 != info->getDirectionOffsets().size()) {
         global::plbErrors().registerError("Error in the Guo off-lattice model boundary completion.");
     }
 
@@ -198,10 +236,11 @@ void GuoOffLatticeModel3D<T,Descriptor>::boundaryCompletion (
 
     Array<T,3>& localForce = info->getLocalForce();
     localForce.resetToZero();
-    for (pluint iDry=0; iDry<dryNodes.size(); ++iDry) {
+    for (plint iDry=0; iDry<(plint)dryNodes.size(); ++iDry) {
         cellCompletion (
-            lattice, dryNodes[iDry], dryNodeFluidDirections[iDry],
-            dryNodeIds[iDry], absoluteOffset, localForce, args );
+            lattice, dryNodes[iDry], info->getDryNodeFluidDirections(iDry),
+            info->getDryNodeIds(iDry), info->getNumDirections(iDry),
+            absoluteOffset, localForce, args );
     }
 }
 
@@ -213,8 +252,8 @@ public:
         OffLatticeModel3D<T,Array<T,3> >& model_,
         BlockLattice3D<T,Descriptor>& lattice_,
         Dot3D const& guoNode_,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-        std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+        std::pair<int,int> const* dryNodeFluidDirections_,
+        plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
         Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
         bool computeStat_, bool secondOrder_);
     virtual ~GuoAlgorithm3D() { }
@@ -233,8 +272,8 @@ protected:
     BlockLattice3D<T,Descriptor>& lattice;
     Dot3D const& guoNode;
     Cell<T,Descriptor>& cell;
-    std::vector<std::pair<int,int> > const& dryNodeFluidDirections;
-    std::vector<plint> const& dryNodeIds;
+    std::pair<int,int> const* dryNodeFluidDirections;
+    plint const* dryNodeIds;
     Dot3D absoluteOffset;
     Array<T,3>& localForce;
     std::vector<AtomicBlock3D *> const& args;
@@ -254,8 +293,8 @@ GuoAlgorithm3D<T,Descriptor>::GuoAlgorithm3D (
             OffLatticeModel3D<T,Array<T,3> >& model_,
             BlockLattice3D<T,Descriptor>& lattice_,
             Dot3D const& guoNode_,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-            std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+            std::pair<int,int> const* dryNodeFluidDirections_,
+            plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
             Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
             bool computeStat_, bool secondOrder_ )
     : model(model_),
@@ -267,10 +306,10 @@ GuoAlgorithm3D<T,Descriptor>::GuoAlgorithm3D (
       absoluteOffset(absoluteOffset_),
       localForce(localForce_),
       args(args_),
+      numDirections(numDirections_),
       computeStat(computeStat_),
       secondOrder(secondOrder_)
 {
-    numDirections = (plint)dryNodeFluidDirections.size();
     weights.resize(numDirections);
     rhoBarVect.resize(numDirections);
     jVect.resize(numDirections);
@@ -381,8 +420,8 @@ public:
         OffLatticeModel3D<T,Array<T,3> >& model_,
         BlockLattice3D<T,Descriptor>& lattice_,
         Dot3D const& guoNode_,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-        std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+        std::pair<int,int> const* dryNodeFluidDirections_,
+        plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
         Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
         bool computeStat_, bool secondOrder_ );
     virtual void extrapolateVariables (
@@ -401,12 +440,12 @@ GuoPiNeqAlgorithm3D<T,Descriptor>::GuoPiNeqAlgorithm3D (
             OffLatticeModel3D<T,Array<T,3> >& model_,
             BlockLattice3D<T,Descriptor>& lattice_,
             Dot3D const& guoNode_,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-            std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+            std::pair<int,int> const* dryNodeFluidDirections_,
+            plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
             Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
             bool computeStat_, bool secondOrder_ )
     : GuoAlgorithm3D<T,Descriptor> (
-            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_,
+            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_, numDirections_,
             absoluteOffset_, localForce_, args_, computeStat_, secondOrder_ )
 {
     PiNeqVect.resize(this->numDirections);
@@ -559,8 +598,8 @@ public:
         OffLatticeModel3D<T,Array<T,3> >& model_,
         BlockLattice3D<T,Descriptor>& lattice_,
         Dot3D const& guoNode_,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-        std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+        std::pair<int,int> const* dryNodeFluidDirections_,
+        plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
         Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_, bool computeStat_, bool secondOrder_ );
     virtual void extrapolateVariables (
               Dot3D const& fluidDirection, int depth, Array<T,3> const& wallNode, T delta,
@@ -578,12 +617,12 @@ GuoOffPopAlgorithm3D<T,Descriptor>::GuoOffPopAlgorithm3D (
             OffLatticeModel3D<T,Array<T,3> >& model_,
             BlockLattice3D<T,Descriptor>& lattice_,
             Dot3D const& guoNode_,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-            std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+            std::pair<int,int> const* dryNodeFluidDirections_,
+            plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
             Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
             bool computeStat_, bool secondOrder_ )
     : GuoAlgorithm3D<T,Descriptor> (
-            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_,
+            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_, numDirections_,
             absoluteOffset_, localForce_, args_, computeStat_, secondOrder_ )
 {
     fNeqVect.resize(this->numDirections);
@@ -747,20 +786,20 @@ template<typename T, template<typename U> class Descriptor>
 void GuoOffLatticeModel3D<T,Descriptor>::cellCompletion (
         BlockLattice3D<T,Descriptor>& lattice,
         Dot3D const& guoNode,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections,
-        std::vector<plint> const& dryNodeIds, Dot3D const& absoluteOffset,
+        std::pair<int,int> const* dryNodeFluidDirections,
+        plint const* dryNodeIds, plint numDirections, Dot3D const& absoluteOffset,
         Array<T,3>& localForce, std::vector<AtomicBlock3D *> const& args )
 {
     GuoAlgorithm3D<T,Descriptor>* algorithm=0;
     if (this->usesRegularizedModel()) {
         algorithm = new GuoPiNeqAlgorithm3D<T,Descriptor> (
                 *this, lattice, guoNode, dryNodeFluidDirections,
-                dryNodeIds, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder() );
+                dryNodeIds, numDirections, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder() );
     }
     else {
         algorithm = new GuoOffPopAlgorithm3D<T,Descriptor> (
                 *this, lattice, guoNode, dryNodeFluidDirections,
-                dryNodeIds, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder() );
+                dryNodeIds, numDirections, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder() );
     }
     bool ok =
         algorithm -> computeNeighborData();
@@ -780,8 +819,8 @@ public:
         OffLatticeModel3D<T,Array<T,3> >& model_,
         BlockLattice3D<T,Descriptor>& lattice_,
         Dot3D const& guoNode_,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-        std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+        std::pair<int,int> const* dryNodeFluidDirections_,
+        plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
         Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
         bool computeStat_, bool secondOrder_ );
     virtual void extrapolateVariables (
@@ -797,12 +836,12 @@ GuoDefineVelocityAlgorithm3D<T,Descriptor>::GuoDefineVelocityAlgorithm3D (
             OffLatticeModel3D<T,Array<T,3> >& model_,
             BlockLattice3D<T,Descriptor>& lattice_,
             Dot3D const& guoNode_,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-            std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+            std::pair<int,int> const* dryNodeFluidDirections_,
+            plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
             Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
             bool computeStat_, bool secondOrder_ )
     : GuoAlgorithm3D<T,Descriptor> (
-            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_,
+            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_, numDirections_,
             absoluteOffset_, localForce_, args_, computeStat_, secondOrder_ )
 { }
 
@@ -994,8 +1033,8 @@ public:
         OffLatticeModel3D<T,Array<T,3> >& model_,
         BlockLattice3D<T,Descriptor>& lattice_,
         Dot3D const& guoNode_,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-        std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+        std::pair<int,int> const* dryNodeFluidDirections_,
+        plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
         Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
         bool computeStat_, bool secondOrder_, 
         std::pair<int,int> const &xDerivDirAndOrder, 
@@ -1033,15 +1072,15 @@ GuoFdCompletionAlgorithm3D<T,Descriptor>::GuoFdCompletionAlgorithm3D (
             OffLatticeModel3D<T,Array<T,3> >& model_,
             BlockLattice3D<T,Descriptor>& lattice_,
             Dot3D const& guoNode_,
-            std::vector<std::pair<int,int> > const& dryNodeFluidDirections_,
-            std::vector<plint> const& dryNodeIds_, Dot3D const& absoluteOffset_,
+            std::pair<int,int> const* dryNodeFluidDirections_,
+            plint const* dryNodeIds_, plint numDirections_, Dot3D const& absoluteOffset_,
             Array<T,3>& localForce_, std::vector<AtomicBlock3D *> const& args_,
             bool computeStat_, bool secondOrder_,
             std::pair<int,int> const &xDerivDirAndOrder_, 
             std::pair<int,int> const &yDerivDirAndOrder_, 
             std::pair<int,int> const &zDerivDirAndOrder_  )
     : GuoAlgorithm3D<T,Descriptor> (
-            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_,
+            model_, lattice_, guoNode_, dryNodeFluidDirections_, dryNodeIds_, numDirections_,
             absoluteOffset_, localForce_, args_, computeStat_, secondOrder_ ),
     xDerivDirAndOrder(xDerivDirAndOrder_), yDerivDirAndOrder(yDerivDirAndOrder_), 
     zDerivDirAndOrder(zDerivDirAndOrder_)
@@ -1514,7 +1553,6 @@ void GuoOffLatticeFdModel3D<T,Descriptor>::prepareCell (
         }
 
         if (!liquidNeighbors.empty()) {
-            info->getDryNodes().push_back(cellLocation);
             std::sort(liquidNeighbors.begin(), liquidNeighbors.end());
             std::vector<std::pair<int,int> > neighborDepthPairs;
             std::vector<plint> ids;
@@ -1536,8 +1574,7 @@ void GuoOffLatticeFdModel3D<T,Descriptor>::prepareCell (
                 neighborDepthPairs.push_back(std::make_pair(liquidNeighbors[i].iNeighbor, liquidNeighbors[i].depth));
                 ids.push_back(liquidNeighbors[i].iTriangle);
             }
-            info->getDryNodeFluidDirections().push_back(neighborDepthPairs);
-            info->getDryNodeIds().push_back(ids);
+            info->addDryNode(cellLocation, &neighborDepthPairs[0], &ids[0], (plint)ids.size());
         }
     }
 }
@@ -1572,17 +1609,13 @@ void GuoOffLatticeFdModel3D<T,Descriptor>::boundaryCompletion (
     PLB_ASSERT( info );
     std::vector<Dot3D> const&
         dryNodes = info->getDryNodes();
-    std::vector<std::vector<std::pair<int,int> > > const&
-        dryNodeFluidDirections = info->getDryNodeFluidDirections();
-    std::vector<std::vector<plint> > const&
-        dryNodeIds = info->getDryNodeIds();
     std::vector<std::pair<int,int> > const&
         xDerivDirAndOrder = info->getXderivDirAndOrder();
     std::vector<std::pair<int,int> > const&
         yDerivDirAndOrder = info->getYderivDirAndOrder();
     std::vector<std::pair<int,int> > const&
         zDerivDirAndOrder = info->getZderivDirAndOrder();
-    if (dryNodes.size() != dryNodeFluidDirections.size()) {
+    if (dryNodes.size() != xDerivDirAndOrder.size()) {
         global::plbErrors().registerError("Error in the Guo off-lattice Fd model boundary completion.");
     }
 
@@ -1590,10 +1623,10 @@ void GuoOffLatticeFdModel3D<T,Descriptor>::boundaryCompletion (
 
     Array<T,3>& localForce = info->getLocalForce();
     localForce.resetToZero();
-    for (pluint iDry=0; iDry<dryNodes.size(); ++iDry) {
+    for (plint iDry=0; iDry<(plint)dryNodes.size(); ++iDry) {
         cellCompletion (
-            lattice, dryNodes[iDry], dryNodeFluidDirections[iDry],
-            dryNodeIds[iDry], absoluteOffset, 
+            lattice, dryNodes[iDry], info->getDryNodeFluidDirections(iDry),
+            info->getDryNodeIds(iDry), info->getNumDirections(iDry), absoluteOffset, 
             xDerivDirAndOrder[iDry], yDerivDirAndOrder[iDry], zDerivDirAndOrder[iDry], localForce, args );
     }
 }
@@ -1602,8 +1635,8 @@ template<typename T, template<typename U> class Descriptor>
 void GuoOffLatticeFdModel3D<T,Descriptor>::cellCompletion (
         BlockLattice3D<T,Descriptor>& lattice,
         Dot3D const& guoNode,
-        std::vector<std::pair<int,int> > const& dryNodeFluidDirections,
-        std::vector<plint> const& dryNodeIds, Dot3D const& absoluteOffset,
+        std::pair<int,int> const* dryNodeFluidDirections,
+        plint const* dryNodeIds, plint numDirections, Dot3D const& absoluteOffset,
         const std::pair<int,int> &xDerivDirAndOrder, 
         const std::pair<int,int> &yDerivDirAndOrder, 
         const std::pair<int,int> &zDerivDirAndOrder,
@@ -1613,12 +1646,12 @@ void GuoOffLatticeFdModel3D<T,Descriptor>::cellCompletion (
     if (this->getDefineVelocity()) {
         algorithm = new GuoDefineVelocityAlgorithm3D<T,Descriptor> (
                 *this, lattice, guoNode, dryNodeFluidDirections,
-                dryNodeIds, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder() );
+                dryNodeIds, numDirections, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder() );
     }
     else {
         algorithm = new GuoFdCompletionAlgorithm3D<T,Descriptor> (
                 *this, lattice, guoNode, dryNodeFluidDirections,
-                dryNodeIds, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder(),
+                dryNodeIds, numDirections, absoluteOffset, localForce, args, this->computesStat(), this->usesSecondOrder(),
                 xDerivDirAndOrder, yDerivDirAndOrder, zDerivDirAndOrder );
     }
     bool ok =
@@ -36,6 +36,7 @@
 #include "offLattice/voxelizer.h"
 #include "offLattice/makeSparse3D.h"
 #include "offLattice/triangleHash.h"
+#include "offLattice/triangleBvh.h"
 #include "offLattice/offLatticeBoundaryProcessor3D.h"
 #include "offLattice/offLatticeBoundaryProfiles3D.h"
 #include "offLattice/offLatticeBoundaryCondition3D.h"
@@ -35,6 +35,7 @@
 #include "offLattice/voxelizer.hh"
 #include "offLattice/makeSparse3D.hh"
 #include "offLattice/triangleHash.hh"
+#include "offLattice/triangleBvh.hh"
 #include "offLattice/offLatticeBoundaryProcessor3D.hh"
 #include "offLattice/offLatticeBoundaryProfiles3D.hh"
 #include "offLattice/offLatticeBoundaryCondition3D.hh"
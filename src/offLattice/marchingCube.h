@@ -71,6 +71,29 @@ template<typename T, class Function>
 void isoSurfaceMarchingCube (
         std::vector<typename TriangleSet<T>::Triangle>& triangles, MultiBlock3D& block, Function const& function, Box3D const& domain );
 
+/// Get an iso-surface by means of the marching cube algorithm, and write it to a binary STL file.
+/** Contrary to isoSurfaceMarchingCube, the triangles are not gathered on the main processor:
+  * every process writes the triangles of its own blocks into the shared file, at an offset
+  * given by an exclusive scan of the number of triangles over the processes. The triangles
+  * are not welded across block boundaries, and their order in the file depends on the
+  * parallelization. As in parallelIO::writeRawData, a file name without path is placed in
+  * the output directory. The vertices are scaled and shifted as in TriangleSet::writeBinarySTL.
+  * Returns the total number of triangles.
+  **/
+template<typename T>
+plint writeIsoSurfaceBinarySTL (
+        std::string fname, std::vector<MultiBlock3D*> surfDefinitionArgs,
+        IsoSurfaceDefinition3D<T>* isoSurfaceDefinition, Box3D const& domain,
+        std::vector<plint> surfaceIds = std::vector<plint>(),
+        T scale = (T) 1, Array<T,3> const& offset = Array<T,3>((T) 0, (T) 0, (T) 0) );
+
+/// Write the iso-surfaces of a scalar-field to a binary STL file, without gathering the triangles.
+template<typename T>
+plint writeIsoSurfaceBinarySTL (
+        std::string fname, MultiScalarField3D<T>& scalarField,
+        std::vector<T> const& isoLevels, Box3D const& domain,
+        T scale = (T) 1, Array<T,3> const& offset = Array<T,3>((T) 0, (T) 0, (T) 0) );
+
 template<typename T, template<typename U> class Descriptor>
 TriangleSet<T> vofToTriangles(MultiScalarField3D<T>& scalarField, T threshold, Box3D domain);
 
@@ -29,7 +29,10 @@
 #include "core/util.h"
 #include "offLattice/marchingCube.h"
 #include "latticeBoltzmann/geometricOperationTemplates.h"
+#include "io/mpiParallelIO.h"
 #include <limits>
+#include <cstdio>
+#include <cstring>
 
 namespace plb {
 
@@ -795,6 +798,123 @@ void isoSurfaceMarchingCube (
     isoSurfaceMarchingCube(triangles, surfDefinitionArgs, isoSurface, domain, surfaceIds);
 }
 
+template<typename T>
+plint writeIsoSurfaceBinarySTL (
+        std::string fname, std::vector<MultiBlock3D*> surfDefinitionArgs,
+        IsoSurfaceDefinition3D<T>* isoSurfaceDefinition, Box3D const& domain,
+        std::vector<plint> surfaceIds, T scale, Array<T,3> const& offset )
+{
+    typedef typename TriangleSet<T>::Triangle Triangle;
+    PLB_ASSERT( surfDefinitionArgs.size()>0 );
+    if (surfaceIds.empty()) {
+        surfaceIds = isoSurfaceDefinition->getSurfaceIds();
+    }
+    MultiContainerBlock3D triangleContainer(*surfDefinitionArgs[0]);
+    std::vector<MultiBlock3D*> args;
+    args.push_back(&triangleContainer);
+    for (pluint i=0; i<surfDefinitionArgs.size(); ++i) {
+        args.push_back(surfDefinitionArgs[i]);
+    }
+    applyProcessingFunctional (
+        new MarchingCubeSurfaces3D<T>(surfaceIds, isoSurfaceDefinition), domain, args );
+
+    // Binary STL: an 80-byte header and the number of triangles, followed by 50 bytes
+    //   per triangle (normal and vertices as floats, and a two-byte attribute).
+    static const plint headerSize = 80 + sizeof(unsigned int);
+    static const plint triangleSize = 12*sizeof(float) + sizeof(unsigned short);
+
+    std::vector<plint> const& localBlocks =
+        triangleContainer.getMultiBlockManagement().getLocalInfo().getBlocks();
+    plint myNumTriangles = 0;
+    for (pluint iBlock=0; iBlock<localBlocks.size(); ++iBlock) {
+        typename MarchingCubeSurfaces3D<T>::TriangleSetData const* data =
+            dynamic_cast<typename MarchingCubeSurfaces3D<T>::TriangleSetData const*> (
+                    triangleContainer.getComponent(localBlocks[iBlock]).getData() );
+        if (data) {
+            myNumTriangles += (plint)data->triangles.size();
+        }
+    }
+
+    // Each process owns the chunk 1+rank of the file; chunk 0 is the header.
+    plint numTriangles = myNumTriangles;
+    plint myEnd = myNumTriangles;
+#ifdef PLB_MPI_PARALLEL
+    global::mpi().reduceAndBcast(numTriangles, MPI_SUM);
+    global::mpi().scan(myNumTriangles, myEnd, MPI_SUM);
+#endif
+    PLB_ASSERT( numTriangles <= (plint)std::numeric_limits<unsigned int>::max() );
+    int rank = global::mpi().getRank();
+    std::vector<plint> chunkOffsets(global::mpi().getSize()+1);
+    chunkOffsets[0] = headerSize;
+    chunkOffsets[rank] = headerSize + triangleSize*(myEnd-myNumTriangles);
+    chunkOffsets[rank+1] = headerSize + triangleSize*myEnd;
+
+    std::vector<plint> myChunks;
+    std::vector<std::vector<char> > chunks;
+    if (global::mpi().isMainProcessor()) {
+        std::vector<char> header(headerSize, '\0');
+        strcpy(&header[0], "plb");
+        unsigned int nt = (unsigned int) numTriangles;
+        memcpy(&header[80], &nt, sizeof(unsigned int));
+        myChunks.push_back(0);
+        chunks.push_back(header);
+    }
+    std::vector<char> myTriangles(triangleSize*myNumTriangles);
+    char* pos = myTriangles.empty() ? 0 : &myTriangles[0];
+    for (pluint iBlock=0; iBlock<localBlocks.size(); ++iBlock) {
+        typename MarchingCubeSurfaces3D<T>::TriangleSetData const* data =
+            dynamic_cast<typename MarchingCubeSurfaces3D<T>::TriangleSetData const*> (
+                    triangleContainer.getComponent(localBlocks[iBlock]).getData() );
+        if (!data) continue;
+        for (pluint iTriangle=0; iTriangle<data->triangles.size(); ++iTriangle) {
+            Triangle const& triangle = data->triangles[iTriangle];
+            Array<T,3> v0 = scale*triangle[0] + offset;
+            Array<T,3> v1 = scale*triangle[1] + offset;
+            Array<T,3> v2 = scale*triangle[2] + offset;
+            Array<T,3> normal = computeTriangleNormal(v0, v1, v2, false);
+            float values[12];
+            for (int iDim=0; iDim<3; ++iDim) {
+                values[iDim]   = (float) normal[iDim];
+                values[3+iDim] = (float) v0[iDim];
+                values[6+iDim] = (float) v1[iDim];
+                values[9+iDim] = (float) v2[iDim];
+            }
+            unsigned short attribute = 0;
+            memcpy(pos, values, 12*sizeof(float));
+            memcpy(pos+12*sizeof(float), &attribute, sizeof(unsigned short));
+            pos += triangleSize;
+        }
+    }
+    if (!myTriangles.empty()) {
+        myChunks.push_back(rank+1);
+        chunks.push_back(std::vector<char>());
+        chunks.back().swap(myTriangles);
+    }
+
+    // The file is removed beforehand, because a previous, longer version would not be truncated.
+    FileName fName(fname);
+    fName.defaultPath(global::directories().getOutputDir());
+    if (global::mpi().isMainProcessor()) {
+        std::remove(fName.get().c_str());
+    }
+    global::mpi().barrier();
+    parallelIO::writeRawData(fName, myChunks, chunkOffsets, chunks);
+    return numTriangles;
+}
+
+template<typename T>
+plint writeIsoSurfaceBinarySTL (
+        std::string fname, MultiScalarField3D<T>& scalarField,
+        std::vector<T> const& isoLevels, Box3D const& domain,
+        T scale, Array<T,3> const& offset )
+{
+    std::vector<MultiBlock3D*> scalarFieldArg;
+    scalarFieldArg.push_back(&scalarField);
+    return writeIsoSurfaceBinarySTL (
+            fname, scalarFieldArg, new ScalarFieldIsoSurface3D<T>(isoLevels), domain,
+            std::vector<plint>(), scale, offset );
+}
+
 template<typename T, template<typename U> class Descriptor>
 TriangleSet<T> vofToTriangles(MultiScalarField3D<T>& scalarField, T threshold, Box3D domain)
 {
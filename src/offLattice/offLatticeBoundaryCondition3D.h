@@ -59,6 +59,16 @@ public:
     void insert(plint processorLevel = 1);
     void apply(std::vector<MultiBlock3D*> const& completionArg);
     void insert(std::vector<MultiBlock3D*> const& completionArg, plint processorLevel = 1);
+    /// Update the off-lattice pattern after a displacement of the wall, once the
+    ///   voxelized domain has been adjusted to the new wall position. Only the cells
+    ///   close to triangles which have a vertex that moved by more than tolerance
+    ///   since the last update are recomputed, by bins of 16^3 cells. If more than
+    ///   half of the triangles moved, the pattern is recomputed from scratch. With a
+    ///   vanishing tolerance, the result is the same as with a pattern computed from
+    ///   scratch.
+    void updatePattern(T tolerance = T());
+    /// Recompute the off-lattice pattern on the given domains only.
+    void updatePattern(std::vector<Box3D> const& domains);
     Array<T,3> getForceOnObject();
     std::auto_ptr<MultiTensorField3D<T,3> > computeVelocity(Box3D domain);
     std::auto_ptr<MultiTensorField3D<T,3> > computeVelocity();
@@ -94,12 +104,18 @@ public:
     T computeAverageShearStressNorm();
     T computeRMSshearStressNorm(Box3D domain);
     T computeRMSshearStressNorm();
+private:
+    /// Compute the off-lattice pattern from scratch.
+    void computePattern();
+    void storePatternVertices();
 private:
     VoxelizedDomain3D<T>& voxelizedDomain;
     MultiBlockLattice3D<T,Descriptor>& lattice;
     MultiBlock3D& boundaryShapeArg;
     OffLatticeModel3D<T,BoundaryType>* offLatticeModel;
     MultiContainerBlock3D offLatticePattern;
+    /// Vertex positions for which the off-lattice pattern is up to date.
+    std::vector<Array<T,3> > patternVertices;
 };
 
 }  // namespace plb
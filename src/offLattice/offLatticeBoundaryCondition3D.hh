@@ -30,6 +30,8 @@
 #include "offLattice/triangularSurfaceMesh.h"
 #include "offLattice/offLatticeBoundaryProfiles3D.h"
 #include "triangleToDef.h"
+#include <algorithm>
+#include <cmath>
 
 namespace plb {
 
@@ -50,20 +52,8 @@ OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::
       offLatticeModel(offLatticeModel_),
       offLatticePattern(lattice)
 {
-    // It is very important that the "offLatticePattern" container block
-    // has the same multi-block management as the lattice used in the
-    // simulation.
-    std::vector<MultiBlock3D*> offLatticeIniArg;
-    // First argument for compute-off-lattice-pattern.
-    offLatticeIniArg.push_back(&offLatticePattern);
-    // Remaining arguments for inner-flow-shape.
-    offLatticeIniArg.push_back(&voxelizedDomain.getVoxelMatrix());
-    offLatticeIniArg.push_back(&voxelizedDomain.getTriangleHash());
-    offLatticeIniArg.push_back(&boundaryShapeArg);
-    applyProcessingFunctional (
-            new OffLatticePatternFunctional3D<T,BoundaryType> (
-                offLatticeModel->clone() ),
-            offLatticePattern.getBoundingBox(), offLatticeIniArg );
+    computePattern();
+    storePatternVertices();
 }
 
 template< typename T,
@@ -80,6 +70,37 @@ OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::
       lattice(lattice_),
       boundaryShapeArg(particleField_),
       offLatticePattern(lattice)
+{
+    computePattern();
+    storePatternVertices();
+}
+
+template< typename T,
+          template<typename U> class Descriptor,
+          class BoundaryType >
+OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::OffLatticeBoundaryCondition3D (
+        OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType> const& rhs )
+    : offLatticeModel(rhs.offLatticeModel.clone()),
+      voxelizedDomain(rhs.voxelizedDomain),
+      lattice(rhs.lattice),
+      boundaryShapeArg(rhs.boundaryShapeArg),
+      offLatticePattern(rhs.offLatticePattern),
+      patternVertices(rhs.patternVertices)
+{ }
+
+
+template< typename T,
+          template<typename U> class Descriptor,
+          class BoundaryType >
+OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::~OffLatticeBoundaryCondition3D()
+{
+    delete offLatticeModel;
+}
+
+template< typename T,
+          template<typename U> class Descriptor,
+          class BoundaryType >
+void OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::computePattern()
 {
     // It is very important that the "offLatticePattern" container block
     // has the same multi-block management as the lattice used in the
@@ -100,22 +121,136 @@ OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::
 template< typename T,
           template<typename U> class Descriptor,
           class BoundaryType >
-OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::OffLatticeBoundaryCondition3D (
-        OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType> const& rhs )
-    : offLatticeModel(rhs.offLatticeModel.clone()),
-      voxelizedDomain(rhs.voxelizedDomain),
-      lattice(rhs.lattice),
-      boundaryShapeArg(rhs.boundaryShapeArg),
-      offLatticePattern(rhs.offLatticePattern)
-{ }
+void OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::storePatternVertices()
+{
+    TriangleBoundary3D<T> const& boundary = voxelizedDomain.getBoundary();
+    boundary.pushSelect(1, voxelizedDomain.hasDynamicMesh() ? 1 : 0); // Closed, Dynamic or Static.
+    TriangularSurfaceMesh<T> const& mesh = boundary.getMesh();
+    patternVertices.resize(mesh.getNumVertices());
+    for (plint iVertex=0; iVertex<mesh.getNumVertices(); ++iVertex) {
+        patternVertices[iVertex] = mesh.getVertex(iVertex);
+    }
+    boundary.popSelect();
+}
 
+template< typename T,
+          template<typename U> class Descriptor,
+          class BoundaryType >
+void OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::updatePattern(T tolerance)
+{
+    TriangleBoundary3D<T> const& boundary = voxelizedDomain.getBoundary();
+    boundary.pushSelect(1, voxelizedDomain.hasDynamicMesh() ? 1 : 0); // Closed, Dynamic or Static.
+    TriangularSurfaceMesh<T> const& mesh = boundary.getMesh();
+    PLB_ASSERT( mesh.getNumVertices() == (plint)patternVertices.size() );
+
+    std::vector<bool> hasMoved(patternVertices.size());
+    for (plint iVertex=0; iVertex<mesh.getNumVertices(); ++iVertex) {
+        hasMoved[iVertex] = norm(mesh.getVertex(iVertex)-patternVertices[iVertex]) > tolerance;
+    }
+    // The pattern of a cell depends on the triangles crossed by its links, and on
+    //   the voxel flags up to getNumNeighbors() cells away along these links. It can
+    //   therefore only change close to the region swept by a moving triangle. These
+    //   regions are marked on a coarse grid of bins, so that the number of domains
+    //   handed to the atomic-blocks does not grow with the number of triangles.
+    static const plint binSize = 16;
+    plint margin = offLatticeModel->getNumNeighbors()+1;
+    Box3D bbox = offLatticePattern.getBoundingBox();
+    plint nBinX = (bbox.getNx()+binSize-1)/binSize;
+    plint nBinY = (bbox.getNy()+binSize-1)/binSize;
+    plint nBinZ = (bbox.getNz()+binSize-1)/binSize;
+    std::vector<bool> isMarked(nBinX*nBinY*nBinZ, false);
+    plint numMovedTriangles = 0;
+    for (plint iTriangle=0; iTriangle<mesh.getNumTriangles(); ++iTriangle) {
+        plint vertexIds[3];
+        bool triangleHasMoved = false;
+        for (plint iLocal=0; iLocal<3; ++iLocal) {
+            vertexIds[iLocal] = mesh.getVertexId(iTriangle, iLocal);
+            triangleHasMoved = triangleHasMoved || hasMoved[vertexIds[iLocal]];
+        }
+        if (triangleHasMoved) {
+            ++numMovedTriangles;
+            Array<T,3> lowerBound(patternVertices[vertexIds[0]]);
+            Array<T,3> upperBound(lowerBound);
+            for (plint iLocal=0; iLocal<3; ++iLocal) {
+                Array<T,3> const& oldVertex = patternVertices[vertexIds[iLocal]];
+                Array<T,3> const& newVertex = mesh.getVertex(vertexIds[iLocal]);
+                for (int iDim=0; iDim<3; ++iDim) {
+                    lowerBound[iDim] = std::min(lowerBound[iDim], std::min(oldVertex[iDim], newVertex[iDim]));
+                    upperBound[iDim] = std::max(upperBound[iDim], std::max(oldVertex[iDim], newVertex[iDim]));
+                }
+            }
+            Box3D swept (
+                    (plint)std::floor(lowerBound[0])-margin, (plint)std::ceil(upperBound[0])+margin,
+                    (plint)std::floor(lowerBound[1])-margin, (plint)std::ceil(upperBound[1])+margin,
+                    (plint)std::floor(lowerBound[2])-margin, (plint)std::ceil(upperBound[2])+margin );
+            Box3D inters;
+            if (intersect(swept, bbox, inters)) {
+                inters = inters.shift(-bbox.x0,-bbox.y0,-bbox.z0);
+                for (plint iX=inters.x0/binSize; iX<=inters.x1/binSize; ++iX) {
+                    for (plint iY=inters.y0/binSize; iY<=inters.y1/binSize; ++iY) {
+                        for (plint iZ=inters.z0/binSize; iZ<=inters.z1/binSize; ++iZ) {
+                            isMarked[(iX*nBinY+iY)*nBinZ+iZ] = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    // Contiguous marked bins along z are merged into a single domain.
+    std::vector<Box3D> domains;
+    for (plint iX=0; iX<nBinX; ++iX) {
+        for (plint iY=0; iY<nBinY; ++iY) {
+            plint iZ = 0;
+            while (iZ<nBinZ) {
+                if (!isMarked[(iX*nBinY+iY)*nBinZ+iZ]) {
+                    ++iZ;
+                    continue;
+                }
+                plint endZ = iZ+1;
+                while (endZ<nBinZ && isMarked[(iX*nBinY+iY)*nBinZ+endZ]) {
+                    ++endZ;
+                }
+                Box3D bins(iX*binSize, (iX+1)*binSize-1, iY*binSize, (iY+1)*binSize-1,
+                           iZ*binSize, endZ*binSize-1);
+                Box3D domain;
+                intersect(bins.shift(bbox.x0,bbox.y0,bbox.z0), bbox, domain);
+                domains.push_back(domain);
+                iZ = endZ;
+            }
+        }
+    }
+    for (plint iVertex=0; iVertex<mesh.getNumVertices(); ++iVertex) {
+        if (hasMoved[iVertex]) {
+            patternVertices[iVertex] = mesh.getVertex(iVertex);
+        }
+    }
+    boundary.popSelect();
+
+    // All processes hold the full moving mesh, and agree on the domains. When most
+    //   of the wall has moved, a full recompute is cheaper than the update.
+    if (2*numMovedTriangles > mesh.getNumTriangles()) {
+        computePattern();
+    }
+    else if (!domains.empty()) {
+        updatePattern(domains);
+    }
+}
 
 template< typename T,
           template<typename U> class Descriptor,
           class BoundaryType >
-OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::~OffLatticeBoundaryCondition3D()
+void OffLatticeBoundaryCondition3D<T,Descriptor,BoundaryType>::updatePattern (
+        std::vector<Box3D> const& domains )
 {
-    delete offLatticeModel;
+    std::vector<MultiBlock3D*> offLatticeUpdateArg;
+    offLatticeUpdateArg.push_back(&offLatticePattern);
+    offLatticeUpdateArg.push_back(&voxelizedDomain.getVoxelMatrix());
+    offLatticeUpdateArg.push_back(&voxelizedDomain.getTriangleHash());
+    offLatticeUpdateArg.push_back(&boundaryShapeArg);
+    applyProcessingFunctional (
+            new UpdateOffLatticePatternFunctional3D<T,BoundaryType> (
+                offLatticeModel->clone(), domains ),
+            offLatticePattern.getBoundingBox(), offLatticeUpdateArg );
 }
 
 template< typename T,
@@ -73,6 +73,12 @@ public:
     virtual bool isExtrapolated() const =0;
     virtual void prepareCell (
             Dot3D const& cellLocation, AtomicContainerBlock3D& container ) =0;
+    /// Recompute the data of the cells listed in cellLocations (relative to the
+    ///   container, sorted in x-major order, without duplicates), and keep the data
+    ///   of all other cells. Returns false if the model does not implement such
+    ///   incremental updates, in which case the container is left unchanged.
+    virtual bool updateCells (
+            std::vector<Dot3D> const& cellLocations, AtomicContainerBlock3D& container );
     virtual void boundaryCompletion (
             AtomicBlock3D& lattice,
             AtomicContainerBlock3D& container,
@@ -120,6 +126,35 @@ private:
     OffLatticeModel3D<T,SurfaceData>* offLatticeModel;
 };
 
+/// Recompute the off-lattice pattern in the neighborhood of a moving wall. Only the
+///   cells inside the given domains are processed again; all other cells keep their
+///   data. Atomic-blocks whose model does not support incremental updates, or more
+///   than half of whose cells are in the domains, get their pattern recomputed from
+///   scratch.
+template<typename T, class SurfaceData>
+class UpdateOffLatticePatternFunctional3D : public BoxProcessingFunctional3D
+{
+public:
+    /// The domains are expressed in absolute coordinates, and may overlap.
+    UpdateOffLatticePatternFunctional3D (
+            OffLatticeModel3D<T,SurfaceData>* offLatticeModel_,
+            std::vector<Box3D> const& domains_ );
+    virtual ~UpdateOffLatticePatternFunctional3D();
+    UpdateOffLatticePatternFunctional3D(UpdateOffLatticePatternFunctional3D const& rhs);
+    UpdateOffLatticePatternFunctional3D& operator= (
+            UpdateOffLatticePatternFunctional3D const& rhs );
+    void swap(UpdateOffLatticePatternFunctional3D& rhs);
+    virtual UpdateOffLatticePatternFunctional3D<T,SurfaceData>* clone() const;
+
+    /// Same arguments as for the OffLatticePatternFunctional3D.
+    virtual void processGenericBlocks(Box3D domain, std::vector<AtomicBlock3D*> fields);
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual BlockDomain::DomainT appliesTo() const;
+private:
+    OffLatticeModel3D<T,SurfaceData>* offLatticeModel;
+    std::vector<Box3D> domains;
+};
+
 template<typename T, template<typename U> class Descriptor, class SurfaceData>
 class OffLatticeCompletionFunctional3D : public BoxProcessingFunctional3D
 {
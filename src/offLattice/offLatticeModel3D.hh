@@ -144,6 +144,13 @@ bool OffLatticeModel3D<T,SurfaceData>::isSolid(Dot3D const& location) const
     }
 }
 
+template<typename T, class SurfaceData>
+bool OffLatticeModel3D<T,SurfaceData>::updateCells (
+        std::vector<Dot3D> const& cellLocations, AtomicContainerBlock3D& container )
+{
+    return false;
+}
+
 template<typename T, template<typename U> class Descriptor, class SurfaceData>
 OffLatticeCompletionFunctional3D<T,Descriptor,SurfaceData>::OffLatticeCompletionFunctional3D (
         OffLatticeModel3D<T,SurfaceData>* offLatticeModel_,
@@ -342,6 +349,138 @@ void OffLatticePatternFunctional3D<T,SurfaceData>::processGenericBlocks (
 }
 
 
+template<typename T, class SurfaceData>
+UpdateOffLatticePatternFunctional3D<T,SurfaceData>::
+    UpdateOffLatticePatternFunctional3D (
+            OffLatticeModel3D<T,SurfaceData>* offLatticeModel_,
+            std::vector<Box3D> const& domains_ )
+  : offLatticeModel(offLatticeModel_),
+    domains(domains_)
+{ }
+
+template<typename T, class SurfaceData>
+UpdateOffLatticePatternFunctional3D<T,SurfaceData>::~UpdateOffLatticePatternFunctional3D()
+{
+    delete offLatticeModel;
+}
+
+template<typename T, class SurfaceData>
+UpdateOffLatticePatternFunctional3D<T,SurfaceData>::
+    UpdateOffLatticePatternFunctional3D (
+            UpdateOffLatticePatternFunctional3D<T,SurfaceData> const& rhs)
+    : offLatticeModel(rhs.offLatticeModel->clone()),
+      domains(rhs.domains)
+{ }
+
+template<typename T, class SurfaceData>
+UpdateOffLatticePatternFunctional3D<T,SurfaceData>&
+    UpdateOffLatticePatternFunctional3D<T,SurfaceData>::operator= (
+            UpdateOffLatticePatternFunctional3D<T,SurfaceData> const& rhs )
+{
+    UpdateOffLatticePatternFunctional3D<T,SurfaceData>(rhs).swap(*this);
+    return *this;
+}
+
+template<typename T, class SurfaceData>
+void UpdateOffLatticePatternFunctional3D<T,SurfaceData>::swap(
+        UpdateOffLatticePatternFunctional3D<T,SurfaceData>& rhs)
+{
+    std::swap(offLatticeModel, rhs.offLatticeModel);
+    domains.swap(rhs.domains);
+}
+
+template<typename T, class SurfaceData>
+UpdateOffLatticePatternFunctional3D<T,SurfaceData>*
+    UpdateOffLatticePatternFunctional3D<T,SurfaceData>::clone() const
+{
+    return new UpdateOffLatticePatternFunctional3D<T,SurfaceData>(*this);
+}
+
+template<typename T, class SurfaceData>
+void UpdateOffLatticePatternFunctional3D<T,SurfaceData>::getTypeOfModification (
+        std::vector<modif::ModifT>& modified) const
+{
+    modified[0] = modif::staticVariables;  // Container.
+    for (pluint i=1; i<modified.size(); ++i) {
+        modified[i] = modif::nothing;
+    }
+}
+
+template<typename T, class SurfaceData>
+BlockDomain::DomainT UpdateOffLatticePatternFunctional3D<T,SurfaceData>::appliesTo() const
+{
+    return BlockDomain::bulk;
+}
+
+template<typename T, class SurfaceData>
+void UpdateOffLatticePatternFunctional3D<T,SurfaceData>::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> fields )
+{
+    PLB_PRECONDITION( fields.size() >= 1 );
+    AtomicContainerBlock3D* container =
+        dynamic_cast<AtomicContainerBlock3D*>(fields[0]);
+    PLB_ASSERT( container );
+    Dot3D location = container->getLocation();
+
+    // Mark the cells to be updated. The domains may overlap, and are typically
+    //   much smaller than the atomic-block.
+    plint nx = domain.getNx();
+    plint ny = domain.getNy();
+    plint nz = domain.getNz();
+    std::vector<bool> isMarked(domain.nCells(), false);
+    bool hasMarkedCells = false;
+    for (pluint iDomain=0; iDomain<domains.size(); ++iDomain) {
+        Box3D inters;
+        if (intersect(domains[iDomain].shift(-location.x,-location.y,-location.z), domain, inters)) {
+            hasMarkedCells = true;
+            for (plint iX=inters.x0; iX<=inters.x1; ++iX) {
+                for (plint iY=inters.y0; iY<=inters.y1; ++iY) {
+                    for (plint iZ=inters.z0; iZ<=inters.z1; ++iZ) {
+                        isMarked[((iX-domain.x0)*ny+iY-domain.y0)*nz+iZ-domain.z0] = true;
+                    }
+                }
+            }
+        }
+    }
+    if (!hasMarkedCells) {
+        return;
+    }
+    std::vector<Dot3D> cellLocations;
+    for (plint iX=0; iX<nx; ++iX) {
+        for (plint iY=0; iY<ny; ++iY) {
+            for (plint iZ=0; iZ<nz; ++iZ) {
+                if (isMarked[(iX*ny+iY)*nz+iZ]) {
+                    cellLocations.push_back(Dot3D(domain.x0+iX,domain.y0+iY,domain.z0+iZ));
+                }
+            }
+        }
+    }
+
+    if (fields.size()>1) {
+        std::vector<AtomicBlock3D*> shapeParameters(fields.size()-1);
+        for (pluint i=0; i<shapeParameters.size(); ++i) {
+            shapeParameters[i] = fields[i+1];
+        }
+        offLatticeModel->provideShapeArguments(shapeParameters);
+    }
+
+    // Without data from a previous computation, if most of the atomic-block must be
+    //   updated, or if the model does not support incremental updates, the whole
+    //   pattern of the atomic-block is recomputed.
+    bool fullUpdate = container->getData()==0 || 2*(plint)cellLocations.size() > domain.nCells();
+    if (fullUpdate || !offLatticeModel->updateCells(cellLocations, *container)) {
+        container->setData(offLatticeModel->generateOffLatticeInfo());
+        for (plint iX=domain.x0; iX<=domain.x1; ++iX) {
+            for (plint iY=domain.y0; iY<=domain.y1; ++iY) {
+                for (plint iZ=domain.z0; iZ<=domain.z1; ++iZ) {
+                    offLatticeModel->prepareCell(Dot3D(iX,iY,iZ), *container);
+                }
+            }
+        }
+    }
+}
+
+
 template< typename T, class SurfaceData >
 GetForceOnObjectFunctional3D<T,SurfaceData>::GetForceOnObjectFunctional3D (
     OffLatticeModel3D<T,SurfaceData>* offLatticeModel_ )
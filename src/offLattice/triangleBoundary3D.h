@@ -269,6 +269,15 @@ public: // Mesh preparation interface.
     plint getTag(plint iTriangle) const;
     std::vector<plint> const& getTriangleTags() const { return triangleTagList; }
     std::vector<plint> const& getVertexTags() const { return vertexTagList; }
+    /// Keep only the wall triangles which are needed in the given domains, and all lids.
+    /** A wall triangle is kept if its bounding box intersects one of the domains,
+     *    enlarged by haloWidth. The fan of triangles around every vertex of a kept
+     *    triangle is kept as well, so that continuous normals are unchanged. The
+     *    triangles and vertices are renumbered, the tags and the lids are preserved.
+     *    This is a local operation, used to distribute a large static mesh among the
+     *    MPI processes; it requires a single set of vertices.
+     **/
+    void restrictToDomain(std::vector<Box3D> const& domains, plint haloWidth);
 private:
     plint currentMesh() const;
     void defineMeshes();
@@ -339,7 +348,8 @@ public:
     /// Use this clone function to provide the meshed data to this object.
     /** The arguments are:
      *  0: The voxel flags (ScalarField3D<int>),
-     *  1: The hash container (AtomicContainerBlock3D),
+     *  1: The hash container (AtomicContainerBlock3D), holding either a
+     *     TriangleHash or a TriangleBvh,
      *  2: The boundary argument: an additional argument needed by BoundaryProfiles
      *     in order to compute the boundary condition. In dynamic walls this is for
      *     example often a MultiParticleField, used to determined the wall velocity.
@@ -368,7 +378,7 @@ public:
                       int flowType_, Box3D const& boundingBox, plint borderWidth_,
                       plint envelopeWidth_, plint blockSize_,
                       plint gridLevel_=0, bool dynamicMesh_ = false);
-    // For faster results, the "seed" should contain at least one of the domain corners.
+    // Deprecated: the "seed" is ignored by the voxelizer, which needs no seed any more.
     VoxelizedDomain3D(TriangleBoundary3D<T> const& boundary_,
                       int flowType_, Box3D const& boundingBox, plint borderWidth_,
                       plint envelopeWidth_, plint blockSize_,
@@ -378,7 +388,25 @@ public:
     ~VoxelizedDomain3D();
     MultiScalarField3D<int>& getVoxelMatrix();
     MultiScalarField3D<int> const& getVoxelMatrix() const;
+    /// Container with fast access to the triangles of each block: by default a
+    ///   TriangleHash, or a TriangleBvh after a call to useTriangleBvh().
     MultiContainerBlock3D& getTriangleHash();
+    /// Replace the triangle hash by a bounding-volume hierarchy (or the other way
+    ///   round). Both are understood by the TriangleFlowShape3D; the hierarchy
+    ///   needs less memory and is faster to query for dense meshes. The container
+    ///   returned by getTriangleHash() is the same object before and after the call.
+    void useTriangleBvh(bool useBvh_ = true);
+    /// Restrict the boundary, which must be the one passed to the constructor, to the
+    ///   part needed by the blocks of the current MPI process, and rebuild the triangle
+    ///   hash. This is only possible for a static mesh, and must be done before the
+    ///   off-lattice boundary condition is created. The triangles which are dropped
+    ///   cannot be recovered: after this call, the domain can neither be
+    ///   reparallelized nor re-voxelized (adjustVoxelization), and both raise a
+    ///   PlbLogicException. To change the parallelization, build a new boundary from
+    ///   the full mesh and distribute it again.
+    void distributeBoundary(TriangleBoundary3D<T>& boundary_, plint haloWidth = 2);
+    /// True after a call to distributeBoundary.
+    bool isDistributed() const { return distributed; }
     MultiBlockManagement3D const& getMultiBlockManagement() const;
     template<class ParticleFieldT>
     void adjustVoxelization(MultiParticleField3D<ParticleFieldT>& particles, bool dynamicMesh);
@@ -386,6 +414,7 @@ public:
     void reparallelize(MultiBlockManagement3D const& newManagement);
     TriangleBoundary3D<T> const& getBoundary() const { return boundary; }
     int getFlowType() const { return flowType; }
+    bool hasDynamicMesh() const { return dynamicMesh; }
 private:
     VoxelizedDomain3D<T>& operator=(VoxelizedDomain3D<T> const& rhs) { }
     void createSparseVoxelMatrix (
@@ -397,6 +426,7 @@ private:
     void extendEnvelopeWidth (
             MultiScalarField3D<int>& fullVoxelMatrix, plint envelopeWidth );
     void createTriangleHash();
+    void fillTriangleHash();
     template<class ParticleFieldT>
     void reCreateTriangleHash(MultiParticleField3D<ParticleFieldT>& particles);
     void computeOuterMask();
@@ -404,6 +434,9 @@ private:
     int flowType;
     plint borderWidth;
     TriangleBoundary3D<T> const& boundary;
+    bool dynamicMesh;
+    bool useBvh;
+    bool distributed;
     MultiScalarField3D<int>* voxelMatrix;
     MultiContainerBlock3D* triangleHash;
 };
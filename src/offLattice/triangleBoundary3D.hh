@@ -28,11 +28,13 @@
 #include "core/globalDefs.h"
 #include "core/geometry3D.h"
 #include "core/util.h"
+#include "core/runTimeDiagnostics.h"
 #include "offLattice/triangleBoundary3D.h"
 #include "offLattice/triangularSurfaceMesh.h"
 #include "offLattice/offLatticeBoundaryProfiles3D.h"
 #include "offLattice/triangleToDef.h"
 #include "offLattice/voxelizer.h"
+#include "offLattice/triangleBvh.h"
 #include "offLattice/makeSparse3D.h"
 #include "offLattice/triangularSurfaceMesh.h"
 #include "dataProcessors/dataAnalysisWrapper3D.h"
@@ -643,6 +645,182 @@ void TriangleBoundary3D<T>::cloneVertexSet(plint whichVertexSet)
                       vertexLists[newVertexSet], emanatingEdgeLists[1], edgeLists[1]) );
 }
 
+template<typename T>
+void TriangleBoundary3D<T>::restrictToDomain (
+        std::vector<Box3D> const& domains, plint haloWidth )
+{
+    // With several sets of vertices, the mesh is moving, and the particles which
+    //   carry the vertices refer to the global numbering.
+    PLB_PRECONDITION( vertexLists.size()==1 );
+    PLB_PRECONDITION( haloWidth>=0 );
+
+    std::vector<Array<T,3> > const& vertices = vertexLists[0];
+    std::vector<Edge> const& openEdges = edgeLists[0];
+    std::vector<Edge> const& closedEdges = edgeLists[1];
+    plint numVertices = (plint)vertices.size();
+    plint numWallTriangles = (plint)openEdges.size()/3;
+    plint numTriangles = (plint)closedEdges.size()/3;
+
+    // Edge 3*iTriangle+iEdge points to vertex (iEdge+1)%3 of the triangle.
+    std::vector<plint> triangleVertices(3*numTriangles);
+    for (plint iTriangle=0; iTriangle<numTriangles; ++iTriangle) {
+        for (plint iEdge=0; iEdge<3; ++iEdge) {
+            triangleVertices[3*iTriangle+(iEdge+1)%3] = closedEdges[3*iTriangle+iEdge].pv;
+        }
+    }
+
+    // Select the wall triangles which intersect the domains.
+    std::vector<bool> isSelected(numWallTriangles, false);
+    for (plint iTriangle=0; iTriangle<numWallTriangles; ++iTriangle) {
+        Array<T,3> lowerBound(vertices[triangleVertices[3*iTriangle]]);
+        Array<T,3> upperBound(lowerBound);
+        for (plint iVertex=1; iVertex<3; ++iVertex) {
+            Array<T,3> const& vertex = vertices[triangleVertices[3*iTriangle+iVertex]];
+            for (int iDim=0; iDim<3; ++iDim) {
+                lowerBound[iDim] = std::min(lowerBound[iDim], vertex[iDim]);
+                upperBound[iDim] = std::max(upperBound[iDim], vertex[iDim]);
+            }
+        }
+        for (pluint iDomain=0; iDomain<domains.size() && !isSelected[iTriangle]; ++iDomain) {
+            Box3D domain(domains[iDomain].enlarge(haloWidth));
+            isSelected[iTriangle] =
+                upperBound[0] >= (T)domain.x0 && lowerBound[0] <= (T)domain.x1 &&
+                upperBound[1] >= (T)domain.y0 && lowerBound[1] <= (T)domain.y1 &&
+                upperBound[2] >= (T)domain.z0 && lowerBound[2] <= (T)domain.z1;
+        }
+    }
+
+    // The full fan of triangles is kept around the vertices of the selected
+    //   triangles and around the rims of the lids, which must remain closed.
+    std::vector<bool> keepFan(numVertices, false);
+    for (plint iTriangle=0; iTriangle<numWallTriangles; ++iTriangle) {
+        if (isSelected[iTriangle]) {
+            for (plint iVertex=0; iVertex<3; ++iVertex) {
+                keepFan[triangleVertices[3*iTriangle+iVertex]] = true;
+            }
+        }
+    }
+    for (pluint iLid=0; iLid<lids.size(); ++iLid) {
+        for (pluint iVertex=0; iVertex<lids[iLid].boundaryVertices.size(); ++iVertex) {
+            keepFan[lids[iLid].boundaryVertices[iVertex]] = true;
+        }
+    }
+    if (lids.empty() && numWallTriangles>0 &&
+        std::find(isSelected.begin(), isSelected.end(), true) == isSelected.end())
+    {
+        isSelected[0] = true; // The mesh must not be empty.
+    }
+
+    // At the border of the selection, a vertex whose selected triangles do not form
+    //   a single fan (more than two border edges) is not allowed in a surface mesh.
+    //   The full fan is added around such vertices, until there are none left.
+    bool modified = true;
+    while (modified) {
+        modified = false;
+        for (plint iTriangle=0; iTriangle<numWallTriangles; ++iTriangle) {
+            for (plint iVertex=0; iVertex<3 && !isSelected[iTriangle]; ++iVertex) {
+                isSelected[iTriangle] = keepFan[triangleVertices[3*iTriangle+iVertex]];
+            }
+        }
+        std::vector<plint> numBorderEdges(numVertices, 0);
+        for (plint iTriangle=0; iTriangle<numWallTriangles; ++iTriangle) {
+            if (!isSelected[iTriangle]) continue;
+            for (plint iEdge=0; iEdge<3; ++iEdge) {
+                plint neighbor = openEdges[3*iTriangle+iEdge].ne;
+                if (neighbor<0 || !isSelected[neighbor/3]) {
+                    ++numBorderEdges[triangleVertices[3*iTriangle+iEdge]];
+                    ++numBorderEdges[triangleVertices[3*iTriangle+(iEdge+1)%3]];
+                }
+            }
+        }
+        for (plint iVertex=0; iVertex<numVertices; ++iVertex) {
+            if (!keepFan[iVertex] && numBorderEdges[iVertex]>2) {
+                keepFan[iVertex] = true;
+                modified = true;
+            }
+        }
+    }
+
+    // The selected wall triangles keep their order and are followed by the lids. The
+    //   vertices are numbered in the order of appearance, as in constructSurfaceMesh,
+    //   so that the vertices of the open mesh come first.
+    std::vector<plint> localTriangles;
+    for (plint iTriangle=0; iTriangle<numWallTriangles; ++iTriangle) {
+        if (isSelected[iTriangle]) {
+            localTriangles.push_back(iTriangle);
+        }
+    }
+    plint numLocalWallTriangles = (plint)localTriangles.size();
+    for (plint iTriangle=numWallTriangles; iTriangle<numTriangles; ++iTriangle) {
+        localTriangles.push_back(iTriangle);
+    }
+
+    std::vector<plint> localVertexIds(numVertices, -1);
+    std::vector<plint> globalVertexIds;
+    plint numLocalWallVertices = 0;
+    std::vector<typename TriangleSet<T>::Triangle> wallTriangles, allTriangles;
+    std::vector<plint> newTriangleTags(localTriangles.size());
+    for (pluint iLocal=0; iLocal<localTriangles.size(); ++iLocal) {
+        plint iTriangle = localTriangles[iLocal];
+        typename TriangleSet<T>::Triangle triangle;
+        for (plint iVertex=0; iVertex<3; ++iVertex) {
+            plint globalId = triangleVertices[3*iTriangle+iVertex];
+            if (localVertexIds[globalId]<0) {
+                localVertexIds[globalId] = (plint)globalVertexIds.size();
+                globalVertexIds.push_back(globalId);
+            }
+            triangle[iVertex] = vertices[globalId];
+        }
+        if ((plint)iLocal<numLocalWallTriangles) {
+            wallTriangles.push_back(triangle);
+            numLocalWallVertices = (plint)globalVertexIds.size();
+        }
+        allTriangles.push_back(triangle);
+        newTriangleTags[iLocal] = triangleTagList[iTriangle];
+    }
+
+    std::vector<Array<T,3> > newVertices, openVertices;
+    std::vector<plint> newEmanatingEdges[2];
+    std::vector<Edge> newEdges[2];
+    constructSurfaceMesh<T>(wallTriangles, openVertices, newEmanatingEdges[0], newEdges[0]);
+    constructSurfaceMesh<T>(allTriangles, newVertices, newEmanatingEdges[1], newEdges[1]);
+    PLB_ASSERT( (plint)openVertices.size()==numLocalWallVertices );
+    PLB_ASSERT( newVertices.size()==globalVertexIds.size() );
+
+    std::vector<Lid> newLids(lids);
+    for (pluint iLid=0; iLid<newLids.size(); ++iLid) {
+        Lid& lid = newLids[iLid];
+        lid.firstTriangle += numLocalWallTriangles-numWallTriangles;
+        lid.centerVertex = localVertexIds[lid.centerVertex];
+        for (pluint iVertex=0; iVertex<lid.boundaryVertices.size(); ++iVertex) {
+            lid.boundaryVertices[iVertex] = localVertexIds[lid.boundaryVertices[iVertex]];
+        }
+    }
+
+    std::vector<plint> newVertexTags;
+    if (!vertexTagList.empty()) {
+        newVertexTags.resize(globalVertexIds.size());
+        for (pluint iVertex=0; iVertex<globalVertexIds.size(); ++iVertex) {
+            newVertexTags[iVertex] = vertexTagList[globalVertexIds[iVertex]];
+        }
+    }
+
+    vertexLists[0].swap(newVertices);
+    for (plint iTopology=0; iTopology<2; ++iTopology) {
+        emanatingEdgeLists[iTopology].swap(newEmanatingEdges[iTopology]);
+        edgeLists[iTopology].swap(newEdges[iTopology]);
+    }
+    triangleTagList.swap(newTriangleTags);
+    vertexTagList.swap(newVertexTags);
+    lids.swap(newLids);
+
+    meshes.clear();
+    meshes.push_back( TriangularSurfaceMesh<T> (
+                      vertexLists[0], emanatingEdgeLists[0], edgeLists[0], numLocalWallVertices ) );
+    meshes.push_back( TriangularSurfaceMesh<T> (
+                      vertexLists[0], emanatingEdgeLists[1], edgeLists[1]) );
+}
+
 template<typename T>
 std::vector<Lid> const&
     TriangleBoundary3D<T>::getInletOutlet() const
@@ -883,16 +1061,20 @@ bool TriangleFlowShape3D<T,SurfaceData>::pointOnSurface (
     PLB_PRECONDITION( hashContainer ); // Make sure these arguments have
     PLB_PRECONDITION( boundaryArg );   //   been provided by the user through
                                        //   the clone function.
-    static const T maxDistance = std::sqrt((T)3);
-    Array<T,2> xRange(fromPoint[0]-maxDistance, fromPoint[0]+maxDistance);
-    Array<T,2> yRange(fromPoint[1]-maxDistance, fromPoint[1]+maxDistance);
-    Array<T,2> zRange(fromPoint[2]-maxDistance, fromPoint[2]+maxDistance);
-    TriangleHash<T> triangleHash(*hashContainer);
     std::vector<plint> possibleTriangles;
     if (id>=0 && id<boundary.getMesh().getNumTriangles()) {
         possibleTriangles.push_back(id);
     }
+    else if (containsTriangleBvh<T>(*hashContainer)) {
+        TriangleBvh<T>(*hashContainer).getTrianglesOnSegment (
+                fromPoint, fromPoint+direction, possibleTriangles );
+    }
     else {
+        static const T maxDistance = std::sqrt((T)3);
+        Array<T,2> xRange(fromPoint[0]-maxDistance, fromPoint[0]+maxDistance);
+        Array<T,2> yRange(fromPoint[1]-maxDistance, fromPoint[1]+maxDistance);
+        Array<T,2> zRange(fromPoint[2]-maxDistance, fromPoint[2]+maxDistance);
+        TriangleHash<T> triangleHash(*hashContainer);
         triangleHash.getTriangles(xRange, yRange, zRange, possibleTriangles);
     }
 
@@ -943,16 +1125,19 @@ bool TriangleFlowShape3D<T,SurfaceData>::intersectsSurface (
     PLB_PRECONDITION( hashContainer ); // Make sure these arguments have
     PLB_PRECONDITION( boundaryArg );   //   been provided by the user through
                                        //   the clone function.
-    static const T maxDistance = std::sqrt((T)3);
-    Array<T,2> xRange(p1[0]-maxDistance, p1[0]+maxDistance);
-    Array<T,2> yRange(p1[1]-maxDistance, p1[1]+maxDistance);
-    Array<T,2> zRange(p1[2]-maxDistance, p1[2]+maxDistance);
-    TriangleHash<T> triangleHash(*hashContainer);
     std::vector<plint> possibleTriangles;
     if (id>=0 && id<boundary.getMesh().getNumTriangles()) {
         possibleTriangles.push_back(id);
     }
+    else if (containsTriangleBvh<T>(*hashContainer)) {
+        TriangleBvh<T>(*hashContainer).getTrianglesOnSegment(p1, p2, possibleTriangles);
+    }
     else {
+        static const T maxDistance = std::sqrt((T)3);
+        Array<T,2> xRange(p1[0]-maxDistance, p1[0]+maxDistance);
+        Array<T,2> yRange(p1[1]-maxDistance, p1[1]+maxDistance);
+        Array<T,2> zRange(p1[2]-maxDistance, p1[2]+maxDistance);
+        TriangleHash<T> triangleHash(*hashContainer);
         triangleHash.getTriangles(xRange, yRange, zRange, possibleTriangles);
     }
 
@@ -999,9 +1184,13 @@ bool TriangleFlowShape3D<T,SurfaceData>::distanceToSurface (
     Array<T,2> xRange(point[0]-maxDistance, point[0]+maxDistance);
     Array<T,2> yRange(point[1]-maxDistance, point[1]+maxDistance);
     Array<T,2> zRange(point[2]-maxDistance, point[2]+maxDistance);
-    TriangleHash<T> triangleHash(*hashContainer);
     std::vector<plint> possibleTriangles;
-    triangleHash.getTriangles(xRange, yRange, zRange, possibleTriangles);
+    if (containsTriangleBvh<T>(*hashContainer)) {
+        TriangleBvh<T>(*hashContainer).getTriangles(xRange, yRange, zRange, possibleTriangles);
+    }
+    else {
+        TriangleHash<T>(*hashContainer).getTriangles(xRange, yRange, zRange, possibleTriangles);
+    }
 
     T    tmpDistance;
     bool tmpIsBehind;
@@ -1054,7 +1243,10 @@ VoxelizedDomain3D<T>::VoxelizedDomain3D (
         plint envelopeWidth_, plint blockSize_, plint gridLevel_, bool dynamicMesh_ )
     : flowType(flowType_),
       borderWidth(borderWidth_),
-      boundary(boundary_)
+      boundary(boundary_),
+      dynamicMesh(dynamicMesh_),
+      useBvh(false),
+      distributed(false)
 {
     PLB_ASSERT( flowType==voxelFlag::inside || flowType==voxelFlag::outside );
     PLB_ASSERT( boundary.getMargin() >= borderWidth );
@@ -1080,7 +1272,10 @@ VoxelizedDomain3D<T>::VoxelizedDomain3D (
         plint envelopeWidth_, plint blockSize_, plint gridLevel_, bool dynamicMesh_ )
     : flowType(flowType_),
       borderWidth(borderWidth_),
-      boundary(boundary_)
+      boundary(boundary_),
+      dynamicMesh(dynamicMesh_),
+      useBvh(false),
+      distributed(false)
 {
     PLB_ASSERT( flowType==voxelFlag::inside || flowType==voxelFlag::outside );
     PLB_ASSERT( boundary.getMargin() >= borderWidth );
@@ -1105,7 +1300,10 @@ VoxelizedDomain3D<T>::VoxelizedDomain3D (
         plint envelopeWidth_, plint blockSize_, Box3D const& seed, plint gridLevel_, bool dynamicMesh_ )
     : flowType(flowType_),
       borderWidth(borderWidth_),
-      boundary(boundary_)
+      boundary(boundary_),
+      dynamicMesh(dynamicMesh_),
+      useBvh(false),
+      distributed(false)
 {
     PLB_ASSERT( flowType==voxelFlag::inside || flowType==voxelFlag::outside );
     PLB_ASSERT( boundary.getMargin() >= borderWidth );
@@ -1143,6 +1341,9 @@ template<typename T>
 VoxelizedDomain3D<T>::VoxelizedDomain3D (
         VoxelizedDomain3D<T> const& rhs )
     : boundary(rhs.boundary),
+      dynamicMesh(rhs.dynamicMesh),
+      useBvh(rhs.useBvh),
+      distributed(rhs.distributed),
       voxelMatrix(new MultiScalarField3D<int>(*rhs.voxelMatrix)),
       triangleHash(new MultiContainerBlock3D(*rhs.triangleHash))
 { }
@@ -1175,11 +1376,56 @@ MultiContainerBlock3D&
     return *triangleHash;
 }
 
+template<typename T>
+void VoxelizedDomain3D<T>::useTriangleBvh(bool useBvh_)
+{
+    if (useBvh_ != useBvh) {
+        useBvh = useBvh_;
+        if (dynamicMesh) {
+            boundary.pushSelect(1,1); // Closed, Dynamic.
+        }
+        else {
+            boundary.pushSelect(1,0); // Closed, Static.
+        }
+        // The data of the container is replaced in place, so that references
+        //   obtained from getTriangleHash() remain valid.
+        fillTriangleHash();
+        boundary.popSelect();
+    }
+}
+
+template<typename T>
+void VoxelizedDomain3D<T>::distributeBoundary (
+        TriangleBoundary3D<T>& boundary_, plint haloWidth )
+{
+    PLB_PRECONDITION( &boundary_ == &boundary );
+    if (dynamicMesh) {
+        plbLogicError("VoxelizedDomain3D::distributeBoundary: a dynamic mesh cannot be distributed.");
+    }
+    MultiBlockManagement3D const& management = voxelMatrix->getMultiBlockManagement();
+    std::vector<plint> const& localBlocks = management.getLocalInfo().getBlocks();
+    std::vector<Box3D> domains(localBlocks.size());
+    for (pluint iBlock=0; iBlock<localBlocks.size(); ++iBlock) {
+        domains[iBlock] = management.getBulk(localBlocks[iBlock]).enlarge (
+                management.getEnvelopeWidth() );
+    }
+    boundary_.restrictToDomain(domains, haloWidth);
+    distributed = true;
+
+    boundary.pushSelect(1,0); // Closed, Static.
+    fillTriangleHash();
+    boundary.popSelect();
+}
+
 template<typename T>
 template<class ParticleFieldT>
 void VoxelizedDomain3D<T>::adjustVoxelization (
         MultiParticleField3D<ParticleFieldT>& particles, bool dynamicMesh )
 {
+    if (distributed) {
+        plbLogicError("VoxelizedDomain3D::adjustVoxelization: the boundary was distributed "
+                      "and does not contain the full mesh any more.");
+    }
     if (dynamicMesh) {
         boundary.pushSelect(1,1); // Closed, Dynamic.
     }
@@ -1188,7 +1434,7 @@ void VoxelizedDomain3D<T>::adjustVoxelization (
     }
     reCreateTriangleHash(particles);
     MultiScalarField3D<int>* newVoxelMatrix =
-        revoxelize(boundary.getMesh(), *voxelMatrix, *triangleHash, borderWidth).release();
+        revoxelize(boundary.getMesh(), *voxelMatrix, borderWidth).release();
     std::swap(voxelMatrix, newVoxelMatrix);
     delete newVoxelMatrix;
     boundary.popSelect();
@@ -1196,6 +1442,10 @@ void VoxelizedDomain3D<T>::adjustVoxelization (
 
 template<typename T>
 void VoxelizedDomain3D<T>::reparallelize(MultiBlockRedistribute3D const& redistribute) {
+    if (distributed) {
+        plbLogicError("VoxelizedDomain3D::reparallelize: the boundary was distributed for "
+                      "the current parallelization and does not contain the full mesh any more.");
+    }
     MultiBlockManagement3D newManagement = redistribute.redistribute(voxelMatrix->getMultiBlockManagement());
     MultiScalarField3D<int>* newVoxelMatrix =
         new MultiScalarField3D<int>(
@@ -1212,6 +1462,10 @@ void VoxelizedDomain3D<T>::reparallelize(MultiBlockRedistribute3D const& redistr
 
 template<typename T>
 void VoxelizedDomain3D<T>::reparallelize(MultiBlockManagement3D const& newManagement) {
+    if (distributed) {
+        plbLogicError("VoxelizedDomain3D::reparallelize: the boundary was distributed for "
+                      "the current parallelization and does not contain the full mesh any more.");
+    }
     MultiScalarField3D<int>* newVoxelMatrix =
         new MultiScalarField3D<int>(
                 newManagement,
@@ -1284,11 +1538,24 @@ template<typename T>
 void VoxelizedDomain3D<T>::createTriangleHash()
 {
     triangleHash = new MultiContainerBlock3D(*voxelMatrix);
+    fillTriangleHash();
+}
+
+template<typename T>
+void VoxelizedDomain3D<T>::fillTriangleHash()
+{
     std::vector<MultiBlock3D*> hashArg;
     hashArg.push_back(triangleHash);
-    applyProcessingFunctional (
-            new CreateTriangleHash<T>(boundary.getMesh()),
-            triangleHash->getBoundingBox(), hashArg );
+    if (useBvh) {
+        applyProcessingFunctional (
+                new CreateTriangleBvh<T>(boundary.getMesh()),
+                triangleHash->getBoundingBox(), hashArg );
+    }
+    else {
+        applyProcessingFunctional (
+                new CreateTriangleHash<T>(boundary.getMesh()),
+                triangleHash->getBoundingBox(), hashArg );
+    }
 }
 
 template<typename T>
@@ -1311,9 +1578,16 @@ void VoxelizedDomain3D<T>::reCreateTriangleHash (
     std::vector<MultiBlock3D*> hashParticleArg;
     hashParticleArg.push_back(triangleHash);
     hashParticleArg.push_back(&particles);
-    applyProcessingFunctional (
-            new ReAssignTriangleHash<T,ParticleFieldT>(boundary.getMesh(),lidBaryCenters),
-            triangleHash->getBoundingBox(), hashParticleArg );
+    if (useBvh) {
+        applyProcessingFunctional (
+                new ReAssignTriangleBvh<T,ParticleFieldT>(boundary.getMesh(),lidBaryCenters),
+                triangleHash->getBoundingBox(), hashParticleArg );
+    }
+    else {
+        applyProcessingFunctional (
+                new ReAssignTriangleHash<T,ParticleFieldT>(boundary.getMesh(),lidBaryCenters),
+                triangleHash->getBoundingBox(), hashParticleArg );
+    }
 }
 
 /* ******** DetectBorderLineFunctional3D ************************************* */
@@ -0,0 +1,161 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Bounding-volume hierarchy over the triangles of a surface mesh, used
+ * as an alternative to the triangle hash -- header file.
+ */
+
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "core/globalDefs.h"
+#include "core/array.h"
+#include "atomicBlock/dataProcessingFunctional3D.h"
+#include "atomicBlock/atomicContainerBlock3D.h"
+#include "multiBlock/multiContainerBlock3D.h"
+#include "offLattice/triangularSurfaceMesh.h"
+#include <vector>
+
+namespace plb {
+
+/// Node of a flattened bounding-volume hierarchy.
+/** The nodes are stored in depth-first order: the first child of an
+ *  interior node is the next node in the array, and "index" is the
+ *  position of the second child. For a leaf, "index" is the position
+ *  of the first triangle in the list of triangles, and numTriangles>0.
+ */
+template<typename T>
+struct TriangleBvhNode {
+    Array<T,3> lowerBound, upperBound;
+    plint index;
+    plint numTriangles;
+};
+
+template<typename T> struct TriangleBvhData;
+
+/// Access to the triangles of an atomic-block through a bounding-volume hierarchy.
+/** The hierarchy is stored in a container block, and can be used instead of a
+ *  TriangleHash wherever the hash container is expected by the
+ *  TriangleFlowShape3D. It holds only the triangles which are relevant to the
+ *  atomic-block, and is built with a binned surface-area heuristic. Unlike the
+ *  hash, the memory it needs does not depend on the number of cells of the
+ *  block, and the query cost does not depend on how many triangles fall into
+ *  a given cell.
+ */
+template<typename T>
+class TriangleBvh {
+public:
+    TriangleBvh(AtomicContainerBlock3D& bvhContainer);
+    /// Build the hierarchy out of all triangles of the mesh which may
+    ///   intersect the domain of the container.
+    void assignTriangles(TriangularSurfaceMesh<T> const& mesh);
+    /// Same as in the TriangleHash: for moving meshes, only the triangles attached
+    ///   to the vertex-particles of this block and to the non-parallel vertices are used.
+    template<class ParticleFieldT>
+    void reAssignTriangles (
+            TriangularSurfaceMesh<T> const& mesh, ParticleFieldT& particles,
+            std::vector<plint> const& nonParallelVertices );
+    /// All triangles whose bounding box intersects the given range. The
+    ///   triangle ids are sorted in increasing order, like in the TriangleHash.
+    void getTriangles (
+            Array<T,2> const& xRange,
+            Array<T,2> const& yRange,
+            Array<T,2> const& zRange,
+            std::vector<plint>& foundTriangles ) const;
+    void getTriangles (
+            Array<T,3> const& lowerBound, Array<T,3> const& upperBound,
+            std::vector<plint>& foundTriangles ) const;
+    /// All triangles whose bounding box is crossed by the segment [point1,point2],
+    ///   sorted in increasing order.
+    void getTrianglesOnSegment (
+            Array<T,3> const& point1, Array<T,3> const& point2,
+            std::vector<plint>& foundTriangles ) const;
+    /// Batched version of getTrianglesOnSegment, for several segments which start at
+    ///   the same point, as the links of a lattice cell. The hierarchy is traversed
+    ///   only once, and every candidate triangle is then checked against each segment.
+    void getTrianglesOnSegments (
+            Array<T,3> const& fromPoint, std::vector<Array<T,3> > const& directions,
+            std::vector<std::vector<plint> >& foundTriangles ) const;
+    plint getNumNodes() const;
+    plint getNumTriangles() const;
+private:
+    void build(TriangularSurfaceMesh<T> const& mesh, std::vector<plint> const& triangleIds);
+    /// Positions (in the leaf ordering) of all triangles whose bounding box
+    ///   intersects the given box.
+    void getCandidates (
+            Array<T,3> const& lowerBound, Array<T,3> const& upperBound,
+            std::vector<plint>& candidates ) const;
+    /// Triangles out of a list of candidates whose bounding box is crossed by
+    ///   the segment [point1,point2].
+    void selectOnSegment (
+            std::vector<plint> const& candidates,
+            Array<T,3> const& point1, Array<T,3> const& point2,
+            std::vector<plint>& foundTriangles ) const;
+private:
+    AtomicContainerBlock3D& container;
+    TriangleBvhData<T>& data;
+};
+
+/// Returns true if the container holds a TriangleBvh, and false if it holds
+///   something else, typically a TriangleHash.
+template<typename T>
+bool containsTriangleBvh(AtomicContainerBlock3D& container);
+
+template<typename T>
+class CreateTriangleBvh : public BoxProcessingFunctional3D {
+public:
+    CreateTriangleBvh (
+            TriangularSurfaceMesh<T> const& mesh_ );
+    // Field 0: BVH container.
+    virtual void processGenericBlocks (
+                Box3D domain, std::vector<AtomicBlock3D*> fields );
+    virtual CreateTriangleBvh<T>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual BlockDomain::DomainT appliesTo() const;
+private:
+    TriangularSurfaceMesh<T> const& mesh;
+};
+
+template<typename T, class ParticleFieldT>
+class ReAssignTriangleBvh : public BoxProcessingFunctional3D {
+public:
+    // See ReAssignTriangleHash for the meaning of nonParallelVertices.
+    ReAssignTriangleBvh (
+            TriangularSurfaceMesh<T> const& mesh_,
+            std::vector<plint> const& nonParallelVertices_ );
+    // Field 0: BVH container; Field 1: Particles.
+    virtual void processGenericBlocks (
+                Box3D domain, std::vector<AtomicBlock3D*> fields );
+    virtual ReAssignTriangleBvh<T,ParticleFieldT>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual BlockDomain::DomainT appliesTo() const;
+private:
+    TriangularSurfaceMesh<T> const& mesh;
+    std::vector<plint> nonParallelVertices;
+};
+
+}  // namespace plb
+
+#endif  // TRIANGLE_BVH_H
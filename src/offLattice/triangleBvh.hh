@@ -0,0 +1,553 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Bounding-volume hierarchy over the triangles of a surface mesh, used
+ * as an alternative to the triangle hash -- generic implementation.
+ */
+
+#ifndef TRIANGLE_BVH_HH
+#define TRIANGLE_BVH_HH
+
+#include "core/globalDefs.h"
+#include "offLattice/triangleBvh.h"
+#include "atomicBlock/atomicContainerBlock3D.h"
+#include <algorithm>
+#include <limits>
+#include <set>
+
+namespace plb {
+
+template<typename T>
+struct TriangleBvhData : public ContainerBlockData {
+    virtual TriangleBvhData<T>* clone() const {
+        return new TriangleBvhData<T>(*this);
+    }
+    /// Flattened hierarchy, in depth-first order.
+    std::vector<TriangleBvhNode<T> > nodes;
+    /// Triangle ids, in the order of the leaves.
+    std::vector<plint> triangles;
+    /// Bounding boxes of the triangles, in the order of the leaves.
+    std::vector<Array<T,3> > lowerBounds, upperBounds;
+};
+
+/// Temporary data needed for the top-down construction of a TriangleBvh.
+template<typename T>
+struct TriangleBvhBuilder {
+    static const plint numBins = 12;
+    static const plint maxLeafSize = 4;
+    /// The traversal uses a stack of fixed size, which limits the depth.
+    static const plint maxDepth = 48;
+
+    TriangleBvhBuilder(std::vector<TriangleBvhNode<T> >& nodes_)
+        : nodes(nodes_)
+    { }
+    plint buildNode(plint begin, plint end, plint depth);
+    static T halfArea(Array<T,3> const& lowerBound, Array<T,3> const& upperBound) {
+        Array<T,3> d(upperBound-lowerBound);
+        return d[0]*d[1]+d[1]*d[2]+d[2]*d[0];
+    }
+    static void include(Array<T,3>& lowerBound, Array<T,3>& upperBound,
+                        Array<T,3> const& lower, Array<T,3> const& upper)
+    {
+        for (int i=0; i<3; ++i) {
+            lowerBound[i] = std::min(lowerBound[i], lower[i]);
+            upperBound[i] = std::max(upperBound[i], upper[i]);
+        }
+    }
+    static void emptyBox(Array<T,3>& lowerBound, Array<T,3>& upperBound) {
+        T big = std::numeric_limits<T>::max();
+        lowerBound = Array<T,3>(big, big, big);
+        upperBound = Array<T,3>(-big, -big, -big);
+    }
+
+    std::vector<TriangleBvhNode<T> >& nodes;
+    std::vector<Array<T,3> > lowerBounds, upperBounds, centroids;
+    /// Permutation of the triangles, which ends up in leaf order.
+    std::vector<plint> order;
+};
+
+template<typename T>
+plint TriangleBvhBuilder<T>::buildNode(plint begin, plint end, plint depth)
+{
+    plint iNode = (plint)nodes.size();
+    nodes.push_back(TriangleBvhNode<T>());
+    Array<T,3> lowerBound, upperBound, lowerCentroid, upperCentroid;
+    emptyBox(lowerBound, upperBound);
+    emptyBox(lowerCentroid, upperCentroid);
+    for (plint i=begin; i<end; ++i) {
+        plint iTriangle = order[i];
+        include(lowerBound, upperBound, lowerBounds[iTriangle], upperBounds[iTriangle]);
+        include(lowerCentroid, upperCentroid, centroids[iTriangle], centroids[iTriangle]);
+    }
+    nodes[iNode].lowerBound = lowerBound;
+    nodes[iNode].upperBound = upperBound;
+
+    plint numTriangles = end-begin;
+    // Binned surface-area heuristic: the cost of a split, relative to the cost
+    //   of a leaf, is 1 + (A_left*N_left + A_right*N_right) / A.
+    T leafCost = (T)numTriangles;
+    T bestCost = std::numeric_limits<T>::max();
+    int bestAxis = -1;
+    plint bestSplit = 0;
+    if (numTriangles > maxLeafSize && depth < maxDepth) {
+        T area = halfArea(lowerBound, upperBound);
+        for (int axis=0; axis<3; ++axis) {
+            T extent = upperCentroid[axis]-lowerCentroid[axis];
+            if (extent <= (T)0) continue;
+            T scale = (T)numBins / extent;
+            plint binCount[numBins];
+            Array<T,3> binLower[numBins], binUpper[numBins];
+            for (plint iBin=0; iBin<numBins; ++iBin) {
+                binCount[iBin] = 0;
+                emptyBox(binLower[iBin], binUpper[iBin]);
+            }
+            for (plint i=begin; i<end; ++i) {
+                plint iTriangle = order[i];
+                plint iBin = std::min(numBins-1,
+                        (plint)((centroids[iTriangle][axis]-lowerCentroid[axis])*scale));
+                ++binCount[iBin];
+                include(binLower[iBin], binUpper[iBin], lowerBounds[iTriangle], upperBounds[iTriangle]);
+            }
+            // Sweep from the right to accumulate the cost of the right-hand sides.
+            T rightCost[numBins];
+            Array<T,3> lower, upper;
+            emptyBox(lower, upper);
+            plint count = 0;
+            for (plint iBin=numBins-1; iBin>0; --iBin) {
+                include(lower, upper, binLower[iBin], binUpper[iBin]);
+                count += binCount[iBin];
+                rightCost[iBin] = count>0 ? (T)count*halfArea(lower, upper) : (T)0;
+            }
+            emptyBox(lower, upper);
+            count = 0;
+            for (plint iSplit=1; iSplit<numBins; ++iSplit) {
+                include(lower, upper, binLower[iSplit-1], binUpper[iSplit-1]);
+                count += binCount[iSplit-1];
+                if (count==0 || count==numTriangles) continue;
+                T cost = (T)1 + ((T)count*halfArea(lower, upper) + rightCost[iSplit]) /
+                                 std::max(area, std::numeric_limits<T>::min());
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = iSplit;
+                }
+            }
+        }
+    }
+    // A leaf is created when no split is possible (all centroids coincide), or when
+    //   splitting is more expensive than intersecting all triangles, as long as the
+    //   leaf does not become too large.
+    if (bestAxis==-1 || (bestCost >= leafCost && numTriangles <= 2*maxLeafSize)) {
+        nodes[iNode].index = begin;
+        nodes[iNode].numTriangles = numTriangles;
+        return iNode;
+    }
+    T scale = (T)numBins / (upperCentroid[bestAxis]-lowerCentroid[bestAxis]);
+    plint middle = begin;
+    for (plint i=begin; i<end; ++i) {
+        plint iTriangle = order[i];
+        plint iBin = std::min(numBins-1,
+                (plint)((centroids[iTriangle][bestAxis]-lowerCentroid[bestAxis])*scale));
+        if (iBin < bestSplit) {
+            std::swap(order[i], order[middle]);
+            ++middle;
+        }
+    }
+    PLB_ASSERT( middle>begin && middle<end );
+    buildNode(begin, middle, depth+1);
+    plint secondChild = buildNode(middle, end, depth+1);
+    nodes[iNode].index = secondChild;
+    nodes[iNode].numTriangles = 0;
+    return iNode;
+}
+
+/// Test if the segment fromPoint + t*direction, 0<=t<=1, crosses the box.
+template<typename T>
+inline bool segmentCrossesBox (
+        Array<T,3> const& fromPoint, Array<T,3> const& direction,
+        Array<T,3> const& lowerBound, Array<T,3> const& upperBound )
+{
+    T t0 = (T)0;
+    T t1 = (T)1;
+    for (int i=0; i<3; ++i) {
+        if (direction[i]==(T)0) {
+            if (fromPoint[i]<lowerBound[i] || fromPoint[i]>upperBound[i]) {
+                return false;
+            }
+        }
+        else {
+            T invDirection = (T)1/direction[i];
+            T tNear = (lowerBound[i]-fromPoint[i])*invDirection;
+            T tFar = (upperBound[i]-fromPoint[i])*invDirection;
+            if (tNear>tFar) std::swap(tNear, tFar);
+            t0 = std::max(t0, tNear);
+            t1 = std::min(t1, tFar);
+            if (t0>t1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+inline bool boxesOverlap (
+        Array<T,3> const& lower1, Array<T,3> const& upper1,
+        Array<T,3> const& lower2, Array<T,3> const& upper2 )
+{
+    return lower1[0]<=upper2[0] && upper1[0]>=lower2[0] &&
+           lower1[1]<=upper2[1] && upper1[1]>=lower2[1] &&
+           lower1[2]<=upper2[2] && upper1[2]>=lower2[2];
+}
+
+
+/* ******** class TriangleBvh ********************************************* */
+
+template<typename T>
+TriangleBvh<T>::TriangleBvh(AtomicContainerBlock3D& bvhContainer)
+    : container(bvhContainer),
+      data(*dynamic_cast<TriangleBvhData<T>*>(bvhContainer.getData()))
+{ }
+
+template<typename T>
+void TriangleBvh<T>::assignTriangles (
+        TriangularSurfaceMesh<T> const& mesh )
+{
+    std::vector<plint> triangleIds;
+    for (plint iTriangle=0; iTriangle<mesh.getNumTriangles(); ++iTriangle) {
+        triangleIds.push_back(iTriangle);
+    }
+    build(mesh, triangleIds);
+}
+
+template<typename T>
+template<class ParticleFieldT>
+void TriangleBvh<T>::reAssignTriangles (
+        TriangularSurfaceMesh<T> const& mesh,
+        ParticleFieldT& particles,
+        std::vector<plint> const& nonParallelVertices )
+{
+    // The same triangles are selected as in TriangleHash::reAssignTriangles.
+    Box3D domain(container.getBoundingBox());
+    Dot3D offset = computeRelativeDisplacement(container, particles);
+    domain = domain.shift(offset.x,offset.y,offset.z);
+    domain.enlarge(1);
+    std::vector<typename ParticleFieldT::ParticleT*> found;
+    particles.findParticles(domain, found);
+    std::set<plint> triangleIds;
+    for (pluint iParticle=0; iParticle<found.size(); ++iParticle) {
+        plint vertexId = found[iParticle]->getTag();
+        std::vector<plint> newTriangles (
+                mesh.getNeighborTriangleIds(vertexId) );
+        triangleIds.insert(newTriangles.begin(), newTriangles.end());
+    }
+    for (pluint iVertex=0; iVertex<nonParallelVertices.size(); ++iVertex) {
+        plint vertexId = nonParallelVertices[iVertex];
+        std::vector<plint> newTriangles (
+                mesh.getNeighborTriangleIds(vertexId) );
+        triangleIds.insert(newTriangles.begin(), newTriangles.end());
+    }
+    build(mesh, std::vector<plint>(triangleIds.begin(), triangleIds.end()));
+}
+
+template<typename T>
+void TriangleBvh<T>::build (
+        TriangularSurfaceMesh<T> const& mesh, std::vector<plint> const& triangleIds )
+{
+    Dot3D location(container.getLocation());
+    Box3D bbox(container.getBoundingBox());
+    std::vector<TriangleBvhNode<T> >().swap(data.nodes);
+    TriangleBvhBuilder<T> builder(data.nodes);
+    std::vector<plint> selected;
+    T scale = (T)1;
+    for (pluint iId=0; iId<triangleIds.size(); ++iId) {
+        plint iTriangle = triangleIds[iId];
+        Array<T,3> const& vertex0 = mesh.getVertex(iTriangle, 0);
+        Array<T,3> const& vertex1 = mesh.getVertex(iTriangle, 1);
+        Array<T,3> const& vertex2 = mesh.getVertex(iTriangle, 2);
+        Array<T,3> lowerBound, upperBound;
+        for (int i=0; i<3; ++i) {
+            lowerBound[i] = std::min(vertex0[i], std::min(vertex1[i], vertex2[i]));
+            upperBound[i] = std::max(vertex0[i], std::max(vertex1[i], vertex2[i]));
+        }
+        // Same selection as in the TriangleHash: the bounding box is fitted
+        //   onto the grid by making it bigger.
+        Box3D discreteRange (
+                (plint)lowerBound[0], (plint)upperBound[0]+1,
+                (plint)lowerBound[1], (plint)upperBound[1]+1,
+                (plint)lowerBound[2], (plint)upperBound[2]+1 );
+        discreteRange = discreteRange.shift (
+                -location.x, -location.y, -location.z );
+        Box3D inters;
+        if (intersect(discreteRange, bbox, inters)) {
+            selected.push_back(iTriangle);
+            builder.lowerBounds.push_back(lowerBound);
+            builder.upperBounds.push_back(upperBound);
+            builder.centroids.push_back((lowerBound+upperBound)*(T)0.5);
+            for (int i=0; i<3; ++i) {
+                scale = std::max(scale, std::max(std::fabs(lowerBound[i]), std::fabs(upperBound[i])));
+            }
+        }
+    }
+    // The boxes are enlarged slightly, so that no intersection is missed which
+    //   is detected by the round-off tolerant triangle tests of the mesh.
+    T margin = (T)1.e3*std::numeric_limits<T>::epsilon()*scale;
+    plint numTriangles = (plint)selected.size();
+    for (plint iTriangle=0; iTriangle<numTriangles; ++iTriangle) {
+        builder.lowerBounds[iTriangle] -= margin;
+        builder.upperBounds[iTriangle] += margin;
+        builder.order.push_back(iTriangle);
+    }
+    if (numTriangles>0) {
+        builder.nodes.reserve(2*numTriangles/TriangleBvhBuilder<T>::maxLeafSize+1);
+        builder.buildNode(0, numTriangles, 0);
+    }
+    data.triangles.resize(numTriangles);
+    data.lowerBounds.resize(numTriangles);
+    data.upperBounds.resize(numTriangles);
+    for (plint i=0; i<numTriangles; ++i) {
+        plint iTriangle = builder.order[i];
+        data.triangles[i] = selected[iTriangle];
+        data.lowerBounds[i] = builder.lowerBounds[iTriangle];
+        data.upperBounds[i] = builder.upperBounds[iTriangle];
+    }
+}
+
+template<typename T>
+void TriangleBvh<T>::getCandidates (
+        Array<T,3> const& lowerBound, Array<T,3> const& upperBound,
+        std::vector<plint>& candidates ) const
+{
+    candidates.clear();
+    if (data.nodes.empty()) return;
+    plint stack[TriangleBvhBuilder<T>::maxDepth+2];
+    plint stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize>0) {
+        plint iNode = stack[--stackSize];
+        TriangleBvhNode<T> const& node = data.nodes[iNode];
+        if (!boxesOverlap(lowerBound, upperBound, node.lowerBound, node.upperBound)) {
+            continue;
+        }
+        if (node.numTriangles>0) {
+            for (plint i=node.index; i<node.index+node.numTriangles; ++i) {
+                if (boxesOverlap(lowerBound, upperBound, data.lowerBounds[i], data.upperBounds[i])) {
+                    candidates.push_back(i);
+                }
+            }
+        }
+        else {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = iNode+1;
+        }
+    }
+}
+
+template<typename T>
+void TriangleBvh<T>::selectOnSegment (
+        std::vector<plint> const& candidates,
+        Array<T,3> const& point1, Array<T,3> const& point2,
+        std::vector<plint>& foundTriangles ) const
+{
+    foundTriangles.clear();
+    Array<T,3> direction(point2-point1);
+    for (pluint iCandidate=0; iCandidate<candidates.size(); ++iCandidate) {
+        plint i = candidates[iCandidate];
+        if (segmentCrossesBox(point1, direction, data.lowerBounds[i], data.upperBounds[i])) {
+            foundTriangles.push_back(data.triangles[i]);
+        }
+    }
+    std::sort(foundTriangles.begin(), foundTriangles.end());
+}
+
+template<typename T>
+void TriangleBvh<T>::getTriangles (
+        Array<T,3> const& lowerBound, Array<T,3> const& upperBound,
+        std::vector<plint>& foundTriangles ) const
+{
+    getCandidates(lowerBound, upperBound, foundTriangles);
+    for (pluint i=0; i<foundTriangles.size(); ++i) {
+        foundTriangles[i] = data.triangles[foundTriangles[i]];
+    }
+    std::sort(foundTriangles.begin(), foundTriangles.end());
+}
+
+template<typename T>
+void TriangleBvh<T>::getTriangles (
+        Array<T,2> const& xRange,
+        Array<T,2> const& yRange,
+        Array<T,2> const& zRange,
+        std::vector<plint>& foundTriangles ) const
+{
+    getTriangles( Array<T,3>(xRange[0], yRange[0], zRange[0]),
+                  Array<T,3>(xRange[1], yRange[1], zRange[1]), foundTriangles );
+}
+
+template<typename T>
+void TriangleBvh<T>::getTrianglesOnSegment (
+        Array<T,3> const& point1, Array<T,3> const& point2,
+        std::vector<plint>& foundTriangles ) const
+{
+    foundTriangles.clear();
+    if (data.nodes.empty()) return;
+    Array<T,3> direction(point2-point1);
+    plint stack[TriangleBvhBuilder<T>::maxDepth+2];
+    plint stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize>0) {
+        plint iNode = stack[--stackSize];
+        TriangleBvhNode<T> const& node = data.nodes[iNode];
+        if (!segmentCrossesBox(point1, direction, node.lowerBound, node.upperBound)) {
+            continue;
+        }
+        if (node.numTriangles>0) {
+            for (plint i=node.index; i<node.index+node.numTriangles; ++i) {
+                if (segmentCrossesBox(point1, direction, data.lowerBounds[i], data.upperBounds[i])) {
+                    foundTriangles.push_back(data.triangles[i]);
+                }
+            }
+        }
+        else {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = iNode+1;
+        }
+    }
+    std::sort(foundTriangles.begin(), foundTriangles.end());
+}
+
+template<typename T>
+void TriangleBvh<T>::getTrianglesOnSegments (
+        Array<T,3> const& fromPoint, std::vector<Array<T,3> > const& directions,
+        std::vector<std::vector<plint> >& foundTriangles ) const
+{
+    Array<T,3> lowerBound(fromPoint), upperBound(fromPoint);
+    for (pluint iDir=0; iDir<directions.size(); ++iDir) {
+        Array<T,3> toPoint(fromPoint+directions[iDir]);
+        TriangleBvhBuilder<T>::include(lowerBound, upperBound, toPoint, toPoint);
+    }
+    std::vector<plint> candidates;
+    getCandidates(lowerBound, upperBound, candidates);
+    foundTriangles.resize(directions.size());
+    for (pluint iDir=0; iDir<directions.size(); ++iDir) {
+        selectOnSegment(candidates, fromPoint, fromPoint+directions[iDir], foundTriangles[iDir]);
+    }
+}
+
+template<typename T>
+plint TriangleBvh<T>::getNumNodes() const {
+    return (plint)data.nodes.size();
+}
+
+template<typename T>
+plint TriangleBvh<T>::getNumTriangles() const {
+    return (plint)data.triangles.size();
+}
+
+template<typename T>
+bool containsTriangleBvh(AtomicContainerBlock3D& container) {
+    return dynamic_cast<TriangleBvhData<T>*>(container.getData()) != 0;
+}
+
+
+/* ******** CreateTriangleBvh ************************************ */
+
+template<typename T>
+CreateTriangleBvh<T>::CreateTriangleBvh (
+        TriangularSurfaceMesh<T> const& mesh_ )
+    :  mesh(mesh_)
+{ }
+
+template<typename T>
+void CreateTriangleBvh<T>::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> blocks )
+{
+    PLB_PRECONDITION( blocks.size()==1 );
+    AtomicContainerBlock3D* container =
+        dynamic_cast<AtomicContainerBlock3D*>(blocks[0]);
+    PLB_ASSERT( container );
+    container->setData(new TriangleBvhData<T>);
+    TriangleBvh<T>(*container).assignTriangles(mesh);
+}
+
+template<typename T>
+CreateTriangleBvh<T>* CreateTriangleBvh<T>::clone() const {
+    return new CreateTriangleBvh<T>(*this);
+}
+
+template<typename T>
+void CreateTriangleBvh<T>::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    modified[0] = modif::staticVariables;  // Container Block with BVH data.
+}
+
+template<typename T>
+BlockDomain::DomainT CreateTriangleBvh<T>::appliesTo() const {
+    return BlockDomain::bulk;
+}
+
+
+/* ******** ReAssignTriangleBvh ************************************ */
+
+template<typename T, class ParticleFieldT>
+ReAssignTriangleBvh<T,ParticleFieldT>::ReAssignTriangleBvh (
+        TriangularSurfaceMesh<T> const& mesh_,
+        std::vector<plint> const& nonParallelVertices_ )
+    :  mesh(mesh_),
+       nonParallelVertices(nonParallelVertices_)
+{ }
+
+template<typename T, class ParticleFieldT>
+void ReAssignTriangleBvh<T,ParticleFieldT>::processGenericBlocks (
+        Box3D domain, std::vector<AtomicBlock3D*> blocks )
+{
+    PLB_PRECONDITION( blocks.size()==2 );
+    AtomicContainerBlock3D* container =
+        dynamic_cast<AtomicContainerBlock3D*>(blocks[0]);
+    PLB_ASSERT( container );
+    ParticleFieldT* particles =
+        dynamic_cast<ParticleFieldT*>(blocks[1]);
+    PLB_ASSERT( particles );
+    TriangleBvh<T>(*container).reAssignTriangles (
+            mesh,*particles,nonParallelVertices);
+}
+
+template<typename T, class ParticleFieldT>
+ReAssignTriangleBvh<T,ParticleFieldT>* ReAssignTriangleBvh<T,ParticleFieldT>::clone() const {
+    return new ReAssignTriangleBvh<T,ParticleFieldT>(*this);
+}
+
+template<typename T, class ParticleFieldT>
+void ReAssignTriangleBvh<T,ParticleFieldT>::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    modified[0] = modif::staticVariables;  // Container Block with BVH data.
+    modified[1] = modif::nothing; // Vertex-Particles.
+}
+
+template<typename T, class ParticleFieldT>
+BlockDomain::DomainT ReAssignTriangleBvh<T,ParticleFieldT>::appliesTo() const {
+    return BlockDomain::bulk;
+}
+
+}  // namespace plb
+
+#endif  // TRIANGLE_BVH_HH
@@ -47,7 +47,11 @@ public:
     TriangleSet(T eps_);
     TriangleSet(std::vector<Triangle> const& triangles_, Precision precision_ = DBL, TriangleSelector<T>* selector = 0);
     TriangleSet(std::vector<Triangle> const& triangles_, T eps_, TriangleSelector<T>* selector = 0);
-    // Currently only STL and OFF files are supported by this class.
+    // Currently only STL and OFF files are supported by this class. The file is read
+    //   by the main processor and the triangles are broadcast: these constructors
+    //   are collective, and must be called by all processes. Constructing the
+    //   TriangleSet from a file on the main processor only (for example inside an
+    //   "if (global::mpi().isMainProcessor())" block) blocks the program.
     TriangleSet(std::string fname, Precision precision_ = DBL, SurfaceGeometryFileFormat fformat = STL,
             TriangleSelector<T>* selector = 0);
     TriangleSet(std::string fname, T eps_, SurfaceGeometryFileFormat fformat = STL,
@@ -237,6 +241,8 @@ private:
     void readBinarySTL(FILE* fp, TriangleSelector<T>* selector);
     void readOFF(std::string fname, TriangleSelector<T>* selector);
     void readAsciiOFF(FILE* fp, TriangleSelector<T>* selector);
+    /// Send the triangles of the main processor to all other processes.
+    void broadcastTriangles();
     bool triangleHasZeroArea(Triangle const& triangle, T epsilon) const;
     bool triangleHasZeroLengthEdges(Triangle const& triangle, T epsilon) const;
     void fixOrientation(Triangle& triangle, Array<T,3> const& n) const;
@@ -31,6 +31,7 @@
 #include "core/globalDefs.h"
 #include "core/util.h"
 #include "latticeBoltzmann/geometricOperationTemplates.h"
+#include "parallelism/mpiManager.h"
 
 #include <algorithm>
 #include <limits>
@@ -226,16 +227,21 @@ void TriangleSet<T>::setEpsilon(T eps_)
 template<typename T>
 void TriangleSet<T>::readSTL(std::string fname, TriangleSelector<T>* selector)
 {
-    FILE* fp = fopen(fname.c_str(), "rb");
-    PLB_ASSERT(fp != 0); // The input file cannot be read.
+    // Only the main processor opens the file: when all processes read the
+    //   same file simultaneously, the file system becomes a bottleneck.
+    if (global::mpi().isMainProcessor()) {
+        FILE* fp = fopen(fname.c_str(), "rb");
+        PLB_ASSERT(fp != 0); // The input file cannot be read.
+
+        if (isAsciiSTL(fp)) {
+            readAsciiSTL(fp, selector);
+        } else {
+            readBinarySTL(fp, selector);
+        }
 
-    if (isAsciiSTL(fp)) {
-        readAsciiSTL(fp, selector);
-    } else {
-        readBinarySTL(fp, selector);
+        fclose(fp);
     }
-
-    fclose(fp);
+    broadcastTriangles();
 }
 
 template<typename T>
@@ -480,42 +486,45 @@ void TriangleSet<T>::readBinarySTL(FILE* fp, TriangleSelector<T>* selector)
 template<typename T>
 void TriangleSet<T>::readOFF(std::string fname, TriangleSelector<T>* selector)
 {
-    FILE *fp = fopen(fname.c_str(), "rb");
-    PLB_ASSERT(fp != 0); // The input file cannot be read.
+    if (global::mpi().isMainProcessor()) {
+        FILE *fp = fopen(fname.c_str(), "rb");
+        PLB_ASSERT(fp != 0); // The input file cannot be read.
 
-    char buf[PLB_CBUFSIZ];
+        char buf[PLB_CBUFSIZ];
 #ifdef PLB_DEBUG
-    char *sp = fgets(buf, PLB_CBUFSIZ, fp);
+        char *sp = fgets(buf, PLB_CBUFSIZ, fp);
 #else
-    (void) fgets(buf, PLB_CBUFSIZ, fp);
+        (void) fgets(buf, PLB_CBUFSIZ, fp);
 #endif
-    PLB_ASSERT(sp != NULL); // The input file cannot be read.
-
-    char *cp = NULL;
-
-    // Currently only ASCII files with header OFF can be read.
-    cp = strstr(buf, "BINARY");
-    PLB_ASSERT(cp == NULL);
-    std::vector<std::string> prefixes;
-    prefixes.push_back("ST");
-    prefixes.push_back("C");
-    prefixes.push_back("N");
-    prefixes.push_back("4");
-    prefixes.push_back("n");
-    for (int iPrefix = 0; iPrefix < (int) prefixes.size(); iPrefix++) {
-        cp = strstr(buf, prefixes[iPrefix].c_str());
+        PLB_ASSERT(sp != NULL); // The input file cannot be read.
+
+        char *cp = NULL;
+
+        // Currently only ASCII files with header OFF can be read.
+        cp = strstr(buf, "BINARY");
         PLB_ASSERT(cp == NULL);
-    }
+        std::vector<std::string> prefixes;
+        prefixes.push_back("ST");
+        prefixes.push_back("C");
+        prefixes.push_back("N");
+        prefixes.push_back("4");
+        prefixes.push_back("n");
+        for (int iPrefix = 0; iPrefix < (int) prefixes.size(); iPrefix++) {
+            cp = strstr(buf, prefixes[iPrefix].c_str());
+            PLB_ASSERT(cp == NULL);
+        }
 
-    cp = strstr(buf, "OFF");
+        cp = strstr(buf, "OFF");
 
-    if (cp != NULL) {
-        readAsciiOFF(fp, selector);
-    } else {
-        PLB_ASSERT(false); // Nothing else is currently supported.
-    }
+        if (cp != NULL) {
+            readAsciiOFF(fp, selector);
+        } else {
+            PLB_ASSERT(false); // Nothing else is currently supported.
+        }
 
-    fclose(fp);
+        fclose(fp);
+    }
+    broadcastTriangles();
 }
 
 template<typename T>
@@ -589,6 +598,34 @@ void TriangleSet<T>::readAsciiOFF(FILE* fp, TriangleSelector<T>* selector)
     }
 }
 
+template<typename T>
+void TriangleSet<T>::broadcastTriangles()
+{
+    plint numTriangles = (plint) triangles.size();
+    global::mpi().bCast(&numTriangles, 1);
+    if (numTriangles == 0 || global::mpi().getSize() == 1) {
+        return;
+    }
+
+    std::vector<T> buffer(9*numTriangles);
+    if (global::mpi().isMainProcessor()) {
+        for (plint iTriangle = 0; iTriangle < numTriangles; iTriangle++) {
+            for (int iVertex = 0; iVertex < 3; iVertex++) {
+                triangles[iTriangle][iVertex].to_cArray(&buffer[9*iTriangle+3*iVertex]);
+            }
+        }
+    }
+    global::mpi().bCast(&buffer[0], (int) buffer.size());
+    if (!global::mpi().isMainProcessor()) {
+        triangles.resize(numTriangles);
+        for (plint iTriangle = 0; iTriangle < numTriangles; iTriangle++) {
+            for (int iVertex = 0; iVertex < 3; iVertex++) {
+                triangles[iTriangle][iVertex].from_cArray(&buffer[9*iTriangle+3*iVertex]);
+            }
+        }
+    }
+}
+
 template<typename T>
 bool TriangleSet<T>::triangleHasZeroArea(Triangle const& triangle, T epsilon) const
 {
@@ -31,6 +31,7 @@
 #include "atomicBlock/dataProcessingFunctional3D.h"
 #include "multiBlock/multiBlockManagement3D.h"
 #include "offLattice/triangleHash.h"
+#include "offLattice/triangleBvh.h"
 #include <memory>
 
 namespace plb {
@@ -68,26 +69,45 @@ std::auto_ptr<MultiScalarField3D<int> > voxelize (
         TriangularSurfaceMesh<T> const& mesh,
         Box3D const& domain, plint borderWidth );
 
-// For faster results, the "seed" should contain at least one of the domain corners.
+/// Deprecated: the seed is no longer needed, since the voxelization does not
+///   propagate from one cell to another, and it is ignored. Contrary to the
+///   version without seed, the cells on the outer layer of the domain are
+///   voxelized as well.
 template<typename T>
 std::auto_ptr<MultiScalarField3D<int> > voxelize (
         TriangularSurfaceMesh<T> const& mesh,
         Box3D const& domain, plint borderWidth, Box3D seed );
 
-// For faster results, the "seed" should contain at least one of the domain corners.
+/// Deprecated: the seed is ignored.
 template<typename T>
 std::auto_ptr<MultiScalarField3D<int> > voxelize (
         TriangularSurfaceMesh<T> const& mesh,
         MultiBlockManagement3D const& management,
         plint borderWidth, Box3D seed );
 
+/// Voxelize the mesh again, on the same multi-block structure as the old voxel
+///   matrix.
+template<typename T>
+std::auto_ptr<MultiScalarField3D<int> > revoxelize (
+        TriangularSurfaceMesh<T> const& mesh,
+        MultiScalarField3D<int>& oldVoxelMatrix, plint borderWidth );
 
+/// Deprecated: the hash container is ignored. A block-wise hash only holds the
+///   triangles of the block, while the rays of the voxelizer need the triangles
+///   on their whole length.
 template<typename T>
 std::auto_ptr<MultiScalarField3D<int> > revoxelize (
         TriangularSurfaceMesh<T> const& mesh,
         MultiScalarField3D<int>& oldVoxelMatrix,
         MultiContainerBlock3D& hashContainer, plint borderWidth );
 
+/// Create a container holding a TriangleBvh with all triangles of the mesh. It
+///   is used by the voxelizer to find the triangles crossed by the rays of a
+///   block, and is built once for all blocks of the process.
+template<typename T>
+std::auto_ptr<AtomicContainerBlock3D> createVoxelizerBvh (
+        TriangularSurfaceMesh<T> const& mesh );
+
 template<typename T>
 class VoxelizeMeshFunctional3D : public BoxProcessingFunctional3D {
 public:
@@ -120,6 +140,44 @@ private:
     bool useFullVoxelizationRange;
 };
 
+/// Voxelization of each block in a single pass, without seed and without
+///   communication between the blocks.
+/** Every cell is classified by casting three rays through it, along the x-,
+ *  y- and z-axis, and counting the crossings with the surface on the side of
+ *  the negative coordinates. The cell is inside when the count is odd for at
+ *  least two of the three rays. On a closed surface, the three rays always
+ *  agree; on a surface with holes, the vote only fails for cells whose rays
+ *  pass through holes in more than one direction.
+ *
+ *  A ray crosses a triangle if it falls inside the projection of the triangle
+ *  onto the plane normal to the ray. Rays which hit an edge or a vertex are
+ *  displaced by an infinitesimal amount (symbolic perturbation), so that a
+ *  crossing through a shared edge is counted exactly once.
+ *
+ *  If a TriangleBvh of the whole mesh is provided, only the triangles whose
+ *  bounding box meets the rays of the block are examined. Otherwise, every
+ *  block loops over all triangles of the mesh.
+ */
+template<typename T>
+class VoxelizeMeshByParityFunctional3D : public BoxProcessingFunctional3D_S<int> {
+public:
+    VoxelizeMeshByParityFunctional3D (
+            TriangularSurfaceMesh<T> const& mesh_, TriangleBvh<T> const* bvh_ = 0 );
+    virtual void process(Box3D domain, ScalarField3D<int>& voxels);
+    virtual VoxelizeMeshByParityFunctional3D<T>* clone() const;
+    virtual void getTypeOfModification(std::vector<modif::ModifT>& modified) const;
+    virtual BlockDomain::DomainT appliesTo() const;
+private:
+    /// Orientation of the point p with respect to the edge (a,b), in the plane of
+    ///   the coordinates u and v. The return value is zero if p is on the line through
+    ///   the edge; the sign accounts for the symbolic perturbation of p in this case.
+    static T orientation( Array<T,3> const& a, Array<T,3> const& b,
+                          T pu, T pv, int u, int v, int& sign );
+private:
+    TriangularSurfaceMesh<T> const& mesh;
+    TriangleBvh<T> const* bvh;
+};
+
 class UndeterminedToFlagFunctional3D : public BoxProcessingFunctional3D_S<int> {
 public:
     UndeterminedToFlagFunctional3D(int flag_);
@@ -29,6 +29,7 @@
 
 #include "core/globalDefs.h"
 #include "offLattice/voxelizer.h"
+#include "offLattice/triangleBvh.hh"
 #include "atomicBlock/dataField3D.h"
 #include "multiBlock/multiBlockGenerator3D.h"
 #include "multiBlock/defaultMultiBlockPolicy3D.h"
@@ -37,6 +38,10 @@
 #include "dataProcessors/metaStuffWrapper3D.h"
 #include "dataProcessors/metaStuffWrapper3D.h"
 #include "core/plbTimer.h"
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <limits>
 
 namespace plb {
 
@@ -105,37 +110,15 @@ std::auto_ptr<MultiScalarField3D<int> > voxelize (
         TriangularSurfaceMesh<T> const& mesh,
         Box3D const& domain, plint borderWidth )
 {
-    // As initial seed, a one-cell layer around the outer boundary is tagged
-    //   as ouside cells.
+    // A one-cell layer around the outer boundary is tagged as outside cells.
     plint envelopeWidth=1;
     std::auto_ptr<MultiScalarField3D<int> > voxelMatrix
         = generateMultiScalarField<int>(domain, voxelFlag::outside, envelopeWidth);
-    setToConstant(*voxelMatrix, voxelMatrix->getBoundingBox().enlarge(-1),
-                  voxelFlag::undetermined);
-
-    MultiContainerBlock3D hashContainer(*voxelMatrix);
-    std::vector<MultiBlock3D*> container_arg;
-    container_arg.push_back(&hashContainer);
+    std::auto_ptr<AtomicContainerBlock3D> bvhContainer(createVoxelizerBvh(mesh));
+    TriangleBvh<T> bvh(*bvhContainer);
     applyProcessingFunctional (
-            new CreateTriangleHash<T>(mesh),
-            hashContainer.getBoundingBox(), container_arg );
-
-    std::vector<MultiBlock3D*> flag_hash_arg;
-    flag_hash_arg.push_back(voxelMatrix.get());
-    flag_hash_arg.push_back(&hashContainer);
-
-    voxelMatrix->resetFlags(); // Flags are used internally by VoxelizeMeshFunctional3D.
-    plint maxIteration=5000;
-    plint i=0;
-    while (!allFlagsTrue(voxelMatrix.get()) && i<maxIteration) {
-        applyProcessingFunctional (
-                new VoxelizeMeshFunctional3D<T>(mesh),
-                voxelMatrix->getBoundingBox(), flag_hash_arg );
-        ++i;
-    }
-    if (i==maxIteration) {
-        pcout << "Warning: Voxelization failed." << std::endl;
-    }
+            new VoxelizeMeshByParityFunctional3D<T>(mesh, &bvh),
+            voxelMatrix->getBoundingBox().enlarge(-1), *voxelMatrix );
 
     detectBorderLine(*voxelMatrix, voxelMatrix->getBoundingBox(), borderWidth);
 
@@ -147,38 +130,14 @@ std::auto_ptr<MultiScalarField3D<int> > voxelize (
         TriangularSurfaceMesh<T> const& mesh,
         Box3D const& domain, plint borderWidth, Box3D seed )
 {
-    // As initial seed, a one-cell layer around the outer boundary is tagged
-    //   as ouside cells.
     plint envelopeWidth=1;
-
     std::auto_ptr<MultiScalarField3D<int> > voxelMatrix
         = generateMultiScalarField<int>(domain, voxelFlag::undetermined, envelopeWidth);
-    setToConstant(*voxelMatrix, seed, voxelFlag::outside);
-
-    MultiContainerBlock3D hashContainer(*voxelMatrix);
-    std::vector<MultiBlock3D*> container_arg;
-    container_arg.push_back(&hashContainer);
+    std::auto_ptr<AtomicContainerBlock3D> bvhContainer(createVoxelizerBvh(mesh));
+    TriangleBvh<T> bvh(*bvhContainer);
     applyProcessingFunctional (
-            new CreateTriangleHash<T>(mesh),
-            hashContainer.getBoundingBox(), container_arg );
-
-    std::vector<MultiBlock3D*> flag_hash_arg;
-    flag_hash_arg.push_back(voxelMatrix.get());
-    flag_hash_arg.push_back(&hashContainer);
-
-    voxelMatrix->resetFlags(); // Flags are used internally by VoxelizeMeshFunctional3D.
-    plint maxIteration=5000;
-    plint i=0;
-    while (!allFlagsTrue(voxelMatrix.get()) && i<maxIteration) {
-        bool useFullVoxelizationRange = (i == 0 ? true : false);
-        applyProcessingFunctional (
-                new VoxelizeMeshFunctional3D<T>(mesh, useFullVoxelizationRange),
-                voxelMatrix->getBoundingBox(), flag_hash_arg );
-        ++i;
-    }
-    if (i==maxIteration) {
-        pcout << "Warning: Voxelization failed." << std::endl;
-    }
+            new VoxelizeMeshByParityFunctional3D<T>(mesh, &bvh),
+            voxelMatrix->getBoundingBox(), *voxelMatrix );
 
     detectBorderLine(*voxelMatrix, voxelMatrix->getBoundingBox(), borderWidth);
 
@@ -191,36 +150,13 @@ std::auto_ptr<MultiScalarField3D<int> > voxelize (
         MultiBlockManagement3D const& management,
         plint borderWidth, Box3D seed )
 {
-    // As initial seed, a one-cell layer around the outer boundary is tagged
-    //   as ouside cells.
     std::auto_ptr<MultiScalarField3D<int> > voxelMatrix
         = defaultGenerateMultiScalarField3D<int>(management, voxelFlag::undetermined);
-    setToConstant(*voxelMatrix, seed, voxelFlag::outside);
-
-    MultiContainerBlock3D hashContainer(*voxelMatrix);
-    std::vector<MultiBlock3D*> container_arg;
-    container_arg.push_back(&hashContainer);
+    std::auto_ptr<AtomicContainerBlock3D> bvhContainer(createVoxelizerBvh(mesh));
+    TriangleBvh<T> bvh(*bvhContainer);
     applyProcessingFunctional (
-            new CreateTriangleHash<T>(mesh),
-            hashContainer.getBoundingBox(), container_arg );
-
-    std::vector<MultiBlock3D*> flag_hash_arg;
-    flag_hash_arg.push_back(voxelMatrix.get());
-    flag_hash_arg.push_back(&hashContainer);
-
-    voxelMatrix->resetFlags(); // Flags are used internally by VoxelizeMeshFunctional3D.
-    plint maxIteration=5000;
-    plint i=0;
-    while (!allFlagsTrue(voxelMatrix.get()) && i<maxIteration) {
-        bool useFullVoxelizationRange = (i == 0 ? true : false);
-        applyProcessingFunctional (
-                new VoxelizeMeshFunctional3D<T>(mesh, useFullVoxelizationRange),
-                voxelMatrix->getBoundingBox(), flag_hash_arg );
-        ++i;
-    }
-    if (i==maxIteration) {
-        pcout << "Warning: Voxelization failed." << std::endl;
-    }
+            new VoxelizeMeshByParityFunctional3D<T>(mesh, &bvh),
+            voxelMatrix->getBoundingBox(), *voxelMatrix );
 
     detectBorderLine(*voxelMatrix, voxelMatrix->getBoundingBox(), borderWidth);
 
@@ -230,38 +166,232 @@ std::auto_ptr<MultiScalarField3D<int> > voxelize (
 template<typename T>
 std::auto_ptr<MultiScalarField3D<int> > revoxelize (
         TriangularSurfaceMesh<T> const& mesh,
-        MultiScalarField3D<int>& oldVoxelMatrix,
-        MultiContainerBlock3D& hashContainer, plint borderWidth )
+        MultiScalarField3D<int>& oldVoxelMatrix, plint borderWidth )
 {
-    // As initial seed, a one-cell layer around the outer boundary is tagged
-    //   as ouside cells.
+    // A one-cell layer around the outer boundary is tagged as outside cells.
     Box3D domain(oldVoxelMatrix.getBoundingBox());
     std::auto_ptr<MultiScalarField3D<int> > voxelMatrix (
             new MultiScalarField3D<int>((MultiBlock3D&)oldVoxelMatrix) );
     setToConstant(*voxelMatrix, domain, voxelFlag::outside);
-    setToConstant(*voxelMatrix, voxelMatrix->getBoundingBox().enlarge(-1),
-                  voxelFlag::undetermined);
+    std::auto_ptr<AtomicContainerBlock3D> bvhContainer(createVoxelizerBvh(mesh));
+    TriangleBvh<T> bvh(*bvhContainer);
+    applyProcessingFunctional (
+            new VoxelizeMeshByParityFunctional3D<T>(mesh, &bvh),
+            voxelMatrix->getBoundingBox().enlarge(-1), *voxelMatrix );
+
+    detectBorderLine(*voxelMatrix, voxelMatrix->getBoundingBox(), borderWidth);
+
+    return std::auto_ptr<MultiScalarField3D<int> >(voxelMatrix);
+}
+
+template<typename T>
+std::auto_ptr<MultiScalarField3D<int> > revoxelize (
+        TriangularSurfaceMesh<T> const& mesh,
+        MultiScalarField3D<int>& oldVoxelMatrix,
+        MultiContainerBlock3D& hashContainer, plint borderWidth )
+{
+    return revoxelize(mesh, oldVoxelMatrix, borderWidth);
+}
+
+template<typename T>
+std::auto_ptr<AtomicContainerBlock3D> createVoxelizerBvh (
+        TriangularSurfaceMesh<T> const& mesh )
+{
+    // The TriangleBvh only keeps the triangles which intersect its container:
+    //   the container is placed around the whole mesh.
+    Array<T,2> xRange, yRange, zRange;
+    mesh.computeBoundingBox(xRange, yRange, zRange);
+    Dot3D location( (plint)std::floor(xRange[0])-1,
+                    (plint)std::floor(yRange[0])-1,
+                    (plint)std::floor(zRange[0])-1 );
+    std::auto_ptr<AtomicContainerBlock3D> container (
+            new AtomicContainerBlock3D (
+                (plint)std::ceil(xRange[1])-location.x+2,
+                (plint)std::ceil(yRange[1])-location.y+2,
+                (plint)std::ceil(zRange[1])-location.z+2 ) );
+    container->setLocation(location);
+    container->setData(new TriangleBvhData<T>);
+    TriangleBvh<T>(*container).assignTriangles(mesh);
+    return container;
+}
+
+
+/* ******** VoxelizeMeshByParityFunctional3D ***************************** */
+
+template<typename T>
+VoxelizeMeshByParityFunctional3D<T>::VoxelizeMeshByParityFunctional3D (
+        TriangularSurfaceMesh<T> const& mesh_, TriangleBvh<T> const* bvh_ )
+    : mesh(mesh_),
+      bvh(bvh_)
+{ }
+
+template<typename T>
+T VoxelizeMeshByParityFunctional3D<T>::orientation (
+        Array<T,3> const& a, Array<T,3> const& b,
+        T pu, T pv, int u, int v, int& sign )
+{
+    // The edge is always evaluated in the same direction, so that two triangles
+    //   which share it obtain exactly opposite results.
+    bool swapped = b[u]<a[u] || (b[u]==a[u] && b[v]<a[v]);
+    Array<T,3> const& p0 = swapped ? b : a;
+    Array<T,3> const& p1 = swapped ? a : b;
+    T eu = p1[u]-p0[u];
+    T ev = p1[v]-p0[v];
+    T result = eu*(pv-p0[v]) - ev*(pu-p0[u]);
+    if (result > T()) {
+        sign = 1;
+    }
+    else if (result < T()) {
+        sign = -1;
+    }
+    else {
+        // The point is displaced by (epsilon, epsilon^2), which adds
+        //   -ev*epsilon + eu*epsilon^2 to the orientation.
+        if (ev != T()) {
+            sign = ev > T() ? -1 : 1;
+        }
+        else if (eu != T()) {
+            sign = eu > T() ? 1 : -1;
+        }
+        else {
+            sign = 0;  // Degenerate edge.
+        }
+    }
+    if (swapped) {
+        sign = -sign;
+        result = -result;
+    }
+    return result;
+}
 
-    std::vector<MultiBlock3D*> flag_hash_arg;
-    flag_hash_arg.push_back(voxelMatrix.get());
-    flag_hash_arg.push_back(&hashContainer);
+template<typename T>
+void VoxelizeMeshByParityFunctional3D<T>::process (
+        Box3D domain, ScalarField3D<int>& voxels )
+{
+    Dot3D location = voxels.getLocation();
+    Array<plint,3> lo(domain.x0+location.x, domain.y0+location.y, domain.z0+location.z);
+    Array<plint,3> hi(domain.x1+location.x, domain.y1+location.y, domain.z1+location.z);
+    Array<plint,3> n(domain.getNx(), domain.getNy(), domain.getNz());
+
+    // For each ray direction, the crossings of all rays through the domain are
+    //   collected as (ray index, coordinate along the ray). Crossings beyond the
+    //   end of the domain do not influence the parity, and are not stored.
+    std::vector<std::pair<plint,T> > crossings[3];
+    std::vector<plint> candidates;
+    if (!bvh) {
+        candidates.resize(mesh.getNumTriangles());
+        for (plint iTriangle=0; iTriangle<mesh.getNumTriangles(); ++iTriangle) {
+            candidates[iTriangle] = iTriangle;
+        }
+    }
+    for (int axis=0; axis<3; ++axis) {
+        int u = (axis+1)%3;
+        int v = (axis+2)%3;
+        if (bvh) {
+            // The rays along this axis cover the cross-section of the domain, and
+            //   extend from minus infinity to the end of the domain.
+            Array<T,3> lowerBound, upperBound;
+            lowerBound[axis] = -std::numeric_limits<T>::max();
+            upperBound[axis] = (T)hi[axis];
+            lowerBound[u] = (T)lo[u];
+            upperBound[u] = (T)hi[u];
+            lowerBound[v] = (T)lo[v];
+            upperBound[v] = (T)hi[v];
+            bvh->getTriangles(lowerBound, upperBound, candidates);
+        }
+        for (pluint iCandidate=0; iCandidate<candidates.size(); ++iCandidate) {
+            plint iTriangle = candidates[iCandidate];
+            Array<T,3> const& p0 = mesh.getVertex(iTriangle, 0);
+            Array<T,3> const& p1 = mesh.getVertex(iTriangle, 1);
+            Array<T,3> const& p2 = mesh.getVertex(iTriangle, 2);
+            Array<T,3> pMin, pMax;
+            for (int d=0; d<3; ++d) {
+                pMin[d] = std::min(p0[d], std::min(p1[d], p2[d]));
+                pMax[d] = std::max(p0[d], std::max(p1[d], p2[d]));
+            }
+            if (pMin[axis] >= (T)hi[axis]) {
+                continue;
+            }
+            plint u0 = std::max(lo[u], (plint)std::ceil(pMin[u]));
+            plint u1 = std::min(hi[u], (plint)std::floor(pMax[u]));
+            plint v0 = std::max(lo[v], (plint)std::ceil(pMin[v]));
+            plint v1 = std::min(hi[v], (plint)std::floor(pMax[v]));
+            for (plint iU=u0; iU<=u1; ++iU) {
+                for (plint iV=v0; iV<=v1; ++iV) {
+                    int s0, s1, s2;
+                    T w0 = orientation(p1, p2, (T)iU, (T)iV, u, v, s0);
+                    T w1 = orientation(p2, p0, (T)iU, (T)iV, u, v, s1);
+                    T w2 = orientation(p0, p1, (T)iU, (T)iV, u, v, s2);
+                    if (s0==0 || s0!=s1 || s0!=s2) {
+                        continue;
+                    }
+                    T sum = w0+w1+w2;
+                    if (sum == T()) {
+                        continue;
+                    }
+                    T coordinate = (w0*p0[axis] + w1*p1[axis] + w2*p2[axis]) / sum;
+                    if (coordinate < (T)hi[axis]) {
+                        plint ray = (iU-lo[u])*n[v] + (iV-lo[v]);
+                        crossings[axis].push_back(std::make_pair(ray, coordinate));
+                    }
+                }
+            }
+        }
+    }
 
-    voxelMatrix->resetFlags(); // Flags are used internally by VoxelizeMeshFunctional3D.
-    plint maxIteration=5000;
-    plint i=0;
-    while (!allFlagsTrue(voxelMatrix.get()) && i<maxIteration) {
-        applyProcessingFunctional (
-                new VoxelizeMeshFunctional3D<T>(mesh),
-                voxelMatrix->getBoundingBox(), flag_hash_arg );
-        ++i;
+    // Each cell receives one vote for each ray along which it is inside.
+    ScalarField3D<int> votes(n[0], n[1], n[2], 0);
+    for (int axis=0; axis<3; ++axis) {
+        int u = (axis+1)%3;
+        int v = (axis+2)%3;
+        std::sort(crossings[axis].begin(), crossings[axis].end());
+        pluint iCrossing = 0;
+        for (plint ray=0; ray<n[u]*n[v]; ++ray) {
+            Array<plint,3> pos;
+            pos[u] = ray/n[v];
+            pos[v] = ray%n[v];
+            bool isInside = false;
+            for (pos[axis]=0; pos[axis]<n[axis]; ++pos[axis]) {
+                T coordinate = (T)(lo[axis]+pos[axis]);
+                while ( iCrossing<crossings[axis].size() && crossings[axis][iCrossing].first==ray &&
+                        crossings[axis][iCrossing].second < coordinate )
+                {
+                    isInside = !isInside;
+                    ++iCrossing;
+                }
+                if (isInside) {
+                    ++votes.get(pos[0], pos[1], pos[2]);
+                }
+            }
+            while (iCrossing<crossings[axis].size() && crossings[axis][iCrossing].first==ray) {
+                ++iCrossing;
+            }
+        }
     }
-    if (i==maxIteration) {
-        pcout << "Warning: Voxelization failed." << std::endl;
+
+    for (plint iX=0; iX<n[0]; ++iX) {
+        for (plint iY=0; iY<n[1]; ++iY) {
+            for (plint iZ=0; iZ<n[2]; ++iZ) {
+                voxels.get(domain.x0+iX, domain.y0+iY, domain.z0+iZ) =
+                    votes.get(iX,iY,iZ) >= 2 ? voxelFlag::inside : voxelFlag::outside;
+            }
+        }
     }
+}
 
-    detectBorderLine(*voxelMatrix, voxelMatrix->getBoundingBox(), borderWidth);
+template<typename T>
+VoxelizeMeshByParityFunctional3D<T>* VoxelizeMeshByParityFunctional3D<T>::clone() const {
+    return new VoxelizeMeshByParityFunctional3D<T>(*this);
+}
 
-    return std::auto_ptr<MultiScalarField3D<int> >(voxelMatrix);
+template<typename T>
+void VoxelizeMeshByParityFunctional3D<T>::getTypeOfModification(std::vector<modif::ModifT>& modified) const {
+    modified[0] = modif::staticVariables;
+}
+
+template<typename T>
+BlockDomain::DomainT VoxelizeMeshByParityFunctional3D<T>::appliesTo() const {
+    return BlockDomain::bulk;
 }
 
 
@@ -42,6 +42,10 @@ struct CommunicationInfo3D {
     int toProcessId;
     Box3D toDomain;
     Dot3D absoluteOffset;
+    /// Populations which are transmitted when only the streamed populations are
+    ///   exchanged: for each cell of the domain, their number followed by their
+    ///   indices (see BlockDataTransfer3D::getStreamedPopulations()).
+    std::vector<plint> populations;
 };
 
 typedef std::vector<CommunicationInfo3D> CommunicationPackage3D;
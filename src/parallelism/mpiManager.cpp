@@ -56,7 +56,14 @@ void MpiManager::init(int *argc, char ***argv, bool verbous) {
     if (verbous) {
         std::cerr << "Constructing an MPI thread" << std::endl;
     }
+#ifdef PLB_SMP_PARALLEL
+    // MPI calls are only issued by the main thread; the shared-memory
+    //   threads of the ThreadPool never communicate.
+    int provided;
+    int ok1 = MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+#else
     int ok1 = MPI_Init(argc, argv);
+#endif
     // If I'm the one who calls MPI_Init, then I need to be
     // the one who calls MPI_Finalize.
     responsibleForMpiMachine = true;
@@ -2708,6 +2715,30 @@ void MpiManager::wait(MPI_Request* request, MPI_Status* status)
     MPI_Wait(request, status);
 }
 
+void MpiManager::sendInit(char *buf, int count, int dest, MPI_Request* request, int tag)
+{
+    if (!ok) return;
+    MPI_Send_init(static_cast<void*>(buf), count, MPI_CHAR, dest, tag, getGlobalCommunicator(), request);
+}
+
+void MpiManager::recvInit(char *buf, int count, int source, MPI_Request* request, int tag)
+{
+    if (!ok) return;
+    MPI_Recv_init(static_cast<void*>(buf), count, MPI_CHAR, source, tag, getGlobalCommunicator(), request);
+}
+
+void MpiManager::start(MPI_Request* request)
+{
+    if (!ok) return;
+    MPI_Start(request);
+}
+
+void MpiManager::requestFree(MPI_Request* request)
+{
+    if (!ok) return;
+    MPI_Request_free(request);
+}
+
 }  // namespace global
 
 }  // namespace plb
@@ -152,6 +152,18 @@ public:
     /// Complete a non-blocking MPI operation
     void wait(MPI_Request* request, MPI_Status* status);
 
+    /// Create a persistent request which sends the bytes at *buf; see start()
+    void sendInit(char *buf, int count, int dest, MPI_Request* request, int tag = 0);
+
+    /// Create a persistent request which receives bytes at *buf; see start()
+    void recvInit(char *buf, int count, int source, MPI_Request* request, int tag = 0);
+
+    /// Launch the communication of a persistent request, non blocking
+    void start(MPI_Request* request);
+
+    /// Release a persistent request, which must be inactive
+    void requestFree(MPI_Request* request);
+
 private:
     /// Implementation code for Scatter
     template <typename T>
@@ -41,52 +41,81 @@ namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+/// Source and destination of the data of an overlap, in the local coordinates
+///   of the atomic-blocks.
+static CommunicationInfo3D computeCommunicationInfo (
+        Overlap3D const& overlap,
+        MultiBlockManagement3D const& originManagement,
+        MultiBlockManagement3D const& destinationManagement )
+{
+    CommunicationInfo3D info;
+
+    info.fromBlockId = overlap.getOriginalId();
+    info.toBlockId   = overlap.getOverlapId();
+
+    SmartBulk3D originalBulk(originManagement.getSparseBlockStructure(),
+                             originManagement.getEnvelopeWidth(), info.fromBlockId);
+    SmartBulk3D overlapBulk(destinationManagement.getSparseBlockStructure(),
+                            destinationManagement.getEnvelopeWidth(), info.toBlockId);
+
+    Box3D originalCoordinates(overlap.getOriginalCoordinates());
+    Box3D overlapCoordinates(overlap.getOverlapCoordinates());
+    info.fromDomain = originalBulk.toLocal(originalCoordinates);
+    info.toDomain   = overlapBulk.toLocal(overlapCoordinates);
+    info.absoluteOffset = Dot3D (
+            overlapCoordinates.x0 - originalCoordinates.x0,
+            overlapCoordinates.y0 - originalCoordinates.y0,
+            overlapCoordinates.z0 - originalCoordinates.z0 );
+
+    PLB_PRECONDITION(info.fromDomain.getNx() == info.toDomain.getNx());
+    PLB_PRECONDITION(info.fromDomain.getNy() == info.toDomain.getNy());
+    PLB_PRECONDITION(info.fromDomain.getNz() == info.toDomain.getNz());
+
+    info.fromProcessId = originManagement.getThreadAttribution().getMpiProcess(info.fromBlockId);
+    info.toProcessId   = destinationManagement.getThreadAttribution().getMpiProcess(info.toBlockId);
+    return info;
+}
+
+/// Domain, in local coordinates, on which the atomic-block blockId executes the
+///   collision and streaming step: the bulk and the envelope, without the envelope
+///   on non-periodic outer boundaries (see MultiBlockLattice3D::collideAndStream()).
+static Box3D computeCollisionDomain(MultiBlock3D const& multiBlock, plint blockId)
+{
+    MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
+    plint envelopeWidth = management.getEnvelopeWidth();
+    SmartBulk3D bulk(management, blockId);
+    Box3D boundingBox(management.getBoundingBox());
+    Box3D domain(bulk.computeNonPeriodicEnvelope());
+    if (multiBlock.periodicity().get(0)) {
+        if (domain.x0 == boundingBox.x0) domain.x0 -= envelopeWidth;
+        if (domain.x1 == boundingBox.x1) domain.x1 += envelopeWidth;
+    }
+    if (multiBlock.periodicity().get(1)) {
+        if (domain.y0 == boundingBox.y0) domain.y0 -= envelopeWidth;
+        if (domain.y1 == boundingBox.y1) domain.y1 += envelopeWidth;
+    }
+    if (multiBlock.periodicity().get(2)) {
+        if (domain.z0 == boundingBox.z0) domain.z0 -= envelopeWidth;
+        if (domain.z1 == boundingBox.z1) domain.z1 += envelopeWidth;
+    }
+    return bulk.toLocal(domain);
+}
+
 CommunicationStructure3D::CommunicationStructure3D (
         std::vector<Overlap3D> const& overlaps,
         MultiBlockManagement3D const& originManagement,
         MultiBlockManagement3D const& destinationManagement,
         plint sizeOfCell )
+    : streamedPopulations(false)
 {
-    plint fromEnvelopeWidth = originManagement.getEnvelopeWidth();
-    plint toEnvelopeWidth = destinationManagement.getEnvelopeWidth();
-    SparseBlockStructure3D const& fromSparseBlock
-        = originManagement.getSparseBlockStructure();
-    SparseBlockStructure3D const& toSparseBlock
-        = destinationManagement.getSparseBlockStructure();
+    ThreadAttribution const& fromAttribution = originManagement.getThreadAttribution();
+    ThreadAttribution const& toAttribution = destinationManagement.getThreadAttribution();
 
     SendRecvPool sendPool, recvPool;
     for (pluint iOverlap=0; iOverlap<overlaps.size(); ++iOverlap) {
-        Overlap3D const& overlap = overlaps[iOverlap];
-        CommunicationInfo3D info;
-
-        info.fromBlockId = overlap.getOriginalId();
-        info.toBlockId   = overlap.getOverlapId();
-
-        SmartBulk3D originalBulk(fromSparseBlock, fromEnvelopeWidth, info.fromBlockId);
-        SmartBulk3D overlapBulk(toSparseBlock, toEnvelopeWidth, info.toBlockId);
-
-        Box3D originalCoordinates(overlap.getOriginalCoordinates());
-        Box3D overlapCoordinates(overlap.getOverlapCoordinates());
-        info.fromDomain = originalBulk.toLocal(originalCoordinates);
-        info.toDomain   = overlapBulk.toLocal(overlapCoordinates);
-        info.absoluteOffset = Dot3D (
-                overlapCoordinates.x0 - originalCoordinates.x0,
-                overlapCoordinates.y0 - originalCoordinates.y0,
-                overlapCoordinates.z0 - originalCoordinates.z0 );
-
-        plint lx = info.fromDomain.x1-info.fromDomain.x0+1;
-        plint ly = info.fromDomain.y1-info.fromDomain.y0+1;
-        plint lz = info.fromDomain.z1-info.fromDomain.z0+1;
-        PLB_PRECONDITION(lx == info.toDomain.x1-info.toDomain.x0+1);
-        PLB_PRECONDITION(ly == info.toDomain.y1-info.toDomain.y0+1);
-        PLB_PRECONDITION(lz == info.toDomain.z1-info.toDomain.z0+1);
-
-        plint numberOfCells = lx*ly*lz;
-
-        ThreadAttribution const& fromAttribution = originManagement.getThreadAttribution();
-        ThreadAttribution const& toAttribution = destinationManagement.getThreadAttribution();
-        info.fromProcessId = fromAttribution.getMpiProcess(info.fromBlockId);
-        info.toProcessId   = toAttribution.getMpiProcess(info.toBlockId);
+        CommunicationInfo3D info = computeCommunicationInfo (
+                overlaps[iOverlap], originManagement, destinationManagement );
+        plint numberOfCells = info.fromDomain.nCells();
 
         if ( fromAttribution.isLocal(info.fromBlockId) &&
              toAttribution.isLocal(info.toBlockId))
@@ -109,6 +138,57 @@ CommunicationStructure3D::CommunicationStructure3D (
     recvComm = RecvPoolCommunicator(recvPool);
 }
 
+/** The list of populations of an overlap is computed by the local atomic-block
+ *  which sends or receives it, from the collision domain of the recipient.
+ */
+CommunicationStructure3D::CommunicationStructure3D (
+        std::vector<Overlap3D> const& overlaps,
+        MultiBlock3D const& multiBlock )
+    : streamedPopulations(true)
+{
+    MultiBlockManagement3D const& management = multiBlock.getMultiBlockManagement();
+    ThreadAttribution const& attribution = management.getThreadAttribution();
+
+    SendRecvPool sendPool, recvPool;
+    for (pluint iOverlap=0; iOverlap<overlaps.size(); ++iOverlap) {
+        CommunicationInfo3D info = computeCommunicationInfo (
+                overlaps[iOverlap], management, management );
+        bool fromLocal = attribution.isLocal(info.fromBlockId);
+        bool toLocal = attribution.isLocal(info.toBlockId);
+        if (!fromLocal && !toLocal) {
+            continue;
+        }
+        AtomicBlock3D const& localBlock =
+            multiBlock.getComponent(fromLocal ? info.fromBlockId : info.toBlockId);
+        plint numBytes = 0;
+        if (!localBlock.getDataTransfer().getStreamedPopulations (
+                    info.toDomain, computeCollisionDomain(multiBlock, info.toBlockId),
+                    info.populations, numBytes ) )
+        {
+            streamedPopulations = false;
+            sendPackage.clear();
+            recvPackage.clear();
+            sendRecvPackage.clear();
+            return;
+        }
+
+        if (fromLocal && toLocal) {
+            sendRecvPackage.push_back(info);
+        }
+        else if (fromLocal) {
+            sendPackage.push_back(info);
+            sendPool.subscribeMessage(info.toProcessId, numBytes);
+        }
+        else {
+            recvPackage.push_back(info);
+            recvPool.subscribeMessage(info.fromProcessId, numBytes);
+        }
+    }
+
+    sendComm = SendPoolCommunicator(sendPool);
+    recvComm = RecvPoolCommunicator(recvPool);
+}
+
 
 
 CommunicationPattern3D::CommunicationPattern3D (
@@ -176,17 +256,20 @@ CommunicationPattern3D::CommunicationPattern3D (
 
 ParallelBlockCommunicator3D::ParallelBlockCommunicator3D()
     : overlapsModified(true),
-      communication(0)
+      communication(0),
+      streamedCommunication(0)
 { }
 
 ParallelBlockCommunicator3D::ParallelBlockCommunicator3D (
         ParallelBlockCommunicator3D const& rhs )
     : overlapsModified(true),
-      communication(0)
+      communication(0),
+      streamedCommunication(0)
 { }
 
 ParallelBlockCommunicator3D::~ParallelBlockCommunicator3D() {
     delete communication;
+    delete streamedCommunication;
 }
 
 ParallelBlockCommunicator3D& ParallelBlockCommunicator3D::operator= (
@@ -199,6 +282,7 @@ ParallelBlockCommunicator3D& ParallelBlockCommunicator3D::operator= (
 void ParallelBlockCommunicator3D::swap(ParallelBlockCommunicator3D& rhs) {
     std::swap(overlapsModified,rhs.overlapsModified);
     std::swap(communication,rhs.communication);
+    std::swap(streamedCommunication,rhs.streamedCommunication);
 }
 
 ParallelBlockCommunicator3D* ParallelBlockCommunicator3D::clone() const {
@@ -207,29 +291,106 @@ ParallelBlockCommunicator3D* ParallelBlockCommunicator3D::clone() const {
 
 void ParallelBlockCommunicator3D::duplicateOverlaps( MultiBlock3D& multiBlock,
                                                      modif::ModifT whichData ) const
+{
+    updateCommunicationStructure(multiBlock);
+    communicate(*communication, multiBlock, multiBlock, whichData);
+}
+
+void ParallelBlockCommunicator3D::startDuplicateOverlaps( MultiBlock3D& multiBlock,
+                                                          modif::ModifT whichData ) const
+{
+    updateCommunicationStructure(multiBlock);
+    global::profiler().start("mpiCommunication");
+    startCommunication(*communication, multiBlock, multiBlock, whichData);
+    global::profiler().stop("mpiCommunication");
+}
+
+void ParallelBlockCommunicator3D::completeDuplicateOverlaps( MultiBlock3D& multiBlock,
+                                                             modif::ModifT whichData ) const
+{
+    PLB_ASSERT(communication != 0);
+    global::profiler().start("mpiCommunication");
+    completeCommunication(*communication, multiBlock, whichData);
+    global::profiler().stop("mpiCommunication");
+}
+
+void ParallelBlockCommunicator3D::duplicateStreamedPopulations(MultiBlock3D& multiBlock) const
+{
+    if (updateStreamedCommunicationStructure(multiBlock)) {
+        communicate(*streamedCommunication, multiBlock, multiBlock, modif::staticVariables);
+    }
+    else {
+        duplicateOverlaps(multiBlock, modif::staticVariables);
+    }
+}
+
+void ParallelBlockCommunicator3D::startDuplicateStreamedPopulations(MultiBlock3D& multiBlock) const
+{
+    if (updateStreamedCommunicationStructure(multiBlock)) {
+        global::profiler().start("mpiCommunication");
+        startCommunication(*streamedCommunication, multiBlock, multiBlock, modif::staticVariables);
+        global::profiler().stop("mpiCommunication");
+    }
+    else {
+        startDuplicateOverlaps(multiBlock, modif::staticVariables);
+    }
+}
+
+void ParallelBlockCommunicator3D::completeDuplicateStreamedPopulations(MultiBlock3D& multiBlock) const
+{
+    if (streamedCommunication && streamedCommunication->streamedPopulations) {
+        global::profiler().start("mpiCommunication");
+        completeCommunication(*streamedCommunication, multiBlock, modif::staticVariables);
+        global::profiler().stop("mpiCommunication");
+    }
+    else {
+        completeDuplicateOverlaps(multiBlock, modif::staticVariables);
+    }
+}
+
+void ParallelBlockCommunicator3D::computeOverlaps (
+        MultiBlock3D const& multiBlock, std::vector<Overlap3D>& overlaps ) const
+{
+    LocalMultiBlockInfo3D const& localInfo = multiBlock.getMultiBlockManagement().getLocalInfo();
+    PeriodicitySwitch3D const& periodicity = multiBlock.periodicity();
+    overlaps = localInfo.getNormalOverlaps();
+    for (pluint iOverlap=0; iOverlap<localInfo.getPeriodicOverlaps().size(); ++iOverlap) {
+        PeriodicOverlap3D const& pOverlap = localInfo.getPeriodicOverlaps()[iOverlap];
+        if (periodicity.get(pOverlap.normalX,pOverlap.normalY,pOverlap.normalZ)) {
+            overlaps.push_back(pOverlap.overlap);
+        }
+    }
+}
+
+void ParallelBlockCommunicator3D::updateCommunicationStructure(MultiBlock3D const& multiBlock) const
 {
     MultiBlockManagement3D const& multiBlockManagement = multiBlock.getMultiBlockManagement();
-    PeriodicitySwitch3D const& periodicity             = multiBlock.periodicity();
 
     // Implement a caching mechanism for the communication structure.
     if (overlapsModified) {
         overlapsModified = false;
-        LocalMultiBlockInfo3D const& localInfo = multiBlockManagement.getLocalInfo();
-        std::vector<Overlap3D> overlaps(multiBlockManagement.getLocalInfo().getNormalOverlaps());
-        for (pluint iOverlap=0; iOverlap<localInfo.getPeriodicOverlaps().size(); ++iOverlap) {
-            PeriodicOverlap3D const& pOverlap = localInfo.getPeriodicOverlaps()[iOverlap];
-            if (periodicity.get(pOverlap.normalX,pOverlap.normalY,pOverlap.normalZ)) {
-                overlaps.push_back(pOverlap.overlap);
-            }
-        }
+        std::vector<Overlap3D> overlaps;
+        computeOverlaps(multiBlock, overlaps);
         delete communication;
         communication = new CommunicationStructure3D (
                                 overlaps,
                                 multiBlockManagement, multiBlockManagement,
                                 multiBlock.sizeOfCell() );
+        // The plan for the streamed populations is recomputed when it is needed.
+        delete streamedCommunication;
+        streamedCommunication = 0;
     }
+}
 
-    communicate(*communication, multiBlock, multiBlock, whichData);
+bool ParallelBlockCommunicator3D::updateStreamedCommunicationStructure(MultiBlock3D const& multiBlock) const
+{
+    updateCommunicationStructure(multiBlock);
+    if (!streamedCommunication) {
+        std::vector<Overlap3D> overlaps;
+        computeOverlaps(multiBlock, overlaps);
+        streamedCommunication = new CommunicationStructure3D(overlaps, multiBlock);
+    }
+    return streamedCommunication->streamedPopulations;
 }
 
 void ParallelBlockCommunicator3D::communicate (
@@ -254,17 +415,39 @@ void ParallelBlockCommunicator3D::communicate (
         MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const
 {
     global::profiler().start("mpiCommunication");
+    startCommunication(communication, originMultiBlock, destinationMultiBlock, whichData);
+    completeCommunication(communication, destinationMultiBlock, whichData);
+    global::profiler().stop("mpiCommunication");
+}
+
+void ParallelBlockCommunicator3D::startCommunication (
+        CommunicationStructure3D& communication,
+        MultiBlock3D const& originMultiBlock,
+        MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const
+{
     bool staticMessage = whichData == modif::staticVariables;
     // 1. Non-blocking receives.
     communication.recvComm.startBeingReceptive(staticMessage);
 
-    // 2. Non-blocking sends.
+    // 2. Non-blocking sends. Static data is packed directly into the buffers
+    //    of the persistent requests.
     for (unsigned iSend=0; iSend<communication.sendPackage.size(); ++iSend) {
         CommunicationInfo3D const& info = communication.sendPackage[iSend];
         AtomicBlock3D const& fromBlock = originMultiBlock.getComponent(info.fromBlockId);
-        fromBlock.getDataTransfer().send (
-                info.fromDomain, communication.sendComm.getSendBuffer(info.toProcessId),
-                whichData );
+        if (communication.streamedPopulations) {
+            fromBlock.getDataTransfer().sendPopulations (
+                    info.fromDomain, info.populations,
+                    communication.sendComm.getStaticSendBuffer(info.toProcessId) );
+        }
+        else if (staticMessage) {
+            fromBlock.getDataTransfer().sendStatic (
+                    info.fromDomain, communication.sendComm.getStaticSendBuffer(info.toProcessId) );
+        }
+        else {
+            fromBlock.getDataTransfer().send (
+                    info.fromDomain, communication.sendComm.getSendBuffer(info.toProcessId),
+                    whichData );
+        }
         communication.sendComm.acceptMessage(info.toProcessId, staticMessage);
     }
 
@@ -276,24 +459,48 @@ void ParallelBlockCommunicator3D::communicate (
         plint deltaX = info.fromDomain.x0 - info.toDomain.x0;
         plint deltaY = info.fromDomain.y0 - info.toDomain.y0;
         plint deltaZ = info.fromDomain.z0 - info.toDomain.z0;
-        toBlock.getDataTransfer().attribute (
-                info.toDomain, deltaX, deltaY, deltaZ, fromBlock,
-                whichData, info.absoluteOffset );
+        if (communication.streamedPopulations) {
+            toBlock.getDataTransfer().attributePopulations (
+                    info.toDomain, deltaX, deltaY, deltaZ, fromBlock, info.populations );
+        }
+        else {
+            toBlock.getDataTransfer().attribute (
+                    info.toDomain, deltaX, deltaY, deltaZ, fromBlock,
+                    whichData, info.absoluteOffset );
+        }
     }
+}
 
+void ParallelBlockCommunicator3D::completeCommunication (
+        CommunicationStructure3D& communication,
+        MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const
+{
+    bool staticMessage = whichData == modif::staticVariables;
     // 4. Finalize the receives.
     for (unsigned iRecv=0; iRecv<communication.recvPackage.size(); ++iRecv) {
         CommunicationInfo3D const& info = communication.recvPackage[iRecv];
         AtomicBlock3D& toBlock = destinationMultiBlock.getComponent(info.toBlockId);
-        toBlock.getDataTransfer().receive (
-                info.toDomain,
-                communication.recvComm.receiveMessage(info.fromProcessId, staticMessage),
-                whichData, info.absoluteOffset );
+        if (communication.streamedPopulations) {
+            toBlock.getDataTransfer().receivePopulations (
+                    info.toDomain, info.populations,
+                    communication.recvComm.receiveStaticMessage(info.fromProcessId) );
+        }
+        else if (staticMessage) {
+            toBlock.getDataTransfer().receiveStatic (
+                    info.toDomain,
+                    communication.recvComm.receiveStaticMessage(info.fromProcessId),
+                    info.absoluteOffset );
+        }
+        else {
+            toBlock.getDataTransfer().receive (
+                    info.toDomain,
+                    communication.recvComm.receiveMessage(info.fromProcessId, staticMessage),
+                    whichData, info.absoluteOffset );
+        }
     }
 
     // 5. Finalize the sends.
     communication.sendComm.finalize(staticMessage);
-    global::profiler().stop("mpiCommunication");
 }
 
 void ParallelBlockCommunicator3D::signalPeriodicity() const {
@@ -52,6 +52,13 @@ struct CommunicationPattern3D
     CommunicationPackage3D sendRecvPackage;
 };
 
+/// Communication plan of a multi-block, cached by ParallelBlockCommunicator3D
+///   until the overlaps are modified.
+/** The static messages (modif::staticVariables) are packed directly from the
+ *  atomic-blocks into preallocated buffers, at offsets which are computed once,
+ *  and exchanged through persistent MPI requests. Other types of data have a
+ *  size which is unknown in advance, and use regular non-blocking messages.
+ */
 struct CommunicationStructure3D
 {
     CommunicationStructure3D (
@@ -59,6 +66,14 @@ struct CommunicationStructure3D
             MultiBlockManagement3D const& originManagement,
             MultiBlockManagement3D const& destinationManagement,
             plint sizeOfCell );
+    /// Plan for the exchange of the streamed populations only, inside multiBlock.
+    /** If the atomic-blocks don't support it, streamedPopulations is false and
+     *  the plan is empty.
+     */
+    CommunicationStructure3D (
+            std::vector<Overlap3D> const& overlaps,
+            MultiBlock3D const& multiBlock );
+    bool streamedPopulations;
     CommunicationPackage3D sendPackage;
     CommunicationPackage3D recvPackage;
     CommunicationPackage3D sendRecvPackage;
@@ -77,21 +92,38 @@ public:
     void swap(ParallelBlockCommunicator3D& rhs);
     virtual ParallelBlockCommunicator3D* clone() const;
     virtual void duplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const;
+    virtual void startDuplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const;
+    virtual void completeDuplicateOverlaps(MultiBlock3D& multiBlock, modif::ModifT whichData) const;
+    virtual void duplicateStreamedPopulations(MultiBlock3D& multiBlock) const;
+    virtual void startDuplicateStreamedPopulations(MultiBlock3D& multiBlock) const;
+    virtual void completeDuplicateStreamedPopulations(MultiBlock3D& multiBlock) const;
     virtual void communicate( std::vector<Overlap3D> const& overlaps,
                               MultiBlock3D const& originMultiBlock,
                               MultiBlock3D& destinationMultiBlock,
                               modif::ModifT whichData ) const;
     virtual void signalPeriodicity() const;
 private:
+    void computeOverlaps(MultiBlock3D const& multiBlock, std::vector<Overlap3D>& overlaps) const;
+    void updateCommunicationStructure(MultiBlock3D const& multiBlock) const;
+    /// Returns false if the streamed populations can't be exchanged separately.
+    bool updateStreamedCommunicationStructure(MultiBlock3D const& multiBlock) const;
     void communicate( CommunicationStructure3D& communication,
                       MultiBlock3D const& originMultiBlock,
                       MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
+    /// Post the receives and the sends, and execute the local copies.
+    void startCommunication( CommunicationStructure3D& communication,
+                             MultiBlock3D const& originMultiBlock,
+                             MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
+    /// Wait for the receives and the sends posted by startCommunication().
+    void completeCommunication( CommunicationStructure3D& communication,
+                                MultiBlock3D& destinationMultiBlock, modif::ModifT whichData ) const;
     void subscribeOverlap (
         Overlap3D const& overlap, MultiBlockManagement3D const& multiBlockManagement,
         SendRecvPool& sendPool, SendRecvPool& recvPool, plint sizeOfCell ) const;
 private:
     mutable bool overlapsModified;
     mutable CommunicationStructure3D* communication;
+    mutable CommunicationStructure3D* streamedCommunication;
 };
 
 
@@ -27,59 +27,177 @@
  */
 #include "parallelism/mpiManager.h"
 #include "parallelism/parallelStatistics.h"
+#include "core/plbDebug.h"
 #include <cmath>
 
 namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+// The integer sums are transmitted as two doubles, a high and a low part, which
+//   are summed exactly for any realistic number of processes.
+static const double intSumSplit = 67108864.;  // 2^26
+
+ParallelCombinedStatistics::ParallelCombinedStatistics()
+    : numAverage(0),
+      numSum(0),
+      numMax(0),
+      numIntSum(0),
+      pendingReduction(false)
+{
+    requests[0] = MPI_REQUEST_NULL;
+    requests[1] = MPI_REQUEST_NULL;
+}
+
+ParallelCombinedStatistics::ParallelCombinedStatistics(ParallelCombinedStatistics const& rhs)
+    : CombinedStatistics(rhs),
+      numAverage(0),
+      numSum(0),
+      numMax(0),
+      numIntSum(0),
+      pendingReduction(false)
+{
+    requests[0] = MPI_REQUEST_NULL;
+    requests[1] = MPI_REQUEST_NULL;
+}
+
+ParallelCombinedStatistics::~ParallelCombinedStatistics()
+{
+    // The reduction is collective: all processes wait for it when they
+    //   destroy their instance.
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (pendingReduction && !finalized) {
+        MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+    }
+}
+
 ParallelCombinedStatistics* ParallelCombinedStatistics::clone() const
 {
     return new ParallelCombinedStatistics(*this);
 }
 
-void ParallelCombinedStatistics::reduceStatistics (
+void ParallelCombinedStatistics::pack (
+            std::vector<double> const& averageObservables,
+            std::vector<double> const& sumWeights,
+            std::vector<double> const& sumObservables,
+            std::vector<double> const& maxObservables,
+            std::vector<plint> const& intSumObservables ) const
+{
+    numAverage = averageObservables.size();
+    numSum = sumObservables.size();
+    numMax = maxObservables.size();
+    numIntSum = intSumObservables.size();
+    sendSumBuffer.clear();
+    for (pluint iAverage=0; iAverage<numAverage; ++iAverage) {
+        sendSumBuffer.push_back(averageObservables[iAverage]*sumWeights[iAverage]);
+    }
+    sendSumBuffer.insert(sendSumBuffer.end(), sumWeights.begin(), sumWeights.end());
+    sendSumBuffer.insert(sendSumBuffer.end(), sumObservables.begin(), sumObservables.end());
+    for (pluint iSum=0; iSum<numIntSum; ++iSum) {
+        double high = std::floor((double)intSumObservables[iSum]/intSumSplit);
+        sendSumBuffer.push_back(high);
+        sendSumBuffer.push_back((double)(intSumObservables[iSum]-(plint)high*(plint)intSumSplit));
+    }
+    sendMaxBuffer.assign(maxObservables.begin(), maxObservables.end());
+    receiveSumBuffer.resize(sendSumBuffer.size());
+    receiveMaxBuffer.resize(sendMaxBuffer.size());
+}
+
+void ParallelCombinedStatistics::unpack (
             std::vector<double>& averageObservables,
-            std::vector<double>& sumWeights,
             std::vector<double>& sumObservables,
             std::vector<double>& maxObservables,
             std::vector<plint>& intSumObservables ) const
 {
-    // Averages
-    for (pluint iAverage=0; iAverage<averageObservables.size(); ++iAverage) {
-        double globalAverage, globalWeight;
-        global::mpi().reduce(averageObservables[iAverage]*sumWeights[iAverage], globalAverage, MPI_SUM);
-        global::mpi().reduce(sumWeights[iAverage], globalWeight, MPI_SUM);
-        if (global::mpi().isMainProcessor() && std::fabs(globalWeight) > 0.5) {
+    double const* value = receiveSumBuffer.empty() ? 0 : &receiveSumBuffer[0];
+    averageObservables.resize(numAverage);
+    for (pluint iAverage=0; iAverage<numAverage; ++iAverage) {
+        double globalAverage = value[iAverage];
+        double globalWeight = value[numAverage+iAverage];
+        if (std::fabs(globalWeight) > 0.5) {
             globalAverage /= globalWeight;
         }
-        global::mpi().bCast(&globalAverage, 1);
         averageObservables[iAverage] = globalAverage;
     }
+    value += 2*numAverage;
+    sumObservables.assign(value, value+numSum);
+    value += numSum;
+    intSumObservables.resize(numIntSum);
+    for (pluint iSum=0; iSum<numIntSum; ++iSum) {
+        intSumObservables[iSum] = (plint)value[2*iSum]*(plint)intSumSplit + (plint)value[2*iSum+1];
+    }
+    maxObservables.assign(receiveMaxBuffer.begin(), receiveMaxBuffer.end());
+}
 
-    // Sum
-    for (pluint iSum=0; iSum<sumObservables.size(); ++iSum) {
-        double globalSum;
-        global::mpi().reduce(sumObservables[iSum], globalSum, MPI_SUM);
-        global::mpi().bCast(&globalSum, 1);
-        sumObservables[iSum] = globalSum;
+void ParallelCombinedStatistics::reduceStatistics (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
+{
+    pack(averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables);
+    // All processes have subscribed the same observables, and skip the same
+    //   empty reductions.
+    if (!sendSumBuffer.empty()) {
+        MPI_Allreduce( &sendSumBuffer[0], &receiveSumBuffer[0], (int)sendSumBuffer.size(), MPI_DOUBLE,
+                       MPI_SUM, global::mpi().getGlobalCommunicator() );
+    }
+    if (!sendMaxBuffer.empty()) {
+        MPI_Allreduce( &sendMaxBuffer[0], &receiveMaxBuffer[0], (int)sendMaxBuffer.size(), MPI_DOUBLE,
+                       MPI_MAX, global::mpi().getGlobalCommunicator() );
     }
+    unpack(averageObservables, sumObservables, maxObservables, intSumObservables);
+}
 
-    // Max
-    for (pluint iMax=0; iMax<maxObservables.size(); ++iMax) {
-        double globalMax;
-        global::mpi().reduce(maxObservables[iMax], globalMax, MPI_MAX);
-        global::mpi().bCast(&globalMax, 1);
-        maxObservables[iMax] = globalMax;
+void ParallelCombinedStatistics::startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
+{
+    PLB_ASSERT( !pendingReduction );
+    pack(averageObservables, sumWeights, sumObservables, maxObservables, intSumObservables);
+    requests[0] = MPI_REQUEST_NULL;
+    requests[1] = MPI_REQUEST_NULL;
+#if MPI_VERSION >= 3
+    if (!sendSumBuffer.empty()) {
+        MPI_Iallreduce( &sendSumBuffer[0], &receiveSumBuffer[0], (int)sendSumBuffer.size(), MPI_DOUBLE,
+                        MPI_SUM, global::mpi().getGlobalCommunicator(), &requests[0] );
+    }
+    if (!sendMaxBuffer.empty()) {
+        MPI_Iallreduce( &sendMaxBuffer[0], &receiveMaxBuffer[0], (int)sendMaxBuffer.size(), MPI_DOUBLE,
+                        MPI_MAX, global::mpi().getGlobalCommunicator(), &requests[1] );
     }
+#else
+    // Without non-blocking collectives, the reductions are executed immediately.
+    if (!sendSumBuffer.empty()) {
+        MPI_Allreduce( &sendSumBuffer[0], &receiveSumBuffer[0], (int)sendSumBuffer.size(), MPI_DOUBLE,
+                       MPI_SUM, global::mpi().getGlobalCommunicator() );
+    }
+    if (!sendMaxBuffer.empty()) {
+        MPI_Allreduce( &sendMaxBuffer[0], &receiveMaxBuffer[0], (int)sendMaxBuffer.size(), MPI_DOUBLE,
+                       MPI_MAX, global::mpi().getGlobalCommunicator() );
+    }
+#endif
+    pendingReduction = true;
+}
 
-    // Integer sum
-    for (pluint iSum=0; iSum<intSumObservables.size(); ++iSum) {
-        plint globalSum;
-        global::mpi().reduce(intSumObservables[iSum], globalSum, MPI_SUM);
-        global::mpi().bCast(&globalSum, 1);
-        intSumObservables[iSum] = globalSum;
+bool ParallelCombinedStatistics::completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const
+{
+    if (!pendingReduction) {
+        return false;
     }
+    MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+    pendingReduction = false;
+    unpack(averageObservables, sumObservables, maxObservables, intSumObservables);
+    return true;
 }
 
 #endif  // PLB_MPI_PARALLEL
@@ -30,14 +30,27 @@
 
 #include "core/globalDefs.h"
 #include "multiBlock/combinedStatistics.h"
+#include "parallelism/mpiManager.h"
 #include <vector>
 
 namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+/// Reduces all statistics with two collective operations.
+/** The sums (including the weights of the averages and the integer sums) are
+ *  packed into one vector, which is reduced by MPI_Allreduce with MPI_SUM, and
+ *  the maxima into another one, reduced with MPI_MAX. In lagged mode,
+ *  MPI_Iallreduce is used instead, and the reductions are completed during the
+ *  next call to combine().
+ */
 class ParallelCombinedStatistics : public CombinedStatistics {
 public:
+    ParallelCombinedStatistics();
+    /// A pending reduction of rhs is not copied.
+    ParallelCombinedStatistics(ParallelCombinedStatistics const& rhs);
+    /// Waits for the completion of a pending reduction.
+    virtual ~ParallelCombinedStatistics();
     virtual ParallelCombinedStatistics* clone() const;
 protected:
     virtual void reduceStatistics (
@@ -46,6 +59,36 @@ protected:
             std::vector<double>& sumObservables,
             std::vector<double>& maxObservables,
             std::vector<plint>& intSumObservables ) const;
+    virtual void startReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumWeights,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const;
+    virtual bool completeReduction (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const;
+private:
+    ParallelCombinedStatistics& operator=(ParallelCombinedStatistics const& rhs);
+    void pack (
+            std::vector<double> const& averageObservables,
+            std::vector<double> const& sumWeights,
+            std::vector<double> const& sumObservables,
+            std::vector<double> const& maxObservables,
+            std::vector<plint> const& intSumObservables ) const;
+    void unpack (
+            std::vector<double>& averageObservables,
+            std::vector<double>& sumObservables,
+            std::vector<double>& maxObservables,
+            std::vector<plint>& intSumObservables ) const;
+private:
+    mutable std::vector<double> sendSumBuffer, receiveSumBuffer;
+    mutable std::vector<double> sendMaxBuffer, receiveMaxBuffer;
+    mutable pluint numAverage, numSum, numMax, numIntSum;
+    mutable MPI_Request requests[2];
+    mutable bool pendingReduction;
 };
  
 #endif  // PLB_MPI_PARALLEL
@@ -36,6 +36,42 @@ namespace plb {
 
 #ifdef PLB_MPI_PARALLEL
 
+CommunicatorEntry::CommunicatorEntry(CommunicatorEntry const& rhs)
+    : lengths(rhs.lengths),
+      offsets(rhs.offsets),
+      cumDataLength(rhs.cumDataLength),
+      messages(rhs.messages),
+      data(rhs.data),
+      staticData(rhs.staticData),
+      dynamicDataSizes(rhs.dynamicDataSizes),
+      currentMessage(rhs.currentMessage),
+      persistentRequest(MPI_REQUEST_NULL)
+{ }
+
+CommunicatorEntry& CommunicatorEntry::operator=(CommunicatorEntry const& rhs) {
+    if (this != &rhs) {
+        if (persistentRequest != MPI_REQUEST_NULL) {
+            global::mpi().requestFree(&persistentRequest);
+        }
+        lengths = rhs.lengths;
+        offsets = rhs.offsets;
+        cumDataLength = rhs.cumDataLength;
+        messages = rhs.messages;
+        data = rhs.data;
+        staticData = rhs.staticData;
+        dynamicDataSizes = rhs.dynamicDataSizes;
+        currentMessage = rhs.currentMessage;
+        persistentRequest = MPI_REQUEST_NULL;
+    }
+    return *this;
+}
+
+CommunicatorEntry::~CommunicatorEntry() {
+    if (persistentRequest != MPI_REQUEST_NULL) {
+        global::mpi().requestFree(&persistentRequest);
+    }
+}
+
 SendPoolCommunicator::SendPoolCommunicator(SendRecvPool const& pool)
     : subscriptions(pool.begin(), pool.end())
 {
@@ -50,17 +86,36 @@ std::vector<char>& SendPoolCommunicator::getSendBuffer(int toProc) {
     return entry.messages[entry.currentMessage];
 }
 
+char* SendPoolCommunicator::getStaticSendBuffer(int toProc) {
+    std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(toProc);
+    PLB_ASSERT( entryPtr != subscriptions.end() );
+    CommunicatorEntry& entry = entryPtr->second;
+    PLB_ASSERT( entry.currentMessage < (int)entry.messages.size() );
+    // An empty message tells acceptMessage() that there is nothing to copy.
+    entry.messages[entry.currentMessage].clear();
+    if (entry.staticData.empty()) {
+        return 0;
+    }
+    return &entry.staticData[entry.offsets[entry.currentMessage]];
+}
+
 void SendPoolCommunicator::acceptMessage(int toProc, bool staticMessage)
 {
     std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(toProc);
     PLB_ASSERT( entryPtr != subscriptions.end() );
     CommunicatorEntry& entry = entryPtr->second;
     PLB_ASSERT( entry.currentMessage < (int)entry.messages.size() );
-    // If communication is static, make sure that the message has
-    //   the right size.
-    PLB_ASSERT( !staticMessage ||
-                ( (int)entry.messages[entry.currentMessage].size() ==
-                  entry.lengths[entry.currentMessage] ) );
+    if (staticMessage) {
+        // A static message is either already in place in the persistent buffer
+        //   (see getStaticSendBuffer()), or it is copied there now.
+        std::vector<char> const& message = entry.messages[entry.currentMessage];
+        if (!message.empty()) {
+            // Make sure that the message has the right size.
+            PLB_ASSERT( (int)message.size() == entry.lengths[entry.currentMessage] );
+            std::copy(message.begin(), message.end(),
+                      entry.staticData.begin()+entry.offsets[entry.currentMessage]);
+        }
+    }
     entry.currentMessage++;
 
     if (entry.currentMessage==(int)entry.lengths.size()) {
@@ -74,9 +129,13 @@ void SendPoolCommunicator::finalize(bool staticMessage) {
     std::map<int, CommunicatorEntry >::iterator iter = subscriptions.begin();
     for (; iter != subscriptions.end(); ++iter) {
         CommunicatorEntry& entry = iter->second;
-        if (!staticMessage) {
-            global::mpi().wait(&entry.sizeRequest, &entry.sizeStatus);
+        if (staticMessage) {
+            if (!entry.staticData.empty()) {
+                global::mpi().wait(&entry.persistentRequest, &entry.messageStatus);
+            }
+            continue;
         }
+        global::mpi().wait(&entry.sizeRequest, &entry.sizeStatus);
         // Empty messages are neither sent nor received.
         if (!entry.data.empty()) {
             global::mpi().wait(&entry.messageRequest, &entry.messageStatus);
@@ -90,24 +149,30 @@ void SendPoolCommunicator::startCommunication(int toProc, bool staticMessage)
     PLB_ASSERT( entryPtr != subscriptions.end() );
     CommunicatorEntry& entry = entryPtr->second;
     if (staticMessage) {
-        entry.data.resize(entry.cumDataLength);
-    }
-    else {
-        // If the communicated data is non-static, the overall size of transmitted
-        //   data must be computed.
-        int dynamicDataLength = 0;
-        entry.dynamicDataSizes.resize(entry.messages.size());
-        for (pluint iMessage=0; iMessage<entry.messages.size(); ++iMessage) {
-            dynamicDataLength += entry.messages[iMessage].size();
-            entry.dynamicDataSizes[iMessage] = entry.messages[iMessage].size();
+        // The static messages are already merged in the persistent buffer.
+        // Empty messages are neither sent nor received.
+        if (!entry.staticData.empty()) {
+            if (entry.persistentRequest == MPI_REQUEST_NULL) {
+                global::mpi().sendInit(&entry.staticData[0], entry.staticData.size(), toProc,
+                                       &entry.persistentRequest);
+            }
+            global::profiler().increment("mpiSendChar", (plint)entry.staticData.size());
+            global::mpi().start(&entry.persistentRequest);
         }
-        entry.data.resize(dynamicDataLength);
+        return;
+    }
+    // If the communicated data is non-static, the overall size of transmitted
+    //   data must be computed.
+    int dynamicDataLength = 0;
+    entry.dynamicDataSizes.resize(entry.messages.size());
+    for (pluint iMessage=0; iMessage<entry.messages.size(); ++iMessage) {
+        dynamicDataLength += entry.messages[iMessage].size();
+        entry.dynamicDataSizes[iMessage] = entry.messages[iMessage].size();
     }
+    entry.data.resize(dynamicDataLength);
     // Merge the individual messages into a single vector.
     int pos=0;
     for (pluint iMessage=0; iMessage<entry.messages.size(); ++iMessage) {
-        PLB_ASSERT( !staticMessage ||
-                    ( (int)entry.messages[iMessage].size() == entry.lengths[iMessage] ));
         PLB_ASSERT(pos+entry.messages[iMessage].size() <= entry.data.size());
         if( !entry.messages[iMessage].empty() && !entry.data.empty() ) {
             std::copy(entry.messages[iMessage].begin(),
@@ -115,12 +180,10 @@ void SendPoolCommunicator::startCommunication(int toProc, bool staticMessage)
         }
         pos+=entry.messages[iMessage].size();
     }
-    if (!staticMessage) {
-        PLB_ASSERT(entry.dynamicDataSizes.size()>0);
-        global::profiler().increment("mpiSendChar", (plint)entry.dynamicDataSizes.size());
-        global::mpi().iSend(&entry.dynamicDataSizes[0], entry.dynamicDataSizes.size(), toProc,
-                            &entry.sizeRequest);
-    }
+    PLB_ASSERT(entry.dynamicDataSizes.size()>0);
+    global::profiler().increment("mpiSendChar", (plint)entry.dynamicDataSizes.size());
+    global::mpi().iSend(&entry.dynamicDataSizes[0], entry.dynamicDataSizes.size(), toProc,
+                        &entry.sizeRequest);
     // Empty messages are neither sent nor received.
     if (!entry.data.empty()) {
         global::profiler().increment("mpiSendChar", (plint)entry.data.size());
@@ -144,12 +207,14 @@ void RecvPoolCommunicator::startBeingReceptive(bool staticMessage)
     for (; iter != subscriptions.end(); ++iter) {
         int fromProc = iter->first;
         CommunicatorEntry& entry = iter->second;
-        entry.data.resize(entry.cumDataLength);
         // Empty messages are neither sent nor received.
-        if (!entry.data.empty()) {
-            global::profiler().increment("mpiReceiveChar", (plint)entry.data.size());
-            global::mpi().iRecv(&entry.data[0], entry.data.size(),
-                                fromProc, &entry.messageRequest);
+        if (!entry.staticData.empty()) {
+            if (entry.persistentRequest == MPI_REQUEST_NULL) {
+                global::mpi().recvInit(&entry.staticData[0], entry.staticData.size(),
+                                       fromProc, &entry.persistentRequest);
+            }
+            global::profiler().increment("mpiReceiveChar", (plint)entry.staticData.size());
+            global::mpi().start(&entry.persistentRequest);
         }
     }
 }
@@ -169,7 +234,30 @@ std::vector<char> const& RecvPoolCommunicator::receiveMessage (
             receiveDynamic(fromProc);
         }
     }
-    std::vector<char> const& message = entry.messages[entry.currentMessage];
+    std::vector<char>& message = entry.messages[entry.currentMessage];
+    if (staticMessage) {
+        int offset = entry.offsets[entry.currentMessage];
+        message.assign(entry.staticData.begin()+offset,
+                       entry.staticData.begin()+offset+entry.lengths[entry.currentMessage]);
+    }
+    entry.currentMessage++;
+    if (entry.currentMessage==(int)entry.lengths.size()) {
+        entry.reset();
+    }
+    return message;
+}
+
+char const* RecvPoolCommunicator::receiveStaticMessage(int fromProc)
+{
+    std::map<int,CommunicatorEntry>::iterator entryPtr = subscriptions.find(fromProc);
+    PLB_ASSERT( entryPtr!= subscriptions.end() );
+    CommunicatorEntry& entry = entryPtr->second;
+    PLB_ASSERT( entry.currentMessage < (int)entry.messages.size() );
+    if (entry.currentMessage==0) {
+        finalizeStatic(fromProc);
+    }
+    char const* message = entry.staticData.empty() ?
+                              0 : &entry.staticData[entry.offsets[entry.currentMessage]];
     entry.currentMessage++;
     if (entry.currentMessage==(int)entry.lengths.size()) {
         entry.reset();
@@ -219,24 +307,10 @@ void RecvPoolCommunicator::finalizeStatic(int fromProc)
     PLB_ASSERT( entryPtr != subscriptions.end() );
     CommunicatorEntry& entry = entryPtr->second;
 
-    // Empty messages are neither sent nor received.
-    if (!entry.data.empty()) {
-        // 1. Make sure the package of messages has been received.
-        global::mpi().wait(&entry.messageRequest, &entry.messageStatus);
-        
-        // 2. The message package is split into individual messages.
-        int pos=0;
-        PLB_ASSERT(entry.messages.size() == entry.lengths.size());
-        for (pluint iMessage=0; iMessage<entry.messages.size(); ++iMessage) {
-            int length = entry.lengths[iMessage];
-            entry.messages[iMessage].resize(length);
-            PLB_ASSERT(pos+length <= (int)entry.data.size());
-            if (!entry.messages[iMessage].empty()) {
-                std::copy( entry.data.begin()+pos, entry.data.begin()+pos+length,
-                           entry.messages[iMessage].begin() );
-            }
-            pos+=length;
-        }
+    // Empty messages are neither sent nor received. The individual messages
+    //   are read from the persistent buffer at their precomputed offsets.
+    if (!entry.staticData.empty()) {
+        global::mpi().wait(&entry.persistentRequest, &entry.messageStatus);
     }
 }
 
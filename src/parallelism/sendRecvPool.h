@@ -77,37 +77,54 @@ private:
 
 /// This is a storage device for the communication between a pair of processors,
 ///   to be used in action.
+/** Static messages, whose lengths are known in advance, are packed into the
+ *  buffer staticData at precomputed offsets, and exchanged through a persistent
+ *  MPI request which is created the first time it is used. The persistent
+ *  request is owned by the entry: it is not duplicated when the entry is copied,
+ *  and it is released by the destructor.
+ */
 struct CommunicatorEntry {
     CommunicatorEntry() 
         : lengths(),
+          offsets(),
           cumDataLength(0),
           messages(),
           data(),
-          currentMessage(0)
+          staticData(),
+          currentMessage(0),
+          persistentRequest(MPI_REQUEST_NULL)
     { } 
     CommunicatorEntry(PoolEntry const& poolEntry)
         : lengths(poolEntry.lengths),
+          offsets(lengths.size()),
           cumDataLength(poolEntry.cumDataLength),
           messages(lengths.size()),
-          currentMessage(0)
+          staticData(cumDataLength),
+          currentMessage(0),
+          persistentRequest(MPI_REQUEST_NULL)
     {
-        for (pluint iMessage=0; iMessage<messages.size(); ++iMessage) {
-            messages[iMessage].resize(lengths[iMessage]);
+        int pos=0;
+        for (pluint iMessage=0; iMessage<lengths.size(); ++iMessage) {
+            offsets[iMessage] = pos;
+            pos += lengths[iMessage];
         }
     }
+    CommunicatorEntry(CommunicatorEntry const& rhs);
+    CommunicatorEntry& operator=(CommunicatorEntry const& rhs);
+    ~CommunicatorEntry();
     void reset() {
         currentMessage=0;
     }
     std::string info() {
         std::stringstream infostr;
         for (pluint iL=0; iL<lengths.size(); ++iL) {
-            int length = lengths[iL];
-            PLB_ASSERT(length==(int)messages[iL].size());
-            infostr << length << " ";
+            infostr << lengths[iL] << " ";
         }
         return infostr.str();
     }
     std::vector<int> lengths;
+    /// Position of each static message inside staticData.
+    std::vector<int> offsets;
     int              cumDataLength;
     std::vector<std::vector<char> > messages;
     /// The variable data holds the message which in the end is being sent.
@@ -115,6 +132,9 @@ struct CommunicatorEntry {
     ///   blocking communication pattern and avoids unnecessery de- and re-
     ///   allocations.
     std::vector<char> data;
+    /// Buffer of the persistent request for static messages. It is never
+    ///   reallocated, because its address is registered with MPI.
+    std::vector<char> staticData;
     /// If the data is dynamic, it must be sent and received piecewise,
     ///   and the individual sizes must be known. 
     ///   Having data here guarantees its persistence throughout the non-
@@ -122,7 +142,7 @@ struct CommunicatorEntry {
     ///   allocations.
     std::vector<int> dynamicDataSizes;
     int currentMessage;
-    MPI_Request sizeRequest, messageRequest;
+    MPI_Request sizeRequest, messageRequest, persistentRequest;
     MPI_Status  sizeStatus, messageStatus;
 };
 
@@ -132,6 +152,9 @@ public:
     SendPoolCommunicator() { }
     SendPoolCommunicator(SendRecvPool const& pool);
     std::vector<char>& getSendBuffer(int toProc);
+    /// Memory into which the next static message to toProc can be packed
+    ///   directly, instead of being written into getSendBuffer(toProc).
+    char* getStaticSendBuffer(int toProc);
     void acceptMessage(int toProc, bool staticMessage);
     void finalize(bool staticMessage);
 private:
@@ -148,6 +171,10 @@ public:
     /// Initiate non-blocking communication.
     void startBeingReceptive(bool staticMessage);
     std::vector<char> const& receiveMessage(int fromProc, bool staticMessage);
+    /// Zero-copy version of receiveMessage(fromProc,true): the returned memory
+    ///   holds the next static message, and is valid until the next call
+    ///   to startBeingReceptive().
+    char const* receiveStaticMessage(int fromProc);
 private:
     void finalizeStatic(int fromProc);
     void receiveDynamic(int fromProc);
@@ -0,0 +1,292 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Pool of shared-memory threads for the execution of block-wise tasks -- implementation file.
+ */
+
+#include "parallelism/threadPool.h"
+#include "core/plbDebug.h"
+#include "core/plbProfiler.h"
+#include "core/plbTimer.h"
+#include "core/runTimeDiagnostics.h"
+#include <exception>
+
+namespace plb {
+
+ThreadPool::ThreadPool()
+    : numThreads(1),
+      parallelRegion(false),
+      queues(1)
+#ifdef PLB_SMP_PARALLEL
+      , generation(0),
+      numActiveWorkers(0),
+      shutdown(false),
+      currentTask(0)
+#endif
+{
+#ifdef PLB_SMP_PARALLEL
+    pthread_mutex_init(&poolMutex, 0);
+    pthread_cond_init(&startCondition, 0);
+    pthread_cond_init(&doneCondition, 0);
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+#ifdef PLB_SMP_PARALLEL
+    stopWorkers();
+    pthread_cond_destroy(&doneCondition);
+    pthread_cond_destroy(&startCondition);
+    pthread_mutex_destroy(&poolMutex);
+#endif
+}
+
+void ThreadPool::setNumThreads(int numThreads_) {
+    PLB_PRECONDITION( numThreads_ >= 1 );
+    PLB_PRECONDITION( !parallelRegion );
+#ifdef PLB_SMP_PARALLEL
+    if (numThreads_ != numThreads) {
+        stopWorkers();
+        numThreads = numThreads_;
+        startWorkers();
+    }
+#else
+    // Without shared-memory parallelism, everything is executed by the calling thread.
+    (void) numThreads_;
+#endif
+}
+
+int ThreadPool::getNumThreads() const {
+    return numThreads;
+}
+
+bool ThreadPool::isParallelRegion() const {
+    return parallelRegion;
+}
+
+void ThreadPool::execute(ThreadPoolTask& task, std::vector<int> const& preferredThread) {
+    plint numTasks = (plint) preferredThread.size();
+    // Nested calls are executed serially by the thread which issues them.
+    if (numThreads==1 || numTasks<=1 || parallelRegion) {
+        executeSerially(task, numTasks);
+        return;
+    }
+#ifdef PLB_SMP_PARALLEL
+    distributeTasks(preferredThread);
+    global::profiler().suspend();
+    parallelRegion = true;
+
+    pthread_mutex_lock(&poolMutex);
+    currentTask = &task;
+    errorMessage.clear();
+    numActiveWorkers = numThreads-1;
+    ++generation;
+    pthread_cond_broadcast(&startCondition);
+    pthread_mutex_unlock(&poolMutex);
+
+    work(0);
+
+    pthread_mutex_lock(&poolMutex);
+    while (numActiveWorkers>0) {
+        pthread_cond_wait(&doneCondition, &poolMutex);
+    }
+    currentTask = 0;
+    std::string message(errorMessage);
+    pthread_mutex_unlock(&poolMutex);
+
+    parallelRegion = false;
+    global::profiler().resume();
+    if (!message.empty()) {
+        throw PlbGenericException(message);
+    }
+#endif
+}
+
+void ThreadPool::distributeTasks(std::vector<int> const& preferredThread) {
+    plint numTasks = (plint) preferredThread.size();
+    bool uniform = true;
+    for (plint iTask=1; iTask<numTasks; ++iTask) {
+        if (preferredThread[iTask] != preferredThread[0]) {
+            uniform = false;
+            break;
+        }
+    }
+    for (int iThread=0; iThread<numThreads; ++iThread) {
+        queues[iThread].clear();
+    }
+    for (plint iTask=0; iTask<numTasks; ++iTask) {
+        int iThread = uniform ? (int)(iTask%numThreads) : preferredThread[iTask]%numThreads;
+        if (iThread<0) {
+            iThread += numThreads;
+        }
+        queues[iThread].push_back(iTask);
+    }
+}
+
+void ThreadPool::executeSerially(ThreadPoolTask& task, plint numTasks) {
+    for (plint iTask=0; iTask<numTasks; ++iTask) {
+        task.execute(iTask);
+    }
+}
+
+#ifdef PLB_SMP_PARALLEL
+
+void ThreadPool::startWorkers() {
+    shutdown = false;
+    queues.resize(numThreads);
+    queueMutexes.resize(numThreads);
+    for (int iThread=0; iThread<numThreads; ++iThread) {
+        pthread_mutex_init(&queueMutexes[iThread], 0);
+    }
+    workers.resize(numThreads-1);
+    workerArguments.resize(numThreads-1);
+    for (int iWorker=0; iWorker<numThreads-1; ++iWorker) {
+        workerArguments[iWorker].pool = this;
+        workerArguments[iWorker].threadId = iWorker+1;
+        workerArguments[iWorker].generation = generation;
+        int errorCode = pthread_create(&workers[iWorker], 0, workerMain, &workerArguments[iWorker]);
+        if (errorCode!=0) {
+            workers.resize(iWorker);
+            workerArguments.resize(iWorker);
+            stopWorkers();
+            numThreads = 1;
+            queues.resize(1);
+            plbMemoryError("Could not create the shared-memory threads.");
+        }
+    }
+}
+
+void ThreadPool::stopWorkers() {
+    pthread_mutex_lock(&poolMutex);
+    shutdown = true;
+    pthread_cond_broadcast(&startCondition);
+    pthread_mutex_unlock(&poolMutex);
+    for (pluint iWorker=0; iWorker<workers.size(); ++iWorker) {
+        pthread_join(workers[iWorker], 0);
+    }
+    workers.clear();
+    workerArguments.clear();
+    for (pluint iThread=0; iThread<queueMutexes.size(); ++iThread) {
+        pthread_mutex_destroy(&queueMutexes[iThread]);
+    }
+    queueMutexes.clear();
+    shutdown = false;
+}
+
+void ThreadPool::work(int threadId) {
+    plint iTask;
+    while (getTask(threadId, iTask)) {
+        try {
+            currentTask->execute(iTask);
+        }
+        catch (std::exception const& exception) {
+            pthread_mutex_lock(&poolMutex);
+            if (errorMessage.empty()) {
+                errorMessage = exception.what();
+            }
+            pthread_mutex_unlock(&poolMutex);
+        }
+    }
+}
+
+/// Take the next task from the front of the own queue or, if
+///   it is empty, steal one from the end of another queue.
+bool ThreadPool::getTask(int threadId, plint& iTask) {
+    for (int iQueue=0; iQueue<numThreads; ++iQueue) {
+        int victim = (threadId+iQueue)%numThreads;
+        pthread_mutex_lock(&queueMutexes[victim]);
+        std::deque<plint>& queue = queues[victim];
+        bool found = !queue.empty();
+        if (found) {
+            if (iQueue==0) {
+                iTask = queue.front();
+                queue.pop_front();
+            }
+            else {
+                iTask = queue.back();
+                queue.pop_back();
+            }
+        }
+        pthread_mutex_unlock(&queueMutexes[victim]);
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void* ThreadPool::workerMain(void* argument) {
+    WorkerArgument* workerArgument = static_cast<WorkerArgument*>(argument);
+    ThreadPool* pool = workerArgument->pool;
+    unsigned long lastGeneration = workerArgument->generation;
+    pthread_mutex_lock(&pool->poolMutex);
+    while (true) {
+        while (!pool->shutdown && pool->generation==lastGeneration) {
+            pthread_cond_wait(&pool->startCondition, &pool->poolMutex);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        lastGeneration = pool->generation;
+        pthread_mutex_unlock(&pool->poolMutex);
+
+        pool->work(workerArgument->threadId);
+
+        pthread_mutex_lock(&pool->poolMutex);
+        --pool->numActiveWorkers;
+        if (pool->numActiveWorkers==0) {
+            pthread_cond_signal(&pool->doneCondition);
+        }
+    }
+    pthread_mutex_unlock(&pool->poolMutex);
+    return 0;
+}
+
+#endif  // PLB_SMP_PARALLEL
+
+TimedThreadPoolTask::TimedThreadPoolTask(ThreadPoolTask& task_, std::vector<double>& taskTimes_)
+    : task(task_),
+      taskTimes(taskTimes_)
+{ }
+
+void TimedThreadPoolTask::execute(plint iTask) {
+    PLB_ASSERT( iTask < (plint)taskTimes.size() );
+    // A local timer is used, because the global timers are not thread-safe.
+    global::PlbTimer timer;
+    timer.start();
+    task.execute(iTask);
+    taskTimes[iTask] += timer.stop();
+}
+
+
+namespace global {
+
+ThreadPool& threadPool() {
+    static ThreadPool instance;
+    return instance;
+}
+
+}  // namespace global
+
+}  // namespace plb
@@ -0,0 +1,197 @@
+/* This file is part of the Palabos library.
+ *
+ * Copyright (C) 2011-2017 FlowKit Sarl
+ * Route d'Oron 2
+ * 1010 Lausanne, Switzerland
+ * E-mail contact: contact@flowkit.com
+ *
+ * The most recent release of Palabos can be downloaded at
+ * <http://www.palabos.org/>
+ *
+ * The library Palabos is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * The library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Pool of shared-memory threads for the execution of block-wise tasks -- header file.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "core/globalDefs.h"
+#include "core/geometry3D.h"
+#include <vector>
+#include <deque>
+#include <string>
+
+#ifdef PLB_SMP_PARALLEL
+#include <pthread.h>
+#endif
+
+namespace plb {
+
+/// A loop body which is executed by the ThreadPool, once for every task index.
+struct ThreadPoolTask {
+    virtual ~ThreadPoolTask() { }
+    virtual void execute(plint iTask) =0;
+};
+
+/// Shared-memory threads which execute independent tasks, typically one per local block.
+/** The calling thread takes part in the execution and counts as thread 0. Every
+ *  task is first queued on its preferred thread; a thread whose queue is empty
+ *  steals tasks from the end of the other queues. Without PLB_SMP_PARALLEL, or with
+ *  a single thread, the tasks are executed in order by the calling thread.
+ *
+ *  The tasks must not call MPI, and they must not access data which is shared with
+ *  another task. During the execution of the tasks, the profiler is suspended.
+ */
+class ThreadPool {
+public:
+    ThreadPool();
+    ~ThreadPool();
+    /// Number of threads, including the calling thread. Threads are
+    ///   created and destroyed as needed.
+    void setNumThreads(int numThreads_);
+    int getNumThreads() const;
+    /// True while tasks are being executed.
+    bool isParallelRegion() const;
+    /// Execute task.execute(iTask) for all 0 <= iTask < preferredThread.size(),
+    ///   and wait for completion. The value preferredThread[iTask] (taken modulo the number
+    ///   of threads) is the thread on which iTask is queued initially. If all tasks
+    ///   have the same preferred thread, they are distributed round-robin instead.
+    void execute(ThreadPoolTask& task, std::vector<int> const& preferredThread);
+private:
+    ThreadPool(ThreadPool const& rhs);
+    ThreadPool& operator=(ThreadPool const& rhs);
+    void distributeTasks(std::vector<int> const& preferredThread);
+    void executeSerially(ThreadPoolTask& task, plint numTasks);
+#ifdef PLB_SMP_PARALLEL
+    void startWorkers();
+    void stopWorkers();
+    void work(int threadId);
+    bool getTask(int threadId, plint& iTask);
+    static void* workerMain(void* argument);
+#endif
+private:
+    int numThreads;
+    bool parallelRegion;
+    std::vector<std::deque<plint> > queues;
+#ifdef PLB_SMP_PARALLEL
+    struct WorkerArgument {
+        ThreadPool* pool;
+        int threadId;
+        unsigned long generation;
+    };
+    std::vector<pthread_t> workers;
+    std::vector<WorkerArgument> workerArguments;
+    std::vector<pthread_mutex_t> queueMutexes;
+    pthread_mutex_t poolMutex;
+    pthread_cond_t startCondition;
+    pthread_cond_t doneCondition;
+    unsigned long generation;
+    int numActiveWorkers;
+    bool shutdown;
+    ThreadPoolTask* currentTask;
+    std::string errorMessage;
+#endif
+};
+
+/// Executes another task, and adds the wall-clock time spent on every
+///   task index iTask to taskTimes[iTask].
+class TimedThreadPoolTask : public ThreadPoolTask {
+public:
+    TimedThreadPoolTask(ThreadPoolTask& task_, std::vector<double>& taskTimes_);
+    virtual void execute(plint iTask);
+private:
+    ThreadPoolTask& task;
+    std::vector<double>& taskTimes;
+};
+
+/// Executes collideAndStream(domain) on a list of atomic-block lattices, one per task.
+template<class Lattice>
+class CollideAndStreamTask : public ThreadPoolTask {
+public:
+    CollideAndStreamTask(std::vector<Lattice*> const& lattices_, std::vector<Box3D> const& domains_)
+        : lattices(lattices_),
+          domains(domains_)
+    { }
+    virtual void execute(plint iTask) {
+        lattices[iTask]->collideAndStream(domains[iTask]);
+    }
+private:
+    std::vector<Lattice*> const& lattices;
+    std::vector<Box3D> const& domains;
+};
+
+/// Executes collideAndStreamShell(domain,interior) or collideAndStreamInterior(domain,interior)
+///   on a list of atomic-block lattices, one per task.
+template<class Lattice>
+class CollideAndStreamPartTask : public ThreadPoolTask {
+public:
+    CollideAndStreamPartTask(std::vector<Lattice*> const& lattices_, std::vector<Box3D> const& domains_,
+                             std::vector<Box3D> const& interiors_, bool shell_)
+        : lattices(lattices_),
+          domains(domains_),
+          interiors(interiors_),
+          shell(shell_)
+    { }
+    virtual void execute(plint iTask) {
+        if (shell) {
+            lattices[iTask]->collideAndStreamShell(domains[iTask], interiors[iTask]);
+        }
+        else {
+            lattices[iTask]->collideAndStreamInterior(domains[iTask], interiors[iTask]);
+        }
+    }
+private:
+    std::vector<Lattice*> const& lattices;
+    std::vector<Box3D> const& domains;
+    std::vector<Box3D> const& interiors;
+    bool shell;
+};
+
+/// Executes collideAndStreamAA(domain) or restoreNaturalLayoutAA(domain) on a list
+///   of atomic-block lattices, one per task.
+template<class Lattice>
+class CollideAndStreamAATask : public ThreadPoolTask {
+public:
+    CollideAndStreamAATask(std::vector<Lattice*> const& lattices_, std::vector<Box3D> const& domains_,
+                           bool restore_)
+        : lattices(lattices_),
+          domains(domains_),
+          restore(restore_)
+    { }
+    virtual void execute(plint iTask) {
+        if (restore) {
+            lattices[iTask]->restoreNaturalLayoutAA(domains[iTask]);
+        }
+        else {
+            lattices[iTask]->collideAndStreamAA(domains[iTask]);
+        }
+    }
+private:
+    std::vector<Lattice*> const& lattices;
+    std::vector<Box3D> const& domains;
+    bool restore;
+};
+
+namespace global {
+
+ThreadPool& threadPool();
+
+}  // namespace global
+
+}  // namespace plb
+
+#endif  // THREAD_POOL_H
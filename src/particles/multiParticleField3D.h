@@ -48,6 +48,7 @@ public:
     MultiParticleField3D& operator=(MultiParticleField3D<ParticleFieldT> const& rhs);
     MultiParticleField3D(MultiParticleField3D<ParticleFieldT> const& rhs);
     void swap(MultiParticleField3D<ParticleFieldT>& rhs);
+    virtual void swapComponents(MultiBlock3D& rhs);
 public:
     virtual ParticleFieldT& getComponent(plint iBlock);
     virtual ParticleFieldT const& getComponent(plint iBlock) const;
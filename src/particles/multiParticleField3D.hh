@@ -124,6 +124,15 @@ void MultiParticleField3D<ParticleFieldT>::swap(MultiParticleField3D<ParticleFie
     MultiBlock3D::swap(rhs);
 }
 
+template<class ParticleFieldT>
+void MultiParticleField3D<ParticleFieldT>::swapComponents(MultiBlock3D& rhs) {
+    MultiParticleField3D<ParticleFieldT>* rhsField =
+        dynamic_cast<MultiParticleField3D<ParticleFieldT>*>(&rhs);
+    PLB_ASSERT( rhsField );
+    MultiBlock3D::swapDistribution(rhs);
+    blocks.swap(rhsField->blocks);
+}
+
 template<class ParticleFieldT>
 MultiParticleField3D<ParticleFieldT>* MultiParticleField3D<ParticleFieldT>::clone() const {
     return new MultiParticleField3D<ParticleFieldT>(*this);
@@ -165,6 +165,18 @@ private:
     LightParticleField3D<T,Descriptor> const* constParticleField;
 };
 
+/// Particle field which stores a flat list of particles.
+/** The particles are kept sorted by spatial bins of a few cells, and the
+ *  start of every bin is recorded, so that domain queries (in particular,
+ *  the transfer of particles in the envelope) only visit the bins which
+ *  intersect the domain. Newly added particles are appended to an unsorted
+ *  tail, and removed particles leave a null entry; both are folded into the
+ *  bins at the next sort. The particles are sorted again after each call
+ *  to advanceParticles(), and whenever the tail and the null entries exceed
+ *  a fraction of the total. Particles returned by the non-const version of
+ *  findParticles() may be moved by the caller, and therefore cancel the
+ *  sorting until the next sort.
+ */
 template<typename T, template<typename U> class Descriptor>
 class LightParticleField3D : public ParticleField3D<T,Descriptor> {
 public:
@@ -193,8 +205,33 @@ public:
     static std::string getBlockName();
     static std::string basicType();
     static std::string descriptorType();
+private:
+    /// Indices of all (non-null) particles contained in the domain.
+    void findParticleIndices(Box3D domain, std::vector<pluint>& indices) const;
+    /// Index of the bin of a particle; particles outside the block go to the nearest bin.
+    plint binIndex(Array<T,3> const& position) const;
+    /// Bin width for which there are not more bins than particles.
+    plint optimalBinWidth(pluint numParticles) const;
+    void setBinWidth(plint binWidth_);
+    /// Recompute the bin of all particles, and sort them.
+    void sortParticles();
+    /// Sort the particles by their stored bin index, and remove the null entries.
+    void sortByBins();
+    /// Sort the particles, if the sorting has been cancelled or the unsorted
+    ///   part of the list has grown too large.
+    void updateSorting();
 private:
     std::vector<Particle3D<T,Descriptor>*> particles;
+    /// Bin index of each particle.
+    std::vector<plint> particleBins;
+    /// When sorted is true, the particles in [0,numSorted) are sorted by bin,
+    ///   and bin iBin occupies [binOffsets[iBin], binOffsets[iBin+1]).
+    std::vector<pluint> binOffsets;
+    std::vector<Particle3D<T,Descriptor>*> particleBuffer;
+    std::vector<plint> binBuffer;
+    pluint numSorted, numRemoved;
+    plint binWidth, binNx, binNy, binNz;
+    bool sorted;
     LightParticleDataTransfer3D<T,Descriptor> dataTransfer;
 };
 
@@ -28,6 +28,7 @@
 #include "core/globalDefs.h"
 #include "particles/particleField3D.h"
 #include <utility>
+#include <algorithm>
 
 namespace plb {
 
@@ -667,8 +668,13 @@ void LightParticleDataTransfer3D<T,Descriptor>::attribute (
 
 template<typename T, template<typename U> class Descriptor>
 LightParticleField3D<T,Descriptor>::LightParticleField3D(plint nx, plint ny, plint nz)
-    : ParticleField3D<T,Descriptor>(nx,ny,nz, new LightParticleDataTransfer3D<T,Descriptor>() )
-{ }
+    : ParticleField3D<T,Descriptor>(nx,ny,nz, new LightParticleDataTransfer3D<T,Descriptor>() ),
+      numSorted(0),
+      numRemoved(0),
+      sorted(true)
+{
+    sortParticles();
+}
 
 template<typename T, template<typename U> class Descriptor>
 LightParticleField3D<T,Descriptor>::~LightParticleField3D()
@@ -680,11 +686,17 @@ LightParticleField3D<T,Descriptor>::~LightParticleField3D()
 
 template<typename T, template<typename U> class Descriptor>
 LightParticleField3D<T,Descriptor>::LightParticleField3D(LightParticleField3D const& rhs)
-    : ParticleField3D<T,Descriptor>(rhs)
+    : ParticleField3D<T,Descriptor>(rhs),
+      numSorted(0),
+      numRemoved(0),
+      sorted(true)
 {
     for (pluint i=0; i<rhs.particles.size(); ++i) {
-        particles.push_back(rhs.particles[i]->clone());
+        if (rhs.particles[i]) {
+            particles.push_back(rhs.particles[i]->clone());
+        }
     }
+    sortParticles();
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -706,6 +718,151 @@ template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::swap(LightParticleField3D<T,Descriptor>& rhs) {
     ParticleField3D<T,Descriptor>::swap(rhs);
     particles.swap(rhs.particles);
+    particleBins.swap(rhs.particleBins);
+    binOffsets.swap(rhs.binOffsets);
+    particleBuffer.swap(rhs.particleBuffer);
+    binBuffer.swap(rhs.binBuffer);
+    std::swap(numSorted, rhs.numSorted);
+    std::swap(numRemoved, rhs.numRemoved);
+    std::swap(binWidth, rhs.binWidth);
+    std::swap(binNx, rhs.binNx);
+    std::swap(binNy, rhs.binNy);
+    std::swap(binNz, rhs.binNz);
+    std::swap(sorted, rhs.sorted);
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint LightParticleField3D<T,Descriptor>::binIndex(Array<T,3> const& position) const
+{
+    plint iX, iY, iZ;
+    this->computeGridPosition(position, iX, iY, iZ);
+    iX = std::min(std::max(iX, (plint)0), this->getNx()-1) / binWidth;
+    iY = std::min(std::max(iY, (plint)0), this->getNy()-1) / binWidth;
+    iZ = std::min(std::max(iZ, (plint)0), this->getNz()-1) / binWidth;
+    return (iX*binNy + iY)*binNz + iZ;
+}
+
+template<typename T, template<typename U> class Descriptor>
+plint LightParticleField3D<T,Descriptor>::optimalBinWidth(pluint numParticles) const
+{
+    plint nx = this->getNx();
+    plint ny = this->getNy();
+    plint nz = this->getNz();
+    plint maxWidth = std::max(nx, std::max(ny, nz));
+    plint width = 1;
+    while ( width < maxWidth &&
+            (pluint)(((nx-1)/width+1)*((ny-1)/width+1)*((nz-1)/width+1)) > numParticles+1 )
+    {
+        width *= 2;
+    }
+    return width;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void LightParticleField3D<T,Descriptor>::setBinWidth(plint binWidth_)
+{
+    binWidth = binWidth_;
+    binNx = (this->getNx()-1)/binWidth+1;
+    binNy = (this->getNy()-1)/binWidth+1;
+    binNz = (this->getNz()-1)/binWidth+1;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void LightParticleField3D<T,Descriptor>::sortParticles()
+{
+    setBinWidth(optimalBinWidth(particles.size()-numRemoved));
+    particleBins.resize(particles.size());
+    for (pluint i=0; i<particles.size(); ++i) {
+        if (particles[i]) {
+            particleBins[i] = binIndex(particles[i]->getPosition());
+        }
+    }
+    sortByBins();
+}
+
+template<typename T, template<typename U> class Descriptor>
+void LightParticleField3D<T,Descriptor>::sortByBins()
+{
+    PLB_ASSERT( particleBins.size()==particles.size() );
+    plint numBins = binNx*binNy*binNz;
+    pluint numParticles = particles.size()-numRemoved;
+    // Counting sort, which keeps the order of the particles inside a bin.
+    binOffsets.assign(numBins+1, 0);
+    for (pluint i=0; i<particles.size(); ++i) {
+        if (particles[i]) {
+            ++binOffsets[particleBins[i]+1];
+        }
+    }
+    for (plint iBin=0; iBin<numBins; ++iBin) {
+        binOffsets[iBin+1] += binOffsets[iBin];
+    }
+    particleBuffer.resize(numParticles);
+    binBuffer.resize(numParticles);
+    for (pluint i=0; i<particles.size(); ++i) {
+        if (particles[i]) {
+            pluint pos = binOffsets[particleBins[i]]++;
+            particleBuffer[pos] = particles[i];
+            binBuffer[pos] = particleBins[i];
+        }
+    }
+    // Shift the offsets back to the start of the bins.
+    for (plint iBin=numBins; iBin>0; --iBin) {
+        binOffsets[iBin] = binOffsets[iBin-1];
+    }
+    binOffsets[0] = 0;
+    particles.swap(particleBuffer);
+    particleBins.swap(binBuffer);
+    numSorted = particles.size();
+    numRemoved = 0;
+    sorted = true;
+}
+
+template<typename T, template<typename U> class Descriptor>
+void LightParticleField3D<T,Descriptor>::updateSorting()
+{
+    pluint numParticles = particles.size()-numRemoved;
+    if (!sorted || optimalBinWidth(numParticles)!=binWidth) {
+        sortParticles();
+    }
+    else if (particles.size()-numSorted+numRemoved > numSorted/8+16) {
+        sortByBins();
+    }
+}
+
+template<typename T, template<typename U> class Descriptor>
+void LightParticleField3D<T,Descriptor>::findParticleIndices (
+        Box3D domain, std::vector<pluint>& indices ) const
+{
+    indices.clear();
+    Box3D finalDomain;
+    if( !intersect(domain, this->getBoundingBox(), finalDomain) ) {
+        return;
+    }
+    pluint unsortedStart = 0;
+    if (sorted) {
+        // A particle is attributed to the cell nearest to it; one extra cell
+        //   accounts for particles which are exactly half-way between cells.
+        Box3D cells;
+        intersect(finalDomain.enlarge(1), this->getBoundingBox(), cells);
+        for (plint bX=cells.x0/binWidth; bX<=cells.x1/binWidth; ++bX) {
+            for (plint bY=cells.y0/binWidth; bY<=cells.y1/binWidth; ++bY) {
+                for (plint bZ=cells.z0/binWidth; bZ<=cells.z1/binWidth; ++bZ) {
+                    plint iBin = (bX*binNy + bY)*binNz + bZ;
+                    for (pluint i=binOffsets[iBin]; i<binOffsets[iBin+1]; ++i) {
+                        if (particles[i] && this->isContained(particles[i]->getPosition(),finalDomain)) {
+                            indices.push_back(i);
+                        }
+                    }
+                }
+            }
+        }
+        unsortedStart = numSorted;
+    }
+    for (pluint i=unsortedStart; i<particles.size(); ++i) {
+        if (particles[i] && this->isContained(particles[i]->getPosition(),finalDomain)) {
+            indices.push_back(i);
+        }
+    }
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -715,6 +872,7 @@ void LightParticleField3D<T,Descriptor>::addParticle(Box3D domain, Particle3D<T,
         this->isContained(particle->getPosition(), finalDomain) )
     {
         particles.push_back(particle);
+        particleBins.push_back(binIndex(particle->getPosition()));
     }
     else {
         delete particle;
@@ -723,40 +881,28 @@ void LightParticleField3D<T,Descriptor>::addParticle(Box3D domain, Particle3D<T,
 
 template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::removeParticles(Box3D domain) {
-    std::vector<Particle3D<T,Descriptor>*> remainingParticles;
-    Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            if (this->isContained(particles[i]->getPosition(),finalDomain)) {
-                delete particles[i];
-            }
-            else {
-                remainingParticles.push_back(particles[i]);
-            }
-        }
+    updateSorting();
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    for (pluint i=0; i<indices.size(); ++i) {
+        delete particles[indices[i]];
+        particles[indices[i]] = 0;
     }
-    remainingParticles.swap(particles);
+    numRemoved += indices.size();
 }
 
 template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::removeParticles(Box3D domain, plint tag) {
-    std::vector<Particle3D<T,Descriptor>*> remainingParticles;
-    Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            if (this->isContained(particles[i]->getPosition(),finalDomain) &&
-                particles[i]->getTag() == tag )
-            {
-                delete particles[i];
-            }
-            else {
-                remainingParticles.push_back(particles[i]);
-            }
+    updateSorting();
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    for (pluint i=0; i<indices.size(); ++i) {
+        if (particles[indices[i]]->getTag() == tag) {
+            delete particles[indices[i]];
+            particles[indices[i]] = 0;
+            ++numRemoved;
         }
     }
-    remainingParticles.swap(particles);
 }
 
 template<typename T, template<typename U> class Descriptor>
@@ -765,10 +911,16 @@ void LightParticleField3D<T,Descriptor>::findParticles (
 {
     found.clear();
     PLB_ASSERT( contained(domain, this->getBoundingBox()) );
-    for (pluint i=0; i<particles.size(); ++i) {
-        if (this->isContained(particles[i]->getPosition(),domain)) {
-            found.push_back(particles[i]);
-        }
+    updateSorting();
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    found.resize(indices.size());
+    for (pluint i=0; i<indices.size(); ++i) {
+        found[i] = particles[indices[i]];
+    }
+    // The caller may modify the positions of the particles.
+    if (!found.empty()) {
+        sorted = false;
     }
 }
 
@@ -778,10 +930,11 @@ void LightParticleField3D<T,Descriptor>::findParticles (
 {
     found.clear();
     PLB_ASSERT( contained(domain, this->getBoundingBox()) );
-    for (pluint i=0; i<particles.size(); ++i) {
-        if (this->isContained(particles[i]->getPosition(),domain)) {
-            found.push_back(particles[i]);
-        }
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    found.resize(indices.size());
+    for (pluint i=0; i<indices.size(); ++i) {
+        found[i] = particles[indices[i]];
     }
 }
 
@@ -789,14 +942,10 @@ template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::velocityToParticleCoupling (
         Box3D domain, TensorField3D<T,3>& velocityField, T scaling )
 {
-    Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            if (this->isContained(particles[i]->getPosition(),finalDomain)) {
-                particles[i]->velocityToParticle(velocityField, scaling);
-            }
-        }
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    for (pluint i=0; i<indices.size(); ++i) {
+        particles[indices[i]]->velocityToParticle(velocityField, scaling);
     }
 }
 
@@ -804,14 +953,10 @@ template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::velocityToParticleCoupling (
         Box3D domain, NTensorField3D<T>& velocityField, T scaling )
 {
-    Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            if (this->isContained(particles[i]->getPosition(),finalDomain)) {
-                particles[i]->velocityToParticle(velocityField, scaling);
-            }
-        }
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    for (pluint i=0; i<indices.size(); ++i) {
+        particles[indices[i]]->velocityToParticle(velocityField, scaling);
     }
 }
 
@@ -819,14 +964,10 @@ template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::rhoBarJtoParticleCoupling (
         Box3D domain, NTensorField3D<T>& rhoBarJfield, bool velIsJ, T scaling )
 {
-    Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            if (this->isContained(particles[i]->getPosition(),finalDomain)) {
-                particles[i]->rhoBarJtoParticle(rhoBarJfield, velIsJ, scaling);
-            }
-        }
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    for (pluint i=0; i<indices.size(); ++i) {
+        particles[indices[i]]->rhoBarJtoParticle(rhoBarJfield, velIsJ, scaling);
     }
 }
 
@@ -834,40 +975,48 @@ template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::fluidToParticleCoupling (
         Box3D domain, BlockLattice3D<T,Descriptor>& lattice, T scaling )
 {
-    Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            if (this->isContained(particles[i]->getPosition(),finalDomain)) {
-                particles[i]->fluidToParticle(lattice, scaling);
-            }
-        }
+    std::vector<pluint> indices;
+    findParticleIndices(domain, indices);
+    for (pluint i=0; i<indices.size(); ++i) {
+        particles[indices[i]]->fluidToParticle(lattice, scaling);
     }
 }
 
 template<typename T, template<typename U> class Descriptor>
 void LightParticleField3D<T,Descriptor>::advanceParticles(Box3D domain, T cutOffValue) {
-    std::vector<Particle3D<T,Descriptor>*> remainingParticles;
+    pluint numParticles = particles.size()-numRemoved;
+    if (optimalBinWidth(numParticles)!=binWidth) {
+        setBinWidth(optimalBinWidth(numParticles));
+    }
     Box3D finalDomain;
-    if( intersect(domain, this->getBoundingBox(), finalDomain) )
-    {
-        for (pluint i=0; i<particles.size(); ++i) {
-            Particle3D<T,Descriptor>* particle = particles[i];
-            if (this->isContained(particle->getPosition(),finalDomain)) {
-                Array<T,3> oldPos( particle->getPosition() );
-                particle->advance();
-                if ( (cutOffValue>=T() && normSqr(oldPos-particle->getPosition())<cutOffValue) ||
-                     (!this->isContained(particle->getPosition(),this->getBoundingBox()))  )
-                {
-                    delete particle;
-                }
-                else {
-                    remainingParticles.push_back(particle);
-                }
+    bool intersects = intersect(domain, this->getBoundingBox(), finalDomain);
+    for (pluint i=0; i<particles.size(); ++i) {
+        Particle3D<T,Descriptor>* particle = particles[i];
+        if (!particle) {
+            continue;
+        }
+        if (intersects && this->isContained(particle->getPosition(),finalDomain)) {
+            Array<T,3> oldPos( particle->getPosition() );
+            particle->advance();
+            if ( (cutOffValue>=T() && normSqr(oldPos-particle->getPosition())<cutOffValue) ||
+                 (!this->isContained(particle->getPosition(),this->getBoundingBox()))  )
+            {
+                delete particle;
+                particles[i] = 0;
+                ++numRemoved;
+            }
+            else {
+                // The particles have moved: their new bin is computed while they are in cache.
+                particleBins[i] = binIndex(particle->getPosition());
             }
         }
+        else {
+            delete particle;
+            particles[i] = 0;
+            ++numRemoved;
+        }
     }
-    particles.swap(remainingParticles);
+    sortByBins();
 }
 
 template<typename T, template<typename U> class Descriptor>